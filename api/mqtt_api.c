@@ -12,55 +12,435 @@
 #define DBG_LVL DBG_LOG
 
 #include "mqtt_api.h"
+#include "mqtt_event_loop.h"
 
-static MQTTFixedBuffer_t mqttBuffer = { .pBuffer = RT_NULL, .size = MQTT_BUF_SIZE };
-static MQTTContext_t mqttContext;
-static TransportInterface_t transportInterface;
-static NetworkContext_t networkContext;
-static MQTTPubAckInfo_t outgoingPublishes[MQTT_OUTGOING_PUBLISH_COUNT];
+static void mqttEventCallback(MQTTContext_t *pContext, MQTTPacketInfo_t *pPacketInfo,
+        MQTTDeserializedInfo_t *pDeserializedInfo);
+static void clientEventCallback(MQTTContext_t *pContext, MQTTPacketInfo_t *pPacketInfo,
+        MQTTDeserializedInfo_t *pDeserializedInfo);
+static void deliverPublish(MQTTContext_t *pContext, MQTTDeserializedInfo_t *pDeserializedInfo, void *pUserData);
+#if MQTT_DUPLEX_ENABLE
+static MQTTStatus_t writerSend(MQTTContext_t *pContext, MQTTPublishInfo_t *publishInfo, void *pUserData);
+#endif
 
-MQTTStatus_t mqttInit(NetworkContext_t *networkContext, MQTTEventCallback_t userCallback)
+static MQTTClient_t defaultClient;
+static rt_list_t clientList = RT_LIST_OBJECT_INIT(clientList);
+
+void mqttClientConfigInit(MQTTClientConfig_t *config)
+{
+    memset(config, 0, sizeof(*config));
+    config->brokerAddress = MQTT_BROKER_ADDRESS;
+    config->brokerPort = MQTT_BROKER_PORT;
+    config->clientId = MQTT_CLIENT_ID;
+    config->keepAliveSeconds = MQTT_KEEP_ALIVE;
+    config->eventCallback = MQTT_USER_CALLBACK;
+    config->bufferSize = MQTT_BUF_SIZE;
+    config->outgoingPublishCount = MQTT_OUTGOING_PUBLISH_COUNT;
+    config->incomingPublishCount = MQTT_INCOMING_PUBLISH_COUNT;
+    config->deferredAckMax = MQTT_DEFERRED_ACK_MAX;
+    config->subscriptionMax = MQTT_SUBSCRIPTION_MAX;
+    config->subscribePacketMax = MQTT_SUBSCRIBE_PACKET_MAX;
+    config->dispatchMaxNodes = MQTT_DISPATCH_MAX_NODES;
+    config->dispatchMaxHandlers = MQTT_DISPATCH_MAX_HANDLERS;
+    config->dispatchMaxLevels = MQTT_DISPATCH_MAX_LEVELS;
+    config->dispatchCacheSize = MQTT_DISPATCH_CACHE_SIZE;
+    config->dispatchCacheTopicMax = MQTT_DISPATCH_CACHE_TOPIC_MAX;
+#if MQTT_OFFLINE_QUEUE_ENABLE
+    config->offlineQueuePath = MQTT_OFFLINE_QUEUE_PATH;
+#endif
+    config->offlineQueueSegmentSize = MQTT_OFFLINE_QUEUE_SEGMENT_SIZE;
+    config->offlineQueueSegmentCount = MQTT_OFFLINE_QUEUE_SEGMENT_COUNT;
+    config->offlineQueueDropPolicy = MQTT_OFFLINE_QUEUE_DROP_POLICY;
+    config->workerCount = MQTT_WORKER_COUNT;
+    config->workerQueueDepth = MQTT_WORKER_QUEUE_DEPTH;
+    config->workerSlotSize = MQTT_WORKER_SLOT_SIZE;
+    config->workerAckMode = MQTT_WORKER_ACK_MODE;
+    config->workerStackSize = MQTT_WORKER_STACK_SIZE;
+    config->workerPriority = MQTT_WORKER_PRIORITY;
+    config->flowHighWatermark = MQTT_FLOW_HIGH_WATERMARK;
+    config->flowLowWatermark = MQTT_FLOW_LOW_WATERMARK;
+    config->writerQueueDepth = MQTT_WRITER_QUEUE_DEPTH;
+    config->writerSlotSize = MQTT_WRITER_SLOT_SIZE;
+    config->writerStackSize = MQTT_WRITER_STACK_SIZE;
+    config->writerPriority = MQTT_WRITER_PRIORITY;
+    config->stackSize = MQTT_CLIENT_STACK_SIZE;
+    config->priority = MQTT_CLIENT_PRIORITY;
+}
+
+/* Bytes mqttClientInit() allocates for config; topic filter copies made later are not included. */
+size_t mqttClientMemoryEstimate(const MQTTClientConfig_t *config)
+{
+    size_t bytes;
+
+    bytes = config->bufferSize;
+    bytes += (config->outgoingPublishCount + config->incomingPublishCount) * sizeof(MQTTPubAckInfo_t);
+    bytes += config->incomingPublishCount * sizeof(MQTTWorkerAck_t);
+    bytes += config->subscriptionMax * sizeof(MQTTSubscribeInfo_t);
+    bytes += (size_t) config->dispatchMaxNodes * sizeof(MQTTDispatchNode_t);
+    bytes += (size_t) config->dispatchMaxHandlers * (sizeof(MQTTDispatchEntry_t) + sizeof(uint16_t));
+    bytes += ((size_t) config->workerCount + 1U)
+            * (sizeof(MQTTDispatchCaller_t) + config->dispatchMaxHandlers * sizeof(MQTTDispatchCall_t));
+    bytes += (size_t) config->dispatchMaxLevels * 2U * sizeof(MQTTDispatchFrame_t);
+    bytes += (size_t) config->dispatchCacheSize * (sizeof(MQTTDispatchCacheLine_t) + config->dispatchCacheTopicMax);
+#if MQTT_OFFLINE_QUEUE_ENABLE
+    if (config->offlineQueuePath != RT_NULL)
+    {
+        bytes += config->offlineQueueSegmentSize + config->offlineQueueSegmentCount * 2U * sizeof(uint32_t);
+    }
+#endif
+    bytes += mqttWorkerPoolMemoryEstimate(config->workerCount, config->workerQueueDepth, config->workerSlotSize,
+            config->workerStackSize);
+#if MQTT_DUPLEX_ENABLE
+    if (config->writerQueueDepth > 0)
+    {
+        bytes += mqttWriterMemoryEstimate(config->writerQueueDepth, config->writerSlotSize, config->writerStackSize);
+    }
+#endif
+    bytes += config->stackSize;
+
+    return bytes;
+}
+
+static void releaseClient(MQTTClient_t *client)
+{
+    mqttWriterDeinit(&client->writer);
+    mqttWorkerPoolDeinit(&client->workers);
+    transportClose(&client->network);
+#if MQTT_OFFLINE_QUEUE_ENABLE
+    if (client->offlineQueueOpen)
+    {
+        mqttOfflineQueueDeinit(&client->offlineQueue);
+        client->offlineQueueOpen = false;
+    }
+#endif
+    mqttSubscriptionDeinit(&client->subscriptions);
+    mqttDispatcherDeinit(&client->dispatcher);
+    rt_free(client->outgoingPublishes);
+    rt_free(client->incomingPublishes);
+    rt_free(client->buffer.pBuffer);
+    if (client->manualAcks != RT_NULL)
+    {
+        rt_free(client->manualAcks);
+        rt_mutex_detach(&client->ackLock);
+    }
+    client->outgoingPublishes = RT_NULL;
+    client->incomingPublishes = RT_NULL;
+    client->manualAcks = RT_NULL;
+    client->buffer.pBuffer = RT_NULL;
+    rt_sem_detach(&client->exited);
+#if MQTT_DUPLEX_ENABLE
+    rt_mutex_detach(&client->stateLock);
+    rt_mutex_detach(&client->sendLock);
+    rt_sem_detach(&client->window);
+#endif
+}
+
+static MQTTStatus_t startFlowControl(MQTTClient_t *client)
+{
+    uint16_t depth = client->config.workerQueueDepth;
+    uint16_t high = client->config.flowHighWatermark;
+    uint16_t low = client->config.flowLowWatermark;
+
+    if (high == 0)
+    {
+        high = (uint16_t) (depth - (depth / 4U));
+        low = (uint16_t) (depth / 4U);
+    }
+
+    /* A submit blocks once a queue is full, so a higher mark never triggers. */
+    high = MIN(high, depth);
+
+    return MQTT_SetFlowControl(&client->context, mqttWorkerPoolDepth, &client->workers, high, low);
+}
+
+MQTTStatus_t mqttClientInit(MQTTClient_t *client, const MQTTClientConfig_t *config)
 {
     MQTTStatus_t status;
 
-    transportInterface.pNetworkContext = networkContext;
-    transportInterface.send = transportSend;
-    transportInterface.recv = transportRecv;
+    if ((client == RT_NULL) || (config == RT_NULL) || (config->eventCallback == RT_NULL))
+    {
+        return MQTTBadParameter;
+    }
+
+    memset(client, 0, sizeof(*client));
+    client->config = *config;
+#if MQTT_DUPLEX_ENABLE
+    rt_mutex_init(&client->stateLock, "mqttst", RT_IPC_FLAG_PRIO);
+    rt_mutex_init(&client->sendLock, "mqttsd", RT_IPC_FLAG_PRIO);
+    rt_sem_init(&client->window, "mqttwin", 0, RT_IPC_FLAG_FIFO);
+#endif
+    rt_sem_init(&client->exited, "mqttrx", 0, RT_IPC_FLAG_FIFO);
+    client->network.socket = -1;
+    client->transport.pNetworkContext = &client->network;
+    client->transport.send = transportSend;
+    client->transport.recv = transportRecv;
+    client->transport.connect = transportConnectStep;
 
-    mqttBuffer.pBuffer = rt_malloc(mqttBuffer.size);
-    if (mqttBuffer.pBuffer == RT_NULL)
+    client->buffer.size = config->bufferSize;
+    client->buffer.pBuffer = rt_malloc(config->bufferSize);
+    client->outgoingPublishes = rt_calloc(config->outgoingPublishCount, sizeof(MQTTPubAckInfo_t));
+    if (config->incomingPublishCount > 0)
+    {
+        client->incomingPublishes = rt_calloc(config->incomingPublishCount, sizeof(MQTTPubAckInfo_t));
+        client->manualAcks = rt_calloc(config->incomingPublishCount, sizeof(MQTTWorkerAck_t));
+        if (client->manualAcks != RT_NULL)
+        {
+            rt_mutex_init(&client->ackLock, "mqttack", RT_IPC_FLAG_PRIO);
+        }
+    }
+    if ((client->buffer.pBuffer == RT_NULL) || (client->outgoingPublishes == RT_NULL)
+            || ((config->incomingPublishCount > 0)
+                    && ((client->incomingPublishes == RT_NULL) || (client->manualAcks == RT_NULL))))
     {
         MQTT_PRINT("Failed to allocate MQTT buffer\n");
-        return MQTTNoMemory;
+        status = MQTTNoMemory;
+        releaseClient(client);
+        return status;
     }
 
-    status = MQTT_Init(&mqttContext, &transportInterface, getCurrentTime, userCallback, &mqttBuffer);
+    status = MQTT_Init(&client->context, &client->transport, getCurrentTime, clientEventCallback, &client->buffer);
+    if (status == MQTTSuccess)
+    {
+        status = MQTT_InitStatefulQoS(&client->context, client->outgoingPublishes, config->outgoingPublishCount,
+                client->incomingPublishes, config->incomingPublishCount);
+    }
+    if ((status == MQTTSuccess) && (config->deferredAckMax > 0))
+    {
+        status = MQTT_SetDeferredAckLimit(&client->context, MIN(config->deferredAckMax, config->incomingPublishCount));
+    }
     if (status != MQTTSuccess)
     {
         MQTT_PRINT("MQTT_Init failed: %d\n", status);
-        rt_free(mqttBuffer.pBuffer);
+        releaseClient(client);
         return status;
     }
-    else
+
+    /* Every worker and the reader may dispatch at the same time. */
+    status = mqttDispatcherInit(&client->dispatcher, config->dispatchMaxNodes, config->dispatchMaxHandlers,
+            config->dispatchMaxLevels, (uint16_t) (config->workerCount + 1U));
+    if (status != MQTTSuccess)
+    {
+        MQTT_PRINT("Failed to initialize topic dispatcher: %d\n", status);
+        releaseClient(client);
+        return status;
+    }
+
+    status = mqttSubscriptionInit(&client->subscriptions, config->subscriptionMax, config->subscribePacketMax,
+            config->bufferSize);
+    if (status != MQTTSuccess)
+    {
+        MQTT_PRINT("Failed to initialize subscription registry: %d\n", status);
+        releaseClient(client);
+        return status;
+    }
+
+    if ((config->dispatchCacheSize > 0)
+            && (mqttDispatcherEnableCache(&client->dispatcher, config->dispatchCacheSize,
+                    config->dispatchCacheTopicMax) != MQTTSuccess))
+    {
+        MQTT_PRINT("Topic dispatch cache disabled, out of memory\n");
+    }
+
+#if MQTT_OFFLINE_QUEUE_ENABLE
+    if (config->offlineQueuePath != RT_NULL)
     {
-        status = MQTT_InitStatefulQoS(&mqttContext, outgoingPublishes, MQTT_OUTGOING_PUBLISH_COUNT, NULL, 0);
-        MQTT_PRINT("MQTT client initialized successfully\n");
+        client->offlineQueueOpen = (mqttOfflineQueueInit(&client->offlineQueue, config->offlineQueuePath,
+                config->offlineQueueSegmentSize, config->offlineQueueSegmentCount,
+                config->offlineQueueDropPolicy) == MQTTSuccess);
+        if (!client->offlineQueueOpen)
+        {
+            /* Not fatal, publishes simply fail while disconnected as before. */
+            MQTT_PRINT("Failed to open offline queue at %s\n", config->offlineQueuePath);
+        }
     }
+#endif
+
+    if (config->workerCount > 0)
+    {
+        status = mqttWorkerPoolInit(&client->workers, &client->context, config->workerCount,
+                config->workerQueueDepth, config->workerSlotSize, config->workerAckMode, deliverPublish, client,
+                config->workerStackSize, config->workerPriority);
+        if (status != MQTTSuccess)
+        {
+            MQTT_PRINT("Failed to start MQTT workers: %d\n", status);
+            releaseClient(client);
+            return status;
+        }
 
+        status = startFlowControl(client);
+        if (status != MQTTSuccess)
+        {
+            MQTT_PRINT("Invalid flow control watermarks: %d\n", status);
+            releaseClient(client);
+            return status;
+        }
+    }
+
+#if MQTT_DUPLEX_ENABLE
+    if (config->writerQueueDepth > 0)
+    {
+        status = mqttWriterInit(&client->writer, &client->context, config->writerQueueDepth, config->writerSlotSize,
+                writerSend, client, config->writerStackSize, config->writerPriority);
+        if (status != MQTTSuccess)
+        {
+            MQTT_PRINT("Failed to start MQTT writer: %d\n", status);
+            releaseClient(client);
+            return status;
+        }
+    }
+#endif
+
+    client->memoryUsage = mqttClientMemoryEstimate(config);
+    client->backoffMs = INITIAL_BACKOFF_MS;
+    client->retryAtMs = getCurrentTime();
+    client->initialized = true;
+
+    rt_enter_critical();
+    rt_list_insert_before(&clientList, &client->node);
+    rt_exit_critical();
+
+    MQTT_PRINT("MQTT client %s initialized, %u bytes\n", config->clientId, (unsigned int) client->memoryUsage);
     return MQTTSuccess;
 }
 
-MQTTStatus_t mqttConnect(NetworkContext_t *networkContext)
+void mqttClientDeinit(MQTTClient_t *client)
+{
+    if ((client == RT_NULL) || (!client->initialized))
+    {
+        return;
+    }
+
+    /* A thread still running the client must be gone before its memory is.
+     * Clearing the thread also tells mqttClientTask() not to release it twice. */
+    client->stopping = true;
+    if ((client->thread != RT_NULL) && (client->thread != rt_thread_self()))
+    {
+        client->thread = RT_NULL;
+        rt_sem_take(&client->exited, RT_WAITING_FOREVER);
+    }
+
+    /* An event loop must not service the client once it is freed. */
+    if (client->loop != RT_NULL)
+    {
+        (void) mqttEventLoopRemove(client->loop, client);
+    }
+
+    rt_enter_critical();
+    rt_list_remove(&client->node);
+    rt_exit_critical();
+
+    releaseClient(client);
+    client->initialized = false;
+}
+
+/* Packets may be sent once connected, or right behind a pipelined CONNECT. */
+static bool mqttCanSend(MQTTClient_t *client)
+{
+    return (client->context.connectStatus == MQTTConnected) || (client->context.connectStatus == MQTTConnackPending);
+}
+
+/* In full duplex mode the writer may be in the middle of a send on this socket. */
+static void closeTransport(MQTTClient_t *client)
+{
+#if MQTT_DUPLEX_ENABLE
+    rt_mutex_take(&client->sendLock, RT_WAITING_FOREVER);
+    transportClose(&client->network);
+    rt_mutex_release(&client->sendLock);
+#else
+    transportClose(&client->network);
+#endif
+}
+
+static void prepareConnectInfo(MQTTClient_t *client)
+{
+    MQTTConnectInfo_t *connectInfo = &client->connectInfo;
+
+    /* Configure connection information, it lives in the client because a
+     * non-blocking connect still reads it after the connect call returns. */
+    memset(connectInfo, 0, sizeof(*connectInfo));
+    connectInfo->clientIdentifierLength = strlen(client->config.clientId);
+    connectInfo->pClientIdentifier = client->config.clientId;
+    connectInfo->keepAliveSeconds = client->config.keepAliveSeconds;
+    connectInfo->cleanSession = true;
+    if (client->config.userName != RT_NULL)
+    {
+        connectInfo->pUserName = client->config.userName;
+        connectInfo->userNameLength = strlen(client->config.userName);
+    }
+    if (client->config.password != RT_NULL)
+    {
+        connectInfo->pPassword = client->config.password;
+        connectInfo->passwordLength = strlen(client->config.password);
+    }
+}
+
+/*
+ * Every CONNECT starts a clean session, which reuses packet IDs from the start.
+ * Acks still owed to the previous one could hit a new message, drop them. The
+ * offline queue records that were never acked are published again.
+ */
+static void startSession(MQTTClient_t *client)
+{
+#if MQTT_OFFLINE_QUEUE_ENABLE
+    if (client->offlineQueueOpen)
+    {
+        mqttOfflineQueueRewind(&client->offlineQueue);
+    }
+#endif
+
+    if (client->workers.initialized)
+    {
+        mqttWorkerPoolNewSession(&client->workers);
+    }
+
+    if (client->manualAcks != RT_NULL)
+    {
+        rt_mutex_take(&client->ackLock, RT_WAITING_FOREVER);
+        client->manualAckHead = 0;
+        client->manualAckCount = 0;
+        rt_mutex_release(&client->ackLock);
+    }
+}
+
+MQTTStatus_t mqttClientConnectAsync(MQTTClient_t *client)
 {
     MQTTStatus_t status;
-    MQTTConnectInfo_t connectInfo = { 0 };
+
+    prepareConnectInfo(client);
+    startSession(client);
+
+    /* DNS, TCP connect, CONNECT and CONNACK are all advanced by MQTT_ProcessLoop. */
+    if (transportConnectStart(&client->network, client->config.brokerAddress, client->config.brokerPort) < 0)
+    {
+        MQTT_PRINT("Failed to start connecting to broker\n");
+        transportClose(&client->network);
+        return MQTTSendFailed;
+    }
+
+    status = MQTT_ConnectAsync(&client->context, &client->connectInfo, NULL);
+    if (status != MQTTSuccess)
+    {
+        MQTT_PRINT("MQTT_ConnectAsync failed: %d\n", status);
+        transportClose(&client->network);
+        return status;
+    }
+
+    rt_kprintf("[%d] MQTT %s connecting\n", getCurrentTime(), client->config.clientId);
+    return MQTTSuccess;
+}
+
+MQTTStatus_t mqttClientConnect(MQTTClient_t *client)
+{
+#if MQTT_ASYNC_CONNECT
+    return mqttClientConnectAsync(client);
+#else
+    MQTTStatus_t status;
+    NetworkContext_t *networkContext = &client->network;
+    MQTTConnectInfo_t *connectInfo = &client->connectInfo;
     bool sessionPresent;
 
-    /* Configure connection information */
-    connectInfo.clientIdentifierLength = strlen(MQTT_CLIENT_ID);
-    connectInfo.pClientIdentifier = MQTT_CLIENT_ID;
-    connectInfo.keepAliveSeconds = MQTT_KEEP_ALIVE;
-    connectInfo.cleanSession = true;
+    prepareConnectInfo(client);
+    startSession(client);
 
     /* Establish TCP connection */
     networkContext->socket = socket(AF_INET, SOCK_STREAM, 0);
@@ -71,12 +451,12 @@ MQTTStatus_t mqttConnect(NetworkContext_t *networkContext)
     }
     struct sockaddr_in serverAddr = { 0 };
     serverAddr.sin_family = AF_INET;
-    serverAddr.sin_port = htons(MQTT_BROKER_PORT);
-    struct hostent *host = gethostbyname(MQTT_BROKER_ADDRESS);
+    serverAddr.sin_port = htons(client->config.brokerPort);
+    struct hostent *host = gethostbyname(client->config.brokerAddress);
     if (host == NULL || host->h_addr_list[0] == NULL)
     {
         MQTT_PRINT("Failed to resolve broker address\n");
-        closesocket(networkContext->socket);
+        transportClose(networkContext);
         return MQTTSendFailed;
     }
     serverAddr.sin_addr.s_addr = *(uint32_t *) host->h_addr_list[0];
@@ -84,45 +464,103 @@ MQTTStatus_t mqttConnect(NetworkContext_t *networkContext)
     if (connect(networkContext->socket, (struct sockaddr *) &serverAddr, sizeof(serverAddr)) < 0)
     {
         MQTT_PRINT("Failed to connect to broker\n");
-        closesocket(networkContext->socket);
+        transportClose(networkContext);
         return MQTTSendFailed;
     }
 
+#if MQTT_PIPELINED_CONNECT
+    /* Do not wait for CONNACK: subscriptions and queued publishes follow the
+     * CONNECT right away and the CONNACK is handled by MQTT_ProcessLoop. */
+    (void) sessionPresent;
+    status = MQTT_SendConnect(&client->context, connectInfo, NULL);
+    if ((status != MQTTSuccess) && (status != MQTTStatusConnected))
+    {
+        MQTT_PRINT("MQTT_SendConnect failed: %d\n", status);
+        transportClose(networkContext);
+        return status;
+    }
+
+    rt_kprintf("[%d] MQTT %s CONNECT sent\n", getCurrentTime(), client->config.clientId);
+#else
     /* MQTT connection */
-    status = MQTT_Connect(&mqttContext, &connectInfo, NULL, 10000, &sessionPresent);
+    status = MQTT_Connect(&client->context, connectInfo, NULL, 10000, &sessionPresent);
     if ((status != MQTTSuccess) && (status != MQTTStatusConnected))
     {
         MQTT_PRINT("MQTT_Connect failed: %d\n", status);
-        closesocket(networkContext->socket);
+        transportClose(networkContext);
         return status;
     }
 
     rt_kprintf("[%d] MQTT broker connected\n", getCurrentTime());
+#endif
     return MQTTSuccess;
+#endif
 }
 
-MQTTStatus_t mqttSubscribe(MQTTSubscribeInfo_t *subscribeInfo)
+MQTTStatus_t mqttClientSubscribe(MQTTClient_t *client, const MQTTSubscribeInfo_t *subscribeInfo, size_t count)
 {
     MQTTStatus_t status;
+    uint32_t packets = 0;
 
-    uint16_t packetId = MQTT_GetPacketId(&mqttContext);
-    status = MQTT_Subscribe(&mqttContext, subscribeInfo, 1, packetId);
+    /* Remember the filters first so they are restored after a reconnect even
+     * if the link is down right now. */
+    status = mqttSubscriptionAdd(&client->subscriptions, subscribeInfo, count);
+    if (status != MQTTSuccess)
+    {
+        MQTT_PRINT("Filters not registered: %d\n", status);
+        return status;
+    }
+
+    if (!mqttCanSend(client))
+    {
+        MQTT_PRINT("Not connected, %u filters will be subscribed on connect\n", (unsigned int) count);
+        return MQTTSuccess;
+    }
+
+    status = mqttSubscriptionSend(&client->subscriptions, &client->context, subscribeInfo, count, &packets);
     if (status != MQTTSuccess)
     {
         MQTT_PRINT("MQTT_Subscribe failed: %d\n", status);
         return status;
     }
 
-    MQTT_PRINT("Subscribed to topic: %s\n", MQTT_TOPIC_SUB);
+    MQTT_PRINT("Subscribed to %u filters in %u packets\n", (unsigned int) count, (unsigned int) packets);
     return MQTTSuccess;
 }
 
-MQTTStatus_t mqttPublish(MQTTPublishInfo_t *publishInfo)
+MQTTStatus_t mqttClientUnsubscribe(MQTTClient_t *client, const MQTTSubscribeInfo_t *subscribeInfo, size_t count)
+{
+    MQTTStatus_t status;
+
+    status = mqttSubscriptionRemove(&client->subscriptions, subscribeInfo, count);
+    if ((status != MQTTSuccess) || (!mqttCanSend(client)))
+    {
+        return status;
+    }
+
+    status = MQTT_Unsubscribe(&client->context, subscribeInfo, count, MQTT_GetPacketId(&client->context));
+    if (status != MQTTSuccess)
+    {
+        MQTT_PRINT("MQTT_Unsubscribe failed: %d\n", status);
+    }
+
+    return status;
+}
+
+static MQTTStatus_t publishNow(MQTTClient_t *client, MQTTPublishInfo_t *publishInfo)
 {
     MQTTStatus_t status;
+    uint16_t packetId = MQTT_GetPacketId(&client->context);
 
-    uint16_t packetId = MQTT_GetPacketId(&mqttContext);
-    status = MQTT_Publish(&mqttContext, publishInfo, packetId);
+    status = MQTT_Publish(&client->context, publishInfo, packetId);
+#if MQTT_OFFLINE_QUEUE_ENABLE
+    if (((status == MQTTSendFailed) || (status == MQTTStatusNotConnected) || (status == MQTTStatusDisconnectPending))
+            && client->offlineQueueOpen)
+    {
+        /* The link dropped under us, the session is cleaned on reconnect so queue a fresh copy. */
+        status = mqttOfflineQueueAppend(&client->offlineQueue, publishInfo);
+    }
+#endif
     if (status != MQTTSuccess)
     {
         MQTT_PRINT("MQTT_Publish failed: %d\n", status);
@@ -133,6 +571,236 @@ MQTTStatus_t mqttPublish(MQTTPublishInfo_t *publishInfo)
     return MQTTSuccess;
 }
 
+#if MQTT_DUPLEX_ENABLE
+/* Runs on the writer thread in full duplex mode. */
+static MQTTStatus_t writerSend(MQTTContext_t *pContext, MQTTPublishInfo_t *publishInfo, void *pUserData)
+{
+    MQTTClient_t *client = (MQTTClient_t *) pUserData;
+    MQTTStatus_t status;
+
+    (void) pContext;
+
+    /* A full outgoing window frees up as the reader handles PUBACKs, so wait
+     * for it here rather than dropping the message. The reader signals each
+     * freed record; the timeout notices a link that went down meanwhile. */
+    status = publishNow(client, publishInfo);
+    while ((status == MQTTNoMemory) && mqttCanSend(client) && !client->writer.stopping)
+    {
+        while (rt_sem_trytake(&client->window) == RT_EOK)
+        {
+        }
+        client->windowWaiting = true;
+        status = publishNow(client, publishInfo);
+        if (status == MQTTNoMemory)
+        {
+            (void) rt_sem_take(&client->window, MQTT_LOOP_CNT);
+            status = publishNow(client, publishInfo);
+        }
+        client->windowWaiting = false;
+    }
+
+    return status;
+}
+#endif
+
+MQTTStatus_t mqttClientPublish(MQTTClient_t *client, MQTTPublishInfo_t *publishInfo)
+{
+#if MQTT_OFFLINE_QUEUE_ENABLE
+    /* Keep publish order: while anything is queued, new messages go behind it. */
+    if (client->offlineQueueOpen
+            && ((!mqttCanSend(client)) || (mqttOfflineQueueDepth(&client->offlineQueue) > 0)))
+    {
+        MQTTStatus_t status = mqttOfflineQueueAppend(&client->offlineQueue, publishInfo);
+        if (status != MQTTSuccess)
+        {
+            MQTT_PRINT("Offline queue append failed: %d\n", status);
+            return status;
+        }
+
+        MQTT_PRINT("Queued message, depth %u\n", mqttOfflineQueueDepth(&client->offlineQueue));
+        return MQTTSuccess;
+    }
+#endif
+
+    if (client->writer.initialized)
+    {
+        return mqttWriterSubmit(&client->writer, publishInfo);
+    }
+
+    return publishNow(client, publishInfo);
+}
+
+MQTTStatus_t mqttClientRegisterHandler(MQTTClient_t *client, const char *topicFilter, MQTTPublishHandler_t handler,
+        void *pUserData)
+{
+    if (topicFilter == RT_NULL)
+    {
+        return MQTTBadParameter;
+    }
+
+    return mqttDispatcherRegister(&client->dispatcher, topicFilter, strlen(topicFilter), handler, pUserData);
+}
+
+MQTTStatus_t mqttClientUnregisterHandler(MQTTClient_t *client, const char *topicFilter, MQTTPublishHandler_t handler)
+{
+    if (topicFilter == RT_NULL)
+    {
+        return MQTTBadParameter;
+    }
+
+    return mqttDispatcherUnregister(&client->dispatcher, topicFilter, strlen(topicFilter), handler);
+}
+
+MQTTStatus_t mqttClientSetStaticTopics(MQTTClient_t *client, const MQTTStaticTopic_t *topics, uint16_t count)
+{
+    return mqttDispatcherSetStaticTopics(&client->dispatcher, topics, count);
+}
+
+void mqttClientGetDispatchCacheStats(MQTTClient_t *client, MQTTDispatchCacheStats_t *stats)
+{
+    mqttDispatcherGetCacheStats(&client->dispatcher, stats);
+}
+
+void mqttClientGetOfflineQueueStats(MQTTClient_t *client, MQTTOfflineQueueStats_t *stats)
+{
+#if MQTT_OFFLINE_QUEUE_ENABLE
+    if (client->offlineQueueOpen)
+    {
+        mqttOfflineQueueGetStats(&client->offlineQueue, stats);
+        return;
+    }
+#else
+    (void) client;
+#endif
+    memset(stats, 0, sizeof(*stats));
+}
+
+void mqttClientGetWorkerStats(MQTTClient_t *client, MQTTWorkerPoolStats_t *stats)
+{
+    mqttWorkerPoolGetStats(&client->workers, stats);
+}
+
+void mqttClientGetWriterStats(MQTTClient_t *client, MQTTWriterStats_t *stats)
+{
+    mqttWriterGetStats(&client->writer, stats);
+}
+
+#if MQTT_DUPLEX_ENABLE
+/* Core hooks of the full duplex mode, see core_mqtt_config.h. */
+void mqttStateLock(const struct MQTTContext *context)
+{
+    rt_mutex_take(&mqttClientFromContext((MQTTContext_t *) context)->stateLock, RT_WAITING_FOREVER);
+}
+
+void mqttStateUnlock(const struct MQTTContext *context)
+{
+    rt_mutex_release(&mqttClientFromContext((MQTTContext_t *) context)->stateLock);
+}
+
+void mqttSendLock(const struct MQTTContext *context)
+{
+    rt_mutex_take(&mqttClientFromContext((MQTTContext_t *) context)->sendLock, RT_WAITING_FOREVER);
+}
+
+void mqttSendUnlock(const struct MQTTContext *context)
+{
+    rt_mutex_release(&mqttClientFromContext((MQTTContext_t *) context)->sendLock);
+}
+#endif
+
+size_t mqttClientMemoryUsage(const MQTTClient_t *client)
+{
+    return client->initialized ? (sizeof(MQTTClient_t) + client->memoryUsage) : 0;
+}
+
+MQTTClient_t *mqttClientFromContext(MQTTContext_t *context)
+{
+    return rt_container_of(context, MQTTClient_t, context);
+}
+
+/* Walks the initialized clients, pass RT_NULL to get the first one. */
+MQTTClient_t *mqttClientNext(MQTTClient_t *client)
+{
+    rt_list_t *node = (client == RT_NULL) ? clientList.next : client->node.next;
+
+    return (node == &clientList) ? RT_NULL : rt_list_entry(node, MQTTClient_t, node);
+}
+
+MQTTClient_t *mqttDefaultClient(void)
+{
+    return &defaultClient;
+}
+
+/* The single connection API, kept as wrappers around the default client. */
+
+MQTTStatus_t mqttInit(NetworkContext_t *networkContext, MQTTEventCallback_t userCallback)
+{
+    MQTTClientConfig_t config;
+
+    /* The default client owns its network context, the argument is kept for source compatibility. */
+    (void) networkContext;
+
+    mqttClientConfigInit(&config);
+    config.eventCallback = userCallback;
+    return mqttClientInit(&defaultClient, &config);
+}
+
+MQTTStatus_t mqttConnect(NetworkContext_t *networkContext)
+{
+    (void) networkContext;
+    return mqttClientConnect(&defaultClient);
+}
+
+MQTTStatus_t mqttSubscribe(MQTTSubscribeInfo_t *subscribeInfo)
+{
+    return mqttClientSubscribe(&defaultClient, subscribeInfo, 1);
+}
+
+MQTTStatus_t mqttSubscribeMany(const MQTTSubscribeInfo_t *subscribeInfo, size_t count)
+{
+    return mqttClientSubscribe(&defaultClient, subscribeInfo, count);
+}
+
+MQTTStatus_t mqttUnsubscribe(MQTTSubscribeInfo_t *subscribeInfo)
+{
+    return mqttClientUnsubscribe(&defaultClient, subscribeInfo, 1);
+}
+
+MQTTStatus_t mqttUnsubscribeMany(const MQTTSubscribeInfo_t *subscribeInfo, size_t count)
+{
+    return mqttClientUnsubscribe(&defaultClient, subscribeInfo, count);
+}
+
+MQTTStatus_t mqttPublish(MQTTPublishInfo_t *publishInfo)
+{
+    return mqttClientPublish(&defaultClient, publishInfo);
+}
+
+MQTTStatus_t mqttRegisterHandler(const char *topicFilter, MQTTPublishHandler_t handler, void *pUserData)
+{
+    return mqttClientRegisterHandler(&defaultClient, topicFilter, handler, pUserData);
+}
+
+MQTTStatus_t mqttUnregisterHandler(const char *topicFilter, MQTTPublishHandler_t handler)
+{
+    return mqttClientUnregisterHandler(&defaultClient, topicFilter, handler);
+}
+
+MQTTStatus_t mqttSetStaticTopics(const MQTTStaticTopic_t *topics, uint16_t count)
+{
+    return mqttClientSetStaticTopics(&defaultClient, topics, count);
+}
+
+void mqttGetDispatchCacheStats(MQTTDispatchCacheStats_t *stats)
+{
+    mqttClientGetDispatchCacheStats(&defaultClient, stats);
+}
+
+void mqttGetOfflineQueueStats(MQTTOfflineQueueStats_t *stats)
+{
+    mqttClientGetOfflineQueueStats(&defaultClient, stats);
+}
+
 const char *mqttStatus(MQTTStatus_t status)
 {
     const char *const statusStrings[] = {
@@ -162,6 +830,49 @@ const char *mqttStatus(MQTTStatus_t status)
     return "Unknown";
 }
 
+/* Hands a publish to its registered handlers, on the receive thread or on a worker. */
+static void deliverPublish(MQTTContext_t *pContext, MQTTDeserializedInfo_t *pDeserializedInfo, void *pUserData)
+{
+    MQTTClient_t *client = pUserData;
+    MQTTPublishInfo_t *pPublishInfo = pDeserializedInfo->pPublishInfo;
+
+    if (mqttDispatcherDispatch(&client->dispatcher, pContext, pDeserializedInfo) > 0)
+    {
+        return;
+    }
+    rt_kprintf("Received message on topic '%.*s': %.*s\n", pPublishInfo->topicNameLength, pPublishInfo->pTopicName,
+            pPublishInfo->payloadLength, (const char *) pPublishInfo->pPayload);
+}
+
+/* Core callback of every client: notes the acks that free an outgoing record,
+ * then hands the packet to the configured event callback. */
+static void clientEventCallback(MQTTContext_t *pContext, MQTTPacketInfo_t *pPacketInfo,
+        MQTTDeserializedInfo_t *pDeserializedInfo)
+{
+    MQTTClient_t *client = mqttClientFromContext(pContext);
+    uint8_t type = pPacketInfo->type & 0xF0U;
+
+    if ((type == MQTT_PACKET_TYPE_PUBACK) || (type == MQTT_PACKET_TYPE_PUBCOMP))
+    {
+#if MQTT_OFFLINE_QUEUE_ENABLE
+        /* Queued records are only committed once the broker has them. */
+        if (client->offlineQueueOpen)
+        {
+            mqttOfflineQueueAck(&client->offlineQueue, pDeserializedInfo->packetIdentifier);
+        }
+#endif
+#if MQTT_DUPLEX_ENABLE
+        if (client->windowWaiting)
+        {
+            client->windowWaiting = false;
+            rt_sem_release(&client->window);
+        }
+#endif
+    }
+
+    client->config.eventCallback(pContext, pPacketInfo, pDeserializedInfo);
+}
+
 static void mqttEventCallback(MQTTContext_t *pContext, MQTTPacketInfo_t *pPacketInfo,
         MQTTDeserializedInfo_t *pDeserializedInfo)
 {
@@ -171,7 +882,8 @@ static void mqttEventCallback(MQTTContext_t *pContext, MQTTPacketInfo_t *pPacket
         return;
     }
 
-    switch (pPacketInfo->type)
+    /* PUBLISH carries its flags in the low nibble of the type. */
+    switch (pPacketInfo->type & 0xF0U)
     {
         case MQTT_PACKET_TYPE_PUBLISH:
         {
@@ -180,14 +892,24 @@ static void mqttEventCallback(MQTTContext_t *pContext, MQTTPacketInfo_t *pPacket
                 rt_kprintf("Error: Invalid publish info\n");
                 return;
             }
-            MQTTPublishInfo_t *pPublishInfo = pDeserializedInfo->pPublishInfo;
-            rt_kprintf("Received message on topic '%.*s': %.*s\n", pPublishInfo->topicNameLength, pPublishInfo->pTopicName,
-                    pPublishInfo->payloadLength, (const char *) pPublishInfo->pPayload);
+            MQTTClient_t *client = mqttClientFromContext(pContext);
+            if (client->workers.initialized)
+            {
+                (void) mqttWorkerPoolSubmit(&client->workers, pDeserializedInfo);
+                break;
+            }
+            deliverPublish(pContext, pDeserializedInfo, client);
             break;
         }
+        case MQTT_PACKET_TYPE_CONNACK:
+            rt_kprintf("[%d] MQTT broker connected\n", getCurrentTime());
+            break;
         case MQTT_PACKET_TYPE_SUBACK:
             rt_kprintf("Subscription ACK\n");
             break;
+        case MQTT_PACKET_TYPE_UNSUBACK:
+            rt_kprintf("Unsubscription ACK\n");
+            break;
         case MQTT_PACKET_TYPE_PUBACK:
             rt_kprintf("Publish ACK\n"); // QoS0 messages do not trigger this callback.
             break;
@@ -196,41 +918,209 @@ static void mqttEventCallback(MQTTContext_t *pContext, MQTTPacketInfo_t *pPacket
     }
 }
 
-void mqttClientTask(void *parameter)
+/*
+ * Queues the ack of a message whose handler set deferAck. Safe from any
+ * thread; the ack is sent by the thread running the client on its next turn.
+ */
+MQTTStatus_t mqttClientAck(MQTTClient_t *client, uint16_t packetId, MQTTQoS_t qos)
+{
+    MQTTStatus_t status = MQTTSuccess;
+    size_t index;
+
+    if ((client == RT_NULL) || (!client->initialized) || (client->manualAcks == RT_NULL) || (packetId == 0)
+            || (qos == MQTTQoS0))
+    {
+        return MQTTBadParameter;
+    }
+
+    rt_mutex_take(&client->ackLock, RT_WAITING_FOREVER);
+    if (client->manualAckCount == client->config.incomingPublishCount)
+    {
+        status = MQTTNoMemory;
+    }
+    else
+    {
+        index = (client->manualAckHead + client->manualAckCount) % client->config.incomingPublishCount;
+        client->manualAcks[index].packetId = packetId;
+        client->manualAcks[index].qos = qos;
+        client->manualAckCount++;
+    }
+    rt_mutex_release(&client->ackLock);
+
+    return status;
+}
+
+/* Sends the acks finished by workers and by mqttClientAck() callers. */
+static void flushAcks(MQTTClient_t *client)
 {
+    MQTTWorkerAck_t ack;
     MQTTStatus_t status;
-    uint32_t retryCount = 0;
-    uint32_t backoffMs = INITIAL_BACKOFF_MS;
-    bool isConnected = false;
 
-    if (mqttInit(&networkContext, MQTT_USER_CALLBACK) != MQTTSuccess)
+    if (client->workers.initialized)
+    {
+        (void) mqttWorkerPoolFlushAcks(&client->workers);
+    }
+
+    if (client->manualAcks == RT_NULL)
     {
-        MQTT_PRINT("MQTT initialization failed\n");
         return;
     }
 
     while (1)
     {
-        if (networkContext.socket >= 0)
+        rt_mutex_take(&client->ackLock, RT_WAITING_FOREVER);
+        if (client->manualAckCount == 0)
         {
-            closesocket(networkContext.socket);
-            networkContext.socket = -1;
+            rt_mutex_release(&client->ackLock);
+            break;
         }
+        ack = client->manualAcks[client->manualAckHead];
+        client->manualAckHead = (client->manualAckHead + 1U) % client->config.incomingPublishCount;
+        client->manualAckCount--;
+        rt_mutex_release(&client->ackLock);
 
-        status = mqttConnect(&networkContext);
+        /* Acks queued before a reconnect were dropped by startSession(). */
+        status = MQTT_AckIncomingPublish(&client->context, ack.packetId, ack.qos);
+        if (status != MQTTSuccess)
+        {
+            MQTT_PRINT("Dropped ack of message %u: %d (%s)\n", ack.packetId, status, mqttStatus(status));
+        }
+    }
+}
+
+static void scheduleRetry(MQTTClient_t *client)
+{
+    if (client->retryCount++ >= MAX_RETRY_ATTEMPTS)
+    {
+        MQTT_PRINT("Maximum retry attempts reached for %s, resetting retry count after 30s\n",
+                client->config.clientId);
+        client->retryAtMs = getCurrentTime() + 30000U;
+        client->retryCount = 0;
+        client->backoffMs = INITIAL_BACKOFF_MS;
+    }
+    else
+    {
+        client->retryAtMs = getCurrentTime() + client->backoffMs;
+        client->backoffMs = MIN(client->backoffMs * 2, MAX_BACKOFF_MS);
+    }
+}
+
+/*
+ * Runs one non-blocking step of a client: a due reconnect, the subscription
+ * restore, an offline queue drain and the process loop. Meant for event loops
+ * that drive many clients from one thread, see mqtt_event_loop.h.
+ */
+MQTTStatus_t mqttClientService(MQTTClient_t *client)
+{
+    MQTTStatus_t status;
+    uint32_t burst;
+
+    if (client->context.connectStatus == MQTTNotConnected)
+    {
+        if ((int32_t) (getCurrentTime() - client->retryAtMs) < 0)
+        {
+            return MQTTSuccess;
+        }
+
+        closeTransport(client);
+        client->restored = false;
+        status = mqttClientConnectAsync(client);
+        if (status != MQTTSuccess)
+        {
+            scheduleRetry(client);
+        }
+        return status;
+    }
+
+    if (!client->restored && mqttCanSend(client))
+    {
+        status = mqttSubscriptionRestore(&client->subscriptions, &client->context);
+        if (status != MQTTSuccess)
+        {
+            MQTT_PRINT("Restoring subscriptions failed: %d (%s)\n", status, mqttStatus(status));
+        }
+        client->restored = true;
+    }
+
+#if MQTT_OFFLINE_QUEUE_ENABLE
+    if (client->offlineQueueOpen && mqttCanSend(client) && (mqttOfflineQueueDepth(&client->offlineQueue) > 0))
+    {
+        /* Never waits for acks here, that would stall every other client of the loop. */
+        status = mqttOfflineQueueDrainSome(&client->offlineQueue, &client->context, MQTT_EVENT_LOOP_DRAIN_BURST);
+        if (status != MQTTSuccess)
+        {
+            MQTT_PRINT("Offline queue drain stopped: %d (%s)\n", status, mqttStatus(status));
+        }
+    }
+#endif
+
+    flushAcks(client);
+
+    /* One call handles one packet, keep going while whole packets are buffered. */
+    burst = 0;
+    do
+    {
+        status = MQTT_ProcessLoop(&client->context);
+    } while ((status == MQTTSuccess) && (client->context.index > 0) && (++burst < MQTT_EVENT_LOOP_BURST));
+
+    if ((status != MQTTSuccess) && (status != MQTTNeedMoreBytes))
+    {
+        MQTT_PRINT("MQTT_ProcessLoop failed for %s: %d (%s)\n", client->config.clientId, status, mqttStatus(status));
+        (void) MQTT_Disconnect(&client->context);
+        closeTransport(client);
+        scheduleRetry(client);
+        return status;
+    }
+
+    if (client->context.connectStatus == MQTTConnected)
+    {
+        client->retryCount = 0;
+        client->backoffMs = INITIAL_BACKOFF_MS;
+    }
+
+    return MQTTSuccess;
+}
+
+/* Sleeps in short steps so that mqttClientStop() is seen during a backoff. */
+static void runDelay(MQTTClient_t *client, uint32_t ms)
+{
+    uint32_t step;
+
+    while ((ms > 0) && !client->stopping)
+    {
+        step = MIN(ms, MQTT_LOOP_CNT);
+        rt_thread_mdelay(step);
+        ms -= step;
+    }
+}
+
+void mqttClientRun(void *parameter)
+{
+    MQTTClient_t *client = parameter;
+    MQTTStatus_t status;
+    uint32_t retryCount = 0;
+    uint32_t backoffMs = INITIAL_BACKOFF_MS;
+    bool isConnected = false;
+    bool restored;
+
+    while (!client->stopping)
+    {
+        closeTransport(client);
+
+        status = mqttClientConnect(client);
         if (status != MQTTSuccess)
         {
             MQTT_PRINT("Connection failed: %d (%s), retrying in %d ms\n", status, mqttStatus(status), backoffMs);
             if (retryCount++ >= MAX_RETRY_ATTEMPTS)
             {
                 MQTT_PRINT("Maximum retry attempts reached, resetting retry count after 60s\n");
-                rt_thread_mdelay(30000);
+                runDelay(client, 30000);
                 retryCount = 0;
                 backoffMs = INITIAL_BACKOFF_MS;
             }
             else
             {
-                rt_thread_mdelay(backoffMs);
+                runDelay(client, backoffMs);
                 backoffMs = MIN(backoffMs * 2, MAX_BACKOFF_MS);
             }
             continue;
@@ -239,23 +1129,76 @@ void mqttClientTask(void *parameter)
         isConnected = true;
         retryCount = 0;
         backoffMs = INITIAL_BACKOFF_MS;
+        restored = false;
 
-        while (1)
+        while (!client->stopping)
         {
-            status = MQTT_ProcessLoop(&mqttContext);
+            /* The session is clean, so every registered filter must be sent again
+             * as soon as CONNECT is out. With a pipelined or non-blocking connect
+             * this goes out before the CONNACK is back. */
+            if (!restored && mqttCanSend(client))
+            {
+                status = mqttSubscriptionRestore(&client->subscriptions, &client->context);
+                if (status != MQTTSuccess)
+                {
+                    MQTT_PRINT("Restoring subscriptions failed: %d (%s)\n", status, mqttStatus(status));
+                }
+                restored = true;
+            }
+
+#if MQTT_OFFLINE_QUEUE_ENABLE
+            if (client->offlineQueueOpen && mqttCanSend(client) && (mqttOfflineQueueDepth(&client->offlineQueue) > 0))
+            {
+                status = mqttOfflineQueueDrain(&client->offlineQueue, &client->context);
+                if (status != MQTTSuccess)
+                {
+                    MQTT_PRINT("Offline queue drain stopped: %d (%s)\n", status, mqttStatus(status));
+                }
+            }
+#endif
+
+            flushAcks(client);
+
+            status = MQTT_ProcessLoop(&client->context);
             if (status != MQTTSuccess && status != MQTTNeedMoreBytes)
             {
                 MQTT_PRINT("MQTT_ProcessLoop failed: %d (%s)\n", status, mqttStatus(status));
-                status = MQTT_Disconnect(&mqttContext);
+                status = MQTT_Disconnect(&client->context);
                 break;
             }
 
+#if MQTT_DUPLEX_ENABLE
+            /* Publishes leave on the writer thread, so this task only has to
+             * wake up for incoming data and keep-alive. A whole packet may
+             * still be buffered after the one just handled. */
+            if ((status == MQTTSuccess) && (client->context.index > 0))
+            {
+                continue;
+            }
+            if ((client->context.connectStatus != MQTTConnecting) && !MQTT_IsReceivePaused(&client->context))
+            {
+                (void) transportWaitReadable(&client->network, MQTT_LOOP_CNT);
+            }
+            else
+            {
+                rt_thread_mdelay(MQTT_LOOP_CNT);
+            }
+#else
+#if MQTT_OFFLINE_QUEUE_ENABLE
+            /* A drain that stopped at a full window goes on once acks are in. */
+            if (client->offlineQueueOpen && mqttCanSend(client) && (mqttOfflineQueueDepth(&client->offlineQueue) > 0))
+            {
+                (void) transportWaitReadable(&client->network, MQTT_LOOP_CNT);
+                continue;
+            }
+#endif
             rt_thread_mdelay(MQTT_LOOP_CNT);
+#endif
         }
 
-        if (isConnected && networkContext.socket >= 0)
+        if (isConnected && client->network.socket >= 0)
         {
-            status = MQTT_Disconnect(&mqttContext);
+            status = MQTT_Disconnect(&client->context);
             if (status != MQTTSuccess)
             {
                 MQTT_PRINT("MQTT_Disconnect failed: %d (%s)\n", status, mqttStatus(status));
@@ -263,21 +1206,73 @@ void mqttClientTask(void *parameter)
             isConnected = false;
         }
 
-        if (networkContext.socket >= 0)
+        closeTransport(client);
+
+        if (client->stopping)
         {
-            closesocket(networkContext.socket);
-            networkContext.socket = -1;
+            break;
         }
 
         MQTT_PRINT("MQTT connection lost, preparing to reconnect in %d ms\n", backoffMs);
-        rt_thread_mdelay(backoffMs);
+        runDelay(client, backoffMs);
         backoffMs = MIN(backoffMs * 2, MAX_BACKOFF_MS);
     }
 
-    if (mqttBuffer.pBuffer != RT_NULL)
+    closeTransport(client);
+    rt_sem_release(&client->exited);
+}
+
+MQTTStatus_t mqttClientStart(MQTTClient_t *client)
+{
+    char name[RT_NAME_MAX];
+
+    if ((client == RT_NULL) || (!client->initialized) || (client->thread != RT_NULL))
+    {
+        return MQTTBadParameter;
+    }
+
+    rt_snprintf(name, sizeof(name), "mq%s", client->config.clientId);
+    client->thread = rt_thread_create(name, mqttClientRun, client, client->config.stackSize, client->config.priority,
+            MQTT_CLIENT_TIMESLICE);
+    if (client->thread == RT_NULL)
+    {
+        MQTT_PRINT("Failed to create MQTT client thread\n");
+        return MQTTNoMemory;
+    }
+
+    rt_thread_startup(client->thread);
+    return MQTTSuccess;
+}
+
+/*
+ * Asks mqttClientRun() to disconnect and return, without waiting for it.
+ * mqttClientDeinit() does both and waits.
+ */
+void mqttClientStop(MQTTClient_t *client)
+{
+    if ((client != RT_NULL) && client->initialized)
+    {
+        client->stopping = true;
+    }
+}
+
+void mqttClientTask(void *parameter)
+{
+    (void) parameter;
+
+    if (mqttInit(RT_NULL, MQTT_USER_CALLBACK) != MQTTSuccess)
+    {
+        MQTT_PRINT("MQTT initialization failed\n");
+        return;
+    }
+
+    defaultClient.thread = rt_thread_self();
+    mqttClientRun(&defaultClient);
+
+    /* Stopped by mqttClientStop(), or by a mqttClientDeinit() that already released it. */
+    if (defaultClient.thread == rt_thread_self())
     {
-        rt_free(mqttBuffer.pBuffer);
-        mqttBuffer.pBuffer = RT_NULL;
+        mqttClientDeinit(&defaultClient);
     }
     MQTT_PRINT("MQTT client exited\n");
 }
@@ -21,6 +21,11 @@
 #include <sys/select.h>  // 添加select相关定义
 #include <unistd.h>      // 添加close等系统调用定义
 #include "port.h"
+#include "mqtt_offline_queue.h"
+#include "mqtt_dispatch.h"
+#include "mqtt_subscription.h"
+#include "mqtt_worker_pool.h"
+#include "mqtt_writer.h"
 #include <rtdbg.h>
 #include <core_mqtt_config.h>
 
@@ -32,10 +37,156 @@
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
+/*
+ * Client handle.
+ *
+ * Everything one broker connection needs lives in an MQTTClient_t: the core
+ * context, network buffer, QoS state records, subscription registry, topic
+ * dispatcher, offline queue and the task running it. All arrays are sized
+ * from an MQTTClientConfig_t by mqttClientInit(), so the number of
+ * connections in an image is bounded by RAM rather than by code copies.
+ * mqttClientConfigInit() fills a config with the core_mqtt_config.h defaults.
+ *
+ * The mqtt* functions without a client argument act on a built-in default
+ * client and keep the single connection API working.
+ *
+ * A handler running on the receive thread may take over acknowledging a QoS 1
+ * or 2 message by setting pDeserializedInfo->deferAck, and call
+ * mqttClientAck() from any thread once the message is processed. Receiving
+ * pauses while deferredAckMax acks are outstanding. Each reconnect starts a
+ * clean session that reuses packet IDs, so acks still queued then are
+ * dropped, and a message received before it must not be acked after it.
+ * Handlers on workers use MQTTWorkerAckOnComplete instead. With workers,
+ * receiving also pauses while a worker queue is above flowHighWatermark,
+ * until it drains to flowLowWatermark, so a flood backs up in the broker's
+ * TCP window instead of blocking the receive thread.
+ *
+ * With MQTT_DUPLEX_ENABLE the client task only receives: mqttClientPublish()
+ * queues the message for a writer thread (see mqtt_writer.h), and the core
+ * hooks serialize the state engine and the socket's send side.
+ */
+
+typedef struct MQTTClientConfig
+{
+    const char *brokerAddress;
+    uint16_t brokerPort;
+    const char *clientId;
+    const char *userName;               /* RT_NULL for none. */
+    const char *password;               /* RT_NULL for none. */
+    uint16_t keepAliveSeconds;
+    MQTTEventCallback_t eventCallback;
+
+    size_t bufferSize;                  /* Network buffer, bounds the incoming packet size. */
+    size_t outgoingPublishCount;        /* QoS 1/2 publishes in flight. */
+    size_t incomingPublishCount;        /* QoS 1/2 messages not acked yet, 0 for QoS 0 only. */
+    size_t deferredAckMax;              /* Acks handlers may defer, 0 for one per incoming publish. */
+    size_t subscriptionMax;
+    size_t subscribePacketMax;
+    uint16_t dispatchMaxNodes;
+    uint16_t dispatchMaxHandlers;
+    uint16_t dispatchMaxLevels;
+    uint16_t dispatchCacheSize;         /* 0 disables the cache. */
+    uint16_t dispatchCacheTopicMax;
+    const char *offlineQueuePath;       /* RT_NULL disables the offline queue. */
+    uint32_t offlineQueueSegmentSize;
+    uint32_t offlineQueueSegmentCount;
+    MQTTOfflineDropPolicy_t offlineQueueDropPolicy;
+    uint16_t workerCount;               /* 0 runs handlers on the receive thread. */
+    uint16_t workerQueueDepth;
+    size_t workerSlotSize;
+    MQTTWorkerAckMode_t workerAckMode;
+    uint32_t workerStackSize;
+    uint8_t workerPriority;
+    uint16_t flowHighWatermark;         /* Worker queue depth that pauses receiving, 0 for 3/4 of it. */
+    uint16_t flowLowWatermark;          /* Depth that resumes receiving, 0 with a derived high mark for 1/4. */
+    uint16_t writerQueueDepth;          /* Full duplex only, 0 publishes on the calling thread. */
+    size_t writerSlotSize;
+    uint32_t writerStackSize;
+    uint8_t writerPriority;
+
+    uint32_t stackSize;                 /* Stack of the task started by mqttClientStart(). */
+    uint8_t priority;
+} MQTTClientConfig_t;
+
+typedef struct MQTTClient
+{
+    MQTTContext_t context;
+    MQTTClientConfig_t config;
+    MQTTFixedBuffer_t buffer;
+    TransportInterface_t transport;
+    NetworkContext_t network;
+    MQTTConnectInfo_t connectInfo;
+    MQTTPubAckInfo_t *outgoingPublishes;
+    MQTTPubAckInfo_t *incomingPublishes;
+    MQTTDispatcher_t dispatcher;
+    MQTTSubscriptionRegistry_t subscriptions;
+    MQTTOfflineQueue_t offlineQueue;
+    bool offlineQueueOpen;
+    MQTTWorkerPool_t workers;
+    MQTTWorkerAck_t *manualAcks;        /* Ring of mqttClientAck() calls, one per incoming publish. */
+    size_t manualAckHead;
+    size_t manualAckCount;
+    struct rt_mutex ackLock;
+    MQTTWriter_t writer;
+    struct rt_mutex stateLock;          /* Full duplex: core state engine. */
+    struct rt_mutex sendLock;           /* Full duplex: send side of the socket. */
+    struct rt_semaphore window;         /* Full duplex: an ack freed an outgoing record. */
+    volatile bool windowWaiting;        /* Full duplex: the writer waits on window. */
+    size_t memoryUsage;                 /* Bytes allocated for this client at init. */
+
+    /* Reconnect state of mqttClientService(). */
+    bool restored;
+    uint32_t retryCount;
+    uint32_t backoffMs;
+    uint32_t retryAtMs;
+
+    struct MQTTEventLoop *loop;         /* Event loop the client was added to, if any. */
+    rt_thread_t thread;                 /* Thread running mqttClientRun(), if any. */
+    struct rt_semaphore exited;         /* Released when mqttClientRun() returns. */
+    volatile bool stopping;
+    rt_list_t node;
+    bool initialized;
+} MQTTClient_t;
+
+void mqttClientConfigInit(MQTTClientConfig_t *config);
+size_t mqttClientMemoryEstimate(const MQTTClientConfig_t *config);
+MQTTStatus_t mqttClientInit(MQTTClient_t *client, const MQTTClientConfig_t *config);
+void mqttClientDeinit(MQTTClient_t *client);
+MQTTStatus_t mqttClientConnect(MQTTClient_t *client);
+MQTTStatus_t mqttClientConnectAsync(MQTTClient_t *client);
+MQTTStatus_t mqttClientService(MQTTClient_t *client);
+MQTTStatus_t mqttClientSubscribe(MQTTClient_t *client, const MQTTSubscribeInfo_t *subscribeInfo, size_t count);
+MQTTStatus_t mqttClientUnsubscribe(MQTTClient_t *client, const MQTTSubscribeInfo_t *subscribeInfo, size_t count);
+MQTTStatus_t mqttClientPublish(MQTTClient_t *client, MQTTPublishInfo_t *publishInfo);
+MQTTStatus_t mqttClientAck(MQTTClient_t *client, uint16_t packetId, MQTTQoS_t qos);
+MQTTStatus_t mqttClientRegisterHandler(MQTTClient_t *client, const char *topicFilter, MQTTPublishHandler_t handler,
+        void *pUserData);
+MQTTStatus_t mqttClientUnregisterHandler(MQTTClient_t *client, const char *topicFilter, MQTTPublishHandler_t handler);
+MQTTStatus_t mqttClientSetStaticTopics(MQTTClient_t *client, const MQTTStaticTopic_t *topics, uint16_t count);
+void mqttClientGetDispatchCacheStats(MQTTClient_t *client, MQTTDispatchCacheStats_t *stats);
+void mqttClientGetOfflineQueueStats(MQTTClient_t *client, MQTTOfflineQueueStats_t *stats);
+void mqttClientGetWorkerStats(MQTTClient_t *client, MQTTWorkerPoolStats_t *stats);
+void mqttClientGetWriterStats(MQTTClient_t *client, MQTTWriterStats_t *stats);
+size_t mqttClientMemoryUsage(const MQTTClient_t *client);
+MQTTClient_t *mqttClientFromContext(MQTTContext_t *context);
+MQTTClient_t *mqttClientNext(MQTTClient_t *client);
+MQTTStatus_t mqttClientStart(MQTTClient_t *client);
+void mqttClientStop(MQTTClient_t *client);
+void mqttClientRun(void *parameter);
+MQTTClient_t *mqttDefaultClient(void);
+
 MQTTStatus_t mqttInit(NetworkContext_t *networkContext, MQTTEventCallback_t userCallback);
 MQTTStatus_t mqttConnect(NetworkContext_t *networkContext);
 MQTTStatus_t mqttSubscribe(MQTTSubscribeInfo_t *subscribeInfo);
+MQTTStatus_t mqttSubscribeMany(const MQTTSubscribeInfo_t *subscribeInfo, size_t count);
+MQTTStatus_t mqttUnsubscribe(MQTTSubscribeInfo_t *subscribeInfo);
+MQTTStatus_t mqttUnsubscribeMany(const MQTTSubscribeInfo_t *subscribeInfo, size_t count);
 MQTTStatus_t mqttPublish(MQTTPublishInfo_t *publishInfo);
+MQTTStatus_t mqttRegisterHandler(const char *topicFilter, MQTTPublishHandler_t handler, void *pUserData);
+MQTTStatus_t mqttUnregisterHandler(const char *topicFilter, MQTTPublishHandler_t handler);
+MQTTStatus_t mqttSetStaticTopics(const MQTTStaticTopic_t *topics, uint16_t count);
+void mqttGetDispatchCacheStats(MQTTDispatchCacheStats_t *stats);
+void mqttGetOfflineQueueStats(MQTTOfflineQueueStats_t *stats);
 void mqttClientTask(void *parameter);
 
 #endif /* APPLICATIONS_FIREMQTT_PORT_MQTT_USR_API_H_ */
@@ -0,0 +1,1030 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+#define DBG_TAG "MQTT"
+#define DBG_LVL DBG_LOG
+
+#include "mqtt_api.h"
+#include "mqtt_dispatch.h"
+
+#define ROOT_NODE           0U
+#define INVALID_INDEX       MQTT_DISPATCH_INVALID_INDEX
+
+#define STATIC_SEED_TRIES   256U
+#define STATIC_MAX_SLOTS    0x8000U
+
+static uint32_t levelHash(const char *level, uint16_t length)
+{
+    uint32_t hash = 2166136261UL;
+    uint16_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        hash ^= (uint8_t) level[i];
+        hash *= 16777619UL;
+    }
+
+    return hash;
+}
+
+static uint32_t seededHash(uint32_t seed, const char *topic, uint16_t length)
+{
+    uint32_t hash = 2166136261UL ^ seed;
+    uint16_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        hash ^= (uint8_t) topic[i];
+        hash *= 16777619UL;
+    }
+
+    /* Final mix so the low bits used as the slot depend on every byte. */
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6DUL;
+    hash ^= hash >> 12;
+
+    return hash;
+}
+
+/* Length of the level starting at offset, the separator is not included. */
+static uint16_t levelLength(const char *topic, uint16_t topicLength, uint16_t offset)
+{
+    const char *end = memchr(&topic[offset], '/', topicLength - offset);
+
+    return (end == RT_NULL) ? (uint16_t) (topicLength - offset) : (uint16_t) (end - &topic[offset]);
+}
+
+/* '+' and '#' must fill a whole level and '#' may only be the last level. */
+static bool validateFilter(const char *filter, uint16_t filterLength)
+{
+    uint16_t i;
+
+    if ((filter == RT_NULL) || (filterLength == 0))
+    {
+        return false;
+    }
+
+    for (i = 0; i < filterLength; i++)
+    {
+        if ((filter[i] == '+') || (filter[i] == '#'))
+        {
+            if (((i > 0) && (filter[i - 1] != '/')) || ((i + 1 < filterLength) && (filter[i + 1] != '/')))
+            {
+                return false;
+            }
+            if ((filter[i] == '#') && (i + 1 != filterLength))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static void resetNode(MQTTDispatchNode_t *node, uint16_t parent)
+{
+    node->pLevel = RT_NULL;
+    node->levelLength = 0;
+    node->levelHash = 0;
+    node->parent = parent;
+    node->firstChild = INVALID_INDEX;
+    node->nextSibling = INVALID_INDEX;
+    node->plusChild = INVALID_INDEX;
+    node->handlers = INVALID_INDEX;
+    node->hashHandlers = INVALID_INDEX;
+}
+
+static uint16_t allocNode(MQTTDispatcher_t *dispatcher, uint16_t parent)
+{
+    uint16_t index = dispatcher->freeNodes;
+
+    if (index != INVALID_INDEX)
+    {
+        dispatcher->freeNodes = dispatcher->nodes[index].nextSibling;
+        resetNode(&dispatcher->nodes[index], parent);
+    }
+
+    return index;
+}
+
+static uint16_t findLiteralChild(const MQTTDispatcher_t *dispatcher, uint16_t parent, const char *level,
+        uint16_t length, uint32_t hash)
+{
+    uint16_t index = dispatcher->nodes[parent].firstChild;
+    const MQTTDispatchNode_t *node;
+
+    while (index != INVALID_INDEX)
+    {
+        node = &dispatcher->nodes[index];
+        if ((node->levelHash == hash) && (node->levelLength == length) && (memcmp(node->pLevel, level, length) == 0))
+        {
+            break;
+        }
+        index = node->nextSibling;
+    }
+
+    return index;
+}
+
+static uint16_t getOrAddChild(MQTTDispatcher_t *dispatcher, uint16_t parent, const char *level, uint16_t length)
+{
+    MQTTDispatchNode_t *node;
+    uint32_t hash;
+    uint16_t index;
+
+    if ((length == 1) && (level[0] == '+'))
+    {
+        index = dispatcher->nodes[parent].plusChild;
+        if (index == INVALID_INDEX)
+        {
+            index = allocNode(dispatcher, parent);
+            if (index != INVALID_INDEX)
+            {
+                dispatcher->nodes[parent].plusChild = index;
+            }
+        }
+        return index;
+    }
+
+    hash = levelHash(level, length);
+    index = findLiteralChild(dispatcher, parent, level, length, hash);
+    if (index != INVALID_INDEX)
+    {
+        return index;
+    }
+
+    index = allocNode(dispatcher, parent);
+    if (index == INVALID_INDEX)
+    {
+        return index;
+    }
+
+    node = &dispatcher->nodes[index];
+    node->pLevel = rt_malloc(length + 1U);
+    if (node->pLevel == RT_NULL)
+    {
+        node->nextSibling = dispatcher->freeNodes;
+        dispatcher->freeNodes = index;
+        return INVALID_INDEX;
+    }
+    memcpy(node->pLevel, level, length);
+    node->pLevel[length] = '\0';
+    node->levelLength = length;
+    node->levelHash = hash;
+    node->nextSibling = dispatcher->nodes[parent].firstChild;
+    dispatcher->nodes[parent].firstChild = index;
+
+    return index;
+}
+
+/* Release empty nodes from index up towards the root. */
+static void pruneNodes(MQTTDispatcher_t *dispatcher, uint16_t index)
+{
+    MQTTDispatchNode_t *node, *parent;
+    uint16_t *link;
+
+    while (index != ROOT_NODE)
+    {
+        node = &dispatcher->nodes[index];
+        if ((node->firstChild != INVALID_INDEX) || (node->plusChild != INVALID_INDEX)
+                || (node->handlers != INVALID_INDEX) || (node->hashHandlers != INVALID_INDEX))
+        {
+            break;
+        }
+
+        parent = &dispatcher->nodes[node->parent];
+        if (parent->plusChild == index)
+        {
+            parent->plusChild = INVALID_INDEX;
+        }
+        else
+        {
+            link = &parent->firstChild;
+            while (*link != index)
+            {
+                link = &dispatcher->nodes[*link].nextSibling;
+            }
+            *link = node->nextSibling;
+        }
+
+        if (node->pLevel != RT_NULL)
+        {
+            rt_free(node->pLevel);
+            node->pLevel = RT_NULL;
+        }
+        node->nextSibling = dispatcher->freeNodes;
+        dispatcher->freeNodes = index;
+        index = node->parent;
+    }
+}
+
+MQTTStatus_t mqttDispatcherInit(MQTTDispatcher_t *dispatcher, uint16_t maxNodes, uint16_t maxEntries,
+        uint16_t maxLevels, uint16_t maxCallers)
+{
+    uint16_t i;
+
+    if ((dispatcher == RT_NULL) || (maxNodes < 2U) || (maxNodes == INVALID_INDEX) || (maxEntries == 0)
+            || (maxEntries == INVALID_INDEX) || (maxLevels == 0) || (maxCallers == 0))
+    {
+        return MQTTBadParameter;
+    }
+
+    memset(dispatcher, 0, sizeof(*dispatcher));
+    dispatcher->maxNodes = maxNodes;
+    dispatcher->maxEntries = maxEntries;
+    dispatcher->maxLevels = maxLevels;
+    dispatcher->maxCallers = maxCallers;
+
+    dispatcher->nodes = rt_calloc(maxNodes, sizeof(MQTTDispatchNode_t));
+    dispatcher->entries = rt_calloc(maxEntries, sizeof(MQTTDispatchEntry_t));
+    dispatcher->matched = rt_calloc(maxEntries, sizeof(uint16_t));
+    dispatcher->stack = rt_calloc(2U * maxLevels, sizeof(MQTTDispatchFrame_t));
+    dispatcher->callers = rt_calloc(maxCallers, sizeof(MQTTDispatchCaller_t));
+    if ((dispatcher->nodes == RT_NULL) || (dispatcher->entries == RT_NULL) || (dispatcher->matched == RT_NULL)
+            || (dispatcher->stack == RT_NULL) || (dispatcher->callers == RT_NULL))
+    {
+        mqttDispatcherDeinit(dispatcher);
+        return MQTTNoMemory;
+    }
+
+    for (i = 0; i < maxCallers; i++)
+    {
+        dispatcher->callers[i].calls = rt_calloc(maxEntries, sizeof(MQTTDispatchCall_t));
+        if (dispatcher->callers[i].calls == RT_NULL)
+        {
+            mqttDispatcherDeinit(dispatcher);
+            return MQTTNoMemory;
+        }
+    }
+
+    resetNode(&dispatcher->nodes[ROOT_NODE], INVALID_INDEX);
+    dispatcher->freeNodes = INVALID_INDEX;
+    for (i = maxNodes - 1U; i > ROOT_NODE; i--)
+    {
+        dispatcher->nodes[i].nextSibling = dispatcher->freeNodes;
+        dispatcher->freeNodes = i;
+    }
+
+    rt_sem_init(&dispatcher->callerFree, "mqttdcf", maxCallers, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&dispatcher->released, "mqttdrl", 0, RT_IPC_FLAG_FIFO);
+    rt_mutex_init(&dispatcher->lock, "mqttdsp", RT_IPC_FLAG_PRIO);
+    dispatcher->initialized = true;
+
+    return MQTTSuccess;
+}
+
+void mqttDispatcherDeinit(MQTTDispatcher_t *dispatcher)
+{
+    uint16_t i;
+
+    if (dispatcher == RT_NULL)
+    {
+        return;
+    }
+
+    if (dispatcher->initialized)
+    {
+        rt_sem_detach(&dispatcher->callerFree);
+        rt_sem_detach(&dispatcher->released);
+        rt_mutex_detach(&dispatcher->lock);
+        dispatcher->initialized = false;
+    }
+    if (dispatcher->callers != RT_NULL)
+    {
+        for (i = 0; i < dispatcher->maxCallers; i++)
+        {
+            if (dispatcher->callers[i].calls != RT_NULL)
+            {
+                rt_free(dispatcher->callers[i].calls);
+            }
+        }
+        rt_free(dispatcher->callers);
+        dispatcher->callers = RT_NULL;
+    }
+    if (dispatcher->nodes != RT_NULL)
+    {
+        for (i = 0; i < dispatcher->maxNodes; i++)
+        {
+            if (dispatcher->nodes[i].pLevel != RT_NULL)
+            {
+                rt_free(dispatcher->nodes[i].pLevel);
+            }
+        }
+        rt_free(dispatcher->nodes);
+        dispatcher->nodes = RT_NULL;
+    }
+    if (dispatcher->entries != RT_NULL)
+    {
+        for (i = 0; i < dispatcher->maxEntries; i++)
+        {
+            if (dispatcher->entries[i].pFilter != RT_NULL)
+            {
+                rt_free(dispatcher->entries[i].pFilter);
+            }
+        }
+        rt_free(dispatcher->entries);
+        dispatcher->entries = RT_NULL;
+    }
+    if (dispatcher->matched != RT_NULL)
+    {
+        rt_free(dispatcher->matched);
+        dispatcher->matched = RT_NULL;
+    }
+    if (dispatcher->stack != RT_NULL)
+    {
+        rt_free(dispatcher->stack);
+        dispatcher->stack = RT_NULL;
+    }
+    if (dispatcher->staticSlots != RT_NULL)
+    {
+        rt_free(dispatcher->staticSlots);
+        dispatcher->staticSlots = RT_NULL;
+    }
+    dispatcher->staticTopics = RT_NULL;
+    if (dispatcher->cacheLines != RT_NULL)
+    {
+        rt_free(dispatcher->cacheLines);
+        dispatcher->cacheLines = RT_NULL;
+    }
+    if (dispatcher->cacheTopics != RT_NULL)
+    {
+        rt_free(dispatcher->cacheTopics);
+        dispatcher->cacheTopics = RT_NULL;
+    }
+    dispatcher->cacheSize = 0;
+}
+
+/* Drop every cached resolution. Caller holds the lock. */
+static void flushCache(MQTTDispatcher_t *dispatcher)
+{
+    uint16_t i;
+
+    for (i = 0; i < dispatcher->cacheSize; i++)
+    {
+        dispatcher->cacheLines[i].topicLength = 0;
+    }
+}
+
+MQTTStatus_t mqttDispatcherEnableCache(MQTTDispatcher_t *dispatcher, uint16_t lines, uint16_t topicMax)
+{
+    MQTTDispatchCacheLine_t *cacheLines = RT_NULL;
+    char *cacheTopics = RT_NULL;
+
+    if ((dispatcher == RT_NULL) || (!dispatcher->initialized) || ((lines > 0) && (topicMax == 0)))
+    {
+        return MQTTBadParameter;
+    }
+
+    if (lines > 0)
+    {
+        cacheLines = rt_calloc(lines, sizeof(MQTTDispatchCacheLine_t));
+        cacheTopics = rt_malloc((size_t) lines * topicMax);
+        if ((cacheLines == RT_NULL) || (cacheTopics == RT_NULL))
+        {
+            rt_free(cacheLines);
+            rt_free(cacheTopics);
+            return MQTTNoMemory;
+        }
+    }
+
+    rt_mutex_take(&dispatcher->lock, RT_WAITING_FOREVER);
+    if (dispatcher->cacheLines != RT_NULL)
+    {
+        rt_free(dispatcher->cacheLines);
+        rt_free(dispatcher->cacheTopics);
+    }
+    dispatcher->cacheLines = cacheLines;
+    dispatcher->cacheTopics = cacheTopics;
+    dispatcher->cacheSize = lines;
+    dispatcher->cacheTopicMax = topicMax;
+    dispatcher->cacheHits = 0;
+    dispatcher->cacheMisses = 0;
+    rt_mutex_release(&dispatcher->lock);
+
+    return MQTTSuccess;
+}
+
+void mqttDispatcherGetCacheStats(MQTTDispatcher_t *dispatcher, MQTTDispatchCacheStats_t *stats)
+{
+    uint16_t i;
+
+    if (stats == RT_NULL)
+    {
+        return;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    if ((dispatcher == RT_NULL) || (!dispatcher->initialized))
+    {
+        return;
+    }
+
+    rt_mutex_take(&dispatcher->lock, RT_WAITING_FOREVER);
+    stats->hits = dispatcher->cacheHits;
+    stats->misses = dispatcher->cacheMisses;
+    stats->lines = dispatcher->cacheSize;
+    for (i = 0; i < dispatcher->cacheSize; i++)
+    {
+        if (dispatcher->cacheLines[i].topicLength > 0)
+        {
+            stats->used++;
+        }
+    }
+    rt_mutex_release(&dispatcher->lock);
+}
+
+/* Walk the filter levels down the trie, creating missing nodes. On failure the
+ * deepest node reached is returned through pLast so the caller can prune it. */
+static uint16_t addFilterNodes(MQTTDispatcher_t *dispatcher, const char *filter, uint16_t filterLength,
+        bool *isHash, uint16_t *pLast)
+{
+    uint16_t index = ROOT_NODE, offset = 0, length;
+    uint16_t levels = 0;
+
+    *isHash = false;
+    while (index != INVALID_INDEX)
+    {
+        *pLast = index;
+        length = levelLength(filter, filterLength, offset);
+        if ((length == 1) && (filter[offset] == '#'))
+        {
+            *isHash = true;
+            break;
+        }
+
+        if (++levels > dispatcher->maxLevels)
+        {
+            index = INVALID_INDEX;
+            break;
+        }
+
+        index = getOrAddChild(dispatcher, index, &filter[offset], length);
+        if ((uint32_t) offset + length >= filterLength)
+        {
+            break;
+        }
+        offset += length + 1U;
+    }
+
+    return index;
+}
+
+MQTTStatus_t mqttDispatcherRegister(MQTTDispatcher_t *dispatcher, const char *filter, uint16_t filterLength,
+        MQTTPublishHandler_t handler, void *pUserData)
+{
+    MQTTStatus_t status = MQTTSuccess;
+    MQTTDispatchEntry_t *entry = RT_NULL;
+    uint16_t index, node = ROOT_NODE, last, *list;
+    bool isHash;
+
+    if ((dispatcher == RT_NULL) || (!dispatcher->initialized) || (handler == RT_NULL)
+            || (!validateFilter(filter, filterLength)))
+    {
+        return MQTTBadParameter;
+    }
+
+    rt_mutex_take(&dispatcher->lock, RT_WAITING_FOREVER);
+
+    for (index = 0; index < dispatcher->maxEntries; index++)
+    {
+        entry = &dispatcher->entries[index];
+        if ((entry->pFilter != RT_NULL) && (entry->remover == RT_NULL) && (entry->handler == handler)
+                && (entry->filterLength == filterLength) && (memcmp(entry->pFilter, filter, filterLength) == 0))
+        {
+            /* Already registered, only refresh the user data. */
+            entry->pUserData = pUserData;
+            rt_mutex_release(&dispatcher->lock);
+            return MQTTSuccess;
+        }
+    }
+
+    for (index = 0; index < dispatcher->maxEntries; index++)
+    {
+        if (dispatcher->entries[index].pFilter == RT_NULL)
+        {
+            break;
+        }
+    }
+
+    if (index == dispatcher->maxEntries)
+    {
+        status = MQTTNoMemory;
+    }
+    else
+    {
+        entry = &dispatcher->entries[index];
+        entry->pFilter = rt_malloc(filterLength + 1U);
+        if (entry->pFilter == RT_NULL)
+        {
+            status = MQTTNoMemory;
+        }
+    }
+
+    if (status == MQTTSuccess)
+    {
+        node = addFilterNodes(dispatcher, filter, filterLength, &isHash, &last);
+        if (node == INVALID_INDEX)
+        {
+            /* Out of nodes or too deep, undo the partially created path. */
+            pruneNodes(dispatcher, last);
+            rt_free(entry->pFilter);
+            entry->pFilter = RT_NULL;
+            status = MQTTNoMemory;
+        }
+    }
+
+    if (status == MQTTSuccess)
+    {
+        memcpy(entry->pFilter, filter, filterLength);
+        entry->pFilter[filterLength] = '\0';
+        entry->filterLength = filterLength;
+        entry->node = node;
+        entry->handler = handler;
+        entry->pUserData = pUserData;
+
+        list = isHash ? &dispatcher->nodes[node].hashHandlers : &dispatcher->nodes[node].handlers;
+        entry->next = *list;
+        *list = index;
+        flushCache(dispatcher);
+    }
+
+    rt_mutex_release(&dispatcher->lock);
+
+    if (status != MQTTSuccess)
+    {
+        MQTT_PRINT("Dispatcher: no room for filter %.*s\n", filterLength, filter);
+    }
+
+    return status;
+}
+
+/* Callers of this thread inside the entry's handler, the handler unregistering itself. Caller holds the lock. */
+static uint16_t ownRefs(const MQTTDispatcher_t *dispatcher, uint16_t index, rt_thread_t self)
+{
+    uint16_t i, refs = 0;
+
+    for (i = 0; i < dispatcher->maxCallers; i++)
+    {
+        if ((dispatcher->callers[i].thread == self) && (dispatcher->callers[i].active == index))
+        {
+            refs++;
+        }
+    }
+
+    return refs;
+}
+
+MQTTStatus_t mqttDispatcherUnregister(MQTTDispatcher_t *dispatcher, const char *filter, uint16_t filterLength,
+        MQTTPublishHandler_t handler)
+{
+    MQTTStatus_t status = MQTTBadParameter;
+    MQTTDispatchEntry_t *entry;
+    MQTTDispatchNode_t *node;
+    rt_thread_t self = rt_thread_self();
+    uint16_t index, *link;
+
+    if ((dispatcher == RT_NULL) || (!dispatcher->initialized) || (filter == RT_NULL))
+    {
+        return MQTTBadParameter;
+    }
+
+    rt_mutex_take(&dispatcher->lock, RT_WAITING_FOREVER);
+
+    /* Unlink first so that no new dispatch resolves to the entries. */
+    for (index = 0; index < dispatcher->maxEntries; index++)
+    {
+        entry = &dispatcher->entries[index];
+        if ((entry->pFilter == RT_NULL) || (entry->remover != RT_NULL) || (entry->filterLength != filterLength)
+                || (memcmp(entry->pFilter, filter, filterLength) != 0)
+                || ((handler != RT_NULL) && (entry->handler != handler)))
+        {
+            continue;
+        }
+
+        node = &dispatcher->nodes[entry->node];
+        link = ((filterLength > 0) && (filter[filterLength - 1] == '#')) ? &node->hashHandlers : &node->handlers;
+        while (*link != index)
+        {
+            link = &dispatcher->entries[*link].next;
+        }
+        *link = entry->next;
+
+        entry->remover = self;
+        pruneNodes(dispatcher, entry->node);
+        flushCache(dispatcher);
+        status = MQTTSuccess;
+    }
+
+    /* Then wait for the handlers still running on other threads. */
+    for (index = 0; index < dispatcher->maxEntries; index++)
+    {
+        entry = &dispatcher->entries[index];
+        if (entry->remover != self)
+        {
+            continue;
+        }
+
+        while (entry->refs > ownRefs(dispatcher, index, self))
+        {
+            dispatcher->releaseWaiters++;
+            rt_mutex_release(&dispatcher->lock);
+            rt_sem_take(&dispatcher->released, RT_WAITING_FOREVER);
+            rt_mutex_take(&dispatcher->lock, RT_WAITING_FOREVER);
+        }
+
+        rt_free(entry->pFilter);
+        entry->pFilter = RT_NULL;
+        entry->remover = RT_NULL;
+        entry->generation++;
+    }
+
+    rt_mutex_release(&dispatcher->lock);
+
+    return status;
+}
+
+static size_t collectHandlers(MQTTDispatcher_t *dispatcher, uint16_t list, size_t count)
+{
+    while ((list != INVALID_INDEX) && (count < dispatcher->maxEntries))
+    {
+        dispatcher->matched[count++] = list;
+        list = dispatcher->entries[list].next;
+    }
+
+    return count;
+}
+
+/* Collect every entry whose filter matches the topic into dispatcher->matched. */
+static size_t resolveTopic(MQTTDispatcher_t *dispatcher, const char *topic, uint16_t topicLength)
+{
+    const MQTTDispatchNode_t *node;
+    MQTTDispatchFrame_t frame;
+    size_t depth = 0, maxDepth = 2U * dispatcher->maxLevels, count = 0;
+    uint16_t length, child;
+    bool rootLevel;
+
+    dispatcher->stack[depth].node = ROOT_NODE;
+    dispatcher->stack[depth].offset = 0;
+    depth++;
+
+    while (depth > 0)
+    {
+        frame = dispatcher->stack[--depth];
+        node = &dispatcher->nodes[frame.node];
+
+        /* Wildcards at the first level never match topics starting with '$'. */
+        rootLevel = (frame.node == ROOT_NODE) && (topicLength > 0) && (topic[0] == '$');
+
+        /* "a/#" matches "a" itself as well as every level below it. */
+        if (!rootLevel)
+        {
+            count = collectHandlers(dispatcher, node->hashHandlers, count);
+        }
+
+        if (frame.offset > topicLength)
+        {
+            count = collectHandlers(dispatcher, node->handlers, count);
+            continue;
+        }
+
+        length = levelLength(topic, topicLength, (uint16_t) frame.offset);
+
+        child = findLiteralChild(dispatcher, frame.node, &topic[frame.offset], length,
+                levelHash(&topic[frame.offset], length));
+        if ((child != INVALID_INDEX) && (depth < maxDepth))
+        {
+            dispatcher->stack[depth].node = child;
+            dispatcher->stack[depth].offset = frame.offset + length + 1U;
+            depth++;
+        }
+
+        if ((!rootLevel) && (node->plusChild != INVALID_INDEX) && (depth < maxDepth))
+        {
+            dispatcher->stack[depth].node = node->plusChild;
+            dispatcher->stack[depth].offset = frame.offset + length + 1U;
+            depth++;
+        }
+    }
+
+    return count;
+}
+
+/* Resolve through the LRU cache, falling back to the trie walk on a miss. */
+static size_t resolveCached(MQTTDispatcher_t *dispatcher, const char *topic, uint16_t topicLength)
+{
+    MQTTDispatchCacheLine_t *line, *victim = RT_NULL;
+    uint32_t hash;
+    size_t count;
+    uint16_t i;
+
+    if ((dispatcher->cacheSize == 0) || (topicLength > dispatcher->cacheTopicMax))
+    {
+        return resolveTopic(dispatcher, topic, topicLength);
+    }
+
+    hash = seededHash(0, topic, topicLength);
+    dispatcher->cacheTick++;
+
+    for (i = 0; i < dispatcher->cacheSize; i++)
+    {
+        line = &dispatcher->cacheLines[i];
+        if ((line->topicLength == topicLength) && (line->hash == hash)
+                && (memcmp(&dispatcher->cacheTopics[(size_t) i * dispatcher->cacheTopicMax], topic, topicLength) == 0))
+        {
+            line->lastUse = dispatcher->cacheTick;
+            memcpy(dispatcher->matched, line->entries, line->count * sizeof(uint16_t));
+            dispatcher->cacheHits++;
+            return line->count;
+        }
+
+        /* Prefer an empty line, otherwise the least recently used one. */
+        if ((victim == RT_NULL) || ((victim->topicLength != 0)
+                && ((line->topicLength == 0) || ((dispatcher->cacheTick - line->lastUse)
+                        > (dispatcher->cacheTick - victim->lastUse)))))
+        {
+            victim = line;
+        }
+    }
+
+    dispatcher->cacheMisses++;
+    count = resolveTopic(dispatcher, topic, topicLength);
+
+    if (count <= MQTT_DISPATCH_CACHE_LINE_HANDLERS)
+    {
+        i = (uint16_t) (victim - dispatcher->cacheLines);
+        memcpy(&dispatcher->cacheTopics[(size_t) i * dispatcher->cacheTopicMax], topic, topicLength);
+        memcpy(victim->entries, dispatcher->matched, count * sizeof(uint16_t));
+        victim->count = (uint16_t) count;
+        victim->hash = hash;
+        victim->topicLength = topicLength;
+        victim->lastUse = dispatcher->cacheTick;
+    }
+
+    return count;
+}
+
+/* Try seeds until every topic lands in its own slot. Returns false if none was found. */
+static bool buildStaticSlots(const MQTTStaticTopic_t *topics, uint16_t count, uint16_t *slots, uint16_t mask,
+        uint32_t *pSeed)
+{
+    uint32_t seed, slot;
+    uint16_t i;
+
+    for (seed = 1; seed <= STATIC_SEED_TRIES; seed++)
+    {
+        memset(slots, 0xFF, ((size_t) mask + 1U) * sizeof(uint16_t));
+        for (i = 0; i < count; i++)
+        {
+            slot = seededHash(seed, topics[i].pTopic, topics[i].topicLength) & mask;
+            if (slots[slot] != INVALID_INDEX)
+            {
+                break;
+            }
+            slots[slot] = i;
+        }
+
+        if (i == count)
+        {
+            *pSeed = seed;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+MQTTStatus_t mqttDispatcherSetStaticTopics(MQTTDispatcher_t *dispatcher, const MQTTStaticTopic_t *topics,
+        uint16_t count)
+{
+    uint16_t *slots = RT_NULL, mask = 1U, i, j;
+    uint32_t seed = 0;
+
+    if ((dispatcher == RT_NULL) || (!dispatcher->initialized) || ((topics == RT_NULL) && (count > 0))
+            || (count >= STATIC_MAX_SLOTS))
+    {
+        return MQTTBadParameter;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        if ((topics[i].pTopic == RT_NULL) || (topics[i].topicLength == 0) || (topics[i].handler == RT_NULL)
+                || (memchr(topics[i].pTopic, '+', topics[i].topicLength) != RT_NULL)
+                || (memchr(topics[i].pTopic, '#', topics[i].topicLength) != RT_NULL))
+        {
+            MQTT_PRINT("Dispatcher: static topic %u is not an exact topic\n", i);
+            return MQTTBadParameter;
+        }
+        for (j = 0; j < i; j++)
+        {
+            if ((topics[j].topicLength == topics[i].topicLength)
+                    && (memcmp(topics[j].pTopic, topics[i].pTopic, topics[i].topicLength) == 0))
+            {
+                MQTT_PRINT("Dispatcher: static topic %.*s listed twice\n", topics[i].topicLength, topics[i].pTopic);
+                return MQTTBadParameter;
+            }
+        }
+    }
+
+    if (count > 0)
+    {
+        /* Start at a load factor of 1/2 and grow the table until a seed works. */
+        while (mask < (uint16_t) (2U * count - 1U))
+        {
+            mask = (uint16_t) ((mask << 1) | 1U);
+        }
+
+        while (slots == RT_NULL)
+        {
+            slots = rt_malloc(((size_t) mask + 1U) * sizeof(uint16_t));
+            if (slots == RT_NULL)
+            {
+                return MQTTNoMemory;
+            }
+            if (!buildStaticSlots(topics, count, slots, mask, &seed))
+            {
+                rt_free(slots);
+                slots = RT_NULL;
+                if (mask >= STATIC_MAX_SLOTS - 1U)
+                {
+                    return MQTTNoMemory;
+                }
+                mask = (uint16_t) ((mask << 1) | 1U);
+            }
+        }
+    }
+
+    rt_mutex_take(&dispatcher->lock, RT_WAITING_FOREVER);
+    if (dispatcher->staticSlots != RT_NULL)
+    {
+        rt_free(dispatcher->staticSlots);
+    }
+    dispatcher->staticTopics = topics;
+    dispatcher->staticSlots = slots;
+    dispatcher->staticMask = mask;
+    dispatcher->staticSeed = seed;
+    rt_mutex_release(&dispatcher->lock);
+
+    MQTT_PRINT("Dispatcher: %u static topics in %u slots\n", count, (unsigned int) mask + 1U);
+
+    return MQTTSuccess;
+}
+
+static const MQTTStaticTopic_t *lookupStaticTopic(const MQTTDispatcher_t *dispatcher, const char *topic,
+        uint16_t topicLength)
+{
+    const MQTTStaticTopic_t *entry;
+    uint16_t index;
+
+    if (dispatcher->staticSlots == RT_NULL)
+    {
+        return RT_NULL;
+    }
+
+    index = dispatcher->staticSlots[seededHash(dispatcher->staticSeed, topic, topicLength) & dispatcher->staticMask];
+    if (index == INVALID_INDEX)
+    {
+        return RT_NULL;
+    }
+
+    entry = &dispatcher->staticTopics[index];
+    if ((entry->topicLength != topicLength) || (memcmp(entry->pTopic, topic, topicLength) != 0))
+    {
+        return RT_NULL;
+    }
+
+    return entry;
+}
+
+static bool trieIsEmpty(const MQTTDispatcher_t *dispatcher)
+{
+    const MQTTDispatchNode_t *root = &dispatcher->nodes[ROOT_NODE];
+
+    return (root->firstChild == INVALID_INDEX) && (root->plusChild == INVALID_INDEX)
+            && (root->hashHandlers == INVALID_INDEX);
+}
+
+/* Take a reference on a resolved entry unless it was unregistered meanwhile. */
+static bool acquireEntry(MQTTDispatcher_t *dispatcher, MQTTDispatchCaller_t *caller, const MQTTDispatchCall_t *call,
+        MQTTPublishHandler_t *handler, void **pUserData)
+{
+    MQTTDispatchEntry_t *entry = &dispatcher->entries[call->entry];
+    bool acquired = false;
+
+    rt_mutex_take(&dispatcher->lock, RT_WAITING_FOREVER);
+    if ((entry->pFilter != RT_NULL) && (entry->remover == RT_NULL) && (entry->generation == call->generation))
+    {
+        *handler = entry->handler;
+        *pUserData = entry->pUserData;
+        entry->refs++;
+        caller->active = call->entry;
+        acquired = true;
+    }
+    rt_mutex_release(&dispatcher->lock);
+
+    return acquired;
+}
+
+static void releaseEntry(MQTTDispatcher_t *dispatcher, MQTTDispatchCaller_t *caller, uint16_t index)
+{
+    MQTTDispatchEntry_t *entry = &dispatcher->entries[index];
+
+    rt_mutex_take(&dispatcher->lock, RT_WAITING_FOREVER);
+    entry->refs--;
+    caller->active = INVALID_INDEX;
+    if (entry->remover != RT_NULL)
+    {
+        /* Every waiter checks its own entry again. */
+        while (dispatcher->releaseWaiters > 0)
+        {
+            dispatcher->releaseWaiters--;
+            rt_sem_release(&dispatcher->released);
+        }
+    }
+    rt_mutex_release(&dispatcher->lock);
+}
+
+size_t mqttDispatcherDispatch(MQTTDispatcher_t *dispatcher, MQTTContext_t *pContext,
+        MQTTDeserializedInfo_t *pDeserializedInfo)
+{
+    const MQTTStaticTopic_t *staticTopic;
+    MQTTPublishInfo_t *publishInfo;
+    MQTTDispatchCaller_t *caller = RT_NULL;
+    MQTTPublishHandler_t staticHandler = RT_NULL, handler;
+    void *staticUserData = RT_NULL, *pUserData;
+    size_t count = 0, handled = 0, i;
+
+    if ((dispatcher == RT_NULL) || (!dispatcher->initialized) || (pDeserializedInfo == RT_NULL)
+            || (pDeserializedInfo->pPublishInfo == RT_NULL))
+    {
+        return 0;
+    }
+
+    publishInfo = pDeserializedInfo->pPublishInfo;
+
+    rt_sem_take(&dispatcher->callerFree, RT_WAITING_FOREVER);
+    rt_mutex_take(&dispatcher->lock, RT_WAITING_FOREVER);
+
+    for (i = 0; i < dispatcher->maxCallers; i++)
+    {
+        if (dispatcher->callers[i].thread == RT_NULL)
+        {
+            caller = &dispatcher->callers[i];
+            caller->thread = rt_thread_self();
+            caller->active = INVALID_INDEX;
+            break;
+        }
+    }
+
+    /* Static topics are immutable user tables, only the handler is copied. */
+    staticTopic = lookupStaticTopic(dispatcher, publishInfo->pTopicName, publishInfo->topicNameLength);
+    if (staticTopic != RT_NULL)
+    {
+        staticHandler = staticTopic->handler;
+        staticUserData = staticTopic->pUserData;
+    }
+
+    if (!trieIsEmpty(dispatcher))
+    {
+        count = resolveCached(dispatcher, publishInfo->pTopicName, publishInfo->topicNameLength);
+    }
+    for (i = 0; i < count; i++)
+    {
+        caller->calls[i].entry = dispatcher->matched[i];
+        caller->calls[i].generation = dispatcher->entries[dispatcher->matched[i]].generation;
+    }
+
+    rt_mutex_release(&dispatcher->lock);
+
+    /* Handlers run unlocked, so they may register or unregister filters and
+     * other threads dispatch meanwhile. */
+    if (staticHandler != RT_NULL)
+    {
+        staticHandler(pContext, pDeserializedInfo, staticUserData);
+        handled++;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        if (acquireEntry(dispatcher, caller, &caller->calls[i], &handler, &pUserData))
+        {
+            handler(pContext, pDeserializedInfo, pUserData);
+            releaseEntry(dispatcher, caller, caller->calls[i].entry);
+            handled++;
+        }
+    }
+
+    rt_mutex_take(&dispatcher->lock, RT_WAITING_FOREVER);
+    caller->thread = RT_NULL;
+    rt_mutex_release(&dispatcher->lock);
+    rt_sem_release(&dispatcher->callerFree);
+
+    return handled;
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+#ifndef APPLICATIONS_FIREMQTT_API_MQTT_DISPATCH_H_
+#define APPLICATIONS_FIREMQTT_API_MQTT_DISPATCH_H_
+
+#include <rtthread.h>
+#include <core_mqtt.h>
+
+/*
+ * Topic dispatcher.
+ *
+ * Topic filters are stored in a trie with one node per filter level. A '+'
+ * level is kept as a dedicated child of its parent and a trailing '#' is kept
+ * as a handler list on the parent itself, so an incoming topic is resolved in
+ * a single walk over its levels instead of one MQTT_MatchTopic() per filter.
+ *
+ * Exact topics known at build time can be given as a static table instead.
+ * They are placed in a perfect hash table, so a hit costs one hash of the
+ * topic and one memcmp. The trie is only walked when wildcard filters or
+ * run-time registrations exist. A table is usually built with an X-macro:
+ *
+ *   #define APP_TOPICS(X) \
+ *       X("dev/42/cmd/reboot", onReboot, RT_NULL) \
+ *       X("dev/42/cmd/config", onConfig, &config)
+ *
+ *   static const MQTTStaticTopic_t appTopics[] = { APP_TOPICS(MQTT_STATIC_TOPIC) };
+ *
+ * An optional LRU cache in front of the trie remembers the handlers resolved
+ * for the most recent topics, keyed by a hash of the whole topic and verified
+ * with a memcmp. Any register or unregister flushes it.
+ *
+ * Handlers run without the dispatcher lock, so up to maxCallers threads (the
+ * workers and the reader) dispatch at the same time. Each entry counts the
+ * callers inside its handler; mqttDispatcherUnregister() waits for them, but
+ * not for a handler that unregisters itself.
+ */
+
+#define MQTT_DISPATCH_INVALID_INDEX     0xFFFFU
+
+/* Topics resolving to more handlers than this are not cached. */
+#define MQTT_DISPATCH_CACHE_LINE_HANDLERS   4U
+
+typedef void (*MQTTPublishHandler_t)(MQTTContext_t *pContext, MQTTDeserializedInfo_t *pDeserializedInfo,
+        void *pUserData);
+
+typedef struct MQTTStaticTopic
+{
+    const char *pTopic;
+    uint16_t topicLength;
+    MQTTPublishHandler_t handler;
+    void *pUserData;
+} MQTTStaticTopic_t;
+
+/* Initializer for a string literal topic, usable as an X-macro. */
+#define MQTT_STATIC_TOPIC(topic, handler, userData)     { (topic), (uint16_t) (sizeof(topic) - 1U), (handler), (userData) },
+
+typedef struct MQTTDispatchNode
+{
+    char *pLevel;               /* Copy of the level text, RT_NULL for '+' and root. */
+    uint16_t levelLength;
+    uint32_t levelHash;
+    uint16_t parent;
+    uint16_t firstChild;        /* Literal children, linked through nextSibling. */
+    uint16_t nextSibling;
+    uint16_t plusChild;         /* Child for a '+' level. */
+    uint16_t handlers;          /* Filters ending at this node. */
+    uint16_t hashHandlers;      /* Filters ending with '#' below this node. */
+} MQTTDispatchNode_t;
+
+typedef struct MQTTDispatchEntry
+{
+    char *pFilter;              /* Copy of the registered filter, RT_NULL if the slot is free. */
+    uint16_t filterLength;
+    uint16_t node;
+    uint16_t next;
+    MQTTPublishHandler_t handler;
+    void *pUserData;
+    uint16_t refs;              /* Callers running the handler right now. */
+    uint16_t generation;        /* Bumped when the slot is freed, stale resolutions skip it. */
+    rt_thread_t remover;        /* Thread unregistering the entry, RT_NULL while registered. */
+} MQTTDispatchEntry_t;
+
+typedef struct MQTTDispatchCall
+{
+    uint16_t entry;
+    uint16_t generation;
+} MQTTDispatchCall_t;
+
+typedef struct MQTTDispatchCaller
+{
+    rt_thread_t thread;         /* RT_NULL if the caller slot is free. */
+    uint16_t active;            /* Entry whose handler runs, or MQTT_DISPATCH_INVALID_INDEX. */
+    MQTTDispatchCall_t *calls;  /* Handlers resolved for the message, maxEntries long. */
+} MQTTDispatchCaller_t;
+
+typedef struct MQTTDispatchFrame
+{
+    uint16_t node;
+    uint32_t offset;            /* Start of the next topic level, length + 1 once consumed. */
+} MQTTDispatchFrame_t;
+
+typedef struct MQTTDispatchCacheLine
+{
+    uint32_t hash;
+    uint32_t lastUse;
+    uint16_t topicLength;       /* 0 marks an empty line. */
+    uint16_t count;
+    uint16_t entries[MQTT_DISPATCH_CACHE_LINE_HANDLERS];
+} MQTTDispatchCacheLine_t;
+
+typedef struct MQTTDispatchCacheStats
+{
+    uint32_t hits;
+    uint32_t misses;
+    uint16_t lines;
+    uint16_t used;
+} MQTTDispatchCacheStats_t;
+
+typedef struct MQTTDispatcher
+{
+    MQTTDispatchNode_t *nodes;
+    uint16_t maxNodes;
+    uint16_t freeNodes;         /* Free list, linked through nextSibling. */
+    MQTTDispatchEntry_t *entries;
+    uint16_t maxEntries;
+    uint16_t maxLevels;
+    uint16_t *matched;          /* Scratch list of resolved entries, maxEntries long. */
+    MQTTDispatchFrame_t *stack; /* Walk stack, 2 * maxLevels frames. */
+    const MQTTStaticTopic_t *staticTopics;
+    uint16_t *staticSlots;      /* Perfect hash table of indexes into staticTopics. */
+    uint32_t staticSeed;
+    uint16_t staticMask;
+    MQTTDispatchCacheLine_t *cacheLines;
+    char *cacheTopics;          /* cacheTopicMax bytes per line. */
+    uint16_t cacheSize;
+    uint16_t cacheTopicMax;
+    uint32_t cacheTick;
+    uint32_t cacheHits;
+    uint32_t cacheMisses;
+    MQTTDispatchCaller_t *callers;
+    uint16_t maxCallers;
+    uint16_t releaseWaiters;    /* Unregister calls waiting for an entry's callers. */
+    struct rt_semaphore callerFree;
+    struct rt_semaphore released;
+    struct rt_mutex lock;
+    bool initialized;
+} MQTTDispatcher_t;
+
+MQTTStatus_t mqttDispatcherInit(MQTTDispatcher_t *dispatcher, uint16_t maxNodes, uint16_t maxEntries,
+        uint16_t maxLevels, uint16_t maxCallers);
+void mqttDispatcherDeinit(MQTTDispatcher_t *dispatcher);
+MQTTStatus_t mqttDispatcherEnableCache(MQTTDispatcher_t *dispatcher, uint16_t lines, uint16_t topicMax);
+void mqttDispatcherGetCacheStats(MQTTDispatcher_t *dispatcher, MQTTDispatchCacheStats_t *stats);
+MQTTStatus_t mqttDispatcherRegister(MQTTDispatcher_t *dispatcher, const char *filter, uint16_t filterLength,
+        MQTTPublishHandler_t handler, void *pUserData);
+MQTTStatus_t mqttDispatcherUnregister(MQTTDispatcher_t *dispatcher, const char *filter, uint16_t filterLength,
+        MQTTPublishHandler_t handler);
+MQTTStatus_t mqttDispatcherSetStaticTopics(MQTTDispatcher_t *dispatcher, const MQTTStaticTopic_t *topics,
+        uint16_t count);
+size_t mqttDispatcherDispatch(MQTTDispatcher_t *dispatcher, MQTTContext_t *pContext,
+        MQTTDeserializedInfo_t *pDeserializedInfo);
+
+#endif /* APPLICATIONS_FIREMQTT_API_MQTT_DISPATCH_H_ */
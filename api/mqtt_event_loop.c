@@ -0,0 +1,440 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+#define DBG_TAG "MQTT"
+#define DBG_LVL DBG_LOG
+
+#include "mqtt_api.h"
+#include "mqtt_event_loop.h"
+
+#include <errno.h>
+#if MQTT_EVENT_LOOP_EPOLL
+#include <sys/epoll.h>
+#include <unistd.h>
+#define EVENT_READ          EPOLLIN
+#define EVENT_WRITE         EPOLLOUT
+#define EVENT_ERROR         (EPOLLERR | EPOLLHUP)
+#else
+#include <poll.h>
+#define EVENT_READ          POLLIN
+#define EVENT_WRITE         POLLOUT
+#define EVENT_ERROR         (POLLERR | POLLHUP | POLLNVAL)
+#endif
+
+/* Name lookups run on the resolver thread and have no socket to wait on. */
+#define RESOLVE_POLL_MS     20U
+
+static void releaseLoop(MQTTEventLoop_t *loop)
+{
+#if MQTT_EVENT_LOOP_EPOLL
+    if (loop->epollFd >= 0)
+    {
+        close(loop->epollFd);
+        loop->epollFd = -1;
+    }
+    rt_free(loop->epollEvents);
+    loop->epollEvents = RT_NULL;
+#else
+    rt_free(loop->pollFds);
+    rt_free(loop->pollSlots);
+    loop->pollFds = RT_NULL;
+    loop->pollSlots = RT_NULL;
+#endif
+    rt_free(loop->slots);
+    loop->slots = RT_NULL;
+}
+
+MQTTStatus_t mqttEventLoopInit(MQTTEventLoop_t *loop, uint16_t maxClients)
+{
+    if ((loop == RT_NULL) || (maxClients == 0))
+    {
+        return MQTTBadParameter;
+    }
+
+    memset(loop, 0, sizeof(*loop));
+    loop->epollFd = -1;
+    loop->maxClients = maxClients;
+    loop->slots = rt_calloc(maxClients, sizeof(MQTTEventLoopSlot_t));
+    if (loop->slots == RT_NULL)
+    {
+        return MQTTNoMemory;
+    }
+
+#if MQTT_EVENT_LOOP_EPOLL
+    loop->epollEvents = rt_calloc(maxClients, sizeof(struct epoll_event));
+    loop->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if ((loop->epollEvents == RT_NULL) || (loop->epollFd < 0))
+    {
+        releaseLoop(loop);
+        return MQTTNoMemory;
+    }
+#else
+    loop->pollFds = rt_calloc(maxClients, sizeof(struct pollfd));
+    loop->pollSlots = rt_calloc(maxClients, sizeof(uint16_t));
+    if ((loop->pollFds == RT_NULL) || (loop->pollSlots == RT_NULL))
+    {
+        releaseLoop(loop);
+        return MQTTNoMemory;
+    }
+#endif
+
+    rt_mutex_init(&loop->lock, "mqttloop", RT_IPC_FLAG_PRIO);
+    rt_sem_init(&loop->exited, "mqttlpx", 0, RT_IPC_FLAG_FIFO);
+    loop->initialized = true;
+
+    return MQTTSuccess;
+}
+
+void mqttEventLoopDeinit(MQTTEventLoop_t *loop)
+{
+    uint16_t i;
+
+    if ((loop == RT_NULL) || (!loop->initialized))
+    {
+        return;
+    }
+
+    mqttEventLoopStop(loop);
+
+    for (i = 0; i < loop->count; i++)
+    {
+        loop->slots[i].client->loop = RT_NULL;
+    }
+
+    releaseLoop(loop);
+    loop->count = 0;
+    rt_sem_detach(&loop->exited);
+    rt_mutex_detach(&loop->lock);
+    loop->initialized = false;
+}
+
+/* Keeps the epoll registration of a slot in line with the socket and events it needs now. */
+static void watchSocket(MQTTEventLoop_t *loop, uint16_t index, int fd, uint32_t events)
+{
+    MQTTEventLoopSlot_t *slot = &loop->slots[index];
+#if MQTT_EVENT_LOOP_EPOLL
+    struct epoll_event event;
+
+    if ((slot->fd == fd) && (slot->events == events))
+    {
+        return;
+    }
+
+    /* A closed socket already left the epoll set, so errors are expected here. */
+    if ((slot->fd >= 0) && ((slot->fd != fd) || (events == 0)))
+    {
+        (void) epoll_ctl(loop->epollFd, EPOLL_CTL_DEL, slot->fd, RT_NULL);
+        slot->events = 0;
+    }
+
+    if ((fd >= 0) && (events != 0))
+    {
+        memset(&event, 0, sizeof(event));
+        event.events = events;
+        event.data.u32 = index;
+        if ((slot->fd == fd) && (slot->events != 0))
+        {
+            if ((epoll_ctl(loop->epollFd, EPOLL_CTL_MOD, fd, &event) < 0) && (errno == ENOENT))
+            {
+                /* Closed and reopened under the same number since the last iteration. */
+                (void) epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, fd, &event);
+            }
+        }
+        else if ((epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, fd, &event) < 0) && (errno == EEXIST))
+        {
+            (void) epoll_ctl(loop->epollFd, EPOLL_CTL_MOD, fd, &event);
+        }
+    }
+#else
+    (void) loop;
+    (void) index;
+#endif
+    slot->fd = fd;
+    slot->events = events;
+}
+
+/* Milliseconds until a client has work to do without any socket activity. */
+static uint32_t clientTimeout(MQTTClient_t *client, uint32_t now)
+{
+    MQTTContext_t *context = &client->context;
+    uint32_t timeout = MQTT_EVENT_LOOP_MAX_WAIT_MS, elapsed, interval;
+
+    switch (context->connectStatus)
+    {
+        case MQTTNotConnected:
+            timeout = ((int32_t) (client->retryAtMs - now) > 0) ? (client->retryAtMs - now) : 0U;
+            break;
+        case MQTTConnected:
+            if (MQTT_IsReceivePaused(context))
+            {
+                /* Acks deferred by handlers are queued from other threads. */
+                timeout = RESOLVE_POLL_MS;
+            }
+            else if (context->waitingForPingResp)
+            {
+                elapsed = now - context->pingReqSendTimeMs;
+                timeout = (elapsed <= MQTT_PINGRESP_TIMEOUT_MS) ? (MQTT_PINGRESP_TIMEOUT_MS - elapsed + 1U) : 0U;
+            }
+            else if (context->keepAliveIntervalSec > 0)
+            {
+                interval = (uint32_t) context->keepAliveIntervalSec * 1000U;
+                elapsed = now - context->lastPacketTxTime;
+                timeout = (elapsed < interval) ? (interval - elapsed) : 0U;
+            }
+            else
+            {
+                /* Empty else MISRA 15.7 */
+            }
+            break;
+        case MQTTDisconnectPending:
+            timeout = 0;
+            break;
+        default:
+            /* Connecting or waiting for CONNACK: the socket reports progress,
+             * the wait cap catches the connect timeouts. */
+            if (client->network.state == TransportResolving)
+            {
+                timeout = RESOLVE_POLL_MS;
+            }
+            break;
+    }
+
+    return MIN(timeout, (uint32_t) MQTT_EVENT_LOOP_MAX_WAIT_MS);
+}
+
+static uint32_t clientEvents(MQTTClient_t *client)
+{
+    /* A paused client must not keep waking the loop with unread data. */
+    if ((client->network.socket < 0) || MQTT_IsReceivePaused(&client->context))
+    {
+        return 0;
+    }
+
+    return (client->network.state == TransportConnecting) ? EVENT_WRITE : EVENT_READ;
+}
+
+MQTTStatus_t mqttEventLoopAdd(MQTTEventLoop_t *loop, MQTTClient_t *client)
+{
+    MQTTEventLoopSlot_t *slot;
+    MQTTStatus_t status = MQTTSuccess;
+
+    if ((loop == RT_NULL) || (!loop->initialized) || (client == RT_NULL) || (!client->initialized))
+    {
+        return MQTTBadParameter;
+    }
+
+    rt_mutex_take(&loop->lock, RT_WAITING_FOREVER);
+
+    /* A client belongs to one loop at a time. */
+    if (client->loop != RT_NULL)
+    {
+        status = MQTTBadParameter;
+    }
+
+    if ((status == MQTTSuccess) && (loop->count == loop->maxClients))
+    {
+        status = MQTTNoMemory;
+    }
+
+    if (status == MQTTSuccess)
+    {
+        slot = &loop->slots[loop->count++];
+        memset(slot, 0, sizeof(*slot));
+        slot->client = client;
+        slot->fd = -1;
+        slot->dueMs = getCurrentTime();
+        client->loop = loop;
+    }
+
+    rt_mutex_release(&loop->lock);
+
+    return status;
+}
+
+MQTTStatus_t mqttEventLoopRemove(MQTTEventLoop_t *loop, MQTTClient_t *client)
+{
+    MQTTStatus_t status = MQTTBadParameter;
+    uint16_t i, last;
+
+    if ((loop == RT_NULL) || (!loop->initialized) || (client == RT_NULL))
+    {
+        return MQTTBadParameter;
+    }
+
+    rt_mutex_take(&loop->lock, RT_WAITING_FOREVER);
+
+    for (i = 0; i < loop->count; i++)
+    {
+        if (loop->slots[i].client == client)
+        {
+            watchSocket(loop, i, -1, 0);
+
+            /* Move the last slot into the gap; its registration carries the old index. */
+            last = --loop->count;
+            if (i != last)
+            {
+                loop->slots[i] = loop->slots[last];
+                watchSocket(loop, i, loop->slots[i].fd, 0);
+            }
+            client->loop = RT_NULL;
+            status = MQTTSuccess;
+            break;
+        }
+    }
+
+    rt_mutex_release(&loop->lock);
+
+    return status;
+}
+
+MQTTStatus_t mqttEventLoopRunOnce(MQTTEventLoop_t *loop)
+{
+    MQTTEventLoopSlot_t *slot;
+    uint32_t now, timeout, wait = MQTT_EVENT_LOOP_MAX_WAIT_MS, events;
+    uint16_t i;
+    int ready, n;
+    bool reconnect;
+#if !MQTT_EVENT_LOOP_EPOLL
+    uint16_t watched = 0;
+#endif
+
+    if ((loop == RT_NULL) || (!loop->initialized))
+    {
+        return MQTTBadParameter;
+    }
+
+    rt_mutex_take(&loop->lock, RT_WAITING_FOREVER);
+
+    now = getCurrentTime();
+    for (i = 0; i < loop->count; i++)
+    {
+        slot = &loop->slots[i];
+        timeout = clientTimeout(slot->client, now);
+        slot->dueMs = now + timeout;
+        slot->ready = false;
+        wait = MIN(wait, timeout);
+
+        events = clientEvents(slot->client);
+        watchSocket(loop, i, slot->client->network.socket, events);
+#if !MQTT_EVENT_LOOP_EPOLL
+        if (events != 0)
+        {
+            loop->pollFds[watched].fd = slot->fd;
+            loop->pollFds[watched].events = (short) events;
+            loop->pollFds[watched].revents = 0;
+            loop->pollSlots[watched] = i;
+            watched++;
+        }
+#endif
+    }
+
+#if MQTT_EVENT_LOOP_EPOLL
+    ready = epoll_wait(loop->epollFd, loop->epollEvents, loop->maxClients, (int) wait);
+    for (n = 0; n < ready; n++)
+    {
+        if (loop->epollEvents[n].data.u32 < loop->count)
+        {
+            loop->slots[loop->epollEvents[n].data.u32].ready = true;
+        }
+    }
+#else
+    ready = poll(loop->pollFds, watched, (int) wait);
+    for (n = 0; (ready > 0) && (n < watched); n++)
+    {
+        if ((loop->pollFds[n].revents & (EVENT_READ | EVENT_WRITE | EVENT_ERROR)) != 0)
+        {
+            loop->slots[loop->pollSlots[n]].ready = true;
+        }
+    }
+#endif
+
+    if ((ready < 0) && (errno != EINTR))
+    {
+        MQTT_PRINT("Event loop wait failed: %d\n", errno);
+    }
+
+    now = getCurrentTime();
+    for (i = 0; i < loop->count; i++)
+    {
+        slot = &loop->slots[i];
+        if (slot->ready || ((int32_t) (now - slot->dueMs) >= 0))
+        {
+            reconnect = (slot->client->context.connectStatus == MQTTNotConnected);
+            (void) mqttClientService(slot->client);
+            loop->serviced++;
+            if (reconnect)
+            {
+                /* The new socket may reuse the old number, register it from scratch. */
+                watchSocket(loop, i, -1, 0);
+            }
+        }
+    }
+    loop->iterations++;
+
+    rt_mutex_release(&loop->lock);
+
+    return MQTTSuccess;
+}
+
+static void mqttEventLoopRun(void *parameter)
+{
+    MQTTEventLoop_t *loop = (MQTTEventLoop_t *) parameter;
+
+    while (!loop->stopping)
+    {
+        if (loop->count == 0)
+        {
+            rt_thread_mdelay(RESOLVE_POLL_MS);
+            continue;
+        }
+        (void) mqttEventLoopRunOnce(loop);
+    }
+
+    rt_sem_release(&loop->exited);
+}
+
+MQTTStatus_t mqttEventLoopStart(MQTTEventLoop_t *loop, uint32_t stackSize, uint8_t priority)
+{
+    if ((loop == RT_NULL) || (!loop->initialized) || (loop->thread != RT_NULL))
+    {
+        return MQTTBadParameter;
+    }
+
+    loop->stopping = false;
+    loop->thread = rt_thread_create("mqttloop", mqttEventLoopRun, loop, stackSize, priority, MQTT_CLIENT_TIMESLICE);
+    if (loop->thread == RT_NULL)
+    {
+        return MQTTNoMemory;
+    }
+    rt_thread_startup(loop->thread);
+
+    return MQTTSuccess;
+}
+
+/*
+ * Stops the thread of mqttEventLoopStart() and waits for it to leave its
+ * current iteration, at most MQTT_EVENT_LOOP_MAX_WAIT_MS. Called from the
+ * loop thread itself it only asks. The clients stay added and can be driven
+ * with mqttEventLoopRunOnce() or a new start.
+ */
+void mqttEventLoopStop(MQTTEventLoop_t *loop)
+{
+    if ((loop == RT_NULL) || (!loop->initialized) || (loop->thread == RT_NULL))
+    {
+        return;
+    }
+
+    loop->stopping = true;
+    if (loop->thread != rt_thread_self())
+    {
+        rt_sem_take(&loop->exited, RT_WAITING_FOREVER);
+    }
+    loop->thread = RT_NULL;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+#ifndef APPLICATIONS_FIREMQTT_API_MQTT_EVENT_LOOP_H_
+#define APPLICATIONS_FIREMQTT_API_MQTT_EVENT_LOOP_H_
+
+#include "mqtt_api.h"
+
+/*
+ * Event loop.
+ *
+ * Drives many clients from one thread instead of one mqttClientRun() thread
+ * per connection. Each iteration waits on the sockets of all clients with
+ * poll(), or epoll on Linux hosts, bounded by the earliest client deadline:
+ * a reconnect backoff, a keep-alive or PINGRESP timeout, or at most
+ * MQTT_EVENT_LOOP_MAX_WAIT_MS. Then mqttClientService() runs for every client
+ * whose socket is ready or whose deadline passed. Connections are set up with
+ * the non-blocking connect, so a slow broker never stalls the others.
+ *
+ * Add and remove take the loop lock, which an iteration holds while it waits.
+ * mqttEventLoopDeinit() stops and joins the thread of mqttEventLoopStart()
+ * before the loop memory goes away. A client is in at most one loop, and
+ * mqttClientDeinit() removes it from there.
+ */
+
+struct pollfd;
+struct epoll_event;
+
+typedef struct MQTTEventLoopSlot
+{
+    MQTTClient_t *client;
+    int fd;                     /* Socket registered with epoll, -1 if none. */
+    uint32_t events;            /* Events registered for fd. */
+    uint32_t dueMs;             /* Service the client at this time even if the socket stays quiet. */
+    bool ready;
+} MQTTEventLoopSlot_t;
+
+typedef struct MQTTEventLoop
+{
+    MQTTEventLoopSlot_t *slots;
+    uint16_t maxClients;
+    uint16_t count;
+    struct pollfd *pollFds;     /* poll() backend. */
+    uint16_t *pollSlots;        /* Slot of each pollFds entry. */
+    int epollFd;                /* epoll backend, -1 otherwise. */
+    struct epoll_event *epollEvents;
+    uint32_t iterations;
+    uint32_t serviced;          /* mqttClientService() calls in total. */
+    rt_thread_t thread;         /* Thread started by mqttEventLoopStart(), if any. */
+    struct rt_semaphore exited;
+    volatile bool stopping;
+    struct rt_mutex lock;
+    bool initialized;
+} MQTTEventLoop_t;
+
+MQTTStatus_t mqttEventLoopInit(MQTTEventLoop_t *loop, uint16_t maxClients);
+void mqttEventLoopDeinit(MQTTEventLoop_t *loop);
+MQTTStatus_t mqttEventLoopAdd(MQTTEventLoop_t *loop, MQTTClient_t *client);
+MQTTStatus_t mqttEventLoopRemove(MQTTEventLoop_t *loop, MQTTClient_t *client);
+MQTTStatus_t mqttEventLoopRunOnce(MQTTEventLoop_t *loop);
+MQTTStatus_t mqttEventLoopStart(MQTTEventLoop_t *loop, uint32_t stackSize, uint8_t priority);
+void mqttEventLoopStop(MQTTEventLoop_t *loop);
+
+#endif /* APPLICATIONS_FIREMQTT_API_MQTT_EVENT_LOOP_H_ */
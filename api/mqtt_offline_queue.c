@@ -0,0 +1,764 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+#define DBG_TAG "MQTT"
+#define DBG_LVL DBG_LOG
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "mqtt_api.h"
+#include "mqtt_offline_queue.h"
+
+#if MQTT_OFFLINE_QUEUE_ENABLE
+
+#define SEGMENT_MAGIC           0x514F514DUL    /* "MQOQ" */
+#define SEGMENT_HEADER_SIZE     8U
+#define RECORD_HEADER_SIZE      8U
+#define SEGMENT_PATH_MAX        64U
+
+#define RECORD_FLAG_QOS_MASK    0x03U
+#define RECORD_FLAG_RETAIN      0x04U
+
+/* The state engine hooks are only set in full duplex mode. */
+#ifndef MQTT_PRE_STATE_UPDATE_HOOK
+#define MQTT_PRE_STATE_UPDATE_HOOK(pContext)
+#define MQTT_POST_STATE_UPDATE_HOOK(pContext)
+#endif
+
+static void putU16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t) (v >> 8);
+    p[1] = (uint8_t) v;
+}
+
+static void putU32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t) (v >> 24);
+    p[1] = (uint8_t) (v >> 16);
+    p[2] = (uint8_t) (v >> 8);
+    p[3] = (uint8_t) v;
+}
+
+static uint16_t getU16(const uint8_t *p)
+{
+    return (uint16_t) (((uint16_t) p[0] << 8) | p[1]);
+}
+
+static uint32_t getU32(const uint8_t *p)
+{
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+static void segmentPath(const MQTTOfflineQueue_t *queue, uint32_t seq, char *path, size_t size)
+{
+    rt_snprintf(path, size, "%s/seg%u.log", queue->pPath, (unsigned int) (seq % queue->segmentCount));
+}
+
+static int openSegment(MQTTOfflineQueue_t *queue, uint32_t seq, int flags)
+{
+    char path[SEGMENT_PATH_MAX];
+
+    segmentPath(queue, seq, path, sizeof(path));
+    return open(path, flags, 0644);
+}
+
+static void removeSegment(MQTTOfflineQueue_t *queue, uint32_t seq)
+{
+    char path[SEGMENT_PATH_MAX];
+    uint32_t slot = seq % queue->segmentCount;
+
+    segmentPath(queue, seq, path, sizeof(path));
+    unlink(path);
+    queue->segRecords[slot] = 0;
+    queue->segBytes[slot] = 0;
+}
+
+/* Create an empty segment for headSeq and keep it open for appending. */
+static MQTTStatus_t createHeadSegment(MQTTOfflineQueue_t *queue)
+{
+    uint8_t header[SEGMENT_HEADER_SIZE];
+    uint32_t slot = queue->headSeq % queue->segmentCount;
+
+    queue->headFd = openSegment(queue, queue->headSeq, O_WRONLY | O_CREAT | O_TRUNC);
+    if (queue->headFd < 0)
+    {
+        MQTT_PRINT("Offline queue: failed to create segment %u\n", (unsigned int) slot);
+        return MQTTPublishStoreFailed;
+    }
+
+    putU32(header, SEGMENT_MAGIC);
+    putU32(&header[4], queue->headSeq);
+    if (write(queue->headFd, header, sizeof(header)) != (int) sizeof(header))
+    {
+        close(queue->headFd);
+        queue->headFd = -1;
+        return MQTTPublishStoreFailed;
+    }
+
+    queue->headOffset = SEGMENT_HEADER_SIZE;
+    queue->segRecords[slot] = 0;
+    queue->segBytes[slot] = SEGMENT_HEADER_SIZE;
+    return MQTTSuccess;
+}
+
+/* Count the complete records of one segment slot. Returns false if the slot holds no valid segment. */
+static bool scanSegment(MQTTOfflineQueue_t *queue, uint32_t slot, uint32_t *seq)
+{
+    char path[SEGMENT_PATH_MAX];
+    uint8_t header[RECORD_HEADER_SIZE];
+    uint32_t offset = SEGMENT_HEADER_SIZE, records = 0, length;
+    int fd;
+
+    rt_snprintf(path, sizeof(path), "%s/seg%u.log", queue->pPath, (unsigned int) slot);
+    fd = open(path, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    if ((read(fd, header, SEGMENT_HEADER_SIZE) != (int) SEGMENT_HEADER_SIZE) || (getU32(header) != SEGMENT_MAGIC)
+            || ((getU32(&header[4]) % queue->segmentCount) != slot))
+    {
+        close(fd);
+        unlink(path);
+        return false;
+    }
+    *seq = getU32(&header[4]);
+
+    /* A torn record at the end (power loss during append) ends the scan. */
+    while (read(fd, header, RECORD_HEADER_SIZE) == (int) RECORD_HEADER_SIZE)
+    {
+        length = RECORD_HEADER_SIZE + getU16(&header[2]) + getU32(&header[4]);
+        if ((offset + length > queue->segmentSize) || (lseek(fd, offset + length, SEEK_SET) != (off_t) (offset + length)))
+        {
+            break;
+        }
+        offset += length;
+        records++;
+    }
+    close(fd);
+
+    queue->segRecords[slot] = records;
+    queue->segBytes[slot] = offset;
+    return true;
+}
+
+static void recoverSegments(MQTTOfflineQueue_t *queue)
+{
+    uint32_t slot, seq, found = 0, minSeq = 0, maxSeq = 0;
+
+    for (slot = 0; slot < queue->segmentCount; slot++)
+    {
+        if (scanSegment(queue, slot, &seq))
+        {
+            if ((found == 0) || (seq < minSeq))
+            {
+                minSeq = seq;
+            }
+            if ((found == 0) || (seq > maxSeq))
+            {
+                maxSeq = seq;
+            }
+            found++;
+        }
+    }
+
+    if (found == 0)
+    {
+        return;
+    }
+
+    /* Segments must form one contiguous run of sequence numbers, otherwise the
+     * order cannot be trusted and the whole log is discarded. */
+    if ((maxSeq - minSeq + 1U) != found)
+    {
+        MQTT_PRINT("Offline queue: inconsistent segments, discarding log\n");
+        for (slot = 0; slot < queue->segmentCount; slot++)
+        {
+            removeSegment(queue, slot);
+        }
+        return;
+    }
+
+    queue->tailSeq = minSeq;
+    queue->headSeq = maxSeq;
+    for (seq = minSeq; seq != maxSeq + 1U; seq++)
+    {
+        slot = seq % queue->segmentCount;
+        queue->stats.depth += queue->segRecords[slot];
+        queue->stats.bytes += queue->segBytes[slot] - SEGMENT_HEADER_SIZE;
+    }
+}
+
+MQTTStatus_t mqttOfflineQueueInit(MQTTOfflineQueue_t *queue, const char *path, uint32_t segmentSize,
+        uint32_t segmentCount, MQTTOfflineDropPolicy_t dropPolicy)
+{
+    uint32_t headSlot;
+
+    if ((queue == RT_NULL) || (path == RT_NULL) || (segmentCount < 2U)
+            || (segmentSize <= SEGMENT_HEADER_SIZE + RECORD_HEADER_SIZE))
+    {
+        return MQTTBadParameter;
+    }
+
+    memset(queue, 0, sizeof(*queue));
+    queue->pPath = path;
+    queue->segmentSize = segmentSize;
+    queue->segmentCount = segmentCount;
+    queue->dropPolicy = dropPolicy;
+    queue->headFd = -1;
+    queue->stats.capacity = segmentSize * segmentCount;
+
+    queue->segRecords = rt_calloc(segmentCount, sizeof(uint32_t));
+    queue->segBytes = rt_calloc(segmentCount, sizeof(uint32_t));
+    queue->batchBuffer = rt_malloc(segmentSize);
+    if ((queue->segRecords == RT_NULL) || (queue->segBytes == RT_NULL) || (queue->batchBuffer == RT_NULL))
+    {
+        mqttOfflineQueueDeinit(queue);
+        return MQTTNoMemory;
+    }
+
+    mkdir(path, 0777);
+    recoverSegments(queue);
+
+    headSlot = queue->headSeq % queue->segmentCount;
+    if (queue->segBytes[headSlot] == 0)
+    {
+        if (createHeadSegment(queue) != MQTTSuccess)
+        {
+            mqttOfflineQueueDeinit(queue);
+            return MQTTPublishStoreFailed;
+        }
+    }
+    else
+    {
+        queue->headFd = openSegment(queue, queue->headSeq, O_WRONLY);
+        if (queue->headFd < 0)
+        {
+            mqttOfflineQueueDeinit(queue);
+            return MQTTPublishStoreFailed;
+        }
+        queue->headOffset = queue->segBytes[headSlot];
+        /* Drop any torn record so new appends are not hidden behind it. */
+        ftruncate(queue->headFd, queue->headOffset);
+    }
+
+    /* Records of a partially drained tail segment are published again after a
+     * reboot, which matches the at-least-once contract of QoS 1. */
+    queue->tailOffset = SEGMENT_HEADER_SIZE;
+    queue->tailConsumed = 0;
+    queue->readSeq = queue->tailSeq;
+    queue->readOffset = SEGMENT_HEADER_SIZE;
+
+    rt_mutex_init(&queue->lock, "mqttoq", RT_IPC_FLAG_PRIO);
+    queue->initialized = true;
+
+    if (queue->stats.depth > 0)
+    {
+        MQTT_PRINT("Offline queue: recovered %u records\n", (unsigned int) queue->stats.depth);
+    }
+
+    return MQTTSuccess;
+}
+
+void mqttOfflineQueueDeinit(MQTTOfflineQueue_t *queue)
+{
+    if (queue == RT_NULL)
+    {
+        return;
+    }
+
+    if (queue->initialized)
+    {
+        rt_mutex_detach(&queue->lock);
+        queue->initialized = false;
+    }
+    if (queue->headFd >= 0)
+    {
+        close(queue->headFd);
+        queue->headFd = -1;
+    }
+    if (queue->segRecords != RT_NULL)
+    {
+        rt_free(queue->segRecords);
+        queue->segRecords = RT_NULL;
+    }
+    if (queue->segBytes != RT_NULL)
+    {
+        rt_free(queue->segBytes);
+        queue->segBytes = RT_NULL;
+    }
+    if (queue->batchBuffer != RT_NULL)
+    {
+        rt_free(queue->batchBuffer);
+        queue->batchBuffer = RT_NULL;
+    }
+}
+
+/* Delete the tail segment and move on to the next one. Caller holds the lock. */
+static void removeTailSegment(MQTTOfflineQueue_t *queue)
+{
+    removeSegment(queue, queue->tailSeq);
+    if (queue->readSeq == queue->tailSeq)
+    {
+        queue->readSeq++;
+        queue->readOffset = SEGMENT_HEADER_SIZE;
+    }
+    queue->tailSeq++;
+    queue->tailOffset = SEGMENT_HEADER_SIZE;
+    queue->tailConsumed = 0;
+}
+
+/* Discard whatever is left of the tail segment. Caller holds the lock. */
+static void dropTailSegment(MQTTOfflineQueue_t *queue)
+{
+    uint32_t slot = queue->tailSeq % queue->segmentCount;
+    uint32_t records = queue->segRecords[slot] - queue->tailConsumed;
+
+    queue->stats.depth -= records;
+    queue->stats.bytes -= queue->segBytes[slot] - queue->tailOffset;
+    queue->stats.dropped += records;
+
+    /* Acks of records in flight from this segment no longer matter. */
+    while ((queue->inflightCount > 0) && (queue->inflight[queue->inflightHead].seq == queue->tailSeq))
+    {
+        queue->inflightHead = (queue->inflightHead + 1U) % MQTT_OFFLINE_QUEUE_INFLIGHT;
+        queue->inflightCount--;
+    }
+
+    removeTailSegment(queue);
+}
+
+/* Start a new head segment, applying the drop policy when all slots are used. Caller holds the lock. */
+static MQTTStatus_t rollHeadSegment(MQTTOfflineQueue_t *queue)
+{
+    if ((queue->headSeq - queue->tailSeq + 1U) >= queue->segmentCount)
+    {
+        if (queue->dropPolicy == MQTTOfflineDropNewest)
+        {
+            return MQTTNoMemory;
+        }
+        dropTailSegment(queue);
+    }
+
+    close(queue->headFd);
+    queue->headFd = -1;
+    queue->headSeq++;
+    return createHeadSegment(queue);
+}
+
+MQTTStatus_t mqttOfflineQueueAppend(MQTTOfflineQueue_t *queue, const MQTTPublishInfo_t *publishInfo)
+{
+    MQTTStatus_t status = MQTTSuccess;
+    uint8_t header[RECORD_HEADER_SIZE];
+    uint32_t length, slot;
+
+    if ((queue == RT_NULL) || (!queue->initialized) || (publishInfo == RT_NULL))
+    {
+        return MQTTBadParameter;
+    }
+
+    length = RECORD_HEADER_SIZE + publishInfo->topicNameLength + (uint32_t) publishInfo->payloadLength;
+    if (length > queue->segmentSize - SEGMENT_HEADER_SIZE)
+    {
+        MQTT_PRINT("Offline queue: %u byte record exceeds segment size\n", (unsigned int) length);
+        rt_mutex_take(&queue->lock, RT_WAITING_FOREVER);
+        queue->stats.dropped++;
+        rt_mutex_release(&queue->lock);
+        return MQTTNoMemory;
+    }
+
+    header[0] = (uint8_t) ((publishInfo->qos & RECORD_FLAG_QOS_MASK) | (publishInfo->retain ? RECORD_FLAG_RETAIN : 0U));
+    header[1] = 0;
+    putU16(&header[2], publishInfo->topicNameLength);
+    putU32(&header[4], (uint32_t) publishInfo->payloadLength);
+
+    rt_mutex_take(&queue->lock, RT_WAITING_FOREVER);
+
+    if ((queue->headFd < 0) || (queue->headOffset + length > queue->segmentSize))
+    {
+        status = (queue->headFd < 0) ? createHeadSegment(queue) : rollHeadSegment(queue);
+    }
+
+    if (status == MQTTSuccess)
+    {
+        lseek(queue->headFd, queue->headOffset, SEEK_SET);
+        if ((write(queue->headFd, header, sizeof(header)) != (int) sizeof(header))
+                || (write(queue->headFd, publishInfo->pTopicName, publishInfo->topicNameLength)
+                        != (int) publishInfo->topicNameLength)
+                || ((publishInfo->payloadLength > 0)
+                        && (write(queue->headFd, publishInfo->pPayload, publishInfo->payloadLength)
+                                != (int) publishInfo->payloadLength)))
+        {
+            /* The torn record is overwritten by the next append. */
+            status = MQTTPublishStoreFailed;
+        }
+    }
+
+    if (status == MQTTSuccess)
+    {
+        slot = queue->headSeq % queue->segmentCount;
+        queue->headOffset += length;
+        queue->segBytes[slot] += length;
+        queue->segRecords[slot]++;
+        queue->stats.depth++;
+        queue->stats.bytes += length;
+    }
+    else
+    {
+        queue->stats.dropped++;
+    }
+
+    rt_mutex_release(&queue->lock);
+
+    return status;
+}
+
+/* Number of outgoing QoS>0 publishes the state engine can still accept. */
+static size_t freeOutgoingRecords(MQTTContext_t *context)
+{
+    size_t i, used = 0;
+
+    /* The reader frees records as acks arrive. */
+    MQTT_PRE_STATE_UPDATE_HOOK(context);
+    for (i = 0; i < context->outgoingPublishRecordMaxCount; i++)
+    {
+        if (context->outgoingPublishRecords[i].packetId != MQTT_PACKET_ID_INVALID)
+        {
+            used++;
+        }
+    }
+    MQTT_POST_STATE_UPDATE_HOOK(context);
+
+    return context->outgoingPublishRecordMaxCount - used;
+}
+
+/* Read the unpublished records of the read segment into batchBuffer, starting at *offset. */
+static uint32_t readBatch(MQTTOfflineQueue_t *queue, uint32_t *seq, uint32_t *offset)
+{
+    uint32_t slot, length = 0;
+    int fd;
+
+    rt_mutex_take(&queue->lock, RT_WAITING_FOREVER);
+
+    slot = queue->readSeq % queue->segmentCount;
+    while ((queue->readOffset >= queue->segBytes[slot]) && (queue->readSeq != queue->headSeq))
+    {
+        queue->readSeq++;
+        queue->readOffset = SEGMENT_HEADER_SIZE;
+        slot = queue->readSeq % queue->segmentCount;
+    }
+
+    if (queue->readOffset < queue->segBytes[slot])
+    {
+        if (queue->readSeq == queue->headSeq)
+        {
+            /* Make appended data visible to the reading descriptor. */
+            fsync(queue->headFd);
+        }
+
+        fd = openSegment(queue, queue->readSeq, O_RDONLY);
+        if (fd >= 0)
+        {
+            length = queue->segBytes[slot] - queue->readOffset;
+            if ((lseek(fd, queue->readOffset, SEEK_SET) != (off_t) queue->readOffset)
+                    || (read(fd, queue->batchBuffer, length) != (int) length))
+            {
+                length = 0;
+            }
+            close(fd);
+        }
+        *seq = queue->readSeq;
+        *offset = queue->readOffset;
+    }
+
+    rt_mutex_release(&queue->lock);
+
+    return length;
+}
+
+/* Commit the leading acked records and delete the segments they emptied. Caller holds the lock. */
+static void advanceTail(MQTTOfflineQueue_t *queue)
+{
+    MQTTOfflineInflight_t *entry;
+
+    for (;;)
+    {
+        if ((queue->tailSeq != queue->headSeq)
+                && (queue->tailOffset >= queue->segBytes[queue->tailSeq % queue->segmentCount]))
+        {
+            removeTailSegment(queue);
+            continue;
+        }
+
+        if (queue->inflightCount == 0)
+        {
+            break;
+        }
+        entry = &queue->inflight[queue->inflightHead];
+        if (!entry->acked)
+        {
+            break;
+        }
+
+        /* Records are published and committed in file order. */
+        queue->tailOffset += entry->length;
+        queue->tailConsumed++;
+        queue->stats.depth--;
+        queue->stats.bytes -= entry->length;
+        queue->stats.drained++;
+        queue->inflightHead = (queue->inflightHead + 1U) % MQTT_OFFLINE_QUEUE_INFLIGHT;
+        queue->inflightCount--;
+    }
+
+    /* Fully drained while sharing the head segment: start over with a fresh file. */
+    if ((queue->stats.depth == 0) && (queue->tailSeq == queue->headSeq))
+    {
+        close(queue->headFd);
+        queue->headFd = -1;
+        removeSegment(queue, queue->headSeq);
+        queue->headSeq++;
+        queue->tailSeq = queue->headSeq;
+        queue->tailOffset = SEGMENT_HEADER_SIZE;
+        queue->tailConsumed = 0;
+        queue->readSeq = queue->headSeq;
+        queue->readOffset = SEGMENT_HEADER_SIZE;
+        createHeadSegment(queue);
+    }
+}
+
+static bool inflightFull(MQTTOfflineQueue_t *queue)
+{
+    bool full;
+
+    rt_mutex_take(&queue->lock, RT_WAITING_FOREVER);
+    full = (queue->inflightCount == MQTT_OFFLINE_QUEUE_INFLIGHT);
+    rt_mutex_release(&queue->lock);
+
+    return full;
+}
+
+/*
+ * Note a record as in flight before it is sent, so that its ack cannot arrive
+ * first. Returns false if the drop policy removed the segment meanwhile.
+ */
+static bool trackRecord(MQTTOfflineQueue_t *queue, uint32_t seq, uint32_t offset, uint32_t length, uint16_t packetId)
+{
+    MQTTOfflineInflight_t *entry;
+    bool tracked = false;
+
+    rt_mutex_take(&queue->lock, RT_WAITING_FOREVER);
+    if ((queue->readSeq == seq) && (queue->readOffset == offset))
+    {
+        entry = &queue->inflight[(queue->inflightHead + queue->inflightCount) % MQTT_OFFLINE_QUEUE_INFLIGHT];
+        entry->seq = seq;
+        entry->offset = offset;
+        entry->length = length;
+        entry->packetId = packetId;
+        entry->acked = false;
+        queue->inflightCount++;
+        queue->readOffset += length;
+        tracked = true;
+    }
+    rt_mutex_release(&queue->lock);
+
+    return tracked;
+}
+
+/*
+ * Settle the record tracked last once MQTT_Publish returned. A record that was
+ * not sent is published again by the next pass; a sent QoS 0 record needs no
+ * ack and is committed right away.
+ */
+static void settleRecord(MQTTOfflineQueue_t *queue, uint32_t seq, uint32_t offset, bool sent)
+{
+    MQTTOfflineInflight_t *entry;
+
+    rt_mutex_take(&queue->lock, RT_WAITING_FOREVER);
+    entry = &queue->inflight[(queue->inflightHead + queue->inflightCount + MQTT_OFFLINE_QUEUE_INFLIGHT - 1U)
+            % MQTT_OFFLINE_QUEUE_INFLIGHT];
+    if ((queue->inflightCount > 0) && (entry->seq == seq) && (entry->offset == offset))
+    {
+        if (!sent)
+        {
+            queue->inflightCount--;
+            queue->readSeq = seq;
+            queue->readOffset = offset;
+        }
+        else if (entry->packetId == MQTT_PACKET_ID_INVALID)
+        {
+            entry->acked = true;
+            advanceTail(queue);
+        }
+    }
+    rt_mutex_release(&queue->lock);
+}
+
+/*
+ * Publish up to maxRecords records. The pass ends at the first QoS 1/2 record
+ * that finds no free state engine slot, it never waits for acks.
+ */
+static MQTTStatus_t drainRecords(MQTTOfflineQueue_t *queue, MQTTContext_t *context, uint32_t maxRecords)
+{
+    MQTTStatus_t status = MQTTSuccess;
+    MQTTPublishInfo_t publishInfo;
+    uint32_t startMs, elapsedMs, count = 0, length, offset, recordLength, seq = 0, base = 0;
+    uint16_t packetId;
+    bool windowFull = false;
+
+    startMs = getCurrentTime();
+
+    while ((status == MQTTSuccess) && !windowFull && (count < maxRecords)
+            && ((length = readBatch(queue, &seq, &base)) > 0))
+    {
+        for (offset = 0; (offset + RECORD_HEADER_SIZE <= length) && (status == MQTTSuccess) && (count < maxRecords);
+                offset += recordLength)
+        {
+            const uint8_t *record = &queue->batchBuffer[offset];
+
+            memset(&publishInfo, 0, sizeof(publishInfo));
+            publishInfo.qos = (MQTTQoS_t) (record[0] & RECORD_FLAG_QOS_MASK);
+            publishInfo.retain = (record[0] & RECORD_FLAG_RETAIN) != 0U;
+            publishInfo.topicNameLength = getU16(&record[2]);
+            publishInfo.payloadLength = getU32(&record[4]);
+            publishInfo.pTopicName = (const char *) &record[RECORD_HEADER_SIZE];
+            publishInfo.pPayload = &record[RECORD_HEADER_SIZE + publishInfo.topicNameLength];
+            recordLength = RECORD_HEADER_SIZE + publishInfo.topicNameLength + (uint32_t) publishInfo.payloadLength;
+
+            if (offset + recordLength > length)
+            {
+                break;
+            }
+
+            /* QoS 1/2 records are windowed by the free state engine slots so
+             * the drain never fails with MQTTNoMemory. */
+            if (inflightFull(queue) || ((publishInfo.qos > MQTTQoS0) && (freeOutgoingRecords(context) == 0)))
+            {
+                windowFull = true;
+                break;
+            }
+
+            packetId = (publishInfo.qos > MQTTQoS0) ? MQTT_GetPacketId(context) : MQTT_PACKET_ID_INVALID;
+            if (!trackRecord(queue, seq, base + offset, recordLength, packetId))
+            {
+                /* The segment was dropped while publishing, re-read from the new tail. */
+                break;
+            }
+
+            status = MQTT_Publish(context, &publishInfo, packetId);
+            settleRecord(queue, seq, base + offset, status == MQTTSuccess);
+            if (status == MQTTSuccess)
+            {
+                count++;
+            }
+        }
+    }
+
+    elapsedMs = getCurrentTime() - startMs;
+    if (count > 0)
+    {
+        rt_mutex_take(&queue->lock, RT_WAITING_FOREVER);
+        queue->stats.lastDrainCount = count;
+        queue->stats.lastDrainMs = elapsedMs;
+        queue->stats.drainRate = (uint32_t) (((uint64_t) count * 1000U) / ((elapsedMs > 0) ? elapsedMs : 1U));
+        rt_mutex_release(&queue->lock);
+    }
+
+    return status;
+}
+
+MQTTStatus_t mqttOfflineQueueDrain(MQTTOfflineQueue_t *queue, MQTTContext_t *context)
+{
+    if ((queue == RT_NULL) || (!queue->initialized) || (context == RT_NULL))
+    {
+        return MQTTBadParameter;
+    }
+
+    return drainRecords(queue, context, UINT32_MAX);
+}
+
+MQTTStatus_t mqttOfflineQueueDrainSome(MQTTOfflineQueue_t *queue, MQTTContext_t *context, uint32_t maxRecords)
+{
+    if ((queue == RT_NULL) || (!queue->initialized) || (context == RT_NULL))
+    {
+        return MQTTBadParameter;
+    }
+
+    return drainRecords(queue, context, maxRecords);
+}
+
+void mqttOfflineQueueAck(MQTTOfflineQueue_t *queue, uint16_t packetId)
+{
+    MQTTOfflineInflight_t *entry;
+    uint32_t i;
+
+    if ((queue == RT_NULL) || (!queue->initialized) || (packetId == MQTT_PACKET_ID_INVALID))
+    {
+        return;
+    }
+
+    rt_mutex_take(&queue->lock, RT_WAITING_FOREVER);
+    for (i = 0; i < queue->inflightCount; i++)
+    {
+        entry = &queue->inflight[(queue->inflightHead + i) % MQTT_OFFLINE_QUEUE_INFLIGHT];
+        if (!entry->acked && (entry->packetId == packetId))
+        {
+            entry->acked = true;
+            advanceTail(queue);
+            break;
+        }
+    }
+    rt_mutex_release(&queue->lock);
+}
+
+void mqttOfflineQueueRewind(MQTTOfflineQueue_t *queue)
+{
+    if ((queue == RT_NULL) || (!queue->initialized))
+    {
+        return;
+    }
+
+    rt_mutex_take(&queue->lock, RT_WAITING_FOREVER);
+    queue->inflightHead = 0;
+    queue->inflightCount = 0;
+    queue->readSeq = queue->tailSeq;
+    queue->readOffset = queue->tailOffset;
+    rt_mutex_release(&queue->lock);
+}
+
+uint32_t mqttOfflineQueueDepth(MQTTOfflineQueue_t *queue)
+{
+    if ((queue == RT_NULL) || (!queue->initialized))
+    {
+        return 0;
+    }
+
+    return queue->stats.depth;
+}
+
+void mqttOfflineQueueGetStats(MQTTOfflineQueue_t *queue, MQTTOfflineQueueStats_t *stats)
+{
+    if ((queue == RT_NULL) || (stats == RT_NULL))
+    {
+        return;
+    }
+
+    if (!queue->initialized)
+    {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    rt_mutex_take(&queue->lock, RT_WAITING_FOREVER);
+    *stats = queue->stats;
+    rt_mutex_release(&queue->lock);
+}
+
+#endif /* MQTT_OFFLINE_QUEUE_ENABLE */
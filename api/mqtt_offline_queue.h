@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+#ifndef APPLICATIONS_FIREMQTT_API_MQTT_OFFLINE_QUEUE_H_
+#define APPLICATIONS_FIREMQTT_API_MQTT_OFFLINE_QUEUE_H_
+
+#include <rtthread.h>
+#include <core_mqtt.h>
+
+/*
+ * Offline publish queue.
+ *
+ * While the broker link is down, publishes are appended to a ring of segment
+ * files ("<path>/seg<slot>.log"). Each segment starts with a small header that
+ * carries a sequence number so the queue order survives a reboot. Records are
+ * laid out as:
+ *
+ *   flags(1) reserved(1) topicLength(2) payloadLength(4) topic payload
+ *
+ * A QoS 1/2 record stays on disk until its PUBACK/PUBCOMP is passed to
+ * mqttOfflineQueueAck(), a QoS 0 record once it is sent. A segment is deleted
+ * once every record in it has been committed, so the on-disk footprint never
+ * exceeds segmentSize * segmentCount bytes. mqttOfflineQueueRewind() makes the
+ * next drain start over at the oldest uncommitted record, which a new session
+ * must do since the acks of the old one are never coming.
+ *
+ * Draining never blocks: a pass publishes records until the queue is empty or
+ * the state engine has no free slot for a QoS 1/2 record, the caller runs the
+ * process loop and drains again once acks have come back.
+ */
+
+typedef enum MQTTOfflineDropPolicy
+{
+    MQTTOfflineDropOldest = 0,  /* Delete the oldest segment to make room. */
+    MQTTOfflineDropNewest       /* Reject the publish that does not fit. */
+} MQTTOfflineDropPolicy_t;
+
+typedef struct MQTTOfflineQueueStats
+{
+    uint32_t depth;             /* Records currently queued. */
+    uint32_t bytes;             /* Bytes of queued records, headers included. */
+    uint32_t capacity;          /* Maximum bytes the queue may hold on disk. */
+    uint32_t dropped;           /* Records lost to the drop policy. */
+    uint32_t drained;           /* Records committed from the queue in total. */
+    uint32_t lastDrainCount;    /* Records published by the last drain pass. */
+    uint32_t lastDrainMs;       /* Duration of the last drain pass. */
+    uint32_t drainRate;         /* Records per second of the last drain pass. */
+} MQTTOfflineQueueStats_t;
+
+typedef struct MQTTOfflineInflight
+{
+    uint32_t seq;               /* Segment of the record. */
+    uint32_t offset;            /* Offset of the record inside its segment. */
+    uint32_t length;            /* Record length, header included. */
+    uint16_t packetId;          /* MQTT_PACKET_ID_INVALID for QoS 0. */
+    bool acked;                 /* Ready to commit once every older record is. */
+} MQTTOfflineInflight_t;
+
+typedef struct MQTTOfflineQueue
+{
+    const char *pPath;
+    uint32_t segmentSize;
+    uint32_t segmentCount;
+    MQTTOfflineDropPolicy_t dropPolicy;
+
+    uint32_t headSeq;           /* Sequence of the segment being appended to. */
+    uint32_t tailSeq;           /* Sequence of the oldest uncommitted segment. */
+    uint32_t headOffset;        /* Write offset inside the head segment. */
+    uint32_t tailOffset;        /* Offset of the oldest uncommitted record. */
+    uint32_t tailConsumed;      /* Records already committed from the tail segment. */
+    uint32_t readSeq;           /* Sequence of the segment being published from. */
+    uint32_t readOffset;        /* Offset of the next record to publish. */
+    int headFd;
+
+    MQTTOfflineInflight_t inflight[MQTT_OFFLINE_QUEUE_INFLIGHT]; /* Published, oldest first. */
+    uint32_t inflightHead;
+    uint32_t inflightCount;
+
+    uint32_t *segRecords;       /* Records written to each segment slot. */
+    uint32_t *segBytes;         /* Valid bytes (header included) of each slot. */
+    uint8_t *batchBuffer;       /* segmentSize bytes, used to read a batch. */
+
+    MQTTOfflineQueueStats_t stats;
+    struct rt_mutex lock;
+    bool initialized;
+} MQTTOfflineQueue_t;
+
+MQTTStatus_t mqttOfflineQueueInit(MQTTOfflineQueue_t *queue, const char *path, uint32_t segmentSize,
+        uint32_t segmentCount, MQTTOfflineDropPolicy_t dropPolicy);
+void mqttOfflineQueueDeinit(MQTTOfflineQueue_t *queue);
+MQTTStatus_t mqttOfflineQueueAppend(MQTTOfflineQueue_t *queue, const MQTTPublishInfo_t *publishInfo);
+MQTTStatus_t mqttOfflineQueueDrain(MQTTOfflineQueue_t *queue, MQTTContext_t *context);
+MQTTStatus_t mqttOfflineQueueDrainSome(MQTTOfflineQueue_t *queue, MQTTContext_t *context, uint32_t maxRecords);
+void mqttOfflineQueueAck(MQTTOfflineQueue_t *queue, uint16_t packetId);
+void mqttOfflineQueueRewind(MQTTOfflineQueue_t *queue);
+uint32_t mqttOfflineQueueDepth(MQTTOfflineQueue_t *queue);
+void mqttOfflineQueueGetStats(MQTTOfflineQueue_t *queue, MQTTOfflineQueueStats_t *stats);
+
+#endif /* APPLICATIONS_FIREMQTT_API_MQTT_OFFLINE_QUEUE_H_ */
@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+#define DBG_TAG "MQTT"
+#define DBG_LVL DBG_LOG
+
+#include "mqtt_api.h"
+#include "mqtt_subscription.h"
+
+/* Fixed header (2), packet identifier (2) of a SUBACK, one return code per filter follows. */
+#define SUBACK_OVERHEAD     4U
+
+MQTTStatus_t mqttSubscriptionInit(MQTTSubscriptionRegistry_t *registry, size_t maxCount, size_t maxPacketSize,
+        size_t receiveBufferSize)
+{
+    if ((registry == RT_NULL) || (maxCount == 0) || (receiveBufferSize <= SUBACK_OVERHEAD))
+    {
+        return MQTTBadParameter;
+    }
+
+    memset(registry, 0, sizeof(*registry));
+    registry->subscriptions = rt_calloc(maxCount, sizeof(MQTTSubscribeInfo_t));
+    if (registry->subscriptions == RT_NULL)
+    {
+        return MQTTNoMemory;
+    }
+
+    registry->maxCount = maxCount;
+    registry->maxPacketSize = maxPacketSize;
+    registry->maxAckSize = receiveBufferSize;
+    rt_mutex_init(&registry->lock, "mqttsub", RT_IPC_FLAG_PRIO);
+    registry->initialized = true;
+
+    return MQTTSuccess;
+}
+
+void mqttSubscriptionDeinit(MQTTSubscriptionRegistry_t *registry)
+{
+    size_t i;
+
+    if ((registry == RT_NULL) || (!registry->initialized))
+    {
+        return;
+    }
+
+    for (i = 0; i < registry->count; i++)
+    {
+        rt_free((void *) registry->subscriptions[i].pTopicFilter);
+    }
+    rt_free(registry->subscriptions);
+    registry->subscriptions = RT_NULL;
+    registry->count = 0;
+    rt_mutex_detach(&registry->lock);
+    registry->initialized = false;
+}
+
+static bool sameFilter(const MQTTSubscribeInfo_t *a, const MQTTSubscribeInfo_t *b)
+{
+    return (a->topicFilterLength == b->topicFilterLength)
+            && (memcmp(a->pTopicFilter, b->pTopicFilter, b->topicFilterLength) == 0);
+}
+
+static size_t findSubscription(const MQTTSubscriptionRegistry_t *registry, const MQTTSubscribeInfo_t *subscribeInfo)
+{
+    size_t i;
+
+    for (i = 0; i < registry->count; i++)
+    {
+        if (sameFilter(&registry->subscriptions[i], subscribeInfo))
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/* Filters of the list the registry does not hold yet, each counted once. */
+static size_t countNewFilters(const MQTTSubscriptionRegistry_t *registry, const MQTTSubscribeInfo_t *subscribeInfo,
+        size_t count)
+{
+    size_t i, j, added = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        if (findSubscription(registry, &subscribeInfo[i]) < registry->count)
+        {
+            continue;
+        }
+        for (j = 0; j < i; j++)
+        {
+            if (sameFilter(&subscribeInfo[j], &subscribeInfo[i]))
+            {
+                break;
+            }
+        }
+        added += (j == i) ? 1U : 0U;
+    }
+
+    return added;
+}
+
+/*
+ * Adds a list of filters as a whole: on failure the registry is left as it
+ * was, so a SUBSCRIBE that is never sent is not restored after a reconnect.
+ */
+MQTTStatus_t mqttSubscriptionAdd(MQTTSubscriptionRegistry_t *registry, const MQTTSubscribeInfo_t *subscribeInfo,
+        size_t count)
+{
+    MQTTStatus_t status = MQTTSuccess;
+    MQTTSubscribeInfo_t *entry;
+    char *filter;
+    size_t i, start;
+
+    if ((registry == RT_NULL) || (!registry->initialized) || (subscribeInfo == RT_NULL))
+    {
+        return MQTTBadParameter;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        if ((subscribeInfo[i].pTopicFilter == RT_NULL) || (subscribeInfo[i].topicFilterLength == 0))
+        {
+            return MQTTBadParameter;
+        }
+    }
+
+    rt_mutex_take(&registry->lock, RT_WAITING_FOREVER);
+
+    start = registry->count;
+    if (countNewFilters(registry, subscribeInfo, count) > registry->maxCount - registry->count)
+    {
+        status = MQTTNoMemory;
+    }
+
+    for (i = 0; (i < count) && (status == MQTTSuccess); i++)
+    {
+        if (findSubscription(registry, &subscribeInfo[i]) < registry->count)
+        {
+            continue;
+        }
+
+        filter = rt_malloc(subscribeInfo[i].topicFilterLength + 1U);
+        if (filter == RT_NULL)
+        {
+            status = MQTTNoMemory;
+            break;
+        }
+        memcpy(filter, subscribeInfo[i].pTopicFilter, subscribeInfo[i].topicFilterLength);
+        filter[subscribeInfo[i].topicFilterLength] = '\0';
+
+        entry = &registry->subscriptions[registry->count++];
+        entry->pTopicFilter = filter;
+        entry->topicFilterLength = subscribeInfo[i].topicFilterLength;
+    }
+
+    if (status == MQTTSuccess)
+    {
+        /* Subscribing again only updates the QoS, as on the broker. */
+        for (i = 0; i < count; i++)
+        {
+            registry->subscriptions[findSubscription(registry, &subscribeInfo[i])].qos = subscribeInfo[i].qos;
+        }
+    }
+    else
+    {
+        while (registry->count > start)
+        {
+            rt_free((void *) registry->subscriptions[--registry->count].pTopicFilter);
+        }
+    }
+
+    rt_mutex_release(&registry->lock);
+
+    return status;
+}
+
+MQTTStatus_t mqttSubscriptionRemove(MQTTSubscriptionRegistry_t *registry, const MQTTSubscribeInfo_t *subscribeInfo,
+        size_t count)
+{
+    size_t i, index;
+
+    if ((registry == RT_NULL) || (!registry->initialized) || (subscribeInfo == RT_NULL))
+    {
+        return MQTTBadParameter;
+    }
+
+    rt_mutex_take(&registry->lock, RT_WAITING_FOREVER);
+
+    for (i = 0; i < count; i++)
+    {
+        index = findSubscription(registry, &subscribeInfo[i]);
+        if (index < registry->count)
+        {
+            rt_free((void *) registry->subscriptions[index].pTopicFilter);
+            registry->count--;
+            memmove(&registry->subscriptions[index], &registry->subscriptions[index + 1U],
+                    (registry->count - index) * sizeof(MQTTSubscribeInfo_t));
+        }
+    }
+
+    rt_mutex_release(&registry->lock);
+
+    return MQTTSuccess;
+}
+
+/* Number of filters from list that fit into one SUBSCRIBE and its SUBACK. */
+static size_t batchLength(const MQTTSubscriptionRegistry_t *registry, const MQTTSubscribeInfo_t *list, size_t count)
+{
+    size_t length = 1, remainingLength, packetSize;
+
+    while (length < count)
+    {
+        if ((SUBACK_OVERHEAD + length + 1U > registry->maxAckSize)
+                || (MQTT_GetSubscribePacketSize(list, length + 1U, &remainingLength, &packetSize) != MQTTSuccess)
+                || (packetSize > registry->maxPacketSize))
+        {
+            break;
+        }
+        length++;
+    }
+
+    return length;
+}
+
+MQTTStatus_t mqttSubscriptionSend(MQTTSubscriptionRegistry_t *registry, MQTTContext_t *context,
+        const MQTTSubscribeInfo_t *subscribeInfo, size_t count, uint32_t *pPackets)
+{
+    MQTTStatus_t status = MQTTSuccess;
+    size_t sent = 0, length;
+    uint32_t packets = 0;
+
+    if ((registry == RT_NULL) || (context == RT_NULL) || ((subscribeInfo == RT_NULL) && (count > 0)))
+    {
+        return MQTTBadParameter;
+    }
+
+    while ((sent < count) && (status == MQTTSuccess))
+    {
+        length = batchLength(registry, &subscribeInfo[sent], count - sent);
+        status = MQTT_Subscribe(context, &subscribeInfo[sent], length, MQTT_GetPacketId(context));
+        if (status == MQTTSuccess)
+        {
+            sent += length;
+            packets++;
+        }
+    }
+
+    if (pPackets != RT_NULL)
+    {
+        *pPackets = packets;
+    }
+
+    return status;
+}
+
+MQTTStatus_t mqttSubscriptionRestore(MQTTSubscriptionRegistry_t *registry, MQTTContext_t *context)
+{
+    MQTTStatus_t status;
+    uint32_t startMs, packets = 0;
+
+    if ((registry == RT_NULL) || (!registry->initialized) || (context == RT_NULL))
+    {
+        return MQTTBadParameter;
+    }
+
+    rt_mutex_take(&registry->lock, RT_WAITING_FOREVER);
+
+    startMs = getCurrentTime();
+    status = mqttSubscriptionSend(registry, context, registry->subscriptions, registry->count, &packets);
+    registry->lastResubscribeMs = getCurrentTime() - startMs;
+    registry->lastResubscribePackets = packets;
+
+    if ((status == MQTTSuccess) && (registry->count > 0))
+    {
+        MQTT_PRINT("Restored %u subscriptions in %u SUBSCRIBE packets (%u ms)\n", (unsigned int) registry->count,
+                (unsigned int) packets, (unsigned int) registry->lastResubscribeMs);
+    }
+
+    rt_mutex_release(&registry->lock);
+
+    return status;
+}
+
+size_t mqttSubscriptionCount(MQTTSubscriptionRegistry_t *registry)
+{
+    if ((registry == RT_NULL) || (!registry->initialized))
+    {
+        return 0;
+    }
+
+    return registry->count;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+#ifndef APPLICATIONS_FIREMQTT_API_MQTT_SUBSCRIPTION_H_
+#define APPLICATIONS_FIREMQTT_API_MQTT_SUBSCRIPTION_H_
+
+#include <rtthread.h>
+#include <core_mqtt.h>
+
+/*
+ * Subscription registry.
+ *
+ * Keeps a copy of every active topic filter and its QoS so the subscriptions
+ * can be restored after a clean-session reconnect. Entries are kept packed in
+ * one MQTTSubscribeInfo_t array, which lets a resubscribe hand slices of it
+ * straight to MQTT_Subscribe() and cover many filters with each SUBSCRIBE.
+ */
+
+typedef struct MQTTSubscriptionRegistry
+{
+    MQTTSubscribeInfo_t *subscriptions;
+    size_t count;
+    size_t maxCount;
+    size_t maxPacketSize;       /* Largest SUBSCRIBE to send. */
+    size_t maxAckSize;          /* Largest SUBACK the receive buffer can hold. */
+    uint32_t lastResubscribeMs;
+    uint32_t lastResubscribePackets;
+    struct rt_mutex lock;
+    bool initialized;
+} MQTTSubscriptionRegistry_t;
+
+MQTTStatus_t mqttSubscriptionInit(MQTTSubscriptionRegistry_t *registry, size_t maxCount, size_t maxPacketSize,
+        size_t receiveBufferSize);
+void mqttSubscriptionDeinit(MQTTSubscriptionRegistry_t *registry);
+MQTTStatus_t mqttSubscriptionAdd(MQTTSubscriptionRegistry_t *registry, const MQTTSubscribeInfo_t *subscribeInfo,
+        size_t count);
+MQTTStatus_t mqttSubscriptionRemove(MQTTSubscriptionRegistry_t *registry, const MQTTSubscribeInfo_t *subscribeInfo,
+        size_t count);
+MQTTStatus_t mqttSubscriptionSend(MQTTSubscriptionRegistry_t *registry, MQTTContext_t *context,
+        const MQTTSubscribeInfo_t *subscribeInfo, size_t count, uint32_t *pPackets);
+MQTTStatus_t mqttSubscriptionRestore(MQTTSubscriptionRegistry_t *registry, MQTTContext_t *context);
+size_t mqttSubscriptionCount(MQTTSubscriptionRegistry_t *registry);
+
+#endif /* APPLICATIONS_FIREMQTT_API_MQTT_SUBSCRIPTION_H_ */
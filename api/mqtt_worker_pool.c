@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+#define DBG_TAG "MQTT"
+#define DBG_LVL DBG_LOG
+
+#include "mqtt_api.h"
+#include "mqtt_worker_pool.h"
+
+static uint32_t topicHash(const char *topic, uint16_t length)
+{
+    uint32_t hash = 2166136261UL;
+    uint16_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        hash ^= (uint8_t) topic[i];
+        hash *= 16777619UL;
+    }
+
+    return hash;
+}
+
+static void deliver(MQTTWorkerPool_t *pool, MQTTWorkerMessage_t *message)
+{
+    MQTTDeserializedInfo_t deserializedInfo;
+
+    memset(&deserializedInfo, 0, sizeof(deserializedInfo));
+    deserializedInfo.packetIdentifier = message->packetId;
+    deserializedInfo.pPublishInfo = &message->publishInfo;
+    deserializedInfo.deserializationResult = MQTTSuccess;
+    pool->handler(pool->context, &deserializedInfo, pool->pUserData);
+}
+
+static void workerEntry(void *parameter)
+{
+    MQTTWorker_t *worker = (MQTTWorker_t *) parameter;
+    MQTTWorkerPool_t *pool = worker->pool;
+    MQTTWorkerMessage_t message;
+    MQTTWorkerAck_t *ack;
+
+    while (1)
+    {
+        rt_sem_take(&worker->items, RT_WAITING_FOREVER);
+
+        rt_mutex_take(&pool->lock, RT_WAITING_FOREVER);
+        if (worker->count == 0)
+        {
+            rt_mutex_release(&pool->lock);
+            if (pool->stopping)
+            {
+                break;
+            }
+            continue;
+        }
+        message = worker->queue[worker->head];
+        rt_mutex_release(&pool->lock);
+
+        /* The slot buffer stays loaned to the handler until the head moves on. */
+        deliver(pool, &message);
+        if (message.allocated)
+        {
+            rt_free(message.data);
+        }
+
+        rt_mutex_take(&pool->lock, RT_WAITING_FOREVER);
+        worker->head = (uint16_t) ((worker->head + 1U) % pool->queueDepth);
+        worker->count--;
+        pool->stats.completed++;
+        if ((pool->ackMode == MQTTWorkerAckOnComplete) && (message.publishInfo.qos > MQTTQoS0))
+        {
+            ack = &pool->acks[(pool->ackHead + pool->ackCount) % ((uint32_t) pool->workerCount * pool->queueDepth)];
+            ack->packetId = message.packetId;
+            ack->qos = message.publishInfo.qos;
+            ack->session = message.session;
+            pool->ackCount++;
+        }
+        rt_mutex_release(&pool->lock);
+
+        rt_sem_release(&worker->space);
+    }
+
+    rt_sem_release(&pool->exited);
+}
+
+size_t mqttWorkerPoolMemoryEstimate(uint16_t workerCount, uint16_t queueDepth, size_t slotSize, uint32_t stackSize)
+{
+    size_t perWorker;
+
+    perWorker = sizeof(MQTTWorker_t) + stackSize;
+    perWorker += (size_t) queueDepth * (sizeof(MQTTWorkerMessage_t) + slotSize + sizeof(MQTTWorkerAck_t));
+
+    return (size_t) workerCount * perWorker;
+}
+
+static void releasePool(MQTTWorkerPool_t *pool, uint16_t started)
+{
+    uint16_t i;
+
+    /* Every started worker drains its queue, sees the extra wakeup and exits. */
+    pool->stopping = true;
+    for (i = 0; i < started; i++)
+    {
+        rt_sem_release(&pool->workers[i].items);
+    }
+    for (i = 0; i < started; i++)
+    {
+        rt_sem_take(&pool->exited, RT_WAITING_FOREVER);
+    }
+
+    for (i = 0; i < pool->workerCount; i++)
+    {
+        rt_free(pool->workers[i].queue);
+        rt_free(pool->workers[i].slots);
+        rt_sem_detach(&pool->workers[i].items);
+        rt_sem_detach(&pool->workers[i].space);
+    }
+    rt_sem_detach(&pool->exited);
+    rt_mutex_detach(&pool->lock);
+    rt_free(pool->workers);
+    rt_free(pool->acks);
+    pool->workers = RT_NULL;
+    pool->acks = RT_NULL;
+}
+
+MQTTStatus_t mqttWorkerPoolInit(MQTTWorkerPool_t *pool, MQTTContext_t *context, uint16_t workerCount,
+        uint16_t queueDepth, size_t slotSize, MQTTWorkerAckMode_t ackMode, MQTTPublishHandler_t handler,
+        void *pUserData, uint32_t stackSize, uint8_t priority)
+{
+    MQTTWorker_t *worker;
+    char name[RT_NAME_MAX];
+    uint16_t i;
+
+    if ((pool == RT_NULL) || (context == RT_NULL) || (handler == RT_NULL) || (workerCount == 0)
+            || (queueDepth == 0) || ((uint32_t) workerCount * queueDepth > UINT16_MAX))
+    {
+        return MQTTBadParameter;
+    }
+
+    memset(pool, 0, sizeof(*pool));
+    pool->workerCount = workerCount;
+    pool->queueDepth = queueDepth;
+    pool->slotSize = slotSize;
+    pool->ackMode = ackMode;
+    pool->context = context;
+    pool->handler = handler;
+    pool->pUserData = pUserData;
+    rt_mutex_init(&pool->lock, "mqttwp", RT_IPC_FLAG_PRIO);
+    rt_sem_init(&pool->exited, "mqttwx", 0, RT_IPC_FLAG_FIFO);
+
+    pool->workers = rt_calloc(workerCount, sizeof(MQTTWorker_t));
+    pool->acks = rt_calloc((size_t) workerCount * queueDepth, sizeof(MQTTWorkerAck_t));
+    if ((pool->workers == RT_NULL) || (pool->acks == RT_NULL))
+    {
+        /* No worker has its semaphores yet. */
+        pool->workerCount = 0;
+        releasePool(pool, 0);
+        return MQTTNoMemory;
+    }
+
+    for (i = 0; i < workerCount; i++)
+    {
+        worker = &pool->workers[i];
+        worker->pool = pool;
+        rt_sem_init(&worker->items, "mqttwi", 0, RT_IPC_FLAG_FIFO);
+        rt_sem_init(&worker->space, "mqttws", queueDepth, RT_IPC_FLAG_FIFO);
+        worker->queue = rt_calloc(queueDepth, sizeof(MQTTWorkerMessage_t));
+        worker->slots = (slotSize > 0) ? rt_malloc((size_t) queueDepth * slotSize) : RT_NULL;
+        if ((worker->queue == RT_NULL) || ((slotSize > 0) && (worker->slots == RT_NULL)))
+        {
+            pool->workerCount = (uint16_t) (i + 1U);
+            releasePool(pool, 0);
+            return MQTTNoMemory;
+        }
+    }
+
+    for (i = 0; i < workerCount; i++)
+    {
+        rt_snprintf(name, sizeof(name), "mqttw%u", (unsigned int) i);
+        pool->workers[i].thread = rt_thread_create(name, workerEntry, &pool->workers[i], stackSize, priority,
+                MQTT_CLIENT_TIMESLICE);
+        if (pool->workers[i].thread == RT_NULL)
+        {
+            MQTT_PRINT("Failed to create MQTT worker thread %u\n", (unsigned int) i);
+            releasePool(pool, i);
+            return MQTTNoMemory;
+        }
+        rt_thread_startup(pool->workers[i].thread);
+    }
+
+    pool->initialized = true;
+
+    return MQTTSuccess;
+}
+
+void mqttWorkerPoolDeinit(MQTTWorkerPool_t *pool)
+{
+    if ((pool == RT_NULL) || (!pool->initialized))
+    {
+        return;
+    }
+
+    releasePool(pool, pool->workerCount);
+    pool->initialized = false;
+}
+
+MQTTStatus_t mqttWorkerPoolSubmit(MQTTWorkerPool_t *pool, MQTTDeserializedInfo_t *pDeserializedInfo)
+{
+    const MQTTPublishInfo_t *publishInfo;
+    MQTTWorkerMessage_t *message;
+    MQTTWorker_t *worker;
+    uint16_t index;
+    size_t size;
+    bool deferAck;
+
+    if ((pool == RT_NULL) || (!pool->initialized) || (pDeserializedInfo == RT_NULL)
+            || (pDeserializedInfo->pPublishInfo == RT_NULL))
+    {
+        return MQTTBadParameter;
+    }
+
+    publishInfo = pDeserializedInfo->pPublishInfo;
+    worker = &pool->workers[topicHash(publishInfo->pTopicName, publishInfo->topicNameLength) % pool->workerCount];
+    size = publishInfo->topicNameLength + publishInfo->payloadLength;
+    deferAck = (pool->ackMode == MQTTWorkerAckOnComplete) && (publishInfo->qos > MQTTQoS0);
+
+    if (rt_sem_take(&worker->space, RT_WAITING_NO) != RT_EOK)
+    {
+        rt_mutex_take(&pool->lock, RT_WAITING_FOREVER);
+        pool->stats.stalls++;
+        rt_mutex_release(&pool->lock);
+        rt_sem_take(&worker->space, RT_WAITING_FOREVER);
+    }
+
+    /* Every queued or unflushed deferred ack holds an entry of the ack ring;
+     * make room by sending the finished ones. */
+    if (deferAck && (pool->deferred == (uint16_t) (pool->workerCount * pool->queueDepth)))
+    {
+        (void) mqttWorkerPoolFlushAcks(pool);
+    }
+
+    rt_mutex_take(&pool->lock, RT_WAITING_FOREVER);
+    index = (uint16_t) ((worker->head + worker->count) % pool->queueDepth);
+    rt_mutex_release(&pool->lock);
+
+    message = &worker->queue[index];
+    message->allocated = (size > pool->slotSize);
+    message->data = message->allocated ? rt_malloc(size) : &worker->slots[(size_t) index * pool->slotSize];
+    if (message->data == RT_NULL)
+    {
+        rt_sem_release(&worker->space);
+        rt_mutex_take(&pool->lock, RT_WAITING_FOREVER);
+        pool->stats.inlined++;
+        rt_mutex_release(&pool->lock);
+
+        /* Better late than lost: handle it here and let the core ack it. */
+        pool->handler(pool->context, pDeserializedInfo, pool->pUserData);
+        return MQTTNoMemory;
+    }
+
+    memcpy(message->data, publishInfo->pTopicName, publishInfo->topicNameLength);
+    if (publishInfo->payloadLength > 0)
+    {
+        memcpy(&message->data[publishInfo->topicNameLength], publishInfo->pPayload, publishInfo->payloadLength);
+    }
+    message->publishInfo = *publishInfo;
+    message->publishInfo.pTopicName = (const char *) message->data;
+    message->publishInfo.pPayload = &message->data[publishInfo->topicNameLength];
+    message->packetId = pDeserializedInfo->packetIdentifier;
+    pDeserializedInfo->deferAck = deferAck;
+
+    rt_mutex_take(&pool->lock, RT_WAITING_FOREVER);
+    message->session = pool->session;
+    worker->count++;
+    pool->stats.submitted++;
+    pool->stats.allocated += message->allocated ? 1U : 0U;
+    pool->deferred += deferAck ? 1U : 0U;
+    rt_mutex_release(&pool->lock);
+
+    rt_sem_release(&worker->items);
+
+    return MQTTSuccess;
+}
+
+MQTTStatus_t mqttWorkerPoolFlushAcks(MQTTWorkerPool_t *pool)
+{
+    MQTTStatus_t status = MQTTSuccess, ackStatus;
+    MQTTWorkerAck_t ack;
+    bool current;
+
+    if ((pool == RT_NULL) || (!pool->initialized))
+    {
+        return MQTTBadParameter;
+    }
+
+    while (1)
+    {
+        rt_mutex_take(&pool->lock, RT_WAITING_FOREVER);
+        if (pool->ackCount == 0)
+        {
+            rt_mutex_release(&pool->lock);
+            break;
+        }
+        ack = pool->acks[pool->ackHead];
+        pool->ackHead = (uint16_t) ((pool->ackHead + 1U) % ((uint32_t) pool->workerCount * pool->queueDepth));
+        pool->ackCount--;
+        pool->deferred--;
+        current = (ack.session == pool->session);
+        rt_mutex_release(&pool->lock);
+
+        /* After a reconnect the clean session has forgotten the message, and
+         * its packet ID may belong to a new one. The ack goes with the old session. */
+        if (!current)
+        {
+            continue;
+        }
+
+        ackStatus = MQTT_AckIncomingPublish(pool->context, ack.packetId, ack.qos);
+        if ((ackStatus != MQTTSuccess) && (status == MQTTSuccess))
+        {
+            status = ackStatus;
+        }
+    }
+
+    return status;
+}
+
+/* Called before a clean CONNECT; acks still owed to the old session are dropped. */
+void mqttWorkerPoolNewSession(MQTTWorkerPool_t *pool)
+{
+    if ((pool == RT_NULL) || (!pool->initialized))
+    {
+        return;
+    }
+
+    rt_mutex_take(&pool->lock, RT_WAITING_FOREVER);
+    pool->session++;
+    rt_mutex_release(&pool->lock);
+}
+
+/* Deepest worker queue. Submits block once any one queue is full, so this is
+ * the depth flow control has to watch. Fits MQTTFlowControlDepth_t. */
+size_t mqttWorkerPoolDepth(void *pool)
+{
+    MQTTWorkerPool_t *workerPool = (MQTTWorkerPool_t *) pool;
+    uint16_t i, depth = 0;
+
+    if ((workerPool == RT_NULL) || (!workerPool->initialized))
+    {
+        return 0;
+    }
+
+    rt_mutex_take(&workerPool->lock, RT_WAITING_FOREVER);
+    for (i = 0; i < workerPool->workerCount; i++)
+    {
+        if (workerPool->workers[i].count > depth)
+        {
+            depth = workerPool->workers[i].count;
+        }
+    }
+    rt_mutex_release(&workerPool->lock);
+
+    return depth;
+}
+
+void mqttWorkerPoolGetStats(MQTTWorkerPool_t *pool, MQTTWorkerPoolStats_t *stats)
+{
+    uint16_t i;
+
+    memset(stats, 0, sizeof(*stats));
+    if ((pool == RT_NULL) || (!pool->initialized))
+    {
+        return;
+    }
+
+    rt_mutex_take(&pool->lock, RT_WAITING_FOREVER);
+    *stats = pool->stats;
+    for (i = 0; i < pool->workerCount; i++)
+    {
+        stats->queued += pool->workers[i].count;
+    }
+    stats->deferred = pool->deferred;
+    rt_mutex_release(&pool->lock);
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+#ifndef APPLICATIONS_FIREMQTT_API_MQTT_WORKER_POOL_H_
+#define APPLICATIONS_FIREMQTT_API_MQTT_WORKER_POOL_H_
+
+#include <rtthread.h>
+#include <core_mqtt.h>
+#include "mqtt_dispatch.h"
+
+/*
+ * Worker pool.
+ *
+ * Moves application handlers off the thread running MQTT_ProcessLoop(). An
+ * incoming PUBLISH is copied into a slot of a bounded queue and handled by one
+ * of the worker threads; the receive thread goes straight back to reading,
+ * pinging and acking. Queues are chosen by a hash of the topic, so messages
+ * of one topic are handled in order by the same worker.
+ *
+ * Each queue slot owns a buffer of slotSize bytes that is loaned to the
+ * handler until it returns. Larger messages get a buffer of their own. A full
+ * queue blocks the receive thread, which pushes back on the broker.
+ *
+ * With MQTTWorkerAckOnComplete the PUBACK or PUBREC of a QoS 1/2 message is
+ * deferred until its handler returned. Workers only record the finished
+ * packet IDs; the receive thread sends the acks with mqttWorkerPoolFlushAcks()
+ * so the socket keeps a single writer. Acks of messages received before
+ * mqttWorkerPoolNewSession() are dropped, their packet IDs may already have
+ * been reused by the new session.
+ */
+
+typedef enum MQTTWorkerAckMode
+{
+    MQTTWorkerAckOnReceive = 0,     /* Ack once the message is queued. */
+    MQTTWorkerAckOnComplete         /* Ack once the handler returned. */
+} MQTTWorkerAckMode_t;
+
+typedef struct MQTTWorkerMessage
+{
+    MQTTPublishInfo_t publishInfo;
+    uint16_t packetId;
+    uint32_t session;           /* Session the message was received in. */
+    uint8_t *data;              /* Topic followed by payload. */
+    bool allocated;             /* data does not belong to the queue slot. */
+} MQTTWorkerMessage_t;
+
+typedef struct MQTTWorkerAck
+{
+    uint16_t packetId;
+    MQTTQoS_t qos;
+    uint32_t session;
+} MQTTWorkerAck_t;
+
+struct MQTTWorkerPool;
+
+typedef struct MQTTWorker
+{
+    struct MQTTWorkerPool *pool;
+    MQTTWorkerMessage_t *queue;
+    uint8_t *slots;             /* queueDepth buffers of slotSize bytes. */
+    uint16_t head;
+    uint16_t count;
+    struct rt_semaphore items;
+    struct rt_semaphore space;
+    rt_thread_t thread;
+} MQTTWorker_t;
+
+typedef struct MQTTWorkerPoolStats
+{
+    uint32_t submitted;
+    uint32_t completed;
+    uint32_t queued;            /* Messages waiting or being handled. */
+    uint32_t deferred;          /* Acks not sent yet. */
+    uint32_t allocated;         /* Messages larger than a slot. */
+    uint32_t inlined;           /* Handled on the receive thread, out of memory. */
+    uint32_t stalls;            /* Submits that waited for a full queue. */
+} MQTTWorkerPoolStats_t;
+
+typedef struct MQTTWorkerPool
+{
+    MQTTWorker_t *workers;
+    uint16_t workerCount;
+    uint16_t queueDepth;
+    size_t slotSize;
+    MQTTWorkerAckMode_t ackMode;
+    MQTTContext_t *context;
+    MQTTPublishHandler_t handler;
+    void *pUserData;
+    MQTTWorkerAck_t *acks;      /* Finished deferred acks, one per queue slot. */
+    uint16_t ackHead;
+    uint16_t ackCount;
+    uint16_t deferred;
+    uint32_t session;           /* Bumped by mqttWorkerPoolNewSession(). */
+    MQTTWorkerPoolStats_t stats;
+    struct rt_mutex lock;
+    struct rt_semaphore exited;
+    volatile bool stopping;
+    bool initialized;
+} MQTTWorkerPool_t;
+
+MQTTStatus_t mqttWorkerPoolInit(MQTTWorkerPool_t *pool, MQTTContext_t *context, uint16_t workerCount,
+        uint16_t queueDepth, size_t slotSize, MQTTWorkerAckMode_t ackMode, MQTTPublishHandler_t handler,
+        void *pUserData, uint32_t stackSize, uint8_t priority);
+void mqttWorkerPoolDeinit(MQTTWorkerPool_t *pool);
+size_t mqttWorkerPoolMemoryEstimate(uint16_t workerCount, uint16_t queueDepth, size_t slotSize, uint32_t stackSize);
+MQTTStatus_t mqttWorkerPoolSubmit(MQTTWorkerPool_t *pool, MQTTDeserializedInfo_t *pDeserializedInfo);
+MQTTStatus_t mqttWorkerPoolFlushAcks(MQTTWorkerPool_t *pool);
+void mqttWorkerPoolNewSession(MQTTWorkerPool_t *pool);
+size_t mqttWorkerPoolDepth(void *pool);
+void mqttWorkerPoolGetStats(MQTTWorkerPool_t *pool, MQTTWorkerPoolStats_t *stats);
+
+#endif /* APPLICATIONS_FIREMQTT_API_MQTT_WORKER_POOL_H_ */
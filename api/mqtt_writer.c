@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+#define DBG_TAG "MQTT"
+#define DBG_LVL DBG_LOG
+
+#include "mqtt_api.h"
+#include "mqtt_writer.h"
+
+static void writerEntry(void *parameter)
+{
+    MQTTWriter_t *writer = (MQTTWriter_t *) parameter;
+    MQTTWriterMessage_t message;
+    MQTTStatus_t status;
+
+    while (1)
+    {
+        rt_sem_take(&writer->items, RT_WAITING_FOREVER);
+
+        rt_mutex_take(&writer->lock, RT_WAITING_FOREVER);
+        if (writer->count == 0)
+        {
+            rt_mutex_release(&writer->lock);
+            if (writer->stopping)
+            {
+                break;
+            }
+            continue;
+        }
+        message = writer->queue[writer->head];
+        rt_mutex_release(&writer->lock);
+
+        /* The slot stays in use until the head moves on. */
+        status = writer->send(writer->context, &message.publishInfo, writer->pUserData);
+        if (message.allocated)
+        {
+            rt_free(message.data);
+        }
+
+        rt_mutex_take(&writer->lock, RT_WAITING_FOREVER);
+        writer->head = (uint16_t) ((writer->head + 1U) % writer->queueDepth);
+        writer->count--;
+        if (status == MQTTSuccess)
+        {
+            writer->stats.sent++;
+        }
+        else
+        {
+            writer->stats.failed++;
+        }
+        rt_mutex_release(&writer->lock);
+
+        rt_sem_release(&writer->space);
+    }
+
+    rt_sem_release(&writer->exited);
+}
+
+size_t mqttWriterMemoryEstimate(uint16_t queueDepth, size_t slotSize, uint32_t stackSize)
+{
+    return stackSize + (size_t) queueDepth * (sizeof(MQTTWriterMessage_t) + slotSize);
+}
+
+static void releaseWriter(MQTTWriter_t *writer, bool started)
+{
+    /* The writer sends what is queued, sees the extra wakeup and exits. */
+    writer->stopping = true;
+    if (started)
+    {
+        rt_sem_release(&writer->items);
+        rt_sem_take(&writer->exited, RT_WAITING_FOREVER);
+    }
+
+    rt_free(writer->queue);
+    rt_free(writer->slots);
+    writer->queue = RT_NULL;
+    writer->slots = RT_NULL;
+    rt_sem_detach(&writer->items);
+    rt_sem_detach(&writer->space);
+    rt_sem_detach(&writer->exited);
+    rt_mutex_detach(&writer->lock);
+}
+
+MQTTStatus_t mqttWriterInit(MQTTWriter_t *writer, MQTTContext_t *context, uint16_t queueDepth, size_t slotSize,
+        MQTTWriterSend_t send, void *pUserData, uint32_t stackSize, uint8_t priority)
+{
+    if ((writer == RT_NULL) || (context == RT_NULL) || (send == RT_NULL) || (queueDepth == 0))
+    {
+        return MQTTBadParameter;
+    }
+
+    memset(writer, 0, sizeof(*writer));
+    writer->context = context;
+    writer->send = send;
+    writer->pUserData = pUserData;
+    writer->queueDepth = queueDepth;
+    writer->slotSize = slotSize;
+    rt_mutex_init(&writer->lock, "mqttwr", RT_IPC_FLAG_PRIO);
+    rt_sem_init(&writer->items, "mqttwri", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&writer->space, "mqttwrs", queueDepth, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&writer->exited, "mqttwrx", 0, RT_IPC_FLAG_FIFO);
+
+    writer->queue = rt_calloc(queueDepth, sizeof(MQTTWriterMessage_t));
+    writer->slots = (slotSize > 0) ? rt_malloc((size_t) queueDepth * slotSize) : RT_NULL;
+    if ((writer->queue == RT_NULL) || ((slotSize > 0) && (writer->slots == RT_NULL)))
+    {
+        releaseWriter(writer, false);
+        return MQTTNoMemory;
+    }
+
+    writer->thread = rt_thread_create("mqttwr", writerEntry, writer, stackSize, priority, MQTT_CLIENT_TIMESLICE);
+    if (writer->thread == RT_NULL)
+    {
+        MQTT_PRINT("Failed to create MQTT writer thread\n");
+        releaseWriter(writer, false);
+        return MQTTNoMemory;
+    }
+    rt_thread_startup(writer->thread);
+
+    writer->initialized = true;
+
+    return MQTTSuccess;
+}
+
+void mqttWriterDeinit(MQTTWriter_t *writer)
+{
+    if ((writer == RT_NULL) || (!writer->initialized))
+    {
+        return;
+    }
+
+    releaseWriter(writer, true);
+    writer->initialized = false;
+}
+
+MQTTStatus_t mqttWriterSubmit(MQTTWriter_t *writer, const MQTTPublishInfo_t *publishInfo)
+{
+    MQTTWriterMessage_t *message;
+    uint16_t index;
+    size_t size;
+
+    if ((writer == RT_NULL) || (!writer->initialized) || (publishInfo == RT_NULL))
+    {
+        return MQTTBadParameter;
+    }
+
+    size = publishInfo->topicNameLength + publishInfo->payloadLength;
+
+    if (rt_sem_take(&writer->space, RT_WAITING_NO) != RT_EOK)
+    {
+        rt_mutex_take(&writer->lock, RT_WAITING_FOREVER);
+        writer->stats.stalls++;
+        rt_mutex_release(&writer->lock);
+        rt_sem_take(&writer->space, RT_WAITING_FOREVER);
+    }
+
+    /* Any thread may publish, so the slot is filled under the lock; the
+     * writer only holds it to move the head. */
+    rt_mutex_take(&writer->lock, RT_WAITING_FOREVER);
+    index = (uint16_t) ((writer->head + writer->count) % writer->queueDepth);
+    message = &writer->queue[index];
+    message->allocated = (size > writer->slotSize);
+    message->data = message->allocated ? rt_malloc(size) : &writer->slots[(size_t) index * writer->slotSize];
+    if (message->data == RT_NULL)
+    {
+        rt_mutex_release(&writer->lock);
+        rt_sem_release(&writer->space);
+        return MQTTNoMemory;
+    }
+
+    memcpy(message->data, publishInfo->pTopicName, publishInfo->topicNameLength);
+    if (publishInfo->payloadLength > 0)
+    {
+        memcpy(&message->data[publishInfo->topicNameLength], publishInfo->pPayload, publishInfo->payloadLength);
+    }
+    message->publishInfo = *publishInfo;
+    message->publishInfo.pTopicName = (const char *) message->data;
+    message->publishInfo.pPayload = &message->data[publishInfo->topicNameLength];
+
+    writer->count++;
+    writer->stats.submitted++;
+    writer->stats.allocated += message->allocated ? 1U : 0U;
+    rt_mutex_release(&writer->lock);
+
+    rt_sem_release(&writer->items);
+
+    return MQTTSuccess;
+}
+
+void mqttWriterGetStats(MQTTWriter_t *writer, MQTTWriterStats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if ((writer == RT_NULL) || (!writer->initialized))
+    {
+        return;
+    }
+
+    rt_mutex_take(&writer->lock, RT_WAITING_FOREVER);
+    *stats = writer->stats;
+    stats->queued = writer->count;
+    rt_mutex_release(&writer->lock);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+#ifndef APPLICATIONS_FIREMQTT_API_MQTT_WRITER_H_
+#define APPLICATIONS_FIREMQTT_API_MQTT_WRITER_H_
+
+#include <rtthread.h>
+#include <core_mqtt.h>
+
+/*
+ * Writer thread of the full duplex mode.
+ *
+ * Application threads hand their publishes to a bounded queue and return;
+ * one writer thread takes them off and sends them, while the client task
+ * keeps receiving, acking and pinging. The two only meet in the state engine
+ * and on the send lock that keeps packets whole on the wire, so a long send
+ * no longer delays inbound processing and both directions can run on their
+ * own core.
+ *
+ * Topic and payload are copied into a slot of slotSize bytes; larger
+ * messages get a buffer of their own. A full queue blocks the publisher.
+ */
+
+typedef MQTTStatus_t (*MQTTWriterSend_t)(MQTTContext_t *context, MQTTPublishInfo_t *publishInfo, void *pUserData);
+
+typedef struct MQTTWriterMessage
+{
+    MQTTPublishInfo_t publishInfo;
+    uint8_t *data;              /* Topic followed by payload. */
+    bool allocated;             /* data does not belong to the queue slot. */
+} MQTTWriterMessage_t;
+
+typedef struct MQTTWriterStats
+{
+    uint32_t submitted;
+    uint32_t sent;
+    uint32_t failed;            /* Send function did not succeed. */
+    uint32_t queued;            /* Messages waiting or being sent. */
+    uint32_t allocated;         /* Messages larger than a slot. */
+    uint32_t stalls;            /* Submits that waited for a full queue. */
+} MQTTWriterStats_t;
+
+typedef struct MQTTWriter
+{
+    MQTTContext_t *context;
+    MQTTWriterSend_t send;
+    void *pUserData;
+    MQTTWriterMessage_t *queue;
+    uint8_t *slots;             /* queueDepth buffers of slotSize bytes. */
+    uint16_t queueDepth;
+    uint16_t head;
+    uint16_t count;
+    size_t slotSize;
+    MQTTWriterStats_t stats;
+    struct rt_mutex lock;
+    struct rt_semaphore items;
+    struct rt_semaphore space;
+    struct rt_semaphore exited;
+    rt_thread_t thread;
+    volatile bool stopping;
+    bool initialized;
+} MQTTWriter_t;
+
+MQTTStatus_t mqttWriterInit(MQTTWriter_t *writer, MQTTContext_t *context, uint16_t queueDepth, size_t slotSize,
+        MQTTWriterSend_t send, void *pUserData, uint32_t stackSize, uint8_t priority);
+void mqttWriterDeinit(MQTTWriter_t *writer);
+size_t mqttWriterMemoryEstimate(uint16_t queueDepth, size_t slotSize, uint32_t stackSize);
+MQTTStatus_t mqttWriterSubmit(MQTTWriter_t *writer, const MQTTPublishInfo_t *publishInfo);
+void mqttWriterGetStats(MQTTWriter_t *writer, MQTTWriterStats_t *stats);
+
+#endif /* APPLICATIONS_FIREMQTT_API_MQTT_WRITER_H_ */
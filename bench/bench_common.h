@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+#ifndef APPLICATIONS_FIREMQTT_BENCH_BENCH_COMMON_H_
+#define APPLICATIONS_FIREMQTT_BENCH_BENCH_COMMON_H_
+
+/*
+ * Helpers shared by the host benchmarks. The benchmarks link the core library
+ * built with MQTT_DO_NOT_USE_CUSTOM_CONFIG, so they run on any POSIX host:
+ *
+ *   gcc -O2 -DMQTT_DO_NOT_USE_CUSTOM_CONFIG -Icore/include -Icore/interface \
+ *       bench/<bench>.c core/core_mqtt.c core/core_mqtt_state.c core/core_mqtt_serializer.c
+ *
+ * The host CMake build has a target for each of them.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+static inline uint64_t benchNowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/*
+ * Cycle counter for cycles-per-byte figures: the TSC on x86, which counts at
+ * the nominal clock rather than the current one, and nanoseconds elsewhere.
+ * BENCH_CYCLE_SOURCE names the one in use so results are labelled.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#define BENCH_CYCLE_SOURCE  "tsc"
+
+static inline uint64_t benchCycles(void)
+{
+    return __rdtsc();
+}
+#else
+#define BENCH_CYCLE_SOURCE  "ns"
+
+static inline uint64_t benchCycles(void)
+{
+    return benchNowNs();
+}
+#endif
+
+/* Keeps results alive so the compiler cannot drop the measured work. */
+static volatile uint32_t benchSink;
+
+#endif /* APPLICATIONS_FIREMQTT_BENCH_BENCH_COMMON_H_ */
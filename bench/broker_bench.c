@@ -0,0 +1,674 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+/*
+ * End-to-end throughput and latency against the mock broker of
+ * mock_broker.c, without a network or a real broker.
+ *
+ *   memory     the core client wired to the broker through function calls,
+ *              the cost of the protocol on both ends without sockets
+ *   loopback   an api/mqtt_api.c client driven by mqttClientService() on
+ *              this thread, talking to the broker thread over 127.0.0.1
+ *
+ * Each run subscribes to its own topic at QoS 2 and publishes MESSAGE_COUNT
+ * messages at QoS 0, 1 and 2, which the broker routes back at the same QoS.
+ * A message carries the time it was published; the broker notes when it
+ * parsed it and when it forwarded it, so the end-to-end latency splits into
+ * the way up (publish to broker) and the way down (broker to handler).
+ *
+ * The fault runs use the loopback client: a delayed CONNACK, a refused
+ * connection, every Nth ack dropped, which strands the PUBLISH in the
+ * outgoing window as nothing is retransmitted on a live connection, and
+ * every Nth delivery larger than the client's network buffer.
+ *
+ * The api client logs every ack on the console, so stdout goes to /dev/null
+ * and the results to a copy of it taken first; -v keeps the log.
+ *
+ * A run that loses a message on a clean link, or a fault that does not end
+ * as expected, is marked FAILED and makes the exit status 1, so ctest runs
+ * it as an end-to-end test. The host CMake build has a target for it; it
+ * links the freemqtt library.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "mqtt_api.h"
+#include "mock_broker.h"
+#include "bench_common.h"
+
+#define MESSAGE_COUNT           10000U
+#define FAULT_MESSAGE_COUNT     200U
+#define PAYLOAD_LENGTH          64U
+#define OUTGOING_RECORDS        32U
+#define INCOMING_RECORDS        32U
+#define NETWORK_BUFFER_SIZE     4096U
+#define MEMORY_QUEUE_SIZE       (1024U * 1024U)
+#define SETTLE_NS               2000000000ULL
+#define CONNACK_DELAY_MS        250U
+#define DROP_ACK_EVERY          25U
+#define OVERSIZED_EVERY         20U
+#define OVERSIZED_LENGTH        (2U * NETWORK_BUFFER_SIZE)
+
+typedef struct Sample
+{
+    uint64_t publishedNs;
+    uint64_t brokerNs;
+    uint64_t forwardedNs;
+    uint64_t receivedNs;
+} Sample_t;
+
+/* Leads every payload so messages of an earlier run are told apart. */
+typedef struct Stamp
+{
+    uint32_t run;
+    uint32_t sequence;
+} Stamp_t;
+
+static MockBroker_t broker;
+static FILE *out;
+static Sample_t samples[MESSAGE_COUNT];
+static uint32_t latencies[MESSAGE_COUNT];
+static uint32_t run;
+static uint32_t received;
+static uint32_t failures;
+
+/* In-memory client. In full duplex mode the core hooks take the locks of the
+ * api client around its context, so the context lives in one. */
+static MQTTClient_t memoryClient;
+static MQTTContext_t *const context = &memoryClient.context;
+static MQTTPubAckInfo_t outgoingRecords[OUTGOING_RECORDS];
+static MQTTPubAckInfo_t incomingRecords[INCOMING_RECORDS];
+static uint8_t networkBuffer[NETWORK_BUFFER_SIZE];
+static uint8_t memoryQueue[MEMORY_QUEUE_SIZE];
+static size_t memoryHead;
+static size_t memoryTail;
+static int memoryConnection;
+static uint32_t inflight;
+
+/*-----------------------------------------------------------*/
+
+static void messageHook(void *pUserData, const MockBrokerMessage_t *pMessage)
+{
+    Stamp_t stamp;
+
+    (void) pUserData;
+
+    if (pMessage->payloadLength < sizeof(stamp))
+    {
+        return;
+    }
+    memcpy(&stamp, pMessage->pPayload, sizeof(stamp));
+    if ((stamp.run == run) && (stamp.sequence < MESSAGE_COUNT))
+    {
+        samples[stamp.sequence].brokerNs = pMessage->receivedNs;
+        samples[stamp.sequence].forwardedNs = pMessage->forwardedNs;
+    }
+}
+
+static void recordMessage(const MQTTPublishInfo_t *pPublishInfo)
+{
+    Stamp_t stamp;
+
+    if (pPublishInfo->payloadLength < sizeof(stamp))
+    {
+        return;
+    }
+    memcpy(&stamp, pPublishInfo->pPayload, sizeof(stamp));
+    if ((stamp.run == run) && (stamp.sequence < MESSAGE_COUNT) && (samples[stamp.sequence].receivedNs == 0U))
+    {
+        samples[stamp.sequence].receivedNs = benchNowNs();
+        received++;
+    }
+}
+
+static int compareLatency(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+/* Percentile in microseconds of the sorted latencies. */
+static double percentileUs(uint32_t count, uint32_t percent)
+{
+    uint32_t index;
+
+    if (count == 0U)
+    {
+        return 0.0;
+    }
+
+    index = (count * percent) / 100U;
+    index = (index >= count) ? (count - 1U) : index;
+
+    return (double) latencies[index] / 1000.0;
+}
+
+/* Median of one leg of the samples, between two of their timestamps. */
+static double legMedianUs(size_t fromOffset, size_t toOffset, uint32_t count)
+{
+    uint32_t i, n = 0;
+    uint64_t from, to;
+
+    for (i = 0; i < count; i++)
+    {
+        memcpy(&from, (const uint8_t *) &samples[i] + fromOffset, sizeof(from));
+        memcpy(&to, (const uint8_t *) &samples[i] + toOffset, sizeof(to));
+        if ((from != 0U) && (to >= from) && (samples[i].receivedNs != 0U))
+        {
+            latencies[n++] = (uint32_t) (((to - from) > UINT32_MAX) ? UINT32_MAX : (to - from));
+        }
+    }
+    qsort(latencies, n, sizeof(latencies[0]), compareLatency);
+
+    return percentileUs(n, 50);
+}
+
+static void report(const char *mode, MQTTQoS_t qos, uint32_t count, uint64_t startNs, uint64_t endNs)
+{
+    double up, down, seconds = (double) (endNs - startNs) / 1e9;
+    uint32_t i, n = 0;
+
+    up = legMedianUs(offsetof(Sample_t, publishedNs), offsetof(Sample_t, brokerNs), count);
+    down = legMedianUs(offsetof(Sample_t, forwardedNs), offsetof(Sample_t, receivedNs), count);
+
+    for (i = 0; i < count; i++)
+    {
+        if (samples[i].receivedNs != 0U)
+        {
+            latencies[n++] = (uint32_t) (samples[i].receivedNs - samples[i].publishedNs);
+        }
+    }
+    qsort(latencies, n, sizeof(latencies[0]), compareLatency);
+    failures += (n == count) ? 0U : 1U;
+
+    fprintf(out, "%-9s %3d %6u %6u %10.0f %8.1f %8.1f %8.1f %8.1f %8.1f%s\n", mode, (int) qos, (unsigned int) count,
+            (unsigned int) n, (seconds > 0.0) ? ((double) n / seconds) : 0.0, percentileUs(n, 50),
+            percentileUs(n, 99), (n > 0U) ? ((double) latencies[n - 1U] / 1000.0) : 0.0, up, down,
+            (n == count) ? "" : "  FAILED");
+}
+
+/* Counts a fault run that did not end as expected. */
+static const char *verdict(bool passed)
+{
+    failures += passed ? 0U : 1U;
+    return passed ? "" : "  FAILED";
+}
+
+static void startRun(void)
+{
+    run++;
+    received = 0;
+    memset(samples, 0, sizeof(samples));
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t getTimeMs(void)
+{
+    return (uint32_t) (benchNowNs() / 1000000U);
+}
+
+/* Broker output for the in-memory client, read back by memoryRecv(). */
+static int32_t memoryDeliver(void *pTransport, const void *pBuffer, size_t length)
+{
+    (void) pTransport;
+
+    if (memoryTail + length > sizeof(memoryQueue))
+    {
+        memmove(memoryQueue, &memoryQueue[memoryHead], memoryTail - memoryHead);
+        memoryTail -= memoryHead;
+        memoryHead = 0;
+        if (memoryTail + length > sizeof(memoryQueue))
+        {
+            return -1;
+        }
+    }
+
+    memcpy(&memoryQueue[memoryTail], pBuffer, length);
+    memoryTail += length;
+    return (int32_t) length;
+}
+
+static int32_t memorySend(NetworkContext_t *pNetworkContext, const void *pBuffer, size_t bytesToSend)
+{
+    (void) pNetworkContext;
+
+    return (mockBrokerInput(&broker, memoryConnection, pBuffer, bytesToSend) == 0) ? (int32_t) bytesToSend : -1;
+}
+
+static int32_t memoryRecv(NetworkContext_t *pNetworkContext, void *pBuffer, size_t bytesToRecv)
+{
+    size_t length = memoryTail - memoryHead;
+
+    (void) pNetworkContext;
+
+    length = (length > bytesToRecv) ? bytesToRecv : length;
+    memcpy(pBuffer, &memoryQueue[memoryHead], length);
+    memoryHead += length;
+
+    return (int32_t) length;
+}
+
+static void memoryCallback(MQTTContext_t *pContext, MQTTPacketInfo_t *pPacketInfo,
+        MQTTDeserializedInfo_t *pDeserializedInfo)
+{
+    (void) pContext;
+
+    switch (pPacketInfo->type & 0xF0U)
+    {
+    case MQTT_PACKET_TYPE_PUBLISH:
+        recordMessage(pDeserializedInfo->pPublishInfo);
+        break;
+
+    case MQTT_PACKET_TYPE_PUBACK:
+    case MQTT_PACKET_TYPE_PUBCOMP:
+        inflight--;
+        break;
+
+    default:
+        break;
+    }
+}
+
+/* One call handles one packet, keep going while any are queued or buffered. */
+static void memoryPump(void)
+{
+    while ((memoryTail > memoryHead) || (context->index > 0U))
+    {
+        if (MQTT_ProcessLoop(context) != MQTTSuccess)
+        {
+            break;
+        }
+    }
+}
+
+static void memoryRun(MQTTQoS_t qos)
+{
+    static uint8_t payload[PAYLOAD_LENGTH];
+    MQTTPublishInfo_t publishInfo = { 0 };
+    Stamp_t stamp = { 0 };
+    uint64_t startNs, endNs;
+    uint32_t sequence;
+
+    startRun();
+    publishInfo.qos = qos;
+    publishInfo.pTopicName = "bench/memory";
+    publishInfo.topicNameLength = (uint16_t) strlen(publishInfo.pTopicName);
+    publishInfo.pPayload = payload;
+    publishInfo.payloadLength = sizeof(payload);
+    stamp.run = run;
+
+    startNs = benchNowNs();
+    for (sequence = 0; sequence < MESSAGE_COUNT; sequence++)
+    {
+        while ((qos != MQTTQoS0) && (inflight >= OUTGOING_RECORDS))
+        {
+            memoryPump();
+        }
+
+        stamp.sequence = sequence;
+        memcpy(payload, &stamp, sizeof(stamp));
+        samples[sequence].publishedNs = benchNowNs();
+        inflight += (qos != MQTTQoS0) ? 1U : 0U;
+        if (MQTT_Publish(context, &publishInfo, (qos != MQTTQoS0) ? MQTT_GetPacketId(context) : 0U) != MQTTSuccess)
+        {
+            inflight -= (qos != MQTTQoS0) ? 1U : 0U;
+        }
+        memoryPump();
+    }
+    endNs = benchNowNs();
+
+    report("memory", qos, MESSAGE_COUNT, startNs, endNs);
+}
+
+static int memorySuite(void)
+{
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t buffer = { networkBuffer, sizeof(networkBuffer) };
+    MQTTConnectInfo_t connectInfo = { 0 };
+    MQTTSubscribeInfo_t subscription = { MQTTQoS2, "bench/memory", 12 };
+    bool sessionPresent;
+    uint32_t qos;
+
+#if MQTT_DUPLEX_ENABLE
+    rt_mutex_init(&memoryClient.stateLock, "benchst", RT_IPC_FLAG_PRIO);
+    rt_mutex_init(&memoryClient.sendLock, "benchsd", RT_IPC_FLAG_PRIO);
+#endif
+    memoryConnection = mockBrokerOpen(&broker, memoryDeliver, NULL);
+    transport.send = memorySend;
+    transport.recv = memoryRecv;
+
+    connectInfo.cleanSession = true;
+    connectInfo.pClientIdentifier = "bench-memory";
+    connectInfo.clientIdentifierLength = (uint16_t) strlen(connectInfo.pClientIdentifier);
+    connectInfo.keepAliveSeconds = 60;
+
+    if ((memoryConnection < 0)
+            || (MQTT_Init(context, &transport, getTimeMs, memoryCallback, &buffer) != MQTTSuccess)
+            || (MQTT_InitStatefulQoS(context, outgoingRecords, OUTGOING_RECORDS, incomingRecords,
+                    INCOMING_RECORDS) != MQTTSuccess)
+            || (MQTT_Connect(context, &connectInfo, NULL, 1000, &sessionPresent) != MQTTSuccess)
+            || (MQTT_Subscribe(context, &subscription, 1, MQTT_GetPacketId(context)) != MQTTSuccess))
+    {
+        fprintf(out, "memory client failed to connect\n");
+        return -1;
+    }
+    memoryPump();
+
+    for (qos = 0; qos <= 2U; qos++)
+    {
+        memoryRun((MQTTQoS_t) qos);
+    }
+
+    (void) MQTT_Disconnect(context);
+    mockBrokerClose(&broker, memoryConnection);
+    return 0;
+}
+
+/*-----------------------------------------------------------*/
+
+static void onMessage(MQTTContext_t *pContext, MQTTDeserializedInfo_t *pDeserializedInfo, void *pUserData)
+{
+    (void) pContext;
+    (void) pUserData;
+
+    recordMessage(pDeserializedInfo->pPublishInfo);
+}
+
+/* Services the client until it is connected, returning the time it took or 0 on timeout. */
+static uint64_t clientStart(MQTTClient_t *client, const char *clientId, uint16_t port, uint64_t timeoutNs)
+{
+    MQTTClientConfig_t config;
+    uint64_t startNs;
+    int one = 1;
+
+    mqttClientConfigInit(&config);
+    config.brokerAddress = "127.0.0.1";
+    config.brokerPort = port;
+    config.clientId = clientId;
+    config.keepAliveSeconds = 60;
+    config.bufferSize = NETWORK_BUFFER_SIZE;
+    config.outgoingPublishCount = OUTGOING_RECORDS;
+    config.incomingPublishCount = INCOMING_RECORDS;
+    /* This thread alone drives the client, so a full duplex writer would wait
+     * for acks nobody reads; and the link never drops, nothing goes to disk. */
+    config.writerQueueDepth = 0;
+    config.offlineQueuePath = RT_NULL;
+
+    if (mqttClientInit(client, &config) != MQTTSuccess)
+    {
+        return 0;
+    }
+
+    startNs = benchNowNs();
+    while (client->context.connectStatus != MQTTConnected)
+    {
+        (void) mqttClientService(client);
+        if (benchNowNs() - startNs > timeoutNs)
+        {
+            return 0;
+        }
+    }
+
+    /* The port leaves Nagle on; small acks would then wait for the broker's delayed ACK. */
+    (void) setsockopt(client->network.socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return benchNowNs() - startNs;
+}
+
+static bool clientSubscribe(MQTTClient_t *client, const char *filter)
+{
+    MQTTSubscribeInfo_t subscription = { MQTTQoS2, filter, (uint16_t) strlen(filter) };
+    MockBrokerStats_t stats;
+    uint32_t subacks;
+    uint64_t startNs = benchNowNs();
+
+    mockBrokerGetStats(&broker, &stats);
+    subacks = stats.packetsOut[MQTT_PACKET_TYPE_SUBACK >> 4];
+
+    if ((mqttClientRegisterHandler(client, filter, onMessage, NULL) != MQTTSuccess)
+            || (mqttClientSubscribe(client, &subscription, 1) != MQTTSuccess))
+    {
+        return false;
+    }
+
+    do
+    {
+        (void) mqttClientService(client);
+        mockBrokerGetStats(&broker, &stats);
+    } while ((stats.packetsOut[MQTT_PACKET_TYPE_SUBACK >> 4] == subacks) && (benchNowNs() - startNs < SETTLE_NS));
+
+    return stats.packetsOut[MQTT_PACKET_TYPE_SUBACK >> 4] != subacks;
+}
+
+/* Publishes count messages, giving up when the outgoing window stays full; returns the number sent. */
+static uint32_t clientPublish(MQTTClient_t *client, const char *topic, MQTTQoS_t qos, uint32_t count)
+{
+    static uint8_t payload[PAYLOAD_LENGTH];
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTStatus_t status;
+    Stamp_t stamp = { run, 0 };
+    uint32_t sequence;
+    uint64_t waitNs;
+
+    publishInfo.qos = qos;
+    publishInfo.pTopicName = topic;
+    publishInfo.topicNameLength = (uint16_t) strlen(topic);
+    publishInfo.pPayload = payload;
+    publishInfo.payloadLength = sizeof(payload);
+
+    for (sequence = 0; sequence < count; sequence++)
+    {
+        stamp.sequence = sequence;
+        memcpy(payload, &stamp, sizeof(stamp));
+
+        waitNs = benchNowNs();
+        samples[sequence].publishedNs = waitNs;
+        while ((status = mqttClientPublish(client, &publishInfo)) == MQTTNoMemory)
+        {
+            (void) mqttClientService(client);
+            if (benchNowNs() - waitNs > SETTLE_NS)
+            {
+                return sequence;
+            }
+            samples[sequence].publishedNs = benchNowNs();
+        }
+        if (status != MQTTSuccess)
+        {
+            samples[sequence].publishedNs = 0;
+        }
+        (void) mqttClientService(client);
+    }
+
+    return count;
+}
+
+/* Services the client until count messages came back or it has been quiet for a while. */
+static uint64_t clientSettle(MQTTClient_t *client, uint32_t count)
+{
+    uint32_t seen = received;
+    uint64_t quietNs = benchNowNs(), lastNs = quietNs;
+
+    while ((received < count) && (benchNowNs() - quietNs < SETTLE_NS))
+    {
+        (void) mqttClientService(client);
+        if (received != seen)
+        {
+            seen = received;
+            quietNs = lastNs = benchNowNs();
+        }
+    }
+
+    return lastNs;
+}
+
+static void clientStop(MQTTClient_t *client)
+{
+    (void) MQTT_Disconnect(&client->context);
+    mqttClientDeinit(client);
+}
+
+static int loopbackSuite(uint16_t port)
+{
+    static MQTTClient_t client;
+    uint64_t startNs, endNs;
+    uint32_t qos;
+
+    if ((clientStart(&client, "bench-loopback", port, SETTLE_NS) == 0U)
+            || !clientSubscribe(&client, "bench/loopback"))
+    {
+        fprintf(out, "loopback client failed to connect\n");
+        return -1;
+    }
+
+    for (qos = 0; qos <= 2U; qos++)
+    {
+        startRun();
+        startNs = benchNowNs();
+        (void) clientPublish(&client, "bench/loopback", (MQTTQoS_t) qos, MESSAGE_COUNT);
+        endNs = clientSettle(&client, MESSAGE_COUNT);
+        report("loopback", (MQTTQoS_t) qos, MESSAGE_COUNT, startNs, endNs);
+    }
+
+    clientStop(&client);
+    return 0;
+}
+
+/*-----------------------------------------------------------*/
+
+static void faultSuite(uint16_t port)
+{
+    static MQTTClient_t client;
+    MockBrokerFaults_t faults = { 0 };
+    MockBrokerStats_t before, after;
+    uint64_t connectNs;
+    uint32_t sent, pending, i;
+
+    fprintf(out, "\nfault                   result\n");
+
+    faults.connackDelayMs = CONNACK_DELAY_MS;
+    mockBrokerSetFaults(&broker, &faults);
+    connectNs = clientStart(&client, "bench-delayed", port, SETTLE_NS);
+    fprintf(out, "connack +%ums         connected in %.1f ms%s\n", (unsigned int) CONNACK_DELAY_MS,
+            (double) connectNs / 1e6, verdict(connectNs != 0U));
+    clientStop(&client);
+
+    memset(&faults, 0, sizeof(faults));
+    faults.connackReturnCode = 5;
+    mockBrokerSetFaults(&broker, &faults);
+    mockBrokerGetStats(&broker, &before);
+    connectNs = clientStart(&client, "bench-refused", port, SETTLE_NS / 4U);
+    mockBrokerGetStats(&broker, &after);
+    fprintf(out, "connack refused         %s, %u attempts refused%s\n", (connectNs == 0U) ? "not connected" : "connected",
+            (unsigned int) (after.refused - before.refused), verdict((connectNs == 0U) && (after.refused != before.refused)));
+    clientStop(&client);
+
+    memset(&faults, 0, sizeof(faults));
+    mockBrokerSetFaults(&broker, &faults);
+    if ((clientStart(&client, "bench-faults", port, SETTLE_NS) == 0U) || !clientSubscribe(&client, "bench/faults"))
+    {
+        fprintf(out, "fault client failed to connect%s\n", verdict(false));
+        clientStop(&client);
+        return;
+    }
+
+    faults.dropAckEvery = DROP_ACK_EVERY;
+    mockBrokerSetFaults(&broker, &faults);
+    mockBrokerGetStats(&broker, &before);
+    startRun();
+    sent = clientPublish(&client, "bench/faults", MQTTQoS1, FAULT_MESSAGE_COUNT);
+    (void) clientSettle(&client, sent);
+    mockBrokerGetStats(&broker, &after);
+    for (i = 0, pending = 0; i < OUTGOING_RECORDS; i++)
+    {
+        pending += (client.outgoingPublishes[i].packetId != MQTT_PACKET_ID_INVALID) ? 1U : 0U;
+    }
+    fprintf(out, "drop 1/%u acks, qos 1   %u of %u sent, %u acks dropped, %u of %u records stranded%s\n",
+            (unsigned int) DROP_ACK_EVERY, (unsigned int) sent, (unsigned int) FAULT_MESSAGE_COUNT,
+            (unsigned int) (after.acksDropped - before.acksDropped), (unsigned int) pending,
+            (unsigned int) OUTGOING_RECORDS, verdict(pending == after.acksDropped - before.acksDropped));
+    clientStop(&client);
+
+    memset(&faults, 0, sizeof(faults));
+    mockBrokerSetFaults(&broker, &faults);
+    if ((clientStart(&client, "bench-oversized", port, SETTLE_NS) == 0U)
+            || !clientSubscribe(&client, "bench/oversized"))
+    {
+        fprintf(out, "fault client failed to connect%s\n", verdict(false));
+        clientStop(&client);
+        return;
+    }
+
+    faults.oversizedEvery = OVERSIZED_EVERY;
+    faults.oversizedLength = OVERSIZED_LENGTH;
+    mockBrokerSetFaults(&broker, &faults);
+    mockBrokerGetStats(&broker, &before);
+    startRun();
+    sent = clientPublish(&client, "bench/oversized", MQTTQoS0, FAULT_MESSAGE_COUNT);
+    (void) clientSettle(&client, sent);
+    mockBrokerGetStats(&broker, &after);
+    fprintf(out, "1/%u of %u B, qos 0    %u of %u received, %u oversized sent, %u reconnects%s\n",
+            (unsigned int) OVERSIZED_EVERY, (unsigned int) OVERSIZED_LENGTH, (unsigned int) received,
+            (unsigned int) sent, (unsigned int) (after.oversizedSent - before.oversizedSent),
+            (unsigned int) (after.connects - before.connects),
+            verdict(received + (after.oversizedSent - before.oversizedSent) == sent));
+    clientStop(&client);
+
+    memset(&faults, 0, sizeof(faults));
+    mockBrokerSetFaults(&broker, &faults);
+}
+
+int main(int argc, char **argv)
+{
+    int port;
+
+    out = fdopen(dup(STDOUT_FILENO), "w");
+    if (out == NULL)
+    {
+        return 1;
+    }
+    setvbuf(out, NULL, _IOLBF, 0);
+    if ((argc < 2) || (strcmp(argv[1], "-v") != 0))
+    {
+        (void) freopen("/dev/null", "w", stdout);
+    }
+
+    if (mockBrokerInit(&broker) != 0)
+    {
+        return 1;
+    }
+    mockBrokerSetMessageHook(&broker, messageHook, NULL);
+
+    fprintf(out, "%u messages of %u B per run, latencies in us\n", (unsigned int) MESSAGE_COUNT,
+            (unsigned int) PAYLOAD_LENGTH);
+    fprintf(out, "mode      qos   sent   recv      msg/s      p50      p99      max    up50  down50\n");
+
+    if (memorySuite() != 0)
+    {
+        mockBrokerDeinit(&broker);
+        return 1;
+    }
+
+    port = mockBrokerListen(&broker, 0);
+    if ((port < 0) || (loopbackSuite((uint16_t) port) != 0))
+    {
+        mockBrokerDeinit(&broker);
+        return 1;
+    }
+
+    faultSuite((uint16_t) port);
+
+    mockBrokerDeinit(&broker);
+    return (failures == 0U) ? 0 : 1;
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+#ifndef APPLICATIONS_FIREMQTT_BENCH_CONFIG_CORE_MQTT_CONFIG_H_
+#define APPLICATIONS_FIREMQTT_BENCH_CONFIG_CORE_MQTT_CONFIG_H_
+
+/*
+ * Core configuration of the benchmarks that count work done inside the core.
+ * Put bench/config on the include path instead of the client's config and
+ * leave MQTT_DO_NOT_USE_CUSTOM_CONFIG undefined.
+ */
+
+#include <stddef.h>
+
+extern size_t benchMemmoveBytes;
+
+#define MQTT_RECV_MEMMOVE_HOOK( pContext, bytes )    ( benchMemmoveBytes += ( bytes ) )
+
+#endif /* APPLICATIONS_FIREMQTT_BENCH_CONFIG_CORE_MQTT_CONFIG_H_ */
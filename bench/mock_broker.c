@@ -0,0 +1,821 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include "mock_broker.h"
+#include "bench_common.h"
+
+#define POLL_INTERVAL_US    1000
+
+static void closeConnection(MockBroker_t *broker, MockBrokerConnection_t *connection);
+
+/*-----------------------------------------------------------*/
+
+static int32_t socketSend(void *pTransport, const void *pBuffer, size_t length)
+{
+    MockBrokerConnection_t *connection = pTransport;
+    const uint8_t *pData = pBuffer;
+    size_t sent = 0;
+    ssize_t result;
+
+    /* Blocking: a client that stops reading stalls the broker, as a full TCP window would. */
+    while (sent < length)
+    {
+        result = send(connection->socket, &pData[sent], length - sent, MSG_NOSIGNAL);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        sent += (size_t) result;
+    }
+
+    return (int32_t) sent;
+}
+
+static bool transmit(MockBroker_t *broker, MockBrokerConnection_t *connection, const uint8_t *pBuffer, size_t length)
+{
+    if (connection->send(connection->pTransport, pBuffer, length) != (int32_t) length)
+    {
+        closeConnection(broker, connection);
+        return false;
+    }
+
+    broker->stats.packetsOut[pBuffer[0] >> 4]++;
+    broker->stats.bytesOut += length;
+    return true;
+}
+
+/* PUBACK, PUBREC and PUBCOMP go through here so they can be dropped. */
+static void sendAck(MockBroker_t *broker, MockBrokerConnection_t *connection, uint8_t packetType, uint16_t packetId)
+{
+    uint8_t ack[MQTT_PUBLISH_ACK_PACKET_SIZE];
+    MQTTFixedBuffer_t buffer = { ack, sizeof(ack) };
+
+    if (packetType != MQTT_PACKET_TYPE_PUBREL)
+    {
+        broker->ackCount++;
+        if ((broker->faults.dropAckEvery != 0U) && ((broker->ackCount % broker->faults.dropAckEvery) == 0U))
+        {
+            broker->stats.acksDropped++;
+            return;
+        }
+    }
+
+    if (MQTT_SerializeAck(&buffer, packetType, packetId) == MQTTSuccess)
+    {
+        (void) transmit(broker, connection, ack, sizeof(ack));
+    }
+}
+
+static void closeConnection(MockBroker_t *broker, MockBrokerConnection_t *connection)
+{
+    if (!connection->open)
+    {
+        return;
+    }
+
+    if (connection->socket >= 0)
+    {
+        close(connection->socket);
+    }
+    connection->open = false;
+    connection->connected = false;
+    connection->socket = -1;
+    broker->stats.disconnects++;
+}
+
+static MockBrokerConnection_t *openConnection(MockBroker_t *broker, MockBrokerSend_t send, void *pTransport)
+{
+    MockBrokerConnection_t *connection;
+    int i;
+
+    for (i = 0; i < MOCK_BROKER_MAX_CONNECTIONS; i++)
+    {
+        connection = &broker->connections[i];
+        if (!connection->open)
+        {
+            memset(connection, 0, sizeof(*connection));
+            connection->open = true;
+            connection->socket = -1;
+            connection->send = send;
+            connection->pTransport = pTransport;
+            connection->nextPacketId = 1;
+            return connection;
+        }
+    }
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+/* Sends one copy of a message to a subscriber, padded when the oversized fault hits. */
+static bool deliver(MockBroker_t *broker, MockBrokerConnection_t *subscriber, const MQTTPublishInfo_t *pPublishInfo,
+        MQTTQoS_t qos)
+{
+    MQTTPublishInfo_t copy = *pPublishInfo;
+    MQTTFixedBuffer_t buffer = { broker->txBuffer, MOCK_BROKER_BUFFER_SIZE };
+    size_t remainingLength, packetSize;
+    uint16_t packetId = 0;
+    uint8_t *padded = NULL;
+    bool sent = false;
+
+    copy.qos = qos;
+    copy.dup = false;
+    copy.retain = false;
+    if (qos != MQTTQoS0)
+    {
+        packetId = subscriber->nextPacketId++;
+        subscriber->nextPacketId = (subscriber->nextPacketId == 0U) ? 1U : subscriber->nextPacketId;
+    }
+
+    broker->deliveryCount++;
+    if ((broker->faults.oversizedEvery != 0U) && ((broker->deliveryCount % broker->faults.oversizedEvery) == 0U)
+            && (broker->faults.oversizedLength > copy.payloadLength))
+    {
+        padded = calloc(1, broker->faults.oversizedLength);
+        if (padded != NULL)
+        {
+            memcpy(padded, copy.pPayload, copy.payloadLength);
+            copy.pPayload = padded;
+            copy.payloadLength = broker->faults.oversizedLength;
+        }
+    }
+
+    if (MQTT_GetPublishPacketSize(&copy, &remainingLength, &packetSize) == MQTTSuccess)
+    {
+        if (packetSize > MOCK_BROKER_BUFFER_SIZE)
+        {
+            buffer.pBuffer = malloc(packetSize);
+            buffer.size = packetSize;
+        }
+        if ((buffer.pBuffer != NULL)
+                && (MQTT_SerializePublish(&copy, packetId, remainingLength, &buffer) == MQTTSuccess))
+        {
+            sent = transmit(broker, subscriber, buffer.pBuffer, packetSize);
+            broker->stats.oversizedSent += (sent && (padded != NULL)) ? 1U : 0U;
+        }
+        if (buffer.pBuffer != broker->txBuffer)
+        {
+            free(buffer.pBuffer);
+        }
+    }
+
+    free(padded);
+    return sent;
+}
+
+/* One copy per subscriber, at the highest QoS of its matching filters but no more than the message's. */
+static void route(MockBroker_t *broker, MockBrokerMessage_t *message, const MQTTPublishInfo_t *pPublishInfo)
+{
+    MockBrokerConnection_t *subscriber;
+    MQTTQoS_t qos;
+    bool match, found;
+    int i;
+    uint16_t s;
+
+    for (i = 0; i < MOCK_BROKER_MAX_CONNECTIONS; i++)
+    {
+        subscriber = &broker->connections[i];
+        if (!subscriber->open || !subscriber->connected)
+        {
+            continue;
+        }
+
+        found = false;
+        qos = MQTTQoS0;
+        for (s = 0; s < subscriber->subscriptionCount; s++)
+        {
+            match = false;
+            MQTT_MatchTopic(pPublishInfo->pTopicName, pPublishInfo->topicNameLength,
+                    subscriber->subscriptions[s].filter, subscriber->subscriptions[s].filterLength, &match);
+            if (match)
+            {
+                found = true;
+                qos = (subscriber->subscriptions[s].qos > qos) ? subscriber->subscriptions[s].qos : qos;
+            }
+        }
+
+        if (found && deliver(broker, subscriber, pPublishInfo, (qos < pPublishInfo->qos) ? qos : pPublishInfo->qos))
+        {
+            message->deliveries++;
+            message->forwardedNs = benchNowNs();
+            broker->stats.deliveries++;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void handleConnect(MockBroker_t *broker, MockBrokerConnection_t *connection, const uint8_t *body,
+        size_t bodyLength)
+{
+    uint16_t idLength;
+
+    /* Protocol name "MQTT", level, flags and keep-alive, then the client identifier. */
+    if ((bodyLength < 12U) || (memcmp(&body[2], "MQTT", 4) != 0) || (body[6] != 4U))
+    {
+        broker->stats.protocolErrors++;
+        closeConnection(broker, connection);
+        return;
+    }
+
+    idLength = (uint16_t) ((body[10] << 8) | body[11]);
+    idLength = (12U + idLength > bodyLength) ? 0U : idLength;
+    idLength = (idLength >= MOCK_BROKER_CLIENT_ID_MAX) ? (MOCK_BROKER_CLIENT_ID_MAX - 1U) : idLength;
+    memcpy(connection->clientId, &body[12], idLength);
+    connection->clientId[idLength] = '\0';
+
+    connection->connack[0] = MQTT_PACKET_TYPE_CONNACK;
+    connection->connack[1] = 2;
+    connection->connack[2] = 0;     /* Never a session present. */
+    connection->connack[3] = broker->faults.connackReturnCode;
+
+    if (broker->faults.connackDelayMs != 0U)
+    {
+        connection->connackDueNs = benchNowNs() + (uint64_t) broker->faults.connackDelayMs * 1000000U;
+        return;
+    }
+
+    if (transmit(broker, connection, connection->connack, sizeof(connection->connack)))
+    {
+        if (connection->connack[3] != 0U)
+        {
+            broker->stats.refused++;
+            closeConnection(broker, connection);
+            return;
+        }
+        connection->connected = true;
+        broker->stats.connects++;
+    }
+}
+
+static void handleSubscribe(MockBroker_t *broker, MockBrokerConnection_t *connection, const uint8_t *body,
+        size_t bodyLength)
+{
+    uint8_t reply[4U + MOCK_BROKER_MAX_SUBSCRIPTIONS * 4U];
+    MockBrokerSubscription_t *subscription;
+    size_t offset = 2, count = 0;
+    uint16_t length, s;
+
+    while ((offset + 3U <= bodyLength) && (count < sizeof(reply) - 4U))
+    {
+        length = (uint16_t) ((body[offset] << 8) | body[offset + 1U]);
+        if (offset + 3U + length > bodyLength)
+        {
+            break;
+        }
+
+        subscription = NULL;
+        for (s = 0; s < connection->subscriptionCount; s++)
+        {
+            if ((connection->subscriptions[s].filterLength == length)
+                    && (memcmp(connection->subscriptions[s].filter, &body[offset + 2U], length) == 0))
+            {
+                subscription = &connection->subscriptions[s];
+            }
+        }
+        if ((subscription == NULL) && (connection->subscriptionCount < MOCK_BROKER_MAX_SUBSCRIPTIONS)
+                && (length > 0U) && (length < MOCK_BROKER_FILTER_MAX))
+        {
+            subscription = &connection->subscriptions[connection->subscriptionCount++];
+            memcpy(subscription->filter, &body[offset + 2U], length);
+            subscription->filterLength = length;
+        }
+
+        if (subscription != NULL)
+        {
+            subscription->qos = (MQTTQoS_t) ((body[offset + 2U + length] > 2U) ? 2U : body[offset + 2U + length]);
+            reply[4U + count] = (uint8_t) subscription->qos;
+        }
+        else
+        {
+            reply[4U + count] = 0x80U;
+        }
+        count++;
+        offset += 3U + length;
+    }
+
+    reply[0] = MQTT_PACKET_TYPE_SUBACK;
+    reply[1] = (uint8_t) (2U + count);
+    reply[2] = body[0];
+    reply[3] = body[1];
+    (void) transmit(broker, connection, reply, 4U + count);
+}
+
+static void handleUnsubscribe(MockBroker_t *broker, MockBrokerConnection_t *connection, const uint8_t *body,
+        size_t bodyLength)
+{
+    uint8_t reply[4];
+    size_t offset = 2;
+    uint16_t length, s;
+
+    while (offset + 2U <= bodyLength)
+    {
+        length = (uint16_t) ((body[offset] << 8) | body[offset + 1U]);
+        if (offset + 2U + length > bodyLength)
+        {
+            break;
+        }
+
+        for (s = 0; s < connection->subscriptionCount; s++)
+        {
+            if ((connection->subscriptions[s].filterLength == length)
+                    && (memcmp(connection->subscriptions[s].filter, &body[offset + 2U], length) == 0))
+            {
+                connection->subscriptions[s] = connection->subscriptions[--connection->subscriptionCount];
+                break;
+            }
+        }
+        offset += 2U + length;
+    }
+
+    reply[0] = MQTT_PACKET_TYPE_UNSUBACK;
+    reply[1] = 2;
+    reply[2] = body[0];
+    reply[3] = body[1];
+    (void) transmit(broker, connection, reply, sizeof(reply));
+}
+
+static void handlePublish(MockBroker_t *broker, MockBrokerConnection_t *connection, uint8_t type, uint8_t *body,
+        size_t bodyLength, size_t headerLength)
+{
+    MQTTPacketInfo_t packetInfo = { type, body, bodyLength, headerLength };
+    MQTTPublishInfo_t publishInfo;
+    MockBrokerMessage_t message;
+    uint16_t packetId = 0;
+    uint8_t bit;
+    bool fresh = true;
+
+    memset(&message, 0, sizeof(message));
+    message.receivedNs = benchNowNs();
+
+    if (MQTT_DeserializePublish(&packetInfo, &packetId, &publishInfo) != MQTTSuccess)
+    {
+        broker->stats.protocolErrors++;
+        closeConnection(broker, connection);
+        return;
+    }
+
+    broker->stats.publishesIn[publishInfo.qos]++;
+    broker->stats.duplicatesIn += publishInfo.dup ? 1U : 0U;
+
+    /* A QoS 2 message is forwarded once, a resend before PUBREL only gets its PUBREC again. */
+    if (publishInfo.qos == MQTTQoS2)
+    {
+        bit = (uint8_t) (1U << (packetId % 8U));
+        fresh = (connection->qos2Received[packetId / 8U] & bit) == 0U;
+        connection->qos2Received[packetId / 8U] |= bit;
+        sendAck(broker, connection, MQTT_PACKET_TYPE_PUBREC, packetId);
+    }
+    else if (publishInfo.qos == MQTTQoS1)
+    {
+        sendAck(broker, connection, MQTT_PACKET_TYPE_PUBACK, packetId);
+    }
+
+    if (fresh)
+    {
+        route(broker, &message, &publishInfo);
+    }
+
+    if (broker->messageHook != NULL)
+    {
+        message.connection = (int) (connection - broker->connections);
+        message.pTopicName = publishInfo.pTopicName;
+        message.topicNameLength = publishInfo.topicNameLength;
+        message.pPayload = publishInfo.pPayload;
+        message.payloadLength = publishInfo.payloadLength;
+        message.qos = publishInfo.qos;
+        message.packetId = packetId;
+        message.dup = publishInfo.dup;
+        broker->messageHook(broker->pHookUserData, &message);
+    }
+}
+
+static void handlePacket(MockBroker_t *broker, MockBrokerConnection_t *connection, uint8_t type, uint8_t *body,
+        size_t bodyLength, size_t headerLength)
+{
+    uint16_t packetId = (bodyLength >= 2U) ? (uint16_t) ((body[0] << 8) | body[1]) : 0U;
+    uint8_t reply[2];
+
+    broker->stats.packetsIn[type >> 4]++;
+    broker->stats.bytesIn += headerLength + bodyLength;
+
+    /* Nothing but CONNECT before CONNECT. */
+    if ((connection->connack[0] == 0U) && (type != MQTT_PACKET_TYPE_CONNECT))
+    {
+        broker->stats.protocolErrors++;
+        closeConnection(broker, connection);
+        return;
+    }
+
+    /* PUBLISH carries flags in the low bits, SUBSCRIBE, UNSUBSCRIBE and PUBREL fixed ones. */
+    switch (((type & 0xF0U) == MQTT_PACKET_TYPE_PUBLISH) ? MQTT_PACKET_TYPE_PUBLISH : type)
+    {
+    case MQTT_PACKET_TYPE_CONNECT:
+        handleConnect(broker, connection, body, bodyLength);
+        break;
+
+    case MQTT_PACKET_TYPE_SUBSCRIBE:
+        handleSubscribe(broker, connection, body, bodyLength);
+        break;
+
+    case MQTT_PACKET_TYPE_UNSUBSCRIBE:
+        handleUnsubscribe(broker, connection, body, bodyLength);
+        break;
+
+    case MQTT_PACKET_TYPE_PUBLISH:
+        handlePublish(broker, connection, type, body, bodyLength, headerLength);
+        break;
+
+    case MQTT_PACKET_TYPE_PUBREL:
+        connection->qos2Received[packetId / 8U] &= (uint8_t) ~(1U << (packetId % 8U));
+        sendAck(broker, connection, MQTT_PACKET_TYPE_PUBCOMP, packetId);
+        break;
+
+    case MQTT_PACKET_TYPE_PUBREC:
+        /* Outgoing QoS 2: nothing is kept, the PUBREL goes out straight away. */
+        sendAck(broker, connection, MQTT_PACKET_TYPE_PUBREL, packetId);
+        break;
+
+    case MQTT_PACKET_TYPE_PUBACK:
+    case MQTT_PACKET_TYPE_PUBCOMP:
+        break;
+
+    case MQTT_PACKET_TYPE_PINGREQ:
+        reply[0] = MQTT_PACKET_TYPE_PINGRESP;
+        reply[1] = 0;
+        (void) transmit(broker, connection, reply, sizeof(reply));
+        break;
+
+    case MQTT_PACKET_TYPE_DISCONNECT:
+        closeConnection(broker, connection);
+        break;
+
+    default:
+        broker->stats.protocolErrors++;
+        closeConnection(broker, connection);
+        break;
+    }
+}
+
+/* Handles every complete packet in the receive buffer and keeps the rest. */
+static void processInput(MockBroker_t *broker, MockBrokerConnection_t *connection)
+{
+    size_t offset = 0, remainingLength, headerLength;
+    uint32_t multiplier;
+
+    while (connection->open && (connection->rxLength - offset >= 2U))
+    {
+        remainingLength = 0;
+        multiplier = 1;
+        headerLength = 1;
+        do
+        {
+            if ((offset + headerLength >= connection->rxLength) || (headerLength > 4U))
+            {
+                headerLength = 0;
+                break;
+            }
+            remainingLength += (connection->rx[offset + headerLength] & 0x7FU) * multiplier;
+            multiplier *= 128U;
+        } while ((connection->rx[offset + headerLength++] & 0x80U) != 0U);
+
+        if ((headerLength == 0U) || (headerLength + remainingLength > sizeof(connection->rx)))
+        {
+            /* A length field over four bytes or a packet that can never fit. */
+            if ((headerLength != 0U) || (connection->rxLength - offset > 4U))
+            {
+                broker->stats.protocolErrors++;
+                closeConnection(broker, connection);
+            }
+            break;
+        }
+        if (offset + headerLength + remainingLength > connection->rxLength)
+        {
+            break;
+        }
+
+        handlePacket(broker, connection, connection->rx[offset], &connection->rx[offset + headerLength],
+                remainingLength, headerLength);
+        offset += headerLength + remainingLength;
+    }
+
+    if (!connection->open)
+    {
+        connection->rxLength = 0;
+        return;
+    }
+
+    memmove(connection->rx, &connection->rx[offset], connection->rxLength - offset);
+    connection->rxLength -= offset;
+}
+
+/* Sends CONNACKs held back by the delay fault once they are due. */
+static void runTimers(MockBroker_t *broker)
+{
+    MockBrokerConnection_t *connection;
+    uint64_t now = benchNowNs();
+    int i;
+
+    for (i = 0; i < MOCK_BROKER_MAX_CONNECTIONS; i++)
+    {
+        connection = &broker->connections[i];
+        if (!connection->open || (connection->connackDueNs == 0U) || (connection->connackDueNs > now))
+        {
+            continue;
+        }
+
+        connection->connackDueNs = 0;
+        if (!transmit(broker, connection, connection->connack, sizeof(connection->connack)))
+        {
+            continue;
+        }
+        if (connection->connack[3] != 0U)
+        {
+            broker->stats.refused++;
+            closeConnection(broker, connection);
+            continue;
+        }
+        connection->connected = true;
+        broker->stats.connects++;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void acceptConnection(MockBroker_t *broker)
+{
+    MockBrokerConnection_t *connection;
+    int socket, one = 1;
+
+    socket = accept(broker->listenSocket, NULL, NULL);
+    if (socket < 0)
+    {
+        return;
+    }
+
+    connection = openConnection(broker, socketSend, NULL);
+    if (connection == NULL)
+    {
+        close(socket);
+        return;
+    }
+
+    (void) setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    connection->socket = socket;
+    connection->pTransport = connection;
+}
+
+static void *listenThread(void *parameter)
+{
+    MockBroker_t *broker = parameter;
+    MockBrokerConnection_t *connection;
+    struct timeval timeout;
+    fd_set readable;
+    ssize_t received;
+    int i, maxSocket;
+
+    while (broker->running)
+    {
+        FD_ZERO(&readable);
+        FD_SET(broker->listenSocket, &readable);
+        maxSocket = broker->listenSocket;
+
+        pthread_mutex_lock(&broker->lock);
+        for (i = 0; i < MOCK_BROKER_MAX_CONNECTIONS; i++)
+        {
+            connection = &broker->connections[i];
+            if (connection->open && (connection->socket >= 0))
+            {
+                FD_SET(connection->socket, &readable);
+                maxSocket = (connection->socket > maxSocket) ? connection->socket : maxSocket;
+            }
+        }
+        pthread_mutex_unlock(&broker->lock);
+
+        timeout.tv_sec = 0;
+        timeout.tv_usec = POLL_INTERVAL_US;
+        if (select(maxSocket + 1, &readable, NULL, NULL, &timeout) < 0)
+        {
+            continue;
+        }
+
+        pthread_mutex_lock(&broker->lock);
+        if (FD_ISSET(broker->listenSocket, &readable))
+        {
+            acceptConnection(broker);
+        }
+
+        for (i = 0; i < MOCK_BROKER_MAX_CONNECTIONS; i++)
+        {
+            connection = &broker->connections[i];
+            if (!connection->open || (connection->socket < 0) || !FD_ISSET(connection->socket, &readable))
+            {
+                continue;
+            }
+
+            received = recv(connection->socket, &connection->rx[connection->rxLength],
+                    sizeof(connection->rx) - connection->rxLength, 0);
+            if ((received <= 0) && ((received == 0) || (errno != EINTR)))
+            {
+                closeConnection(broker, connection);
+                continue;
+            }
+            if (received > 0)
+            {
+                connection->rxLength += (size_t) received;
+                processInput(broker, connection);
+            }
+        }
+
+        runTimers(broker);
+        pthread_mutex_unlock(&broker->lock);
+    }
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+int mockBrokerInit(MockBroker_t *broker)
+{
+    int i;
+
+    memset(broker, 0, sizeof(*broker));
+    broker->listenSocket = -1;
+    for (i = 0; i < MOCK_BROKER_MAX_CONNECTIONS; i++)
+    {
+        broker->connections[i].socket = -1;
+    }
+
+    broker->txBuffer = malloc(MOCK_BROKER_BUFFER_SIZE);
+    if (broker->txBuffer == NULL)
+    {
+        return -1;
+    }
+
+    pthread_mutex_init(&broker->lock, NULL);
+    return 0;
+}
+
+void mockBrokerDeinit(MockBroker_t *broker)
+{
+    int i;
+
+    if (broker->running)
+    {
+        broker->running = false;
+        pthread_join(broker->thread, NULL);
+    }
+    if (broker->listenSocket >= 0)
+    {
+        close(broker->listenSocket);
+        broker->listenSocket = -1;
+    }
+
+    for (i = 0; i < MOCK_BROKER_MAX_CONNECTIONS; i++)
+    {
+        closeConnection(broker, &broker->connections[i]);
+    }
+
+    free(broker->txBuffer);
+    broker->txBuffer = NULL;
+    pthread_mutex_destroy(&broker->lock);
+}
+
+void mockBrokerSetFaults(MockBroker_t *broker, const MockBrokerFaults_t *faults)
+{
+    pthread_mutex_lock(&broker->lock);
+    broker->faults = *faults;
+    broker->ackCount = 0;
+    broker->deliveryCount = 0;
+    pthread_mutex_unlock(&broker->lock);
+}
+
+void mockBrokerSetMessageHook(MockBroker_t *broker, MockBrokerMessageHook_t hook, void *pUserData)
+{
+    pthread_mutex_lock(&broker->lock);
+    broker->messageHook = hook;
+    broker->pHookUserData = pUserData;
+    pthread_mutex_unlock(&broker->lock);
+}
+
+void mockBrokerGetStats(MockBroker_t *broker, MockBrokerStats_t *stats)
+{
+    pthread_mutex_lock(&broker->lock);
+    *stats = broker->stats;
+    pthread_mutex_unlock(&broker->lock);
+}
+
+int mockBrokerListen(MockBroker_t *broker, uint16_t port)
+{
+    struct sockaddr_in address;
+    socklen_t addressLength = sizeof(address);
+    int one = 1;
+
+    broker->listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (broker->listenSocket < 0)
+    {
+        return -1;
+    }
+    (void) setsockopt(broker->listenSocket, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if ((bind(broker->listenSocket, (struct sockaddr *) &address, sizeof(address)) != 0)
+            || (listen(broker->listenSocket, MOCK_BROKER_MAX_CONNECTIONS) != 0)
+            || (getsockname(broker->listenSocket, (struct sockaddr *) &address, &addressLength) != 0))
+    {
+        close(broker->listenSocket);
+        broker->listenSocket = -1;
+        return -1;
+    }
+    broker->port = ntohs(address.sin_port);
+
+    broker->running = true;
+    if (pthread_create(&broker->thread, NULL, listenThread, broker) != 0)
+    {
+        broker->running = false;
+        close(broker->listenSocket);
+        broker->listenSocket = -1;
+        return -1;
+    }
+
+    return broker->port;
+}
+
+int mockBrokerOpen(MockBroker_t *broker, MockBrokerSend_t send, void *pTransport)
+{
+    MockBrokerConnection_t *connection;
+    int index = -1;
+
+    pthread_mutex_lock(&broker->lock);
+    connection = openConnection(broker, send, pTransport);
+    if (connection != NULL)
+    {
+        index = (int) (connection - broker->connections);
+    }
+    pthread_mutex_unlock(&broker->lock);
+
+    return index;
+}
+
+int mockBrokerInput(MockBroker_t *broker, int connection, const void *pBuffer, size_t length)
+{
+    MockBrokerConnection_t *pConnection = &broker->connections[connection];
+    const uint8_t *pData = pBuffer;
+    size_t chunk;
+    int result;
+
+    pthread_mutex_lock(&broker->lock);
+    while (pConnection->open && (length > 0U))
+    {
+        chunk = sizeof(pConnection->rx) - pConnection->rxLength;
+        chunk = (chunk > length) ? length : chunk;
+        memcpy(&pConnection->rx[pConnection->rxLength], pData, chunk);
+        pConnection->rxLength += chunk;
+        pData += chunk;
+        length -= chunk;
+        processInput(broker, pConnection);
+    }
+    result = pConnection->open ? 0 : -1;
+    pthread_mutex_unlock(&broker->lock);
+
+    return result;
+}
+
+void mockBrokerClose(MockBroker_t *broker, int connection)
+{
+    pthread_mutex_lock(&broker->lock);
+    closeConnection(broker, &broker->connections[connection]);
+    pthread_mutex_unlock(&broker->lock);
+}
+
+void mockBrokerPoll(MockBroker_t *broker)
+{
+    pthread_mutex_lock(&broker->lock);
+    runTimers(broker);
+    pthread_mutex_unlock(&broker->lock);
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+#ifndef APPLICATIONS_FIREMQTT_BENCH_MOCK_BROKER_H_
+#define APPLICATIONS_FIREMQTT_BENCH_MOCK_BROKER_H_
+
+/*
+ * Mock broker.
+ *
+ * A minimal MQTT 3.1.1 broker for offline end-to-end and load tests, built on
+ * the core serializer. It takes CONNECT, SUBSCRIBE, UNSUBSCRIBE, PUBLISH at
+ * QoS 0 to 2 with their acks, PINGREQ and DISCONNECT, and routes every
+ * PUBLISH to the matching subscriptions at the lower of the two QoS levels.
+ * Sessions are always clean and nothing is retransmitted, retained or
+ * willed.
+ *
+ * Connections come in two ways:
+ *
+ *   loopback TCP   mockBrokerListen() accepts on 127.0.0.1 in its own thread,
+ *                  so an unmodified client, e.g. one of api/mqtt_api.c, can
+ *                  connect to it
+ *   in memory      mockBrokerOpen() returns a connection whose output goes to
+ *                  a send function, and mockBrokerInput() feeds it the bytes
+ *                  the client sent; mockBrokerPoll() runs the timers
+ *
+ * Faults are scripted through MockBrokerFaults_t and can be changed while it
+ * runs. Every PUBLISH received is reported to the message hook with the time
+ * it was parsed and the time its last copy was handed to a subscriber, both
+ * from the CLOCK_MONOTONIC of benchNowNs().
+ *
+ * All calls take the broker lock; send functions and the message hook run
+ * under it and must not call back into the broker.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "core_mqtt.h"
+
+#define MOCK_BROKER_MAX_CONNECTIONS     8
+#define MOCK_BROKER_MAX_SUBSCRIPTIONS   16
+#define MOCK_BROKER_FILTER_MAX          128
+#define MOCK_BROKER_CLIENT_ID_MAX       64
+#define MOCK_BROKER_BUFFER_SIZE         (64U * 1024U)
+
+typedef int32_t (*MockBrokerSend_t)(void *pTransport, const void *pBuffer, size_t length);
+
+typedef struct MockBrokerFaults
+{
+    uint32_t connackDelayMs;        /* CONNACK held back this long. */
+    uint8_t connackReturnCode;      /* Non-zero refuses connections with it. */
+    uint32_t dropAckEvery;          /* Every Nth PUBACK, PUBREC or PUBCOMP is not sent, 0 for none. */
+    uint32_t oversizedEvery;        /* Every Nth delivery has its payload padded */
+    size_t oversizedLength;         /* with zeros to this length, 0 for none. */
+} MockBrokerFaults_t;
+
+typedef struct MockBrokerMessage
+{
+    int connection;                 /* Publisher. */
+    const char *pTopicName;
+    uint16_t topicNameLength;
+    const void *pPayload;
+    size_t payloadLength;
+    MQTTQoS_t qos;
+    uint16_t packetId;
+    bool dup;
+    uint32_t deliveries;            /* Subscribers it was sent to. */
+    uint64_t receivedNs;
+    uint64_t forwardedNs;           /* 0 when nobody subscribed. */
+} MockBrokerMessage_t;
+
+typedef void (*MockBrokerMessageHook_t)(void *pUserData, const MockBrokerMessage_t *pMessage);
+
+typedef struct MockBrokerStats
+{
+    uint32_t connects;
+    uint32_t refused;
+    uint32_t disconnects;           /* Closed connections, clean or not. */
+    uint32_t protocolErrors;
+    uint32_t packetsIn[16];         /* By packet type, the high nibble. */
+    uint32_t packetsOut[16];
+    uint64_t bytesIn;
+    uint64_t bytesOut;
+    uint32_t publishesIn[3];        /* By QoS. */
+    uint32_t duplicatesIn;
+    uint32_t deliveries;
+    uint32_t acksDropped;
+    uint32_t oversizedSent;
+} MockBrokerStats_t;
+
+typedef struct MockBrokerSubscription
+{
+    char filter[MOCK_BROKER_FILTER_MAX];
+    uint16_t filterLength;
+    MQTTQoS_t qos;
+} MockBrokerSubscription_t;
+
+typedef struct MockBrokerConnection
+{
+    bool open;
+    bool connected;                 /* CONNACK sent. */
+    MockBrokerSend_t send;
+    void *pTransport;
+    int socket;                     /* Loopback TCP, -1 in memory. */
+    uint8_t rx[MOCK_BROKER_BUFFER_SIZE];
+    size_t rxLength;
+    char clientId[MOCK_BROKER_CLIENT_ID_MAX];
+    MockBrokerSubscription_t subscriptions[MOCK_BROKER_MAX_SUBSCRIPTIONS];
+    uint16_t subscriptionCount;
+    uint16_t nextPacketId;
+    uint64_t connackDueNs;          /* Delayed CONNACK, 0 for none. */
+    uint8_t connack[4];
+    uint8_t qos2Received[65536U / 8U];
+} MockBrokerConnection_t;
+
+typedef struct MockBroker
+{
+    MockBrokerConnection_t connections[MOCK_BROKER_MAX_CONNECTIONS];
+    MockBrokerFaults_t faults;
+    MockBrokerStats_t stats;
+    MockBrokerMessageHook_t messageHook;
+    void *pHookUserData;
+    uint32_t ackCount;
+    uint32_t deliveryCount;
+    uint8_t *txBuffer;
+    pthread_mutex_t lock;
+    pthread_t thread;
+    int listenSocket;
+    uint16_t port;
+    volatile bool running;
+} MockBroker_t;
+
+int mockBrokerInit(MockBroker_t *broker);
+void mockBrokerDeinit(MockBroker_t *broker);
+void mockBrokerSetFaults(MockBroker_t *broker, const MockBrokerFaults_t *faults);
+void mockBrokerSetMessageHook(MockBroker_t *broker, MockBrokerMessageHook_t hook, void *pUserData);
+void mockBrokerGetStats(MockBroker_t *broker, MockBrokerStats_t *stats);
+
+/* Loopback TCP: returns the port listened on, port 0 picks a free one, or -1. */
+int mockBrokerListen(MockBroker_t *broker, uint16_t port);
+
+/* In memory: a connection index or -1, then 0 or -1 once the connection is closed. */
+int mockBrokerOpen(MockBroker_t *broker, MockBrokerSend_t send, void *pTransport);
+int mockBrokerInput(MockBroker_t *broker, int connection, const void *pBuffer, size_t length);
+void mockBrokerClose(MockBroker_t *broker, int connection);
+void mockBrokerPoll(MockBroker_t *broker);
+
+#endif /* APPLICATIONS_FIREMQTT_BENCH_MOCK_BROKER_H_ */
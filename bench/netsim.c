@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "netsim.h"
+
+#define PIPE_CAPACITY       (4U * 1024U * 1024U)
+#define PIPE_SEGMENTS       (64U * 1024U)
+
+static uint64_t virtualNowUs;
+
+uint64_t netsimNowUs(void)
+{
+    return virtualNowUs;
+}
+
+uint32_t netsimGetTimeMs(void)
+{
+    return (uint32_t) (virtualNowUs / 1000U);
+}
+
+void netsimSetTimeUs(uint64_t nowUs)
+{
+    virtualNowUs = nowUs;
+}
+
+static uint32_t nextRandom(NetsimLink_t *link)
+{
+    link->randomState ^= link->randomState << 13;
+    link->randomState ^= link->randomState >> 17;
+    link->randomState ^= link->randomState << 5;
+    return link->randomState;
+}
+
+static uint32_t randomBelow(NetsimLink_t *link, uint32_t limit)
+{
+    return (limit == 0U) ? 0U : (nextRandom(link) % limit);
+}
+
+static void scheduleDrop(NetsimLink_t *link)
+{
+    uint32_t every = link->config.disconnectEveryUs;
+
+    /* Anywhere between half and one and a half times the mean. */
+    link->nextDropUs = (every == 0U) ? UINT64_MAX : (virtualNowUs + every / 2U + randomBelow(link, every));
+}
+
+static int pipeInit(NetsimPipe_t *pipe)
+{
+    memset(pipe, 0, sizeof(*pipe));
+    pipe->data = malloc(PIPE_CAPACITY);
+    pipe->segments = malloc(PIPE_SEGMENTS * sizeof(NetsimSegment_t));
+    pipe->capacity = PIPE_CAPACITY;
+    pipe->segmentCapacity = PIPE_SEGMENTS;
+
+    return ((pipe->data != NULL) && (pipe->segments != NULL)) ? 0 : -1;
+}
+
+static void pipeReset(NetsimPipe_t *pipe)
+{
+    pipe->readOffset = 0;
+    pipe->writeOffset = 0;
+    pipe->base = 0;
+    pipe->segmentHead = 0;
+    pipe->segmentCount = 0;
+    pipe->wireFreeUs = virtualNowUs;
+}
+
+/* Bytes at the head of the pipe whose segments, and all before them, have arrived. */
+static size_t pipeReadable(NetsimPipe_t *pipe)
+{
+    size_t end = pipe->readOffset, i;
+    const NetsimSegment_t *segment;
+
+    while ((pipe->segmentCount > 0U) && (pipe->segments[pipe->segmentHead].end <= pipe->readOffset))
+    {
+        pipe->segmentHead = (pipe->segmentHead + 1U) % pipe->segmentCapacity;
+        pipe->segmentCount--;
+    }
+
+    for (i = 0; i < pipe->segmentCount; i++)
+    {
+        segment = &pipe->segments[(pipe->segmentHead + i) % pipe->segmentCapacity];
+        if (segment->arrivalUs > virtualNowUs)
+        {
+            break;
+        }
+        end = segment->end;
+    }
+
+    return end - pipe->readOffset;
+}
+
+/* When the next byte becomes readable, UINT64_MAX when nothing is on the way. */
+static uint64_t pipeNextArrival(const NetsimPipe_t *pipe)
+{
+    size_t i;
+    const NetsimSegment_t *segment;
+
+    for (i = 0; i < pipe->segmentCount; i++)
+    {
+        segment = &pipe->segments[(pipe->segmentHead + i) % pipe->segmentCapacity];
+        if ((segment->end > pipe->readOffset) && (segment->arrivalUs > virtualNowUs))
+        {
+            return segment->arrivalUs;
+        }
+    }
+
+    return UINT64_MAX;
+}
+
+static size_t pipeWrite(NetsimLink_t *link, NetsimPipe_t *pipe, const uint8_t *pBuffer, size_t length)
+{
+    NetsimSegment_t *segment;
+    uint64_t departUs;
+    size_t used = pipe->writeOffset - pipe->base;
+
+    if ((length == 0U) || (pipe->segmentCount == pipe->segmentCapacity))
+    {
+        return 0;
+    }
+
+    /* Make room by dropping what was read already. */
+    if (used + length > pipe->capacity)
+    {
+        memmove(pipe->data, &pipe->data[pipe->readOffset - pipe->base], pipe->writeOffset - pipe->readOffset);
+        pipe->base = pipe->readOffset;
+        used = pipe->writeOffset - pipe->base;
+        if (used + length > pipe->capacity)
+        {
+            length = pipe->capacity - used;
+        }
+    }
+
+    memcpy(&pipe->data[used], pBuffer, length);
+    pipe->writeOffset += length;
+
+    departUs = (pipe->wireFreeUs > virtualNowUs) ? pipe->wireFreeUs : virtualNowUs;
+    if (link->config.bytesPerSecond != 0U)
+    {
+        departUs += ((uint64_t) length * 1000000U) / link->config.bytesPerSecond;
+    }
+    pipe->wireFreeUs = departUs;
+
+    segment = &pipe->segments[(pipe->segmentHead + pipe->segmentCount) % pipe->segmentCapacity];
+    segment->end = pipe->writeOffset;
+    segment->arrivalUs = departUs + link->config.latencyUs + randomBelow(link, link->config.jitterUs + 1U);
+    if (randomBelow(link, 100U) < link->config.reorderPercent)
+    {
+        segment->arrivalUs += link->config.reorderDelayUs;
+    }
+    pipe->segmentCount++;
+
+    return length;
+}
+
+static size_t pipeRead(NetsimPipe_t *pipe, uint8_t *pBuffer, size_t length)
+{
+    size_t readable = pipeReadable(pipe);
+
+    if (length > readable)
+    {
+        length = readable;
+    }
+
+    memcpy(pBuffer, &pipe->data[pipe->readOffset - pipe->base], length);
+    pipe->readOffset += length;
+
+    return length;
+}
+
+static bool clientStalled(const NetsimLink_t *link)
+{
+    return (link->config.stallEveryUs != 0U) && ((virtualNowUs % link->config.stallEveryUs) < link->config.stallForUs);
+}
+
+static void checkDrop(NetsimLink_t *link)
+{
+    if (link->up && (virtualNowUs >= link->nextDropUs))
+    {
+        link->up = false;
+        link->droppedAtUs = link->nextDropUs;
+        link->drops++;
+    }
+}
+
+int netsimInit(NetsimLink_t *link, const NetsimLinkConfig_t *config, uint32_t seed)
+{
+    memset(link, 0, sizeof(*link));
+    link->config = *config;
+    link->randomState = (seed == 0U) ? 1U : seed;
+
+    if ((pipeInit(&link->toBroker) != 0) || (pipeInit(&link->toClient) != 0))
+    {
+        netsimDeinit(link);
+        return -1;
+    }
+
+    netsimReconnect(link);
+    return 0;
+}
+
+void netsimDeinit(NetsimLink_t *link)
+{
+    free(link->toBroker.data);
+    free(link->toBroker.segments);
+    free(link->toClient.data);
+    free(link->toClient.segments);
+    memset(&link->toBroker, 0, sizeof(link->toBroker));
+    memset(&link->toClient, 0, sizeof(link->toClient));
+}
+
+void netsimReconnect(NetsimLink_t *link)
+{
+    pipeReset(&link->toBroker);
+    pipeReset(&link->toClient);
+    link->up = true;
+    scheduleDrop(link);
+}
+
+void netsimAdvance(NetsimLink_t *link, uint64_t us)
+{
+    uint64_t target = virtualNowUs + us, next;
+
+    do
+    {
+        next = pipeNextArrival(&link->toBroker);
+        virtualNowUs = (next < target) ? next : target;
+        checkDrop(link);
+
+        if (link->service != NULL)
+        {
+            link->service(link->serviceArg);
+        }
+    } while (virtualNowUs < target);
+}
+
+/* Moves the clock on when the client end could not move any data. */
+static void idle(NetsimLink_t *link)
+{
+    uint64_t next = virtualNowUs + NETSIM_IDLE_STEP_US, arrival, stallEndUs;
+
+    arrival = pipeNextArrival(&link->toClient);
+    next = (arrival < next) ? arrival : next;
+    arrival = pipeNextArrival(&link->toBroker);
+    next = (arrival < next) ? arrival : next;
+    if (clientStalled(link))
+    {
+        stallEndUs = virtualNowUs - (virtualNowUs % link->config.stallEveryUs) + link->config.stallForUs;
+        next = (stallEndUs < next) ? stallEndUs : next;
+    }
+    next = (link->nextDropUs > virtualNowUs && link->nextDropUs < next) ? link->nextDropUs : next;
+
+    netsimAdvance(link, next - virtualNowUs);
+}
+
+size_t netsimReadable(NetsimLink_t *link, NetsimEnd_t to)
+{
+    return link->up ? pipeReadable((to == NetsimClient) ? &link->toClient : &link->toBroker) : 0U;
+}
+
+int32_t netsimSend(NetsimLink_t *link, NetsimEnd_t from, const void *pBuffer, size_t bytesToSend)
+{
+    NetsimPipe_t *pipe = (from == NetsimClient) ? &link->toBroker : &link->toClient;
+    size_t length = bytesToSend, inFlight;
+
+    if (from == NetsimBroker)
+    {
+        return link->up ? (int32_t) pipeWrite(link, pipe, pBuffer, length) : -1;
+    }
+
+    checkDrop(link);
+    if (!link->up)
+    {
+        return -1;
+    }
+
+    inFlight = pipe->writeOffset - pipe->readOffset;
+    if (link->config.sendWindow != 0U)
+    {
+        length = (inFlight >= link->config.sendWindow) ? 0U :
+                ((length > link->config.sendWindow - inFlight) ? (link->config.sendWindow - inFlight) : length);
+    }
+    if ((link->config.maxSendChunk != 0U) && (length > 0U))
+    {
+        size_t chunk = 1U + randomBelow(link, (uint32_t) link->config.maxSendChunk);
+        length = (length > chunk) ? chunk : length;
+    }
+    if (clientStalled(link))
+    {
+        length = 0;
+    }
+
+    length = pipeWrite(link, pipe, pBuffer, length);
+    if (link->service != NULL)
+    {
+        link->service(link->serviceArg);
+    }
+    if (length == 0U)
+    {
+        idle(link);
+    }
+
+    return (int32_t) length;
+}
+
+int32_t netsimRecv(NetsimLink_t *link, NetsimEnd_t to, void *pBuffer, size_t bytesToRecv)
+{
+    NetsimPipe_t *pipe = (to == NetsimClient) ? &link->toClient : &link->toBroker;
+    size_t length = bytesToRecv;
+
+    if (to == NetsimBroker)
+    {
+        return link->up ? (int32_t) pipeRead(pipe, pBuffer, length) : -1;
+    }
+
+    if (link->service != NULL)
+    {
+        link->service(link->serviceArg);
+    }
+    checkDrop(link);
+    if (!link->up)
+    {
+        return -1;
+    }
+
+    if (link->config.maxRecvChunk != 0U)
+    {
+        size_t chunk = 1U + randomBelow(link, (uint32_t) link->config.maxRecvChunk);
+        length = (length > chunk) ? chunk : length;
+    }
+    if (clientStalled(link))
+    {
+        length = 0;
+    }
+
+    length = pipeRead(pipe, pBuffer, length);
+    if (length == 0U)
+    {
+        idle(link);
+    }
+
+    return (int32_t) length;
+}
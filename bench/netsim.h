@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+#ifndef APPLICATIONS_FIREMQTT_BENCH_NETSIM_H_
+#define APPLICATIONS_FIREMQTT_BENCH_NETSIM_H_
+
+/*
+ * Simulated TCP connection between a client and a broker stand-in, running
+ * on a virtual clock. Nothing sleeps: when the client finds nothing to send
+ * or receive, the clock jumps to the next segment arrival (at most
+ * NETSIM_IDLE_STEP_US ahead), so a run is fast and gives the same figures
+ * every time for the same seed.
+ *
+ * Each send becomes one segment. A segment leaves once the ones before it
+ * are on the wire at the configured bandwidth, and arrives after the latency
+ * plus jitter, or later when it is picked for reordering. Bytes are delivered
+ * in order, so a late segment holds back the ones behind it as in TCP.
+ * Partial sends and receives, stalls and disconnects only hit the client end;
+ * the broker end always moves whole buffers.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NETSIM_IDLE_STEP_US     1000U
+
+typedef enum NetsimEnd
+{
+    NetsimClient = 0,
+    NetsimBroker
+} NetsimEnd_t;
+
+typedef struct NetsimLinkConfig
+{
+    uint32_t latencyUs;             /* One way. */
+    uint32_t jitterUs;              /* Added to the latency, uniform 0..jitterUs. */
+    uint32_t bytesPerSecond;        /* 0 for no limit. */
+    uint32_t reorderPercent;        /* Segments arriving reorderDelayUs late. */
+    uint32_t reorderDelayUs;
+    size_t sendWindow;              /* Bytes sent but not read by the peer yet. */
+    size_t maxSendChunk;            /* Client sends take 1..maxSendChunk bytes, 0 for all. */
+    size_t maxRecvChunk;            /* Client receives return 1..maxRecvChunk bytes, 0 for all. */
+    uint32_t stallEveryUs;          /* The client end moves no data for stallForUs */
+    uint32_t stallForUs;            /* out of every stallEveryUs, 0 for never. */
+    uint32_t disconnectEveryUs;     /* Mean time between drops, 0 for never. */
+} NetsimLinkConfig_t;
+
+typedef struct NetsimSegment
+{
+    size_t end;                     /* Stream offset after the segment. */
+    uint64_t arrivalUs;
+} NetsimSegment_t;
+
+typedef struct NetsimPipe
+{
+    uint8_t *data;
+    size_t capacity;
+    size_t readOffset;              /* Stream offsets, data[0] is at base. */
+    size_t writeOffset;
+    size_t base;
+    NetsimSegment_t *segments;
+    size_t segmentCapacity;
+    size_t segmentHead;
+    size_t segmentCount;
+    uint64_t wireFreeUs;            /* When the last segment is fully sent. */
+} NetsimPipe_t;
+
+typedef struct NetsimLink
+{
+    NetsimLinkConfig_t config;
+    NetsimPipe_t toBroker;
+    NetsimPipe_t toClient;
+    uint32_t randomState;
+    bool up;
+    uint64_t nextDropUs;
+    uint64_t droppedAtUs;
+    uint32_t drops;
+
+    /* Runs the broker stand-in whenever the client end touches the link. */
+    void (*service)(void *serviceArg);
+    void *serviceArg;
+} NetsimLink_t;
+
+uint64_t netsimNowUs(void);
+uint32_t netsimGetTimeMs(void);
+void netsimSetTimeUs(uint64_t nowUs);
+
+int netsimInit(NetsimLink_t *link, const NetsimLinkConfig_t *config, uint32_t seed);
+void netsimDeinit(NetsimLink_t *link);
+
+/* Drops whatever is in flight and brings the link up again, as a new connection. */
+void netsimReconnect(NetsimLink_t *link);
+
+/*
+ * Lets virtual time pass, running the broker stand-in at every segment
+ * arrival on the way.
+ */
+void netsimAdvance(NetsimLink_t *link, uint64_t us);
+
+/* Bytes that can be received at this end now, without waiting. */
+size_t netsimReadable(NetsimLink_t *link, NetsimEnd_t to);
+
+/* Transport calls; 0 means nothing could be moved now, -1 that the link is down. */
+int32_t netsimSend(NetsimLink_t *link, NetsimEnd_t from, const void *pBuffer, size_t bytesToSend);
+int32_t netsimRecv(NetsimLink_t *link, NetsimEnd_t to, void *pBuffer, size_t bytesToRecv);
+
+#endif /* APPLICATIONS_FIREMQTT_BENCH_NETSIM_H_ */
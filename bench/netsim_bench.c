@@ -0,0 +1,646 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+/*
+ * Runs the client over the simulated links of netsim.c against a broker
+ * stand-in, on virtual time. For every link profile the client connects with
+ * a persistent session, subscribes to its own storm topic, publishes a storm
+ * at QoS 0, 1 and 2, idles for a few keep-alive periods and disconnects.
+ * Dropped connections are recovered the way an application would: reconnect
+ * after a back-off and let MQTT_Connect() resend the unacknowledged PUBLISHes
+ * and PUBRELs from the retransmit store.
+ *
+ * Per storm it prints acknowledged messages per virtual second and the ack
+ * latency percentiles: PUBLISH to PUBACK for QoS 1, to PUBCOMP for QoS 2 and
+ * to the broker's echo for QoS 0. Per profile it prints the connect time, the
+ * reconnects with the time from the drop to the next CONNACK, and the pings
+ * seen while idle. QoS 0 echoes lost with a connection are missing from the
+ * acked column. The client's own processing takes no virtual time, so the
+ * figures show the protocol and the link only, and are the same on every run.
+ *
+ *   gcc -O2 -DMQTT_DO_NOT_USE_CUSTOM_CONFIG -Icore/include -Icore/interface \
+ *       bench/netsim_bench.c bench/netsim.c core/core_mqtt.c core/core_mqtt_state.c core/core_mqtt_serializer.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "core_mqtt.h"
+#include "netsim.h"
+#include "bench_common.h"
+
+#define MESSAGE_COUNT           2000U
+#define PAYLOAD_LENGTH          256U
+#define OUTGOING_RECORDS        32U
+#define INCOMING_RECORDS        16U
+#define NETWORK_BUFFER_SIZE     4096U
+#define BROKER_BUFFER_SIZE      8192U
+#define KEEP_ALIVE_SECONDS      10U
+#define IDLE_US                 35000000U
+#define QUIET_US                5000000U
+#define BACKOFF_US              100000U
+#define CONNACK_TIMEOUT_MS      5000U
+#define START_US                1000000U
+#define CLIENT_ID               "netsim-client"
+#define STORM_FILTER            "sim/storm/#"
+
+typedef struct Profile
+{
+    const char *name;
+    NetsimLinkConfig_t link;
+} Profile_t;
+
+/* latency, jitter, bytes/s, reorder %, reorder delay, window, send chunk, recv chunk, stall every/for, drop every */
+static const Profile_t profiles[] =
+{
+    { "lan",     { 200, 50, 12500000, 0, 0, 65536, 0, 0, 0, 0, 0 } },
+    { "wan",     { 40000, 5000, 1250000, 0, 0, 65536, 0, 0, 0, 0, 0 } },
+    { "reorder", { 20000, 2000, 1250000, 10, 30000, 65536, 0, 0, 0, 0, 0 } },
+    { "partial", { 5000, 0, 12500000, 0, 0, 65536, 7, 5, 0, 0, 0 } },
+    { "stall",   { 10000, 1000, 1250000, 0, 0, 65536, 0, 0, 3000000, 400000, 0 } },
+    { "flaky",   { 20000, 2000, 1250000, 0, 0, 65536, 0, 0, 0, 0, 4000000 } },
+    { "mobile",  { 60000, 20000, 256000, 5, 50000, 16384, 512, 256, 10000000, 1000000, 8000000 } },
+};
+
+/* The broker stand-in: one client, one persistent session. */
+typedef struct Broker
+{
+    NetsimLink_t *link;
+    uint8_t rx[BROKER_BUFFER_SIZE];
+    size_t rxLength;
+    bool sessionExists;
+    char filter[64];
+    uint16_t filterLength;
+    uint8_t qos2Received[65536U / 8U];
+    uint32_t pings;
+    uint32_t duplicates;
+} Broker_t;
+
+struct NetworkContext
+{
+    NetsimLink_t *link;
+};
+
+static NetsimLink_t link;
+static Broker_t broker;
+static NetworkContext_t network;
+static MQTTContext_t context;
+static MQTTPubAckInfo_t outgoingRecords[OUTGOING_RECORDS];
+static MQTTPubAckInfo_t incomingRecords[INCOMING_RECORDS];
+static uint8_t networkBuffer[NETWORK_BUFFER_SIZE];
+
+/* Retransmit store, by packet ID. */
+static uint8_t *storedPackets[65536];
+static size_t storedLengths[65536];
+
+/* Per storm. */
+static MQTTQoS_t stormQos;
+static uint64_t sendUs[65536];
+static uint64_t echoSendUs[MESSAGE_COUNT];
+static uint32_t latencies[MESSAGE_COUNT];
+static uint32_t latencyCount;
+static uint32_t inflight;
+static uint64_t lastEventUs;
+static bool subscribed;
+
+/* Per profile. */
+static uint32_t reconnects;
+static uint64_t reconnectTotalUs;
+static uint64_t reconnectWorstUs;
+
+/*-----------------------------------------------------------*/
+
+static void brokerSend(const uint8_t *pBuffer, size_t length)
+{
+    (void) netsimSend(broker.link, NetsimBroker, pBuffer, length);
+}
+
+static void brokerAck(uint8_t packetType, uint16_t packetId)
+{
+    uint8_t ack[MQTT_PUBLISH_ACK_PACKET_SIZE];
+    MQTTFixedBuffer_t buffer = { ack, sizeof(ack) };
+
+    if (MQTT_SerializeAck(&buffer, packetType, packetId) == MQTTSuccess)
+    {
+        brokerSend(ack, sizeof(ack));
+    }
+}
+
+static void brokerEcho(const MQTTPublishInfo_t *pPublishInfo)
+{
+    static uint8_t packet[BROKER_BUFFER_SIZE];
+    MQTTPublishInfo_t echo = *pPublishInfo;
+    MQTTFixedBuffer_t buffer = { packet, sizeof(packet) };
+    size_t remainingLength, packetSize;
+    bool match = false;
+
+    MQTT_MatchTopic(echo.pTopicName, echo.topicNameLength, broker.filter, broker.filterLength, &match);
+    if ((broker.filterLength == 0U) || !match)
+    {
+        return;
+    }
+
+    echo.qos = MQTTQoS0;
+    echo.dup = false;
+    if ((MQTT_GetPublishPacketSize(&echo, &remainingLength, &packetSize) == MQTTSuccess)
+            && (MQTT_SerializePublish(&echo, 0, remainingLength, &buffer) == MQTTSuccess))
+    {
+        brokerSend(packet, packetSize);
+    }
+}
+
+static void brokerHandle(uint8_t type, uint8_t *body, size_t bodyLength, size_t headerLength)
+{
+    MQTTPacketInfo_t packetInfo = { type, body, bodyLength, headerLength };
+    MQTTPublishInfo_t publishInfo;
+    uint16_t packetId = (bodyLength >= 2U) ? (uint16_t) ((body[0] << 8) | body[1]) : 0U;
+    uint16_t length;
+    uint8_t reply[5];
+    bool cleanSession;
+
+    /* PUBLISH carries flags in the low bits, SUBSCRIBE and PUBREL fixed ones. */
+    switch (((type & 0xF0U) == MQTT_PACKET_TYPE_PUBLISH) ? MQTT_PACKET_TYPE_PUBLISH : type)
+    {
+    case MQTT_PACKET_TYPE_CONNECT:
+        /* Connect flags follow the protocol name and level. */
+        cleanSession = (bodyLength > 7U) && ((body[7] & 0x02U) != 0U);
+        if (cleanSession)
+        {
+            broker.filterLength = 0;
+            memset(broker.qos2Received, 0, sizeof(broker.qos2Received));
+        }
+        reply[0] = MQTT_PACKET_TYPE_CONNACK;
+        reply[1] = 2;
+        reply[2] = (!cleanSession && broker.sessionExists) ? 1U : 0U;
+        reply[3] = 0;
+        broker.sessionExists = !cleanSession;
+        brokerSend(reply, 4);
+        break;
+
+    case MQTT_PACKET_TYPE_SUBSCRIBE:
+        length = (bodyLength >= 4U) ? (uint16_t) ((body[2] << 8) | body[3]) : 0U;
+        if ((length > 0U) && (length < sizeof(broker.filter)) && (4U + length < bodyLength))
+        {
+            memcpy(broker.filter, &body[4], length);
+            broker.filterLength = length;
+        }
+        /* Echoes go out at QoS 0 only. */
+        reply[0] = MQTT_PACKET_TYPE_SUBACK;
+        reply[1] = 3;
+        reply[2] = body[0];
+        reply[3] = body[1];
+        reply[4] = 0;
+        brokerSend(reply, 5);
+        break;
+
+    case MQTT_PACKET_TYPE_PUBLISH:
+        if (MQTT_DeserializePublish(&packetInfo, &packetId, &publishInfo) != MQTTSuccess)
+        {
+            break;
+        }
+        broker.duplicates += publishInfo.dup ? 1U : 0U;
+        if (publishInfo.qos == MQTTQoS2)
+        {
+            /* A resent QoS 2 PUBLISH was delivered already, it only gets its PUBREC again. */
+            if ((broker.qos2Received[packetId / 8U] & (1U << (packetId % 8U))) == 0U)
+            {
+                broker.qos2Received[packetId / 8U] |= (uint8_t) (1U << (packetId % 8U));
+                brokerEcho(&publishInfo);
+            }
+            brokerAck(MQTT_PACKET_TYPE_PUBREC, packetId);
+        }
+        else
+        {
+            if (publishInfo.qos == MQTTQoS1)
+            {
+                brokerAck(MQTT_PACKET_TYPE_PUBACK, packetId);
+            }
+            brokerEcho(&publishInfo);
+        }
+        break;
+
+    case MQTT_PACKET_TYPE_PUBREL:
+        broker.qos2Received[packetId / 8U] &= (uint8_t) ~(1U << (packetId % 8U));
+        brokerAck(MQTT_PACKET_TYPE_PUBCOMP, packetId);
+        break;
+
+    case MQTT_PACKET_TYPE_PINGREQ:
+        reply[0] = MQTT_PACKET_TYPE_PINGRESP;
+        reply[1] = 0;
+        brokerSend(reply, 2);
+        broker.pings++;
+        break;
+
+    default:
+        break;
+    }
+}
+
+/* Reads what has arrived and answers every complete packet. */
+static void brokerService(void *serviceArg)
+{
+    size_t offset, remainingLength, headerLength;
+    uint32_t multiplier;
+    int32_t received;
+
+    (void) serviceArg;
+
+    received = netsimRecv(broker.link, NetsimBroker, &broker.rx[broker.rxLength],
+            sizeof(broker.rx) - broker.rxLength);
+    if (received < 0)
+    {
+        broker.rxLength = 0;
+        return;
+    }
+    broker.rxLength += (size_t) received;
+
+    offset = 0;
+    while (broker.rxLength - offset >= 2U)
+    {
+        remainingLength = 0;
+        multiplier = 1;
+        headerLength = 1;
+        do
+        {
+            if (offset + headerLength >= broker.rxLength)
+            {
+                headerLength = 0;
+                break;
+            }
+            remainingLength += (broker.rx[offset + headerLength] & 0x7FU) * multiplier;
+            multiplier *= 128U;
+        } while ((broker.rx[offset + headerLength++] & 0x80U) != 0U);
+
+        if ((headerLength == 0U) || (offset + headerLength + remainingLength > broker.rxLength))
+        {
+            break;
+        }
+
+        brokerHandle(broker.rx[offset], &broker.rx[offset + headerLength], remainingLength, headerLength);
+        offset += headerLength + remainingLength;
+    }
+
+    memmove(broker.rx, &broker.rx[offset], broker.rxLength - offset);
+    broker.rxLength -= offset;
+}
+
+/*-----------------------------------------------------------*/
+
+static int32_t simSend(NetworkContext_t *pNetworkContext, const void *pBuffer, size_t bytesToSend)
+{
+    return netsimSend(pNetworkContext->link, NetsimClient, pBuffer, bytesToSend);
+}
+
+static int32_t simRecv(NetworkContext_t *pNetworkContext, void *pBuffer, size_t bytesToRecv)
+{
+    return netsimRecv(pNetworkContext->link, NetsimClient, pBuffer, bytesToRecv);
+}
+
+static bool storePacket(MQTTContext_t *pContext, uint16_t packetId, MQTTVec_t *pMqttVec)
+{
+    size_t length = MQTT_GetBytesInMQTTVec(pMqttVec);
+    uint8_t *copy = malloc(length);
+
+    (void) pContext;
+
+    if (copy == NULL)
+    {
+        return false;
+    }
+
+    MQTT_SerializeMQTTVec(copy, pMqttVec);
+    free(storedPackets[packetId]);
+    storedPackets[packetId] = copy;
+    storedLengths[packetId] = length;
+
+    return true;
+}
+
+static bool retrievePacket(MQTTContext_t *pContext, uint16_t packetId, uint8_t **pSerializedMqttVec,
+        size_t *pSerializedMqttVecLen)
+{
+    (void) pContext;
+
+    *pSerializedMqttVec = storedPackets[packetId];
+    *pSerializedMqttVecLen = storedLengths[packetId];
+
+    return storedPackets[packetId] != NULL;
+}
+
+static void clearPacket(MQTTContext_t *pContext, uint16_t packetId)
+{
+    (void) pContext;
+
+    free(storedPackets[packetId]);
+    storedPackets[packetId] = NULL;
+    storedLengths[packetId] = 0;
+}
+
+static void recordLatency(uint64_t sentUs)
+{
+    uint64_t elapsed = netsimNowUs() - sentUs;
+
+    if (latencyCount < MESSAGE_COUNT)
+    {
+        latencies[latencyCount++] = (elapsed > UINT32_MAX) ? UINT32_MAX : (uint32_t) elapsed;
+    }
+    lastEventUs = netsimNowUs();
+}
+
+static void eventCallback(MQTTContext_t *pContext, MQTTPacketInfo_t *pPacketInfo,
+        MQTTDeserializedInfo_t *pDeserializedInfo)
+{
+    const MQTTPublishInfo_t *pPublishInfo = pDeserializedInfo->pPublishInfo;
+    uint16_t packetId = pDeserializedInfo->packetIdentifier;
+    uint32_t sequence;
+
+    (void) pContext;
+
+    switch (pPacketInfo->type & 0xF0U)
+    {
+    case MQTT_PACKET_TYPE_PUBLISH:
+        /* Only the QoS 0 storm is timed by its echoes. */
+        if ((stormQos == MQTTQoS0) && (pPublishInfo->payloadLength >= sizeof(sequence)))
+        {
+            memcpy(&sequence, pPublishInfo->pPayload, sizeof(sequence));
+            if ((sequence < MESSAGE_COUNT) && (echoSendUs[sequence] != 0U))
+            {
+                recordLatency(echoSendUs[sequence]);
+                echoSendUs[sequence] = 0;
+            }
+        }
+        break;
+
+    case MQTT_PACKET_TYPE_PUBACK:
+    case MQTT_PACKET_TYPE_PUBCOMP:
+        recordLatency(sendUs[packetId]);
+        inflight--;
+        break;
+
+    case MQTT_PACKET_TYPE_SUBACK:
+        subscribed = true;
+        break;
+
+    default:
+        break;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static bool connectClient(void)
+{
+    MQTTConnectInfo_t connectInfo = { 0 };
+    bool sessionPresent = false;
+
+    connectInfo.cleanSession = false;
+    connectInfo.pClientIdentifier = CLIENT_ID;
+    connectInfo.clientIdentifierLength = (uint16_t) strlen(CLIENT_ID);
+    connectInfo.keepAliveSeconds = KEEP_ALIVE_SECONDS;
+
+    return MQTT_Connect(&context, &connectInfo, NULL, CONNACK_TIMEOUT_MS, &sessionPresent) == MQTTSuccess;
+}
+
+/* Opens a new connection after a back-off until the session is resumed. */
+static void recover(void)
+{
+    uint64_t lostUs = link.up ? netsimNowUs() : link.droppedAtUs, elapsed;
+
+    do
+    {
+        (void) MQTT_Disconnect(&context);
+        netsimAdvance(&link, BACKOFF_US);
+        netsimReconnect(&link);
+        broker.rxLength = 0;
+
+        /* The TCP handshake. */
+        netsimAdvance(&link, 2U * link.config.latencyUs);
+    } while (!connectClient());
+
+    elapsed = netsimNowUs() - lostUs;
+    reconnects++;
+    reconnectTotalUs += elapsed;
+    reconnectWorstUs = (elapsed > reconnectWorstUs) ? elapsed : reconnectWorstUs;
+}
+
+static void pump(void)
+{
+    MQTTStatus_t status = MQTT_ProcessLoop(&context);
+
+    if ((status != MQTTSuccess) && (status != MQTTNeedMoreBytes))
+    {
+        recover();
+    }
+}
+
+static int compareLatency(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+static double percentileMs(uint32_t percent)
+{
+    uint32_t index;
+
+    if (latencyCount == 0U)
+    {
+        return 0.0;
+    }
+
+    index = (latencyCount * percent) / 100U;
+    index = (index >= latencyCount) ? (latencyCount - 1U) : index;
+
+    return (double) latencies[index] / 1000.0;
+}
+
+static void storm(MQTTQoS_t qos)
+{
+    static uint8_t payload[PAYLOAD_LENGTH];
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTStatus_t status;
+    char topic[32];
+    uint32_t sequence, duplicates = broker.duplicates;
+    uint16_t packetId = 0;
+    uint64_t startUs = netsimNowUs();
+    double seconds;
+
+    stormQos = qos;
+    latencyCount = 0;
+    lastEventUs = startUs;
+    memset(echoSendUs, 0, sizeof(echoSendUs));
+    memset(payload, 's', sizeof(payload));
+
+    publishInfo.qos = qos;
+    publishInfo.pTopicName = topic;
+    publishInfo.topicNameLength = (uint16_t) snprintf(topic, sizeof(topic), "sim/storm/qos%d", (int) qos);
+    publishInfo.pPayload = payload;
+    publishInfo.payloadLength = sizeof(payload);
+
+    for (sequence = 0; sequence < MESSAGE_COUNT; sequence++)
+    {
+        while ((qos != MQTTQoS0) && (inflight >= OUTGOING_RECORDS))
+        {
+            pump();
+        }
+
+        memcpy(payload, &sequence, sizeof(sequence));
+        if (qos == MQTTQoS0)
+        {
+            echoSendUs[sequence] = netsimNowUs();
+        }
+        else
+        {
+            packetId = MQTT_GetPacketId(&context);
+            sendUs[packetId] = netsimNowUs();
+            inflight++;
+        }
+
+        status = MQTT_Publish(&context, &publishInfo, packetId);
+        if (status == MQTTSendFailed)
+        {
+            /* The record is kept and the PUBLISH resent with the session. */
+            recover();
+        }
+        else if (status != MQTTSuccess)
+        {
+            inflight -= (qos != MQTTQoS0) ? 1U : 0U;
+            recover();
+            sequence--;
+        }
+
+        /* Read what has arrived meanwhile, as a receive thread would. */
+        while (netsimReadable(&link, NetsimClient) > 0U)
+        {
+            pump();
+        }
+    }
+
+    /* QoS 0 echoes lost with a connection are waited for until it is quiet. */
+    while (((inflight > 0U) || ((qos == MQTTQoS0) && (latencyCount < MESSAGE_COUNT)))
+            && (netsimNowUs() - lastEventUs < QUIET_US))
+    {
+        pump();
+    }
+
+    seconds = (double) (lastEventUs - startUs) / 1e6;
+    qsort(latencies, latencyCount, sizeof(latencies[0]), compareLatency);
+    printf("  %3d %6u %6u %10.1f %8.2f %8.2f %8.2f %8.2f %5u\n", (int) qos, (unsigned int) MESSAGE_COUNT,
+            (unsigned int) latencyCount, (seconds > 0.0) ? ((double) latencyCount / seconds) : 0.0,
+            percentileMs(50), percentileMs(90), percentileMs(99),
+            (latencyCount > 0U) ? ((double) latencies[latencyCount - 1U] / 1000.0) : 0.0,
+            (unsigned int) (broker.duplicates - duplicates));
+}
+
+static int runProfile(const Profile_t *profile, uint32_t seed)
+{
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t buffer = { networkBuffer, sizeof(networkBuffer) };
+    MQTTSubscribeInfo_t subscription = { MQTTQoS0, STORM_FILTER, (uint16_t) strlen(STORM_FILTER) };
+    uint64_t wallStart = benchNowNs(), connectUs, idleEndUs;
+    uint32_t pings, i;
+
+    netsimSetTimeUs(START_US);
+    if (netsimInit(&link, &profile->link, seed) != 0)
+    {
+        return 1;
+    }
+
+    memset(&broker, 0, sizeof(broker));
+    broker.link = &link;
+    link.service = brokerService;
+    network.link = &link;
+    transport.send = simSend;
+    transport.recv = simRecv;
+    transport.pNetworkContext = &network;
+
+    memset(&context, 0, sizeof(context));
+    memset(outgoingRecords, 0, sizeof(outgoingRecords));
+    memset(incomingRecords, 0, sizeof(incomingRecords));
+    MQTT_Init(&context, &transport, netsimGetTimeMs, eventCallback, &buffer);
+    MQTT_InitStatefulQoS(&context, outgoingRecords, OUTGOING_RECORDS, incomingRecords, INCOMING_RECORDS);
+    MQTT_InitRetransmits(&context, storePacket, retrievePacket, clearPacket);
+
+    inflight = 0;
+    subscribed = false;
+    reconnects = 0;
+    reconnectTotalUs = 0;
+    reconnectWorstUs = 0;
+
+    netsimAdvance(&link, 2U * link.config.latencyUs);
+    if (!connectClient())
+    {
+        recover();
+    }
+    connectUs = netsimNowUs() - START_US;
+
+    printf("%s\n", profile->name);
+    printf("  qos   sent  acked      msg/s   p50 ms   p90 ms   p99 ms   max ms  dups\n");
+
+    /* A SUBSCRIBE lost with a connection is sent again. */
+    while (!subscribed)
+    {
+        if (MQTT_Subscribe(&context, &subscription, 1, MQTT_GetPacketId(&context)) != MQTTSuccess)
+        {
+            recover();
+            continue;
+        }
+        lastEventUs = netsimNowUs();
+        while (!subscribed && (netsimNowUs() - lastEventUs < QUIET_US))
+        {
+            pump();
+        }
+    }
+
+    storm(MQTTQoS0);
+    storm(MQTTQoS1);
+    storm(MQTTQoS2);
+
+    pings = broker.pings;
+    idleEndUs = netsimNowUs() + IDLE_US;
+    while (netsimNowUs() < idleEndUs)
+    {
+        pump();
+    }
+    pings = broker.pings - pings;
+
+    (void) MQTT_Disconnect(&context);
+
+    printf("  connect %.2f ms, %u drops, %u reconnects (mean %.1f ms, worst %.1f ms), %u pings in %u s idle, "
+            "wall %.1f ms\n", (double) connectUs / 1000.0, (unsigned int) link.drops, (unsigned int) reconnects,
+            (reconnects > 0U) ? ((double) reconnectTotalUs / reconnects / 1000.0) : 0.0,
+            (double) reconnectWorstUs / 1000.0, (unsigned int) pings, (unsigned int) (IDLE_US / 1000000U),
+            (double) (benchNowNs() - wallStart) / 1e6);
+
+    for (i = 0; i < 65536U; i++)
+    {
+        clearPacket(&context, (uint16_t) i);
+    }
+    netsimDeinit(&link);
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t seed = (argc > 1) ? (uint32_t) strtoul(argv[1], NULL, 0) : 1U;
+    uint32_t p;
+    int failures = 0;
+
+    printf("%u messages of %u bytes per storm, %u inflight, seed %u\n", (unsigned int) MESSAGE_COUNT,
+            (unsigned int) PAYLOAD_LENGTH, (unsigned int) OUTGOING_RECORDS, (unsigned int) seed);
+
+    for (p = 0; p < sizeof(profiles) / sizeof(profiles[0]); p++)
+    {
+        failures += runProfile(&profiles[p], seed);
+    }
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+/*
+ * Receive path throughput: MQTT_ProcessLoop() reads pre-generated PUBLISH
+ * streams from an in-memory transport. Every QoS level and payload size is
+ * run with recv returning 1 byte, 64 bytes or as much as the network buffer
+ * takes, and the bytes memmove()d inside receiveSingleIteration() are counted
+ * through MQTT_RECV_MEMMOVE_HOOK. Build with the counting config instead of
+ * MQTT_DO_NOT_USE_CUSTOM_CONFIG:
+ *
+ *   gcc -O2 -Ibench/config -Icore/include -Icore/interface \
+ *       bench/recv_bench.c core/core_mqtt.c core/core_mqtt_state.c core/core_mqtt_serializer.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "core_mqtt.h"
+#include "bench_common.h"
+
+#define PACKET_COUNT        20000U
+#define BUFFER_SIZE         4096U
+#define INCOMING_RECORDS    16U
+#define WHOLE_BUFFER        0U
+#define TOPIC               "bench/receive/sensor-0042/telemetry"
+
+struct NetworkContext
+{
+    const uint8_t *stream;
+    size_t length;
+    size_t offset;
+    size_t chunk;               /* Largest recv, WHOLE_BUFFER for no limit. */
+    uint32_t recvCalls;
+    size_t sentBytes;
+};
+
+size_t benchMemmoveBytes;
+
+static uint32_t publishCallbacks;
+static uint32_t otherCallbacks;
+
+static int32_t mockRecv(NetworkContext_t *pNetworkContext, void *pBuffer, size_t bytesToRecv)
+{
+    size_t length = pNetworkContext->length - pNetworkContext->offset;
+
+    pNetworkContext->recvCalls++;
+    if (length > bytesToRecv)
+    {
+        length = bytesToRecv;
+    }
+    if ((pNetworkContext->chunk != WHOLE_BUFFER) && (length > pNetworkContext->chunk))
+    {
+        length = pNetworkContext->chunk;
+    }
+
+    memcpy(pBuffer, &pNetworkContext->stream[pNetworkContext->offset], length);
+    pNetworkContext->offset += length;
+
+    return (int32_t) length;
+}
+
+static int32_t mockSend(NetworkContext_t *pNetworkContext, const void *pBuffer, size_t bytesToSend)
+{
+    (void) pBuffer;
+
+    /* Acks go nowhere. */
+    pNetworkContext->sentBytes += bytesToSend;
+    return (int32_t) bytesToSend;
+}
+
+static uint32_t benchTimeMs(void)
+{
+    return (uint32_t) (benchNowNs() / 1000000ULL);
+}
+
+static void eventCallback(MQTTContext_t *pContext, MQTTPacketInfo_t *pPacketInfo,
+        MQTTDeserializedInfo_t *pDeserializedInfo)
+{
+    (void) pContext;
+
+    if ((pPacketInfo->type & 0xF0U) == MQTT_PACKET_TYPE_PUBLISH)
+    {
+        publishCallbacks++;
+        benchSink += (uint32_t) pDeserializedInfo->pPublishInfo->payloadLength;
+    }
+    else
+    {
+        otherCallbacks++;
+    }
+}
+
+/* PACKET_COUNT publishes; each QoS 2 one is followed by the broker's PUBREL. */
+static size_t buildStream(uint8_t *stream, size_t size, MQTTQoS_t qos, size_t payloadLength)
+{
+    static uint8_t payload[BUFFER_SIZE];
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTFixedBuffer_t buffer;
+    size_t length = 0, remainingLength, packetSize;
+    uint16_t packetId;
+    uint32_t i;
+
+    memset(payload, 'p', sizeof(payload));
+    publishInfo.qos = qos;
+    publishInfo.pTopicName = TOPIC;
+    publishInfo.topicNameLength = (uint16_t) strlen(TOPIC);
+    publishInfo.pPayload = payload;
+    publishInfo.payloadLength = payloadLength;
+
+    for (i = 0; i < PACKET_COUNT; i++)
+    {
+        packetId = (qos == MQTTQoS0) ? 0U : (uint16_t) ((i % 65535U) + 1U);
+        MQTT_GetPublishPacketSize(&publishInfo, &remainingLength, &packetSize);
+
+        buffer.pBuffer = &stream[length];
+        buffer.size = size - length;
+        if (MQTT_SerializePublish(&publishInfo, packetId, remainingLength, &buffer) != MQTTSuccess)
+        {
+            break;
+        }
+        length += packetSize;
+
+        if (qos == MQTTQoS2)
+        {
+            buffer.pBuffer = &stream[length];
+            buffer.size = size - length;
+            if (MQTT_SerializeAck(&buffer, MQTT_PACKET_TYPE_PUBREL, packetId) != MQTTSuccess)
+            {
+                break;
+            }
+            length += MQTT_PUBLISH_ACK_PACKET_SIZE;
+        }
+    }
+
+    return length;
+}
+
+static int runCase(const uint8_t *stream, size_t streamLength, MQTTQoS_t qos, size_t payloadLength, size_t chunk)
+{
+    static uint8_t networkBuffer[BUFFER_SIZE];
+    static MQTTPubAckInfo_t outgoingRecords[1];
+    static MQTTPubAckInfo_t incomingRecords[INCOMING_RECORDS];
+    NetworkContext_t network = { 0 };
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t buffer = { networkBuffer, BUFFER_SIZE };
+    MQTTContext_t context;
+    MQTTStatus_t status = MQTTSuccess;
+    uint64_t start, elapsed;
+    double seconds;
+    char chunkName[16];
+
+    network.stream = stream;
+    network.length = streamLength;
+    network.chunk = chunk;
+    transport.recv = mockRecv;
+    transport.send = mockSend;
+    transport.pNetworkContext = &network;
+
+    memset(&context, 0, sizeof(context));
+    memset(incomingRecords, 0, sizeof(incomingRecords));
+    MQTT_Init(&context, &transport, benchTimeMs, eventCallback, &buffer);
+    MQTT_InitStatefulQoS(&context, outgoingRecords, 1, incomingRecords, INCOMING_RECORDS);
+    context.connectStatus = MQTTConnected;
+    context.keepAliveIntervalSec = 0;
+
+    publishCallbacks = 0;
+    otherCallbacks = 0;
+    benchMemmoveBytes = 0;
+
+    start = benchNowNs();
+    while (((network.offset < network.length) || (context.index > 0U))
+            && ((status == MQTTSuccess) || (status == MQTTNeedMoreBytes)))
+    {
+        status = MQTT_ProcessLoop(&context);
+    }
+    elapsed = benchNowNs() - start;
+
+    if (chunk == WHOLE_BUFFER)
+    {
+        snprintf(chunkName, sizeof(chunkName), "buffer");
+    }
+    else
+    {
+        snprintf(chunkName, sizeof(chunkName), "%u", (unsigned int) chunk);
+    }
+
+    seconds = (double) elapsed / 1e9;
+    printf("%3d %7u %7s %12.0f %9.1f %12.1f %10u %9u %9u\n", (int) qos, (unsigned int) payloadLength, chunkName,
+            (double) publishCallbacks / seconds, (double) elapsed / (double) PACKET_COUNT,
+            (double) benchMemmoveBytes / (double) PACKET_COUNT, (unsigned int) network.recvCalls,
+            (unsigned int) publishCallbacks, (unsigned int) otherCallbacks);
+
+    if ((publishCallbacks != PACKET_COUNT) || ((status != MQTTSuccess) && (status != MQTTNeedMoreBytes)))
+    {
+        printf("    incomplete: status %s\n", MQTT_Status_strerror(status));
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(void)
+{
+    static const size_t payloadLengths[] = { 16, 256, 1024 };
+    static const size_t chunks[] = { 1, 64, WHOLE_BUFFER };
+    uint8_t *stream;
+    size_t streamSize, streamLength;
+    uint32_t q, p, c;
+    int failures = 0;
+
+    streamSize = PACKET_COUNT * (BUFFER_SIZE / 2U);
+    stream = malloc(streamSize);
+    if (stream == NULL)
+    {
+        return 1;
+    }
+
+    printf("%u packets per case, %u byte network buffer\n", (unsigned int) PACKET_COUNT, (unsigned int) BUFFER_SIZE);
+    printf("qos payload   chunk     packets/s    ns/pkt memmove B/pkt recv calls publishes     other\n");
+
+    for (q = 0; q < 3U; q++)
+    {
+        for (p = 0; p < sizeof(payloadLengths) / sizeof(payloadLengths[0]); p++)
+        {
+            streamLength = buildStream(stream, streamSize, (MQTTQoS_t) q, payloadLengths[p]);
+            for (c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+            {
+                failures += runCase(stream, streamLength, (MQTTQoS_t) q, payloadLengths[p], chunks[c]);
+            }
+        }
+    }
+
+    free(stream);
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+/*
+ * Times the packet functions of core_mqtt_serializer.c over topic length,
+ * payload size and subscription count sweeps. Payload sizes are picked so
+ * the remaining length takes 1, 2, 3 and 4 bytes. Results go to stdout as
+ * CSV, or as a JSON array with --json, one record per function and case:
+ *
+ *   function, topic_length, payload_length, count, remaining_length_bytes,
+ *   iterations, ns_per_op, bytes_per_op
+ *
+ *   gcc -O2 -DMQTT_DO_NOT_USE_CUSTOM_CONFIG -Icore/include -Icore/interface \
+ *       bench/serializer_bench.c core/core_mqtt.c core/core_mqtt_state.c core/core_mqtt_serializer.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "core_mqtt.h"
+#include "bench_common.h"
+
+#define BYTES_PER_CASE      (64U * 1024U * 1024U)
+#define ITERATIONS_MIN      64U
+#define ITERATIONS_MAX      200000U
+#define TOPIC_MAX_LEN       256U
+#define PAYLOAD_MAX_LEN     2200000U
+#define FILTER_MAX_COUNT    32U
+#define BUFFER_SIZE         (PAYLOAD_MAX_LEN + TOPIC_MAX_LEN + 16U)
+
+typedef struct BenchCase
+{
+    const char *function;
+    size_t topicLength;
+    size_t payloadLength;
+    size_t count;
+    size_t remainingLength;
+    size_t packetSize;
+} BenchCase_t;
+
+static bool jsonOutput;
+static bool firstRow = true;
+static uint8_t *buffer;
+static char topic[TOPIC_MAX_LEN];
+static uint8_t *payload;
+
+static uint32_t remainingLengthBytes(size_t remainingLength)
+{
+    return (remainingLength < 128U) ? 1U : (remainingLength < 16384U) ? 2U : (remainingLength < 2097152U) ? 3U : 4U;
+}
+
+/* Fewer rounds for large packets so every case moves about the same bytes. */
+static uint32_t iterationsFor(size_t bytesPerOp)
+{
+    size_t iterations = BYTES_PER_CASE / (bytesPerOp + 64U);
+
+    if (iterations < ITERATIONS_MIN)
+    {
+        iterations = ITERATIONS_MIN;
+    }
+    if (iterations > ITERATIONS_MAX)
+    {
+        iterations = ITERATIONS_MAX;
+    }
+
+    return (uint32_t) iterations;
+}
+
+static void printRow(const BenchCase_t *benchCase, uint32_t iterations, uint64_t elapsedNs)
+{
+    double nsPerOp = (double) elapsedNs / (double) iterations;
+
+    if (jsonOutput)
+    {
+        printf("%s  {\"function\": \"%s\", \"topic_length\": %u, \"payload_length\": %u, \"count\": %u, "
+                "\"remaining_length_bytes\": %u, \"iterations\": %u, \"ns_per_op\": %.2f, \"bytes_per_op\": %u}",
+                firstRow ? "" : ",\n", benchCase->function, (unsigned int) benchCase->topicLength,
+                (unsigned int) benchCase->payloadLength, (unsigned int) benchCase->count,
+                remainingLengthBytes(benchCase->remainingLength), iterations, nsPerOp,
+                (unsigned int) benchCase->packetSize);
+    }
+    else
+    {
+        printf("%s,%u,%u,%u,%u,%u,%.2f,%u\n", benchCase->function, (unsigned int) benchCase->topicLength,
+                (unsigned int) benchCase->payloadLength, (unsigned int) benchCase->count,
+                remainingLengthBytes(benchCase->remainingLength), iterations, nsPerOp,
+                (unsigned int) benchCase->packetSize);
+    }
+    firstRow = false;
+}
+
+static void benchPublish(size_t topicLength, size_t payloadLength)
+{
+    MQTTPublishInfo_t publishInfo = { 0 }, deserialized;
+    MQTTFixedBuffer_t fixedBuffer = { buffer, BUFFER_SIZE };
+    MQTTPacketInfo_t packetInfo;
+    BenchCase_t benchCase = { 0 };
+    size_t remainingLength = 0, packetSize = 0, headerSize, index;
+    uint16_t packetId;
+    uint32_t i, iterations;
+    uint64_t start;
+
+    publishInfo.qos = MQTTQoS1;
+    publishInfo.pTopicName = topic;
+    publishInfo.topicNameLength = (uint16_t) topicLength;
+    publishInfo.pPayload = payload;
+    publishInfo.payloadLength = payloadLength;
+
+    MQTT_GetPublishPacketSize(&publishInfo, &remainingLength, &packetSize);
+    benchCase.topicLength = topicLength;
+    benchCase.payloadLength = payloadLength;
+    benchCase.count = 1;
+    benchCase.remainingLength = remainingLength;
+    benchCase.packetSize = packetSize;
+
+    /* Only the full serialization touches the payload. */
+    iterations = ITERATIONS_MAX;
+    benchCase.function = "MQTT_GetPublishPacketSize";
+    start = benchNowNs();
+    for (i = 0; i < iterations; i++)
+    {
+        MQTT_GetPublishPacketSize(&publishInfo, &remainingLength, &packetSize);
+        benchSink += (uint32_t) packetSize;
+    }
+    printRow(&benchCase, iterations, benchNowNs() - start);
+
+    iterations = iterationsFor(packetSize);
+    benchCase.function = "MQTT_SerializePublish";
+    start = benchNowNs();
+    for (i = 0; i < iterations; i++)
+    {
+        MQTT_SerializePublish(&publishInfo, (uint16_t) (i | 1U), remainingLength, &fixedBuffer);
+        benchSink += buffer[packetSize - 1U];
+    }
+    printRow(&benchCase, iterations, benchNowNs() - start);
+
+    iterations = ITERATIONS_MAX;
+    benchCase.function = "MQTT_SerializePublishHeaderWithoutTopic";
+    start = benchNowNs();
+    for (i = 0; i < iterations; i++)
+    {
+        MQTT_SerializePublishHeaderWithoutTopic(&publishInfo, remainingLength, buffer, &headerSize);
+        benchSink += (uint32_t) headerSize;
+    }
+    printRow(&benchCase, iterations, benchNowNs() - start);
+
+    /* The buffer holds the serialized packet from here on. */
+    MQTT_SerializePublish(&publishInfo, 1U, remainingLength, &fixedBuffer);
+
+    benchCase.function = "MQTT_ProcessIncomingPacketTypeAndLength";
+    start = benchNowNs();
+    for (i = 0; i < iterations; i++)
+    {
+        index = packetSize;
+        MQTT_ProcessIncomingPacketTypeAndLength(buffer, &index, &packetInfo);
+        benchSink += (uint32_t) packetInfo.remainingLength;
+    }
+    printRow(&benchCase, iterations, benchNowNs() - start);
+
+    index = packetSize;
+    MQTT_ProcessIncomingPacketTypeAndLength(buffer, &index, &packetInfo);
+    packetInfo.pRemainingData = &buffer[packetInfo.headerLength];
+
+    benchCase.function = "MQTT_DeserializePublish";
+    start = benchNowNs();
+    for (i = 0; i < iterations; i++)
+    {
+        MQTT_DeserializePublish(&packetInfo, &packetId, &deserialized);
+        benchSink += packetId + (uint32_t) deserialized.payloadLength;
+    }
+    printRow(&benchCase, iterations, benchNowNs() - start);
+}
+
+static void benchSubscribe(size_t topicLength, size_t count)
+{
+    MQTTSubscribeInfo_t subscriptions[FILTER_MAX_COUNT];
+    MQTTFixedBuffer_t fixedBuffer = { buffer, BUFFER_SIZE };
+    BenchCase_t benchCase = { 0 };
+    size_t remainingLength = 0, packetSize = 0, i;
+    uint32_t n, iterations;
+    uint64_t start;
+
+    for (i = 0; i < count; i++)
+    {
+        subscriptions[i].qos = (MQTTQoS_t) (i % 3U);
+        subscriptions[i].pTopicFilter = topic;
+        subscriptions[i].topicFilterLength = (uint16_t) topicLength;
+    }
+
+    MQTT_GetSubscribePacketSize(subscriptions, count, &remainingLength, &packetSize);
+    benchCase.function = "MQTT_SerializeSubscribe";
+    benchCase.topicLength = topicLength;
+    benchCase.count = count;
+    benchCase.remainingLength = remainingLength;
+    benchCase.packetSize = packetSize;
+
+    iterations = iterationsFor(packetSize);
+    start = benchNowNs();
+    for (n = 0; n < iterations; n++)
+    {
+        MQTT_SerializeSubscribe(subscriptions, count, (uint16_t) (n | 1U), remainingLength, &fixedBuffer);
+        benchSink += buffer[packetSize - 1U];
+    }
+    printRow(&benchCase, iterations, benchNowNs() - start);
+}
+
+static void benchAck(const char *name, uint8_t type, size_t remainingLength)
+{
+    MQTTPacketInfo_t packetInfo = { 0 };
+    BenchCase_t benchCase = { 0 };
+    uint8_t body[2U + FILTER_MAX_COUNT] = { 0x00, 0x2A };
+    uint16_t packetId;
+    bool sessionPresent;
+    uint32_t i, iterations = ITERATIONS_MAX;
+    uint64_t start;
+
+    /* Every byte after the packet ID is a valid SUBACK return code or a
+     * CONNACK accepted code. */
+    if (type == MQTT_PACKET_TYPE_CONNACK)
+    {
+        body[1] = 0x00;
+    }
+
+    packetInfo.type = type;
+    packetInfo.pRemainingData = body;
+    packetInfo.remainingLength = remainingLength;
+    packetInfo.headerLength = 2U;
+
+    benchCase.function = name;
+    benchCase.count = (type == MQTT_PACKET_TYPE_SUBACK) ? (remainingLength - 2U) : 1U;
+    benchCase.remainingLength = remainingLength;
+    benchCase.packetSize = remainingLength + 2U;
+
+    start = benchNowNs();
+    for (i = 0; i < iterations; i++)
+    {
+        MQTT_DeserializeAck(&packetInfo, &packetId, &sessionPresent);
+        benchSink += packetId;
+    }
+    printRow(&benchCase, iterations, benchNowNs() - start);
+}
+
+int main(int argc, char **argv)
+{
+    static const size_t topicLengths[] = { 8, 64, 256 };
+    static const size_t payloadLengths[] = { 16, 1000, 100000, 2100000 };
+    static const size_t filterCounts[] = { 1, 8, FILTER_MAX_COUNT };
+    size_t t, p, f;
+
+    jsonOutput = (argc > 1) && (strcmp(argv[1], "--json") == 0);
+
+    buffer = malloc(BUFFER_SIZE);
+    payload = malloc(PAYLOAD_MAX_LEN);
+    if ((buffer == NULL) || (payload == NULL))
+    {
+        return 1;
+    }
+    memset(payload, 'p', PAYLOAD_MAX_LEN);
+    memset(topic, 't', sizeof(topic));
+
+    if (jsonOutput)
+    {
+        printf("[\n");
+    }
+    else
+    {
+        printf("function,topic_length,payload_length,count,remaining_length_bytes,iterations,ns_per_op,bytes_per_op\n");
+    }
+
+    for (t = 0; t < sizeof(topicLengths) / sizeof(topicLengths[0]); t++)
+    {
+        for (p = 0; p < sizeof(payloadLengths) / sizeof(payloadLengths[0]); p++)
+        {
+            benchPublish(topicLengths[t], payloadLengths[p]);
+        }
+        for (f = 0; f < sizeof(filterCounts) / sizeof(filterCounts[0]); f++)
+        {
+            benchSubscribe(topicLengths[t], filterCounts[f]);
+        }
+    }
+
+    benchAck("MQTT_DeserializeAck(PUBACK)", MQTT_PACKET_TYPE_PUBACK, 2U);
+    benchAck("MQTT_DeserializeAck(PUBREC)", MQTT_PACKET_TYPE_PUBREC, 2U);
+    benchAck("MQTT_DeserializeAck(PUBREL)", MQTT_PACKET_TYPE_PUBREL, 2U);
+    benchAck("MQTT_DeserializeAck(PUBCOMP)", MQTT_PACKET_TYPE_PUBCOMP, 2U);
+    benchAck("MQTT_DeserializeAck(CONNACK)", MQTT_PACKET_TYPE_CONNACK, 2U);
+    for (f = 0; f < sizeof(filterCounts) / sizeof(filterCounts[0]); f++)
+    {
+        benchAck("MQTT_DeserializeAck(SUBACK)", MQTT_PACKET_TYPE_SUBACK, 2U + filterCounts[f]);
+    }
+
+    if (jsonOutput)
+    {
+        printf("\n]\n");
+    }
+
+    free(buffer);
+    free(payload);
+    return 0;
+}
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+/*
+ * Cost of the outgoing QoS 1 state records as the inflight window grows from
+ * 8 to 65535 records. For every window size and ack pattern (in order,
+ * newest first, random) it times:
+ *
+ *   fill     MQTT_ReserveState() and MQTT_UpdateStatePublish() until full
+ *   resend   one MQTT_PublishToResend() walk over the full window
+ *   steady   ack one, publish one, with the window kept full; every reserve
+ *            that finds the last record in use runs compactRecords()
+ *   drain    MQTT_UpdateStateAck() until empty
+ *
+ * and prints the mean and the worst single call. Single calls are timed, so
+ * the clock overhead printed first is part of every figure.
+ *
+ *   gcc -O2 -DMQTT_DO_NOT_USE_CUSTOM_CONFIG -Icore/include -Icore/interface \
+ *       bench/state_bench.c core/core_mqtt.c core/core_mqtt_state.c core/core_mqtt_serializer.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "core_mqtt.h"
+#include "core_mqtt_state.h"
+#include "bench_common.h"
+
+#define STEADY_OPS_MAX      4096U
+
+typedef enum AckPattern
+{
+    AckInOrder = 0,
+    AckReverse,
+    AckRandom
+} AckPattern_t;
+
+typedef struct OpStats
+{
+    uint64_t totalNs;
+    uint64_t worstNs;
+    uint32_t ops;
+    uint32_t failures;
+} OpStats_t;
+
+struct NetworkContext
+{
+    int unused;
+};
+
+static const char *const patternNames[] = { "in-order", "reverse", "random" };
+static uint32_t randomState = 12345U;
+static uint16_t *inflight;
+static size_t inflightCount;
+
+static uint32_t nextRandom(void)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+static int32_t stubRecv(NetworkContext_t *pNetworkContext, void *pBuffer, size_t bytesToRecv)
+{
+    (void) pNetworkContext;
+    (void) pBuffer;
+    (void) bytesToRecv;
+    return 0;
+}
+
+static int32_t stubSend(NetworkContext_t *pNetworkContext, const void *pBuffer, size_t bytesToSend)
+{
+    (void) pNetworkContext;
+    (void) pBuffer;
+    return (int32_t) bytesToSend;
+}
+
+static uint32_t benchTimeMs(void)
+{
+    return (uint32_t) (benchNowNs() / 1000000ULL);
+}
+
+static void eventCallback(MQTTContext_t *pContext, MQTTPacketInfo_t *pPacketInfo,
+        MQTTDeserializedInfo_t *pDeserializedInfo)
+{
+    (void) pContext;
+    (void) pPacketInfo;
+    (void) pDeserializedInfo;
+}
+
+static void record(OpStats_t *stats, uint64_t elapsedNs, MQTTStatus_t status)
+{
+    stats->totalNs += elapsedNs;
+    stats->worstNs = (elapsedNs > stats->worstNs) ? elapsedNs : stats->worstNs;
+    stats->ops++;
+    stats->failures += (status == MQTTSuccess) ? 0U : 1U;
+}
+
+static void printStats(size_t recordCount, AckPattern_t pattern, const char *operation, const OpStats_t *stats)
+{
+    printf("%7u  %-9s %-28s %7u %10.1f %10u%s\n", (unsigned int) recordCount, patternNames[pattern], operation,
+            (unsigned int) stats->ops, (stats->ops > 0U) ? ((double) stats->totalNs / (double) stats->ops) : 0.0,
+            (unsigned int) stats->worstNs, (stats->failures > 0U) ? "  FAILED" : "");
+}
+
+static void publishOne(MQTTContext_t *context, uint16_t packetId, OpStats_t *reserve, OpStats_t *publish)
+{
+    MQTTPublishState_t state;
+    MQTTStatus_t status;
+    uint64_t start;
+
+    start = benchNowNs();
+    status = MQTT_ReserveState(context, packetId, MQTTQoS1);
+    record(reserve, benchNowNs() - start, status);
+
+    start = benchNowNs();
+    status = MQTT_UpdateStatePublish(context, packetId, MQTT_SEND, MQTTQoS1, &state);
+    record(publish, benchNowNs() - start, status);
+
+    inflight[inflightCount++] = packetId;
+}
+
+/* Takes the next packet to ack out of the inflight list, oldest first. */
+static uint16_t pickAck(AckPattern_t pattern)
+{
+    size_t index = (pattern == AckInOrder) ? 0U :
+            (pattern == AckReverse) ? (inflightCount - 1U) : (nextRandom() % inflightCount);
+    uint16_t packetId = inflight[index];
+
+    memmove(&inflight[index], &inflight[index + 1U], (inflightCount - index - 1U) * sizeof(uint16_t));
+    inflightCount--;
+
+    return packetId;
+}
+
+static void ackOne(MQTTContext_t *context, uint16_t packetId, OpStats_t *ack)
+{
+    MQTTPublishState_t state;
+    MQTTStatus_t status;
+    uint64_t start;
+
+    start = benchNowNs();
+    status = MQTT_UpdateStateAck(context, packetId, MQTTPuback, MQTT_RECEIVE, &state);
+    record(ack, benchNowNs() - start, status);
+}
+
+static void runCase(size_t recordCount, AckPattern_t pattern)
+{
+    static MQTTPubAckInfo_t incomingRecords[1];
+    MQTTPubAckInfo_t *outgoingRecords = calloc(recordCount, sizeof(MQTTPubAckInfo_t));
+    NetworkContext_t network = { 0 };
+    TransportInterface_t transport = { 0 };
+    uint8_t networkBuffer[64];
+    MQTTFixedBuffer_t buffer = { networkBuffer, sizeof(networkBuffer) };
+    MQTTContext_t context;
+    MQTTStateCursor_t cursor = MQTT_STATE_CURSOR_INITIALIZER;
+    OpStats_t fillReserve = { 0 }, fillPublish = { 0 }, resend = { 0 }, steadyAck = { 0 }, steadyReserve = { 0 },
+            steadyPublish = { 0 }, drainAck = { 0 };
+    uint64_t start, elapsed;
+    uint16_t packetId;
+    size_t i, steadyOps;
+
+    if (outgoingRecords == NULL)
+    {
+        return;
+    }
+
+    transport.recv = stubRecv;
+    transport.send = stubSend;
+    transport.pNetworkContext = &network;
+    memset(&context, 0, sizeof(context));
+    MQTT_Init(&context, &transport, benchTimeMs, eventCallback, &buffer);
+    MQTT_InitStatefulQoS(&context, outgoingRecords, recordCount, incomingRecords, 1);
+    inflightCount = 0;
+
+    for (i = 0; i < recordCount; i++)
+    {
+        publishOne(&context, (uint16_t) (i + 1U), &fillReserve, &fillPublish);
+    }
+
+    do
+    {
+        start = benchNowNs();
+        packetId = MQTT_PublishToResend(&context, &cursor);
+        elapsed = benchNowNs() - start;
+        if (packetId != MQTT_PACKET_ID_INVALID)
+        {
+            record(&resend, elapsed, MQTTSuccess);
+        }
+    } while (packetId != MQTT_PACKET_ID_INVALID);
+
+    /* The acked ID is free again, so it is reused for the next publish. */
+    steadyOps = (recordCount < STEADY_OPS_MAX) ? recordCount : STEADY_OPS_MAX;
+    for (i = 0; i < steadyOps; i++)
+    {
+        packetId = pickAck(pattern);
+        ackOne(&context, packetId, &steadyAck);
+        publishOne(&context, packetId, &steadyReserve, &steadyPublish);
+    }
+
+    while (inflightCount > 0U)
+    {
+        ackOne(&context, pickAck(pattern), &drainAck);
+    }
+
+    printStats(recordCount, pattern, "fill    MQTT_ReserveState", &fillReserve);
+    printStats(recordCount, pattern, "fill    MQTT_UpdateStatePublish", &fillPublish);
+    printStats(recordCount, pattern, "resend  MQTT_PublishToResend", &resend);
+    printStats(recordCount, pattern, "steady  MQTT_UpdateStateAck", &steadyAck);
+    printStats(recordCount, pattern, "steady  MQTT_ReserveState", &steadyReserve);
+    printStats(recordCount, pattern, "steady  MQTT_UpdateStatePublish", &steadyPublish);
+    printStats(recordCount, pattern, "drain   MQTT_UpdateStateAck", &drainAck);
+
+    free(outgoingRecords);
+}
+
+int main(void)
+{
+    static const size_t recordCounts[] = { 8, 32, 128, 1024, 8192, 65535 };
+    uint64_t start, overhead = ~0ULL;
+    size_t r;
+    uint32_t p, i;
+
+    inflight = malloc(65535U * sizeof(uint16_t));
+    if (inflight == NULL)
+    {
+        return 1;
+    }
+
+    for (i = 0; i < 1000U; i++)
+    {
+        start = benchNowNs();
+        start = benchNowNs() - start;
+        overhead = (start < overhead) ? start : overhead;
+    }
+
+    printf("clock overhead %u ns per timed call\n", (unsigned int) overhead);
+    printf("records  pattern   operation                        ops      ns/op   worst ns\n");
+
+    for (r = 0; r < sizeof(recordCounts) / sizeof(recordCounts[0]); r++)
+    {
+        for (p = AckInOrder; p <= AckRandom; p++)
+        {
+            runCase(recordCounts[r], (AckPattern_t) p);
+        }
+    }
+
+    free(inflight);
+    return 0;
+}
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+/*
+ * Topic dispatch cost of MQTT_MatchTopic(): every message of a deep topic
+ * corpus is checked against 1, 10, 100 and 1000 subscribed filters, the way a
+ * client walks its subscription list. The filters are drawn from the corpus
+ * itself in one of these mixes:
+ *
+ *   exact      a corpus topic as is
+ *   plus       a corpus topic with one to three levels replaced by '+'
+ *   hash       a corpus topic cut after a few levels and ended with '#'
+ *   dollar     "$SYS/..." filters and leading wildcards, with '$' topics in
+ *              the corpus that a leading wildcard must not match
+ *   near-miss  a topic of a small hot set with its last byte changed or one
+ *              level more, so the matcher walks the whole string to fail
+ *   mixed      all of the above, weighted towards '+' and exact filters
+ *
+ * The messages are the topics the filters were drawn from, as a client only
+ * receives what it subscribed to. Each row prints topic/filter comparisons
+ * per second and cycles per byte of topic and filter compared. The corpus is
+ * generated from a fixed seed, so the hit count of a row must stay the same
+ * when the matcher changes.
+ *
+ *   gcc -O2 -DMQTT_DO_NOT_USE_CUSTOM_CONFIG -Icore/include -Icore/interface \
+ *       bench/topic_corpus_bench.c core/core_mqtt.c core/core_mqtt_state.c core/core_mqtt_serializer.c
+ */
+
+#include <string.h>
+#include <stdbool.h>
+#include "core_mqtt.h"
+#include "bench_common.h"
+
+#define TOPIC_COUNT         512U
+#define TOPIC_MAX_LEN       128U
+#define FILTER_MAX_COUNT    1000U
+#define COMPARISONS         2000000U
+#define HOT_TOPIC_COUNT     8U
+
+typedef enum FilterMix
+{
+    MixExact = 0,
+    MixPlus,
+    MixHash,
+    MixDollar,
+    MixNearMiss,
+    MixMixed,
+    MixCount
+} FilterMix_t;
+
+static const char *const mixNames[MixCount] = { "exact", "plus", "hash", "dollar", "near-miss", "mixed" };
+static const uint32_t filterCounts[] = { 1, 10, 100, 1000 };
+
+static const char *const regions[] = { "eu-west-1", "eu-central-1", "us-east-2", "ap-southeast-1" };
+static const char *const sensors[] =
+{
+    "environment/temperature/celsius", "environment/humidity/percent", "power/active/watts",
+    "power/reactive/var", "vibration/axis-x/rms", "status/online"
+};
+static const char *const sysTopics[] =
+{
+    "$SYS/broker/clients/connected", "$SYS/broker/load/messages/received/1min",
+    "$SYS/broker/load/bytes/sent/15min", "$SYS/broker/uptime"
+};
+
+static char topics[TOPIC_COUNT][TOPIC_MAX_LEN];
+static uint16_t topicLengths[TOPIC_COUNT];
+static char filters[FILTER_MAX_COUNT][TOPIC_MAX_LEN];
+static uint16_t filterLengths[FILTER_MAX_COUNT];
+static uint32_t filterSources[FILTER_MAX_COUNT];
+static uint32_t randomState = 2463534242U;
+
+static uint32_t nextRandom(void)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+/* fleet/<region>/site-NN/line-NN/cell-NN/device-NNNNNN/<sensor>, one in 16 a $SYS topic. */
+static void buildTopics(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < TOPIC_COUNT; i++)
+    {
+        if ((i % 16U) == 15U)
+        {
+            topicLengths[i] = (uint16_t) snprintf(topics[i], TOPIC_MAX_LEN, "%s", sysTopics[(i / 16U) % 4U]);
+        }
+        else
+        {
+            topicLengths[i] = (uint16_t) snprintf(topics[i], TOPIC_MAX_LEN,
+                    "fleet/%s/site-%02u/line-%02u/cell-%02u/device-%06u/%s", regions[nextRandom() % 4U],
+                    (unsigned int) (nextRandom() % 12U), (unsigned int) (nextRandom() % 8U),
+                    (unsigned int) (nextRandom() % 16U), (unsigned int) (nextRandom() % 1000000U),
+                    sensors[nextRandom() % 6U]);
+        }
+    }
+}
+
+/* Index of the byte after the given number of levels, or the length. */
+static uint16_t levelEnd(const char *topic, uint16_t length, uint32_t levels)
+{
+    uint16_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        if ((topic[i] == '/') && (--levels == 0U))
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+static uint32_t levelCount(const char *topic, uint16_t length)
+{
+    uint32_t count = 1;
+    uint16_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        count += (topic[i] == '/') ? 1U : 0U;
+    }
+
+    return count;
+}
+
+/* Copies a topic with the levels set in plusMask replaced by '+'. */
+static uint16_t copyWithPlus(char *filter, const char *topic, uint16_t length, uint32_t plusMask)
+{
+    uint32_t level = 0;
+    uint16_t i, out = 0;
+    bool skipping = false;
+
+    for (i = 0; i < length; i++)
+    {
+        if (topic[i] == '/')
+        {
+            level++;
+            skipping = false;
+            filter[out++] = '/';
+        }
+        else if ((plusMask & (1UL << level)) != 0U)
+        {
+            if (!skipping)
+            {
+                filter[out++] = '+';
+                skipping = true;
+            }
+        }
+        else
+        {
+            filter[out++] = topic[i];
+        }
+    }
+    filter[out] = '\0';
+
+    return out;
+}
+
+/* Writes a filter of the given mix and the corpus topic it was drawn from. */
+static uint16_t makeFilter(char *filter, FilterMix_t mix, uint32_t *source)
+{
+    const char *topic;
+    uint16_t length, cut;
+    uint32_t t, levels, mask = 0, i;
+
+    if (mix == MixMixed)
+    {
+        static const FilterMix_t weights[] =
+        {
+            MixExact, MixExact, MixExact, MixPlus, MixPlus, MixPlus, MixPlus, MixHash, MixHash, MixDollar, MixNearMiss
+        };
+        mix = weights[nextRandom() % (sizeof(weights) / sizeof(weights[0]))];
+    }
+
+    /* Every 16th topic is a $SYS one, see buildTopics(). */
+    t = (mix == MixNearMiss) ? (nextRandom() % HOT_TOPIC_COUNT) :
+            (mix == MixDollar) ? ((nextRandom() % (TOPIC_COUNT / 16U)) * 16U + 15U) : (nextRandom() % TOPIC_COUNT);
+    topic = topics[t];
+    length = topicLengths[t];
+    levels = levelCount(topic, length);
+    *source = t;
+
+    switch (mix)
+    {
+    case MixPlus:
+        for (i = 0; i < 1U + (nextRandom() % 3U); i++)
+        {
+            mask |= 1UL << (nextRandom() % levels);
+        }
+        return copyWithPlus(filter, topic, length, mask);
+
+    case MixHash:
+        cut = levelEnd(topic, length, 1U + (nextRandom() % (levels - 1U)));
+        memcpy(filter, topic, cut);
+        memcpy(&filter[cut], "/#", 3);
+        return (uint16_t) (cut + 2U);
+
+    case MixDollar:
+        switch (nextRandom() % 4U)
+        {
+        case 0:
+            return (uint16_t) snprintf(filter, TOPIC_MAX_LEN, "$SYS/broker/+/%s", (nextRandom() & 1U) ? "#" : "connected");
+        case 1:
+            return (uint16_t) snprintf(filter, TOPIC_MAX_LEN, "%s", sysTopics[nextRandom() % 4U]);
+        case 2:
+            return (uint16_t) snprintf(filter, TOPIC_MAX_LEN, "#");
+        default:
+            return (uint16_t) snprintf(filter, TOPIC_MAX_LEN, "+/broker/clients/connected");
+        }
+
+    case MixNearMiss:
+        memcpy(filter, topic, length);
+        if ((nextRandom() & 1U) != 0U)
+        {
+            filter[length - 1U] ^= 0x01;
+            filter[length] = '\0';
+            return length;
+        }
+        memcpy(&filter[length], "/raw", 5);
+        return (uint16_t) (length + 4U);
+
+    case MixExact:
+    default:
+        memcpy(filter, topic, length + 1U);
+        return length;
+    }
+}
+
+static void runCase(FilterMix_t mix, uint32_t filterCount)
+{
+    uint32_t messages = COMPARISONS / filterCount, m, f, t, hits = 0;
+    uint64_t filterBytes = 0, bytes = 0, start, startCycles, elapsed, cycles;
+    bool match = false;
+
+    for (f = 0; f < filterCount; f++)
+    {
+        filterLengths[f] = makeFilter(filters[f], mix, &filterSources[f]);
+        filterBytes += filterLengths[f];
+    }
+
+    startCycles = benchCycles();
+    start = benchNowNs();
+    for (m = 0; m < messages; m++)
+    {
+        t = filterSources[m % filterCount];
+        for (f = 0; f < filterCount; f++)
+        {
+            MQTT_MatchTopic(topics[t], topicLengths[t], filters[f], filterLengths[f], &match);
+            hits += match ? 1U : 0U;
+        }
+        bytes += (uint64_t) topicLengths[t] * filterCount + filterBytes;
+    }
+    elapsed = benchNowNs() - start;
+    cycles = benchCycles() - startCycles;
+    benchSink += hits;
+
+    printf("%-10s %7u %9u %10u %12.0f %9.1f %9.2f\n", mixNames[mix], (unsigned int) filterCount,
+            (unsigned int) messages, (unsigned int) hits,
+            (double) messages * filterCount * 1e9 / (double) elapsed,
+            (double) elapsed / ((double) messages * filterCount), (double) cycles / (double) bytes);
+}
+
+int main(void)
+{
+    uint32_t mix, n;
+
+    buildTopics();
+
+    printf("%u topics, cycles counted with %s\n", (unsigned int) TOPIC_COUNT, BENCH_CYCLE_SOURCE);
+    printf("mix        filters  messages       hits    matches/s  ns/match cycles/B\n");
+
+    for (mix = 0; mix < MixCount; mix++)
+    {
+        for (n = 0; n < sizeof(filterCounts) / sizeof(filterCounts[0]); n++)
+        {
+            runCase((FilterMix_t) mix, filterCounts[n]);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+/*
+ * Compares MQTT_MatchTopic() with MQTT_MatchCompiledTopic() on a telemetry
+ * style topic set: every topic is matched against every filter, the way an
+ * application looping over its subscriptions would do it.
+ */
+
+#include <string.h>
+#include <stdbool.h>
+#include "core_mqtt.h"
+#include "bench_common.h"
+
+#define TOPIC_COUNT         64
+#define TOPIC_MAX_LEN       96
+#define TOKEN_MAX_COUNT     8
+#define ROUNDS              2000
+
+static const char *const filters[] =
+{
+    "site/eu-west/building-7/floor-3/device-0042/temperature/celsius",
+    "site/eu-west/building-7/floor-3/device-0042/humidity/percent",
+    "site/eu-west/building-7/+/+/temperature/celsius",
+    "site/+/building-7/floor-3/+/+/+",
+    "site/eu-west/building-7/#",
+    "site/us-east/#",
+    "site/+/+/+/device-0001/power/watts",
+    "+/eu-west/+/floor-1/+/co2/ppm",
+    "site/eu-west/building-2/floor-0/device-0007/door/state",
+    "#",
+};
+
+#define FILTER_COUNT        (sizeof(filters) / sizeof(filters[0]))
+
+static const char *const regions[] = { "eu-west", "us-east", "ap-south", "eu-north" };
+static const char *const sensors[] = { "temperature/celsius", "humidity/percent", "co2/ppm", "power/watts" };
+
+static char topics[TOPIC_COUNT][TOPIC_MAX_LEN];
+static uint16_t topicLengths[TOPIC_COUNT];
+
+static void buildTopics(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < TOPIC_COUNT; i++)
+    {
+        topicLengths[i] = (uint16_t) snprintf(topics[i], TOPIC_MAX_LEN, "site/%s/building-%u/floor-%u/device-%04u/%s",
+                regions[i % 4U], (unsigned int) (i % 8U), (unsigned int) (i % 5U), (unsigned int) (i * 7U % 50U),
+                sensors[(i / 4U) % 4U]);
+    }
+
+    /* Make sure the exact-match filters hit too. */
+    topicLengths[0] = (uint16_t) snprintf(topics[0], TOPIC_MAX_LEN, "%s", filters[0]);
+    topicLengths[1] = (uint16_t) snprintf(topics[1], TOPIC_MAX_LEN, "%s", filters[1]);
+}
+
+int main(void)
+{
+    static MQTTTopicToken_t tokens[FILTER_COUNT][TOKEN_MAX_COUNT];
+    MQTTCompiledTopicFilter_t compiled[FILTER_COUNT];
+    uint16_t filterLengths[FILTER_COUNT];
+    uint64_t start, referenceNs, compiledNs;
+    uint32_t round, t, f, matches = 0, mismatches = 0;
+    bool expected, actual;
+    double perMatch;
+
+    buildTopics();
+
+    for (f = 0; f < FILTER_COUNT; f++)
+    {
+        filterLengths[f] = (uint16_t) strlen(filters[f]);
+        if (MQTT_CompileTopicFilter(filters[f], filterLengths[f], tokens[f], TOKEN_MAX_COUNT, &compiled[f]) != MQTTSuccess)
+        {
+            printf("failed to compile %s\n", filters[f]);
+            return 1;
+        }
+    }
+
+    /* Both matchers must agree before timing them. */
+    for (t = 0; t < TOPIC_COUNT; t++)
+    {
+        for (f = 0; f < FILTER_COUNT; f++)
+        {
+            MQTT_MatchTopic(topics[t], topicLengths[t], filters[f], filterLengths[f], &expected);
+            MQTT_MatchCompiledTopic(topics[t], topicLengths[t], &compiled[f], &actual);
+            matches += expected ? 1U : 0U;
+            if (expected != actual)
+            {
+                printf("mismatch: topic %s filter %s\n", topics[t], filters[f]);
+                mismatches++;
+            }
+        }
+    }
+
+    start = benchNowNs();
+    for (round = 0; round < ROUNDS; round++)
+    {
+        for (t = 0; t < TOPIC_COUNT; t++)
+        {
+            for (f = 0; f < FILTER_COUNT; f++)
+            {
+                MQTT_MatchTopic(topics[t], topicLengths[t], filters[f], filterLengths[f], &expected);
+                benchSink += expected;
+            }
+        }
+    }
+    referenceNs = benchNowNs() - start;
+
+    start = benchNowNs();
+    for (round = 0; round < ROUNDS; round++)
+    {
+        for (t = 0; t < TOPIC_COUNT; t++)
+        {
+            for (f = 0; f < FILTER_COUNT; f++)
+            {
+                MQTT_MatchCompiledTopic(topics[t], topicLengths[t], &compiled[f], &actual);
+                benchSink += actual;
+            }
+        }
+    }
+    compiledNs = benchNowNs() - start;
+
+    perMatch = 1.0 / ((double) ROUNDS * TOPIC_COUNT * FILTER_COUNT);
+    printf("topics %u, filters %u, matches per round %u, mismatches %u\n", (unsigned int) TOPIC_COUNT,
+            (unsigned int) FILTER_COUNT, (unsigned int) matches, (unsigned int) mismatches);
+    printf("MQTT_MatchTopic         %8.1f ns/match\n", (double) referenceNs * perMatch);
+    printf("MQTT_MatchCompiledTopic %8.1f ns/match\n", (double) compiledNs * perMatch);
+    printf("speedup                 %8.2fx\n", (double) referenceNs / (double) compiledNs);
+
+    return (mismatches == 0U) ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+/*
+ * Times MQTT_MatchTopic() on long, deep topics. Build it twice to compare the
+ * portable byte loops with the word/SIMD backend:
+ *
+ *   -DMQTT_TOPIC_MATCH_ACCELERATION=0    portable
+ *   -DMQTT_TOPIC_MATCH_ACCELERATION=1    SSE2 / NEON / word-at-a-time
+ *
+ * Both builds print a checksum over a randomized corpus of short topics and
+ * filters full of separators and wildcards; the checksums must be equal.
+ */
+
+#include <string.h>
+#include <stdbool.h>
+#include "core_mqtt.h"
+#include "core_mqtt_config_defaults.h"
+#include "bench_common.h"
+
+#define TOPIC_COUNT         32
+#define TOPIC_MAX_LEN       160
+#define FUZZ_CASES          200000
+#define FUZZ_MAX_LEN        12
+#define ROUNDS              5000
+
+static const char *const filters[] =
+{
+    "enterprise-campus-north/region-emea-central/building-headquarters-07/floor-level-12/device-gateway-000042/sensor-temperature-ambient/metric-celsius",
+    "enterprise-campus-north/region-emea-central/building-headquarters-07/floor-level-12/device-gateway-000042/sensor-temperature-ambient/metric-fahrenheit",
+    "enterprise-campus-north/region-emea-central/+/floor-level-12/+/sensor-temperature-ambient/metric-celsius",
+    "enterprise-campus-north/region-emea-central/building-headquarters-07/#",
+    "enterprise-campus-north/+/+/+/+/+/metric-celsius",
+    "enterprise-campus-south/#",
+};
+
+#define FILTER_COUNT        (sizeof(filters) / sizeof(filters[0]))
+
+static char topics[TOPIC_COUNT][TOPIC_MAX_LEN];
+static uint16_t topicLengths[TOPIC_COUNT];
+static uint32_t randomState = 12345U;
+
+static uint32_t nextRandom(void)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+static void buildTopics(void)
+{
+    static const char *const metrics[] = { "celsius", "fahrenheit", "kelvin", "percent" };
+    uint32_t i;
+
+    for (i = 0; i < TOPIC_COUNT; i++)
+    {
+        topicLengths[i] = (uint16_t) snprintf(topics[i], TOPIC_MAX_LEN,
+                "enterprise-campus-north/region-emea-central/building-headquarters-%02u/floor-level-12/"
+                "device-gateway-%06u/sensor-temperature-ambient/metric-%s",
+                (unsigned int) (7U + (i % 2U)), (unsigned int) (42U + (i % 3U)), metrics[i % 4U]);
+    }
+}
+
+/* Random short strings over a tiny alphabet hit every edge case of the matcher. */
+static uint16_t randomString(char *buffer, bool allowWildcards)
+{
+    static const char alphabet[] = "ab/$+#";
+    uint16_t length = (uint16_t) (1U + (nextRandom() % FUZZ_MAX_LEN)), i;
+    uint32_t letters = allowWildcards ? 6U : 4U;
+
+    for (i = 0; i < length; i++)
+    {
+        buffer[i] = alphabet[nextRandom() % letters];
+    }
+
+    return length;
+}
+
+int main(void)
+{
+    char name[FUZZ_MAX_LEN], filter[FUZZ_MAX_LEN];
+    uint16_t filterLengths[FILTER_COUNT], nameLength, filterLength;
+    uint32_t round, t, f, checksum = 0, matches = 0;
+    uint64_t start, elapsed;
+    bool match;
+
+    for (round = 0; round < FUZZ_CASES; round++)
+    {
+        nameLength = randomString(name, false);
+        filterLength = randomString(filter, true);
+        MQTT_MatchTopic(name, nameLength, filter, filterLength, &match);
+        checksum = (checksum * 31U) + (match ? 1U : 0U);
+    }
+
+    buildTopics();
+    for (f = 0; f < FILTER_COUNT; f++)
+    {
+        filterLengths[f] = (uint16_t) strlen(filters[f]);
+    }
+
+    start = benchNowNs();
+    for (round = 0; round < ROUNDS; round++)
+    {
+        for (t = 0; t < TOPIC_COUNT; t++)
+        {
+            for (f = 0; f < FILTER_COUNT; f++)
+            {
+                MQTT_MatchTopic(topics[t], topicLengths[t], filters[f], filterLengths[f], &match);
+                matches += match ? 1U : 0U;
+            }
+        }
+    }
+    elapsed = benchNowNs() - start;
+    benchSink = matches;
+
+    printf("backend   : %s\n", (MQTT_TOPIC_MATCH_ACCELERATION != 0) ?
+#if defined(__SSE2__)
+            "sse2"
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+            "neon"
+#else
+            "word"
+#endif
+            : "portable");
+    printf("checksum  : %08x\n", (unsigned int) checksum);
+    printf("long topic: %.1f ns/match (%u bytes avg)\n",
+            (double) elapsed / ((double) ROUNDS * TOPIC_COUNT * FILTER_COUNT), (unsigned int) topicLengths[0]);
+
+    return 0;
+}
@@ -31,10 +31,21 @@
 
 #include "core_mqtt.h"
 #include "core_mqtt_state.h"
+#include "core_mqtt_trace.h"
 
 /* Include config defaults header to get default values of configs. */
 #include "core_mqtt_config_defaults.h"
 
+#if ( MQTT_TOPIC_MATCH_ACCELERATION != 0 )
+    #if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && ( _M_IX86_FP >= 2 ) )
+        #include <emmintrin.h>
+        #define MQTT_TOPIC_MATCH_SSE2
+    #elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+        #include <arm_neon.h>
+        #define MQTT_TOPIC_MATCH_NEON
+    #endif
+#endif
+
 #ifndef MQTT_PRE_SEND_HOOK
 
 /**
@@ -68,6 +79,62 @@
     #define MQTT_POST_STATE_UPDATE_HOOK( pContext )
 #endif /* !MQTT_POST_STATE_UPDATE_HOOK */
 
+#ifndef MQTT_RECV_MEMMOVE_HOOK
+
+/**
+ * @brief Hook called with the number of bytes that follow a handled packet
+ * in the network buffer, just before they are moved to its front.
+ */
+    #define MQTT_RECV_MEMMOVE_HOOK( pContext, bytes )
+#endif /* !MQTT_RECV_MEMMOVE_HOOK */
+
+/**
+ * @brief Access a counter of #MQTTMetrics_t.
+ *
+ * The send and the receive side of a context may run on different threads,
+ * so counters are accessed atomically where the compiler offers it. Relaxed
+ * ordering is enough as the counters guard nothing.
+ */
+#if defined( __GNUC__ ) || defined( __clang__ )
+    #define MQTT_METRICS_ATOMIC_ADD( pCounter, amount ) \
+    ( ( void ) __atomic_fetch_add( ( pCounter ), ( uint32_t ) ( amount ), __ATOMIC_RELAXED ) )
+    #define MQTT_METRICS_ATOMIC_LOAD( pCounter ) \
+    __atomic_load_n( ( pCounter ), __ATOMIC_RELAXED )
+    #define MQTT_METRICS_ATOMIC_STORE( pCounter, value ) \
+    __atomic_store_n( ( pCounter ), ( uint32_t ) ( value ), __ATOMIC_RELAXED )
+#else
+    #define MQTT_METRICS_ATOMIC_ADD( pCounter, amount )     ( ( void ) ( *( pCounter ) += ( uint32_t ) ( amount ) ) )
+    #define MQTT_METRICS_ATOMIC_LOAD( pCounter )            ( *( pCounter ) )
+    #define MQTT_METRICS_ATOMIC_STORE( pCounter, value )    ( *( pCounter ) = ( uint32_t ) ( value ) )
+#endif
+
+/**
+ * @brief Add to a counter, or a round trip started at a time to a latency
+ * histogram, of #MQTTMetrics_t in the context. No code is generated unless
+ * #MQTT_METRICS_ENABLE is set.
+ */
+#if ( MQTT_METRICS_ENABLE != 0 )
+    #define MQTT_METRICS_ADD( pContext, counter, amount ) \
+    MQTT_METRICS_ATOMIC_ADD( &( ( pContext )->metrics.counter ), amount )
+    #define MQTT_METRICS_LATENCY( pContext, histogram, startTimeMs ) \
+    addLatency( ( pContext ), &( ( pContext )->metrics.histogram ), ( startTimeMs ) )
+#else
+    #define MQTT_METRICS_ADD( pContext, counter, amount )
+    #define MQTT_METRICS_LATENCY( pContext, histogram, startTimeMs )
+#endif
+
+/**
+ * @brief Record a trace event, see #MQTTTraceEventType_t for the meaning of
+ * the arguments. No code is generated unless #MQTT_TRACE_ENABLE is set.
+ */
+#if ( MQTT_TRACE_ENABLE != 0 )
+    #define MQTT_TRACE( pContext, event, packetId, detail, length )  \
+    MQTT_TraceRecord( MQTT_TRACE_TIMESTAMP_US( pContext ), ( event ), \
+                      ( packetId ), ( uint8_t ) ( detail ), ( uint32_t ) ( length ) )
+#else
+    #define MQTT_TRACE( pContext, event, packetId, detail, length )
+#endif
+
 /**
  * @brief Bytes required to encode any string length in an MQTT packet header.
  * Length is always encoded in two bytes according to the MQTT specification.
@@ -345,6 +412,23 @@ static MQTTStatus_t sendPublishAcks( MQTTContext_t * pContext,
  */
 static MQTTStatus_t handleKeepAlive( MQTTContext_t * pContext );
 
+#if ( MQTT_METRICS_ENABLE != 0 )
+
+/**
+ * @brief Add a round trip to a latency histogram.
+ *
+ * Histograms are only written by the thread receiving the acks, so the
+ * largest sample needs no compare and swap.
+ *
+ * @param[in] pContext Initialized MQTT Context.
+ * @param[in] pHistogram Histogram in the context's counters.
+ * @param[in] startTimeMs When the request went out.
+ */
+    static void addLatency( const MQTTContext_t * pContext,
+                            MQTTLatencyHistogram_t * pHistogram,
+                            uint32_t startTimeMs );
+#endif
+
 /**
  * @brief Handle received MQTT PUBLISH packet.
  *
@@ -367,6 +451,19 @@ static MQTTStatus_t handleIncomingPublish( MQTTContext_t * pContext,
 static MQTTStatus_t handlePublishAcks( MQTTContext_t * pContext,
                                        MQTTPacketInfo_t * pIncomingPacket );
 
+/**
+ * @brief Handle a CONNACK answering a CONNECT sent by #MQTT_SendConnect.
+ *
+ * @param[in] pContext MQTT Connection context.
+ * @param[in] pIncomingPacket Incoming CONNACK packet.
+ *
+ * @return #MQTTSuccess if the connection was accepted, #MQTTServerRefused if
+ * the broker refused it, #MQTTBadResponse if no CONNACK was expected or it is
+ * malformed.
+ */
+static MQTTStatus_t handlePipelinedConnack( MQTTContext_t * pContext,
+                                            const MQTTPacketInfo_t * pIncomingPacket );
+
 /**
  * @brief Handle received MQTT ack.
  *
@@ -381,6 +478,14 @@ static MQTTStatus_t handleIncomingAck( MQTTContext_t * pContext,
                                        MQTTPacketInfo_t * pIncomingPacket,
                                        bool manageKeepAlive );
 
+/**
+ * @brief Pause or resume receiving from the consumer queue depth reported to
+ * #MQTT_SetFlowControl.
+ *
+ * @param[in] pContext MQTT Connection context.
+ */
+static void updateFlowControl( MQTTContext_t * pContext );
+
 /**
  * @brief Run a single iteration of the receive loop.
  *
@@ -475,6 +580,46 @@ static MQTTStatus_t sendPublishWithoutCopy( MQTTContext_t * pContext,
                                             size_t headerSize,
                                             uint16_t packetId );
 
+/**
+ * @brief Validate the parameters of a CONNECT that does not wait for the CONNACK.
+ *
+ * @param[in] pContext MQTT Connection context.
+ * @param[in] pConnectInfo MQTT CONNECT packet information.
+ * @param[in] pWillInfo Last Will and Testament, may be NULL.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed or a persistent
+ * session is requested, #MQTTSuccess otherwise.
+ */
+static MQTTStatus_t validatePipelinedConnectParams( const MQTTContext_t * pContext,
+                                                     const MQTTConnectInfo_t * pConnectInfo,
+                                                     const MQTTPublishInfo_t * pWillInfo );
+
+/**
+ * @brief Send a clean-session CONNECT and move the context to
+ * #MQTTConnackPending. Must be called with the state update hook taken.
+ *
+ * @param[in] pContext MQTT Connection context.
+ * @param[in] pConnectInfo MQTT CONNECT packet information.
+ * @param[in] pWillInfo Last Will and Testament, may be NULL.
+ *
+ * @return #MQTTSuccess, #MQTTSendFailed or a serialization error.
+ */
+static MQTTStatus_t sendPipelinedConnect( MQTTContext_t * pContext,
+                                          const MQTTConnectInfo_t * pConnectInfo,
+                                          const MQTTPublishInfo_t * pWillInfo );
+
+/**
+ * @brief Run one transport connect step of #MQTT_ConnectAsync and send the
+ * CONNECT once the transport is up.
+ *
+ * @param[in] pContext MQTT Connection context.
+ *
+ * @return #MQTTSuccess while in progress or once the CONNECT was sent,
+ * #MQTTSendFailed if the transport failed and #MQTTKeepAliveTimeout if it
+ * did not connect in time.
+ */
+static MQTTStatus_t advanceConnect( MQTTContext_t * pContext );
+
 /**
  * @brief Function to validate #MQTT_Publish parameters.
  *
@@ -558,6 +703,230 @@ static bool matchTopicFilter( const char * pTopicName,
                               const char * pTopicFilter,
                               uint16_t topicFilterLength );
 
+#if ( MQTT_TOPIC_MATCH_ACCELERATION != 0 )
+
+/**
+ * @brief Find the first '/' level separator in a buffer.
+ *
+ * @param[in] pBuffer The buffer to search.
+ * @param[in] length Number of bytes to search.
+ *
+ * @return Index of the first '/', or @p length if there is none.
+ */
+static size_t findLevelSeparator( const char * pBuffer,
+                                  size_t length );
+
+/**
+ * @brief Count the leading bytes two buffers have in common.
+ *
+ * @param[in] pFirst The first buffer.
+ * @param[in] pSecond The second buffer.
+ * @param[in] length Number of bytes to compare at most.
+ *
+ * @return Number of equal leading bytes, at most @p length.
+ */
+static size_t commonPrefixLength( const char * pFirst,
+                                  const char * pSecond,
+                                  size_t length );
+
+#endif /* if ( MQTT_TOPIC_MATCH_ACCELERATION != 0 ) */
+
+/*-----------------------------------------------------------*/
+
+#if ( MQTT_TOPIC_MATCH_ACCELERATION != 0 )
+
+/**
+ * @brief Machine word used by the word-at-a-time fallback.
+ */
+    #if ( UINTPTR_MAX > 0xFFFFFFFFU )
+        typedef uint64_t MQTTMatchWord_t;
+    #else
+        typedef uint32_t MQTTMatchWord_t;
+    #endif
+
+/**
+ * @brief A word with every byte set to 0x01.
+ */
+    #define MATCH_WORD_ONES     ( ( ( MQTTMatchWord_t ) ~( MQTTMatchWord_t ) 0U ) / 0xFFU )
+
+/**
+ * @brief Load a word from a possibly unaligned address.
+ */
+static inline MQTTMatchWord_t loadMatchWord( const char * pBuffer )
+{
+    MQTTMatchWord_t word;
+
+    ( void ) memcpy( &word, pBuffer, sizeof( word ) );
+
+    return word;
+}
+
+/**
+ * @brief Index of the first non-zero byte in a non-zero word, in memory order.
+ */
+static inline size_t firstNonZeroByte( MQTTMatchWord_t word )
+{
+    size_t index = 0U;
+
+    #if defined( __GNUC__ ) && defined( __BYTE_ORDER__ ) && ( __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ )
+        index = ( size_t ) __builtin_ctzll( ( unsigned long long ) word ) / 8U;
+    #elif defined( __GNUC__ ) && defined( __BYTE_ORDER__ ) && ( __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__ )
+        index = ( size_t ) ( __builtin_clzll( ( unsigned long long ) word ) -
+                             ( ( sizeof( unsigned long long ) - sizeof( word ) ) * 8U ) ) / 8U;
+    #else
+        uint8_t bytes[ sizeof( word ) ];
+
+        ( void ) memcpy( bytes, &word, sizeof( word ) );
+
+        while( bytes[ index ] == 0U )
+        {
+            index++;
+        }
+    #endif
+
+    return index;
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t findLevelSeparator( const char * pBuffer,
+                                  size_t length )
+{
+    size_t index = 0U;
+    MQTTMatchWord_t word;
+
+    #if defined( MQTT_TOPIC_MATCH_SSE2 )
+        const __m128i separators = _mm_set1_epi8( '/' );
+        int mask;
+
+        while( ( index + 16U ) <= length )
+        {
+            mask = _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( ( const __m128i * ) &pBuffer[ index ] ),
+                                                      separators ) );
+
+            if( mask != 0 )
+            {
+                #if defined( __GNUC__ )
+                    return index + ( size_t ) __builtin_ctz( ( unsigned int ) mask );
+                #else
+                    break;
+                #endif
+            }
+
+            index += 16U;
+        }
+    #elif defined( MQTT_TOPIC_MATCH_NEON )
+        const uint8x16_t separators = vdupq_n_u8( ( uint8_t ) '/' );
+        uint64_t mask;
+
+        while( ( index + 16U ) <= length )
+        {
+            /* Narrow the 16 byte comparison to one nibble per byte. */
+            mask = vget_lane_u64( vreinterpret_u64_u8( vshrn_n_u16( vreinterpretq_u16_u8(
+                                                                        vceqq_u8( vld1q_u8( ( const uint8_t * ) &pBuffer[ index ] ), separators ) ), 4 ) ), 0 );
+
+            if( mask != 0U )
+            {
+                return index + ( ( size_t ) __builtin_ctzll( mask ) / 4U );
+            }
+
+            index += 16U;
+        }
+    #endif /* if defined( MQTT_TOPIC_MATCH_SSE2 ) */
+
+    /* Flag the zero bytes of ( word ^ separators ). Unlike the shorter
+     * ( x - 0x01.. ) & ~x & 0x80.. test, no carry crosses a byte here, so the
+     * flags are exact on either byte order. */
+    while( ( index + sizeof( word ) ) <= length )
+    {
+        word = loadMatchWord( &pBuffer[ index ] ) ^ ( MATCH_WORD_ONES * ( MQTTMatchWord_t ) '/' );
+        word = ~( ( ( word & ( MATCH_WORD_ONES * 0x7FU ) ) + ( MATCH_WORD_ONES * 0x7FU ) ) |
+                  word | ( MATCH_WORD_ONES * 0x7FU ) );
+
+        if( word != 0U )
+        {
+            return index + firstNonZeroByte( word );
+        }
+
+        index += sizeof( word );
+    }
+
+    while( ( index < length ) && ( pBuffer[ index ] != '/' ) )
+    {
+        index++;
+    }
+
+    return index;
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t commonPrefixLength( const char * pFirst,
+                                  const char * pSecond,
+                                  size_t length )
+{
+    size_t index = 0U;
+    MQTTMatchWord_t difference;
+
+    #if defined( MQTT_TOPIC_MATCH_SSE2 )
+        int mask;
+
+        while( ( index + 16U ) <= length )
+        {
+            mask = _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( ( const __m128i * ) &pFirst[ index ] ),
+                                                      _mm_loadu_si128( ( const __m128i * ) &pSecond[ index ] ) ) );
+
+            if( mask != 0xFFFF )
+            {
+                #if defined( __GNUC__ )
+                    return index + ( size_t ) __builtin_ctz( ( unsigned int ) ~mask );
+                #else
+                    break;
+                #endif
+            }
+
+            index += 16U;
+        }
+    #elif defined( MQTT_TOPIC_MATCH_NEON )
+        uint64_t mask;
+
+        while( ( index + 16U ) <= length )
+        {
+            mask = vget_lane_u64( vreinterpret_u64_u8( vshrn_n_u16( vreinterpretq_u16_u8(
+                                                                        vceqq_u8( vld1q_u8( ( const uint8_t * ) &pFirst[ index ] ),
+                                                                                  vld1q_u8( ( const uint8_t * ) &pSecond[ index ] ) ) ), 4 ) ), 0 );
+
+            if( mask != UINT64_MAX )
+            {
+                return index + ( ( size_t ) __builtin_ctzll( ~mask ) / 4U );
+            }
+
+            index += 16U;
+        }
+    #endif /* if defined( MQTT_TOPIC_MATCH_SSE2 ) */
+
+    while( ( index + sizeof( difference ) ) <= length )
+    {
+        difference = loadMatchWord( &pFirst[ index ] ) ^ loadMatchWord( &pSecond[ index ] );
+
+        if( difference != 0U )
+        {
+            return index + firstNonZeroByte( difference );
+        }
+
+        index += sizeof( difference );
+    }
+
+    while( ( index < length ) && ( pFirst[ index ] == pSecond[ index ] ) )
+    {
+        index++;
+    }
+
+    return index;
+}
+
+#endif /* if ( MQTT_TOPIC_MATCH_ACCELERATION != 0 ) */
+
 /*-----------------------------------------------------------*/
 
 static bool matchEndWildcardsSpecialCases( const char * pTopicFilter,
@@ -636,17 +1005,23 @@ static bool matchWildcards( const char * pTopicName,
         /* Move topic name index to the end of the current level. The end of the
          * current level is identified by the last character before the next level
          * separator '/'. */
-        while( nameIndex < topicNameLength )
-        {
-            /* Exit the loop if we hit the level separator. */
-            if( pTopicName[ nameIndex ] == '/' )
+        #if ( MQTT_TOPIC_MATCH_ACCELERATION != 0 )
+            nameIndex += ( uint16_t ) findLevelSeparator( &pTopicName[ nameIndex ],
+                                                          ( size_t ) topicNameLength - nameIndex );
+            nextLevelExistsInTopicName = ( nameIndex < topicNameLength );
+        #else
+            while( nameIndex < topicNameLength )
             {
-                nextLevelExistsInTopicName = true;
-                break;
-            }
+                /* Exit the loop if we hit the level separator. */
+                if( pTopicName[ nameIndex ] == '/' )
+                {
+                    nextLevelExistsInTopicName = true;
+                    break;
+                }
 
-            nameIndex += 1;
-        }
+                nameIndex += 1;
+            }
+        #endif /* if ( MQTT_TOPIC_MATCH_ACCELERATION != 0 ) */
 
         /* Determine if the topic filter contains a child level after the current level
          * represented by the '+' wildcard. */
@@ -726,6 +1101,23 @@ static bool matchTopicFilter( const char * pTopicName,
 
     while( ( nameIndex < topicNameLength ) && ( filterIndex < topicFilterLength ) )
     {
+        #if ( MQTT_TOPIC_MATCH_ACCELERATION != 0 )
+            {
+                size_t skip;
+
+                /* Skip the run of equal characters in one go. The skip stops short
+                 * of the last character of either string, which needs the end of
+                 * string checks below. */
+                skip = commonPrefixLength( &pTopicName[ nameIndex ],
+                                           &pTopicFilter[ filterIndex ],
+                                           ( ( topicNameLength - nameIndex ) < ( topicFilterLength - filterIndex ) ) ?
+                                           ( ( size_t ) topicNameLength - nameIndex - 1U ) :
+                                           ( ( size_t ) topicFilterLength - filterIndex - 1U ) );
+                nameIndex += ( uint16_t ) skip;
+                filterIndex += ( uint16_t ) skip;
+            }
+        #endif
+
         /* Check if the character in the topic name matches the corresponding
          * character in the topic filter string. */
         if( pTopicName[ nameIndex ] == pTopicFilter[ filterIndex ] )
@@ -794,6 +1186,11 @@ static int32_t sendMessageVector( MQTTContext_t * pContext,
     /* Send must always be defined */
     assert( pContext->transportInterface.send != NULL );
 
+    #if ( MQTT_METRICS_ENABLE != 0 ) || ( MQTT_TRACE_ENABLE != 0 )
+        /* The vectors are advanced as they go out, keep the type for the count. */
+        const uint8_t packetTypeByte = *( ( const uint8_t * ) pIoVec->iov_base );
+    #endif
+
     /* Count the total number of bytes to be sent as outlined in the vector. */
     for( pIoVectIterator = pIoVec; pIoVectIterator <= &( pIoVec[ ioVecCount - 1U ] ); pIoVectIterator++ )
     {
@@ -803,6 +1200,10 @@ static int32_t sendMessageVector( MQTTContext_t * pContext,
     /* Reset the iterator to point to the first entry in the array. */
     pIoVectIterator = pIoVec;
 
+    /* Packets from different threads must not interleave on the wire. */
+    MQTT_PRE_SEND_HOOK( pContext );
+    MQTT_TRACE( pContext, MQTTTraceSendStart, 0U, packetTypeByte, bytesToSend );
+
     /* Note the start time. */
     startTime = pContext->getTime();
 
@@ -827,6 +1228,16 @@ static int32_t sendMessageVector( MQTTContext_t * pContext,
              * more bytes than expected are sent. */
             assert( sendResult <= ( ( int32_t ) bytesToSend - bytesSentOrError ) );
 
+            MQTT_METRICS_ADD( pContext, bytesSent, sendResult );
+
+            /* Without writev a packet goes out one vector per call. */
+            if( ( pContext->transportInterface.writev != NULL ) ?
+                ( sendResult < ( ( int32_t ) bytesToSend - bytesSentOrError ) ) :
+                ( ( size_t ) sendResult < pIoVectIterator->iov_len ) )
+            {
+                MQTT_METRICS_ADD( pContext, partialSends, 1U );
+            }
+
             bytesSentOrError += sendResult;
 
             /* Set last transmission time. */
@@ -841,20 +1252,22 @@ static int32_t sendMessageVector( MQTTContext_t * pContext,
             bytesSentOrError = sendResult;
             LogError( ( "sendMessageVector: Unable to send packet: Network Error." ) );
 
-            if( pContext->connectStatus == MQTTConnected )
+            if( ( pContext->connectStatus == MQTTConnected ) ||
+                ( pContext->connectStatus == MQTTConnackPending ) )
             {
                 pContext->connectStatus = MQTTDisconnectPending;
             }
         }
         else
         {
-            /* MISRA Empty body */
+            MQTT_METRICS_ADD( pContext, sendRetries, 1U );
         }
 
         /* Check for timeout. */
         if( calculateElapsedTime( pContext->getTime(), startTime ) > MQTT_SEND_TIMEOUT_MS )
         {
             LogError( ( "sendMessageVector: Unable to send packet: Timed out." ) );
+            MQTT_METRICS_ADD( pContext, sendTimeouts, ( bytesSentOrError < ( int32_t ) bytesToSend ) ? 1U : 0U );
             break;
         }
 
@@ -878,6 +1291,14 @@ static int32_t sendMessageVector( MQTTContext_t * pContext,
         }
     }
 
+    if( bytesSentOrError == ( int32_t ) bytesToSend )
+    {
+        MQTT_METRICS_ADD( pContext, packetsSent[ packetTypeByte >> 4 ], 1U );
+    }
+
+    MQTT_TRACE( pContext, MQTTTraceSendDone, 0U, packetTypeByte, bytesSentOrError );
+    MQTT_POST_SEND_HOOK( pContext );
+
     return bytesSentOrError;
 }
 
@@ -895,6 +1316,10 @@ static int32_t sendBuffer( MQTTContext_t * pContext,
     assert( pContext->transportInterface.send != NULL );
     assert( pIndex != NULL );
 
+    /* Packets from different threads must not interleave on the wire. */
+    MQTT_PRE_SEND_HOOK( pContext );
+    MQTT_TRACE( pContext, MQTTTraceSendStart, 0U, pBufferToSend[ 0 ], bytesToSend );
+
     /* Set the timeout. */
     startTime = pContext->getTime();
 
@@ -910,6 +1335,13 @@ static int32_t sendBuffer( MQTTContext_t * pContext,
              * more bytes than expected are sent. */
             assert( sendResult <= ( ( int32_t ) bytesToSend - bytesSentOrError ) );
 
+            MQTT_METRICS_ADD( pContext, bytesSent, sendResult );
+
+            if( sendResult < ( ( int32_t ) bytesToSend - bytesSentOrError ) )
+            {
+                MQTT_METRICS_ADD( pContext, partialSends, 1U );
+            }
+
             bytesSentOrError += sendResult;
             pIndex = &pIndex[ sendResult ];
 
@@ -925,24 +1357,34 @@ static int32_t sendBuffer( MQTTContext_t * pContext,
             bytesSentOrError = sendResult;
             LogError( ( "sendBuffer: Unable to send packet: Network Error." ) );
 
-            if( pContext->connectStatus == MQTTConnected )
+            if( ( pContext->connectStatus == MQTTConnected ) ||
+                ( pContext->connectStatus == MQTTConnackPending ) )
             {
                 pContext->connectStatus = MQTTDisconnectPending;
             }
         }
         else
         {
-            /* MISRA Empty body */
+            MQTT_METRICS_ADD( pContext, sendRetries, 1U );
         }
 
         /* Check for timeout. */
         if( calculateElapsedTime( pContext->getTime(), startTime ) >= ( MQTT_SEND_TIMEOUT_MS ) )
         {
             LogError( ( "sendBuffer: Unable to send packet: Timed out." ) );
+            MQTT_METRICS_ADD( pContext, sendTimeouts, ( bytesSentOrError < ( int32_t ) bytesToSend ) ? 1U : 0U );
             break;
         }
     }
 
+    if( bytesSentOrError == ( int32_t ) bytesToSend )
+    {
+        MQTT_METRICS_ADD( pContext, packetsSent[ pBufferToSend[ 0 ] >> 4 ], 1U );
+    }
+
+    MQTT_TRACE( pContext, MQTTTraceSendDone, 0U, pBufferToSend[ 0 ], bytesSentOrError );
+    MQTT_POST_SEND_HOOK( pContext );
+
     return bytesSentOrError;
 }
 
@@ -1018,6 +1460,11 @@ static int32_t recvExact( MQTTContext_t * pContext,
                                pIndex,
                                bytesRemaining );
 
+        if( bytesRecvd != 0 )
+        {
+            MQTT_TRACE( pContext, MQTTTraceRecv, 0U, 0U, bytesRecvd );
+        }
+
         if( bytesRecvd < 0 )
         {
             LogError( ( "Network error while receiving packet: ReturnCode=%ld.",
@@ -1027,7 +1474,8 @@ static int32_t recvExact( MQTTContext_t * pContext,
 
             MQTT_PRE_STATE_UPDATE_HOOK( pContext );
 
-            if( pContext->connectStatus == MQTTConnected )
+            if( ( pContext->connectStatus == MQTTConnected ) ||
+                ( pContext->connectStatus == MQTTConnackPending ) )
             {
                 pContext->connectStatus = MQTTDisconnectPending;
             }
@@ -1048,6 +1496,7 @@ static int32_t recvExact( MQTTContext_t * pContext,
 
             bytesRemaining -= ( size_t ) bytesRecvd;
             totalBytesRecvd += ( int32_t ) bytesRecvd;
+            MQTT_METRICS_ADD( pContext, bytesReceived, bytesRecvd );
             /* Increment the index. */
             pIndex = &pIndex[ bytesRecvd ];
             LogDebug( ( "BytesReceived=%ld, BytesRemaining=%lu, TotalBytesReceived=%ld.",
@@ -1064,6 +1513,7 @@ static int32_t recvExact( MQTTContext_t * pContext,
             if( timeSinceLastRecvMs >= MQTT_RECV_POLLING_TIMEOUT_MS )
             {
                 LogError( ( "Unable to receive packet: Timed out in transport recv." ) );
+                MQTT_METRICS_ADD( pContext, recvTimeouts, 1U );
                 receiveError = true;
             }
         }
@@ -1131,6 +1581,8 @@ static MQTTStatus_t discardPacket( MQTTContext_t * pContext,
     {
         LogError( ( "Dumped packet. DumpedBytes=%lu.",
                     ( unsigned long ) totalBytesReceived ) );
+        MQTT_METRICS_ADD( pContext, discardedPackets, 1U );
+        MQTT_METRICS_ADD( pContext, discardedBytes, totalBytesReceived );
         /* Packet dumped, so no data is available. */
         status = MQTTNoDataAvailable;
     }
@@ -1193,6 +1645,8 @@ static MQTTStatus_t discardStoredPacket( MQTTContext_t * pContext,
     {
         LogError( ( "Dumped packet. DumpedBytes=%lu.",
                     ( unsigned long ) totalBytesReceived ) );
+        MQTT_METRICS_ADD( pContext, discardedPackets, 1U );
+        MQTT_METRICS_ADD( pContext, discardedBytes, mqttPacketSize );
         /* Packet dumped, so no data is available. */
         status = MQTTNoDataAvailable;
     }
@@ -1265,10 +1719,12 @@ static uint8_t getAckTypeToSend( MQTTPublishState_t state )
     switch( state )
     {
         case MQTTPubAckSend:
+        case MQTTPubAckDeferred:
             packetTypeByte = MQTT_PACKET_TYPE_PUBACK;
             break;
 
         case MQTTPubRecSend:
+        case MQTTPubRecDeferred:
             packetTypeByte = MQTT_PACKET_TYPE_PUBREC;
             break;
 
@@ -1324,31 +1780,34 @@ static MQTTStatus_t sendPublishAcks( MQTTContext_t * pContext,
 
             connectStatus = pContext->connectStatus;
 
-            if( connectStatus != MQTTConnected )
+            MQTT_POST_STATE_UPDATE_HOOK( pContext );
+
+            if( ( connectStatus != MQTTConnected ) && ( connectStatus != MQTTConnackPending ) )
             {
-                status = ( connectStatus == MQTTNotConnected ) ? MQTTStatusNotConnected : MQTTStatusDisconnectPending;
+                status = ( connectStatus == MQTTDisconnectPending ) ? MQTTStatusDisconnectPending : MQTTStatusNotConnected;
             }
+        }
 
-            if( status == MQTTSuccess )
-            {
-                /* Here, we are not using the vector approach for efficiency. There is just one buffer
-                 * to be sent which can be achieved with a normal send call. */
-                sendResult = sendBuffer( pContext,
-                                         localBuffer.pBuffer,
-                                         MQTT_PUBLISH_ACK_PACKET_SIZE );
+        if( status == MQTTSuccess )
+        {
+            /* Here, we are not using the vector approach for efficiency. There is just one buffer
+             * to be sent which can be achieved with a normal send call. The
+             * record of an incoming publish is only touched by the receiving
+             * thread, so the state lock is not held across the send. */
+            sendResult = sendBuffer( pContext,
+                                     localBuffer.pBuffer,
+                                     MQTT_PUBLISH_ACK_PACKET_SIZE );
 
-                if( sendResult < ( int32_t ) MQTT_PUBLISH_ACK_PACKET_SIZE )
-                {
-                    status = MQTTSendFailed;
-                }
+            if( sendResult < ( int32_t ) MQTT_PUBLISH_ACK_PACKET_SIZE )
+            {
+                status = MQTTSendFailed;
             }
-
-            MQTT_POST_STATE_UPDATE_HOOK( pContext );
         }
 
         if( status == MQTTSuccess )
         {
             pContext->controlPacketSent = true;
+            MQTT_TRACE( pContext, MQTTTraceAckSent, packetId, packetTypeByte, MQTT_PUBLISH_ACK_PACKET_SIZE );
 
             MQTT_PRE_STATE_UPDATE_HOOK( pContext );
 
@@ -1360,7 +1819,11 @@ static MQTTStatus_t sendPublishAcks( MQTTContext_t * pContext,
 
             MQTT_POST_STATE_UPDATE_HOOK( pContext );
 
-            if( status != MQTTSuccess )
+            if( status == MQTTSuccess )
+            {
+                MQTT_TRACE( pContext, MQTTTraceState, packetId, newState, 0U );
+            }
+            else
             {
                 LogError( ( "Failed to update state of publish %hu.",
                             ( unsigned short ) packetId ) );
@@ -1380,12 +1843,40 @@ static MQTTStatus_t sendPublishAcks( MQTTContext_t * pContext,
 
 /*-----------------------------------------------------------*/
 
+#if ( MQTT_METRICS_ENABLE != 0 )
+    static void addLatency( const MQTTContext_t * pContext,
+                            MQTTLatencyHistogram_t * pHistogram,
+                            uint32_t startTimeMs )
+    {
+        uint32_t elapsedMs = calculateElapsedTime( pContext->getTime(), startTimeMs );
+        uint32_t bucket = 0U;
+
+        /* Bucket i holds samples of i significant bits, the last one the rest. */
+        while( ( bucket < ( MQTT_LATENCY_BUCKET_COUNT - 1U ) ) && ( ( elapsedMs >> bucket ) != 0U ) )
+        {
+            bucket++;
+        }
+
+        MQTT_METRICS_ATOMIC_ADD( &( pHistogram->buckets[ bucket ] ), 1U );
+        MQTT_METRICS_ATOMIC_ADD( &( pHistogram->count ), 1U );
+        MQTT_METRICS_ATOMIC_ADD( &( pHistogram->totalMs ), elapsedMs );
+
+        if( elapsedMs > MQTT_METRICS_ATOMIC_LOAD( &( pHistogram->maxMs ) ) )
+        {
+            MQTT_METRICS_ATOMIC_STORE( &( pHistogram->maxMs ), elapsedMs );
+        }
+    }
+
+/*-----------------------------------------------------------*/
+#endif /* if ( MQTT_METRICS_ENABLE != 0 ) */
+
 static MQTTStatus_t handleKeepAlive( MQTTContext_t * pContext )
 {
     MQTTStatus_t status = MQTTSuccess;
     uint32_t now = 0U;
     uint32_t packetTxTimeoutMs = 0U;
     uint32_t lastPacketTxTime = 0U;
+    MQTTConnectionStatus_t connectStatus;
 
     assert( pContext != NULL );
     assert( pContext->getTime != NULL );
@@ -1399,13 +1890,31 @@ static MQTTStatus_t handleKeepAlive( MQTTContext_t * pContext )
         packetTxTimeoutMs = PACKET_TX_TIMEOUT_MS;
     }
 
+    MQTT_PRE_STATE_UPDATE_HOOK( pContext );
+    connectStatus = pContext->connectStatus;
+    MQTT_POST_STATE_UPDATE_HOOK( pContext );
+
+    /* Keep-alive starts with the CONNACK, until then only its arrival is timed. */
+    if( connectStatus == MQTTConnackPending )
+    {
+        if( calculateElapsedTime( now, pContext->connectStartTimeMs ) > MQTT_CONNACK_TIMEOUT_MS )
+        {
+            LogError( ( "No CONNACK received within %lu ms.",
+                        ( unsigned long ) MQTT_CONNACK_TIMEOUT_MS ) );
+            MQTT_METRICS_ADD( pContext, keepAliveTimeouts, 1U );
+            status = MQTTKeepAliveTimeout;
+        }
+    }
     /* If keep alive interval is 0, it is disabled. */
-    if( pContext->waitingForPingResp == true )
+    else if( pContext->waitingForPingResp == true )
     {
-        /* Has time expired? */
-        if( calculateElapsedTime( now, pContext->pingReqSendTimeMs ) >
-            MQTT_PINGRESP_TIMEOUT_MS )
+        /* Has time expired? The PINGRESP cannot be read while receiving is
+         * paused, so it is only timed while the socket is being read. */
+        if( ( MQTT_IsReceivePaused( pContext ) == false ) &&
+            ( calculateElapsedTime( now, pContext->pingReqSendTimeMs ) >
+              MQTT_PINGRESP_TIMEOUT_MS ) )
         {
+            MQTT_METRICS_ADD( pContext, keepAliveTimeouts, 1U );
             status = MQTTKeepAliveTimeout;
         }
     }
@@ -1440,10 +1949,12 @@ static MQTTStatus_t handleIncomingPublish( MQTTContext_t * pContext,
 {
     MQTTStatus_t status;
     MQTTPublishState_t publishRecordState = MQTTStateNull;
+    MQTTPublishState_t existingState = MQTTStateNull;
     uint16_t packetIdentifier = 0U;
     MQTTPublishInfo_t publishInfo;
     MQTTDeserializedInfo_t deserializedInfo;
     bool duplicatePublish = false;
+    bool ackDeferred = false;
 
     assert( pContext != NULL );
     assert( pIncomingPacket != NULL );
@@ -1452,6 +1963,7 @@ static MQTTStatus_t handleIncomingPublish( MQTTContext_t * pContext,
     status = MQTT_DeserializePublish( pIncomingPacket, &packetIdentifier, &publishInfo );
     LogInfo( ( "De-serialized incoming PUBLISH packet: DeserializerResult=%s.",
                MQTT_Status_strerror( status ) ) );
+    MQTT_TRACE( pContext, MQTTTraceDeserialized, packetIdentifier, pIncomingPacket->type, pIncomingPacket->remainingLength );
 
     if( ( status == MQTTSuccess ) &&
         ( pContext->incomingPublishRecords == NULL ) &&
@@ -1480,6 +1992,7 @@ static MQTTStatus_t handleIncomingPublish( MQTTContext_t * pContext,
         {
             LogInfo( ( "State record updated. New state=%s.",
                        MQTT_State_strerror( publishRecordState ) ) );
+            MQTT_TRACE( pContext, MQTTTraceState, packetIdentifier, publishRecordState, 0U );
         }
 
         /* Different cases in which an incoming publish with duplicate flag is
@@ -1510,6 +2023,7 @@ static MQTTStatus_t handleIncomingPublish( MQTTContext_t * pContext,
          *       data is not passed to the application. */
         else if( status == MQTTStateCollision )
         {
+            MQTT_METRICS_ADD( pContext, stateCollisions, 1U );
             status = MQTTSuccess;
             duplicatePublish = true;
 
@@ -1521,6 +2035,17 @@ static MQTTStatus_t handleIncomingPublish( MQTTContext_t * pContext,
             LogDebug( ( "Incoming publish packet with packet id %hu already exists.",
                         ( unsigned short ) packetIdentifier ) );
 
+            /* The application still owns the first copy of the publish and
+             * acks it when done, so the duplicate is dropped silently. */
+            MQTT_PRE_STATE_UPDATE_HOOK( pContext );
+
+            existingState = MQTT_GetIncomingPublishState( pContext, packetIdentifier, NULL );
+
+            MQTT_POST_STATE_UPDATE_HOOK( pContext );
+
+            ackDeferred = ( existingState == MQTTPubAckDeferred ) ||
+                          ( existingState == MQTTPubRecDeferred );
+
             if( publishInfo.dup == false )
             {
                 LogError( ( "DUP flag is 0 for duplicate packet (MQTT-3.3.1.-1)." ) );
@@ -1541,6 +2066,7 @@ static MQTTStatus_t handleIncomingPublish( MQTTContext_t * pContext,
         deserializedInfo.packetIdentifier = packetIdentifier;
         deserializedInfo.pPublishInfo = &publishInfo;
         deserializedInfo.deserializationResult = status;
+        deserializedInfo.deferAck = false;
 
         /* Invoke application callback to hand the buffer over to application
          * before sending acks.
@@ -1548,15 +2074,48 @@ static MQTTStatus_t handleIncomingPublish( MQTTContext_t * pContext,
          * duplicate incoming publishes. */
         if( duplicatePublish == false )
         {
+            MQTT_TRACE( pContext, MQTTTraceCallbackEnter, packetIdentifier, pIncomingPacket->type, 0U );
             pContext->appCallback( pContext,
                                    pIncomingPacket,
                                    &deserializedInfo );
+            MQTT_TRACE( pContext, MQTTTraceCallbackExit, packetIdentifier, pIncomingPacket->type, 0U );
         }
 
-        /* Send PUBACK or PUBREC if necessary. */
-        status = sendPublishAcks( pContext,
-                                  packetIdentifier,
-                                  publishRecordState );
+        /* Send PUBACK or PUBREC if necessary, unless the application takes
+         * care of it with MQTT_AckIncomingPublish. The state record keeps
+         * the publish until then. */
+        if( ackDeferred == true )
+        {
+            LogDebug( ( "Dropped duplicate of publish %hu waiting for a deferred ack.",
+                        ( unsigned short ) packetIdentifier ) );
+        }
+        else if( ( deserializedInfo.deferAck == true ) && ( publishInfo.qos > MQTTQoS0 ) &&
+                 ( duplicatePublish == false ) )
+        {
+            MQTT_PRE_STATE_UPDATE_HOOK( pContext );
+
+            status = MQTT_UpdateStateDeferAck( pContext,
+                                               packetIdentifier,
+                                               &publishRecordState );
+
+            if( status == MQTTSuccess )
+            {
+                pContext->deferredAckCount++;
+                MQTT_TRACE( pContext, MQTTTraceState, packetIdentifier, publishRecordState, 0U );
+            }
+
+            MQTT_POST_STATE_UPDATE_HOOK( pContext );
+
+            LogDebug( ( "Ack of incoming publish %hu deferred by the application, %lu outstanding.",
+                        ( unsigned short ) packetIdentifier,
+                        ( unsigned long ) pContext->deferredAckCount ) );
+        }
+        else
+        {
+            status = sendPublishAcks( pContext,
+                                      packetIdentifier,
+                                      publishRecordState );
+        }
     }
 
     return status;
@@ -1574,6 +2133,11 @@ static MQTTStatus_t handlePublishAcks( MQTTContext_t * pContext,
     MQTTEventCallback_t appCallback;
     MQTTDeserializedInfo_t deserializedInfo;
 
+    #if ( MQTT_METRICS_ENABLE != 0 )
+        uint32_t sendTimeMs = 0U;
+        MQTTStatus_t sendTimeStatus = MQTTBadResponse;
+    #endif
+
     assert( pContext != NULL );
     assert( pIncomingPacket != NULL );
     assert( pContext->appCallback != NULL );
@@ -1584,11 +2148,20 @@ static MQTTStatus_t handlePublishAcks( MQTTContext_t * pContext,
     status = MQTT_DeserializeAck( pIncomingPacket, &packetIdentifier, NULL );
     LogInfo( ( "Ack packet deserialized with result: %s.",
                MQTT_Status_strerror( status ) ) );
+    MQTT_TRACE( pContext, MQTTTraceDeserialized, packetIdentifier, pIncomingPacket->type, pIncomingPacket->remainingLength );
 
     if( status == MQTTSuccess )
     {
         MQTT_PRE_STATE_UPDATE_HOOK( pContext );
 
+        #if ( MQTT_METRICS_ENABLE != 0 )
+            /* The record goes with the last ack, take its send time first. */
+            if( ( ackType == MQTTPuback ) || ( ackType == MQTTPubcomp ) )
+            {
+                sendTimeStatus = MQTT_GetPublishSendTime( pContext, packetIdentifier, &sendTimeMs );
+            }
+        #endif
+
         status = MQTT_UpdateStateAck( pContext,
                                       packetIdentifier,
                                       ackType,
@@ -1601,6 +2174,22 @@ static MQTTStatus_t handlePublishAcks( MQTTContext_t * pContext,
         {
             LogInfo( ( "State record updated. New state=%s.",
                        MQTT_State_strerror( publishRecordState ) ) );
+            MQTT_TRACE( pContext, MQTTTraceState, packetIdentifier, publishRecordState, 0U );
+
+            #if ( MQTT_METRICS_ENABLE != 0 )
+                if( ( sendTimeStatus == MQTTSuccess ) && ( ackType == MQTTPuback ) )
+                {
+                    MQTT_METRICS_LATENCY( pContext, publishAck, sendTimeMs );
+                }
+                else if( sendTimeStatus == MQTTSuccess )
+                {
+                    MQTT_METRICS_LATENCY( pContext, publishComplete, sendTimeMs );
+                }
+                else
+                {
+                    /* Not the last ack of a PUBLISH. */
+                }
+            #endif
         }
         else
         {
@@ -1629,7 +2218,9 @@ static MQTTStatus_t handlePublishAcks( MQTTContext_t * pContext,
 
         /* Invoke application callback to hand the buffer over to application
          * before sending acks. */
+        MQTT_TRACE( pContext, MQTTTraceCallbackEnter, packetIdentifier, pIncomingPacket->type, 0U );
         appCallback( pContext, pIncomingPacket, &deserializedInfo );
+        MQTT_TRACE( pContext, MQTTTraceCallbackExit, packetIdentifier, pIncomingPacket->type, 0U );
 
         /* Send PUBREL or PUBCOMP if necessary. */
         status = sendPublishAcks( pContext,
@@ -1642,6 +2233,53 @@ static MQTTStatus_t handlePublishAcks( MQTTContext_t * pContext,
 
 /*-----------------------------------------------------------*/
 
+static MQTTStatus_t handlePipelinedConnack( MQTTContext_t * pContext,
+                                            const MQTTPacketInfo_t * pIncomingPacket )
+{
+    MQTTStatus_t status = MQTTBadResponse;
+    bool sessionPresent = false;
+
+    assert( pContext != NULL );
+    assert( pIncomingPacket != NULL );
+
+    MQTT_PRE_STATE_UPDATE_HOOK( pContext );
+
+    if( pContext->connectStatus == MQTTConnackPending )
+    {
+        status = MQTT_DeserializeAck( pIncomingPacket, NULL, &sessionPresent );
+
+        /* Only clean sessions are pipelined, so the broker must not have
+         * kept one. */
+        if( ( status == MQTTSuccess ) && ( sessionPresent == true ) )
+        {
+            LogError( ( "Unexpected session present flag in pipelined CONNACK." ) );
+            status = MQTTBadResponse;
+        }
+
+        if( status == MQTTSuccess )
+        {
+            LogInfo( ( "MQTT connection established with the broker." ) );
+            pContext->connectStatus = MQTTConnected;
+        }
+        else
+        {
+            LogError( ( "Pipelined CONNECT failed with status = %s.",
+                        MQTT_Status_strerror( status ) ) );
+            pContext->connectStatus = MQTTDisconnectPending;
+        }
+    }
+    else
+    {
+        LogError( ( "Unexpected CONNACK from server." ) );
+    }
+
+    MQTT_POST_STATE_UPDATE_HOOK( pContext );
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
 static MQTTStatus_t handleIncomingAck( MQTTContext_t * pContext,
                                        MQTTPacketInfo_t * pIncomingPacket,
                                        bool manageKeepAlive )
@@ -1681,8 +2319,14 @@ static MQTTStatus_t handleIncomingAck( MQTTContext_t * pContext,
 
         case MQTT_PACKET_TYPE_PINGRESP:
             status = MQTT_DeserializeAck( pIncomingPacket, &packetIdentifier, NULL );
+            MQTT_TRACE( pContext, MQTTTraceDeserialized, packetIdentifier, pIncomingPacket->type, pIncomingPacket->remainingLength );
             invokeAppCallback = ( status == MQTTSuccess ) && !manageKeepAlive;
 
+            if( ( status == MQTTSuccess ) && ( pContext->waitingForPingResp == true ) )
+            {
+                MQTT_METRICS_LATENCY( pContext, pingResponse, pContext->pingReqSendTimeMs );
+            }
+
             if( ( status == MQTTSuccess ) && ( manageKeepAlive == true ) )
             {
                 pContext->waitingForPingResp = false;
@@ -1694,6 +2338,13 @@ static MQTTStatus_t handleIncomingAck( MQTTContext_t * pContext,
         case MQTT_PACKET_TYPE_UNSUBACK:
             /* Deserialize and give these to the app provided callback. */
             status = MQTT_DeserializeAck( pIncomingPacket, &packetIdentifier, NULL );
+            MQTT_TRACE( pContext, MQTTTraceDeserialized, packetIdentifier, pIncomingPacket->type, pIncomingPacket->remainingLength );
+            invokeAppCallback = ( status == MQTTSuccess ) || ( status == MQTTServerRefused );
+            break;
+
+        case MQTT_PACKET_TYPE_CONNACK:
+            status = handlePipelinedConnack( pContext, pIncomingPacket );
+            MQTT_TRACE( pContext, MQTTTraceDeserialized, 0U, pIncomingPacket->type, pIncomingPacket->remainingLength );
             invokeAppCallback = ( status == MQTTSuccess ) || ( status == MQTTServerRefused );
             break;
 
@@ -1711,15 +2362,53 @@ static MQTTStatus_t handleIncomingAck( MQTTContext_t * pContext,
         deserializedInfo.packetIdentifier = packetIdentifier;
         deserializedInfo.deserializationResult = status;
         deserializedInfo.pPublishInfo = NULL;
+        MQTT_TRACE( pContext, MQTTTraceCallbackEnter, packetIdentifier, pIncomingPacket->type, 0U );
         appCallback( pContext, pIncomingPacket, &deserializedInfo );
-        /* In case a SUBACK indicated refusal, reset the status to continue the loop. */
-        status = MQTTSuccess;
+        MQTT_TRACE( pContext, MQTTTraceCallbackExit, packetIdentifier, pIncomingPacket->type, 0U );
+
+        /* In case a SUBACK indicated refusal, reset the status to continue the
+         * loop. A refused CONNACK ends the connection and is bubbled up. */
+        if( pIncomingPacket->type != MQTT_PACKET_TYPE_CONNACK )
+        {
+            status = MQTTSuccess;
+        }
     }
 
     return status;
 }
 /*-----------------------------------------------------------*/
 
+static void updateFlowControl( MQTTContext_t * pContext )
+{
+    size_t depth;
+
+    if( pContext->getConsumerDepth != NULL )
+    {
+        depth = pContext->getConsumerDepth( pContext->pFlowControlUserData );
+
+        /* The gap between the watermarks keeps receiving from toggling on
+         * every message. */
+        if( ( pContext->flowPaused == false ) && ( depth >= pContext->flowHighWatermark ) )
+        {
+            LogDebug( ( "Consumer queue depth %lu, pausing receive.",
+                        ( unsigned long ) depth ) );
+            pContext->flowPaused = true;
+        }
+        else if( ( pContext->flowPaused == true ) && ( depth <= pContext->flowLowWatermark ) )
+        {
+            LogDebug( ( "Consumer queue depth %lu, resuming receive.",
+                        ( unsigned long ) depth ) );
+            pContext->flowPaused = false;
+        }
+        else
+        {
+            /* MISRA else. */
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
 static MQTTStatus_t receiveSingleIteration( MQTTContext_t * pContext,
                                             bool manageKeepAlive )
 {
@@ -1731,19 +2420,42 @@ static MQTTStatus_t receiveSingleIteration( MQTTContext_t * pContext,
     assert( pContext != NULL );
     assert( pContext->networkBuffer.pBuffer != NULL );
 
-    /* Read as many bytes as possible into the network buffer. */
-    recvBytes = pContext->transportInterface.recv( pContext->transportInterface.pNetworkContext,
-                                                   &( pContext->networkBuffer.pBuffer[ pContext->index ] ),
-                                                   pContext->networkBuffer.size - pContext->index );
+    updateFlowControl( pContext );
+
+    if( MQTT_IsReceivePaused( pContext ) == true )
+    {
+        /* Too many acks are deferred or the consumers are behind. Leave the
+         * socket and any buffered packets alone until they catch up, but keep
+         * the connection alive. */
+        recvBytes = 0;
+        status = MQTTNoDataAvailable;
+    }
+    else
+    {
+        /* Read as many bytes as possible into the network buffer. */
+        recvBytes = pContext->transportInterface.recv( pContext->transportInterface.pNetworkContext,
+                                                       &( pContext->networkBuffer.pBuffer[ pContext->index ] ),
+                                                       pContext->networkBuffer.size - pContext->index );
+    }
+
+    if( recvBytes != 0 )
+    {
+        MQTT_TRACE( pContext, MQTTTraceRecv, 0U, 0U, recvBytes );
+    }
 
-    if( recvBytes < 0 )
+    if( status == MQTTNoDataAvailable )
+    {
+        /* Receiving is paused. */
+    }
+    else if( recvBytes < 0 )
     {
         /* The receive function has failed. Bubble up the error up to the user. */
         status = MQTTRecvFailed;
 
         MQTT_PRE_STATE_UPDATE_HOOK( pContext );
 
-        if( pContext->connectStatus == MQTTConnected )
+        if( ( pContext->connectStatus == MQTTConnected ) ||
+            ( pContext->connectStatus == MQTTConnackPending ) )
         {
             pContext->connectStatus = MQTTDisconnectPending;
         }
@@ -1763,12 +2475,18 @@ static MQTTStatus_t receiveSingleIteration( MQTTContext_t * pContext,
     {
         /* Update the number of bytes in the MQTT fixed buffer. */
         pContext->index += ( size_t ) recvBytes;
+        MQTT_METRICS_ADD( pContext, bytesReceived, recvBytes );
 
         status = MQTT_ProcessIncomingPacketTypeAndLength( pContext->networkBuffer.pBuffer,
                                                           &( pContext->index ),
                                                           &incomingPacket );
 
         totalMQTTPacketLength = incomingPacket.remainingLength + incomingPacket.headerLength;
+
+        if( status == MQTTSuccess )
+        {
+            MQTT_TRACE( pContext, MQTTTraceHeader, 0U, incomingPacket.type, incomingPacket.remainingLength );
+        }
     }
 
     /* No data was received, check for keep alive timeout. */
@@ -1830,6 +2548,7 @@ static MQTTStatus_t receiveSingleIteration( MQTTContext_t * pContext,
     if( status == MQTTSuccess )
     {
         incomingPacket.pRemainingData = &pContext->networkBuffer.pBuffer[ incomingPacket.headerLength ];
+        MQTT_METRICS_ADD( pContext, packetsReceived[ incomingPacket.type >> 4 ], 1U );
 
         /* PUBLISH packets allow flags in the lower four bits. For other
          * packet types, they are reserved. */
@@ -1846,6 +2565,8 @@ static MQTTStatus_t receiveSingleIteration( MQTTContext_t * pContext,
         pContext->index -= totalMQTTPacketLength;
 
         /* Move the remaining bytes to the front of the buffer. */
+        MQTT_RECV_MEMMOVE_HOOK( pContext, pContext->index );
+        MQTT_METRICS_ADD( pContext, memmoveBytes, pContext->index );
         ( void ) memmove( pContext->networkBuffer.pBuffer,
                           &( pContext->networkBuffer.pBuffer[ totalMQTTPacketLength ] ),
                           pContext->index );
@@ -2499,6 +3220,10 @@ static MQTTStatus_t receiveConnack( MQTTContext_t * pContext,
         /* Update the packet info pointer to the buffer read. */
         pIncomingPacket->pRemainingData = pContext->networkBuffer.pBuffer;
 
+        /* The fixed header was read past recvExact, count it here. */
+        MQTT_METRICS_ADD( pContext, bytesReceived, pIncomingPacket->headerLength );
+        MQTT_METRICS_ADD( pContext, packetsReceived[ MQTT_PACKET_TYPE_CONNACK >> 4 ], 1U );
+
         /* Deserialize CONNACK. */
         status = MQTT_DeserializeAck( pIncomingPacket, NULL, pSessionPresent );
     }
@@ -2632,6 +3357,138 @@ static MQTTStatus_t handleCleanSession( MQTTContext_t * pContext )
                          pContext->incomingPublishRecordMaxCount * sizeof( *pContext->incomingPublishRecords ) );
     }
 
+    /* Acks deferred in the old session are not sent anymore. */
+    pContext->deferredAckCount = 0U;
+
+    return status;
+}
+
+static MQTTStatus_t validatePipelinedConnectParams( const MQTTContext_t * pContext,
+                                                     const MQTTConnectInfo_t * pConnectInfo,
+                                                     const MQTTPublishInfo_t * pWillInfo )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    size_t remainingLength = 0UL, packetSize = 0UL;
+
+    if( ( pContext == NULL ) || ( pConnectInfo == NULL ) )
+    {
+        LogError( ( "Argument cannot be NULL: pContext=%p, "
+                    "pConnectInfo=%p.",
+                    ( void * ) pContext,
+                    ( void * ) pConnectInfo ) );
+        status = MQTTBadParameter;
+    }
+    else if( pConnectInfo->cleanSession != true )
+    {
+        LogError( ( "A pipelined CONNECT must request a clean session." ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        /* Reject a CONNECT that cannot be serialized before any state changes. */
+        status = MQTT_GetConnectPacketSize( pConnectInfo,
+                                            pWillInfo,
+                                            &remainingLength,
+                                            &packetSize );
+    }
+
+    return status;
+}
+
+static MQTTStatus_t sendPipelinedConnect( MQTTContext_t * pContext,
+                                          const MQTTConnectInfo_t * pConnectInfo,
+                                          const MQTTPublishInfo_t * pWillInfo )
+{
+    MQTTStatus_t status;
+    size_t remainingLength = 0UL, packetSize = 0UL;
+
+    assert( pContext != NULL );
+    assert( pConnectInfo != NULL );
+
+    status = MQTT_GetConnectPacketSize( pConnectInfo,
+                                        pWillInfo,
+                                        &remainingLength,
+                                        &packetSize );
+
+    /* The session is known to be clean, so the old state is dropped
+     * before anything of the new session is sent. */
+    if( status == MQTTSuccess )
+    {
+        status = handleCleanSession( pContext );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        status = sendConnectWithoutCopy( pContext,
+                                         pConnectInfo,
+                                         pWillInfo,
+                                         remainingLength );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        pContext->connectStatus = MQTTConnackPending;
+        pContext->connectStartTimeMs = pContext->getTime();
+        pContext->keepAliveIntervalSec = pConnectInfo->keepAliveSeconds;
+        pContext->waitingForPingResp = false;
+        pContext->pingReqSendTimeMs = 0U;
+    }
+
+    return status;
+}
+
+static MQTTStatus_t advanceConnect( MQTTContext_t * pContext )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    int32_t result;
+
+    assert( pContext != NULL );
+    assert( pContext->transportInterface.connect != NULL );
+
+    result = pContext->transportInterface.connect( pContext->transportInterface.pNetworkContext );
+
+    MQTT_PRE_STATE_UPDATE_HOOK( pContext );
+
+    if( pContext->connectStatus != MQTTConnecting )
+    {
+        /* Disconnected while the transport step ran. */
+    }
+    else if( result > 0 )
+    {
+        LogDebug( ( "Transport connected, sending CONNECT." ) );
+        status = sendPipelinedConnect( pContext, pContext->pConnectInfo, pContext->pWillInfo );
+    }
+    else if( result < 0 )
+    {
+        LogError( ( "Transport connect failed with %ld.", ( long int ) result ) );
+        status = MQTTSendFailed;
+    }
+    else if( calculateElapsedTime( pContext->getTime(), pContext->connectStartTimeMs ) >
+             MQTT_TRANSPORT_CONNECT_TIMEOUT_MS )
+    {
+        LogError( ( "Transport not connected within %lu ms.",
+                    ( unsigned long ) MQTT_TRANSPORT_CONNECT_TIMEOUT_MS ) );
+        status = MQTTKeepAliveTimeout;
+    }
+    else
+    {
+        /* Empty else MISRA 15.7 */
+    }
+
+    if( ( result != 0 ) || ( status != MQTTSuccess ) )
+    {
+        if( ( status != MQTTSuccess ) && ( pContext->connectStatus == MQTTConnecting ) )
+        {
+            pContext->connectStatus = MQTTNotConnected;
+        }
+
+        /* The connect information is only referenced until the CONNECT left. */
+        pContext->pConnectInfo = NULL;
+        pContext->pWillInfo = NULL;
+    }
+
+    MQTT_POST_STATE_UPDATE_HOOK( pContext );
+
     return status;
 }
 
@@ -2788,6 +3645,7 @@ MQTTStatus_t MQTT_InitStatefulQoS( MQTTContext_t * pContext,
     {
         pContext->incomingPublishRecordMaxCount = incomingPublishCount;
         pContext->incomingPublishRecords = pIncomingPublishRecords;
+        pContext->deferredAckMax = incomingPublishCount;
         pContext->outgoingPublishRecordMaxCount = outgoingPublishCount;
         pContext->outgoingPublishRecords = pOutgoingPublishRecords;
     }
@@ -2895,6 +3753,10 @@ MQTTStatus_t MQTT_CheckConnectStatus( const MQTTContext_t * pContext )
                 status = MQTTStatusConnected;
                 break;
 
+            case MQTTConnackPending:
+                status = MQTTStatusConnected;
+                break;
+
             case MQTTDisconnectPending:
                 status = MQTTStatusDisconnectPending;
                 break;
@@ -2954,7 +3816,7 @@ MQTTStatus_t MQTT_Connect( MQTTContext_t * pContext,
 
         if( connectStatus != MQTTNotConnected )
         {
-            status = ( connectStatus == MQTTConnected ) ? MQTTStatusConnected : MQTTStatusDisconnectPending;
+            status = ( connectStatus == MQTTDisconnectPending ) ? MQTTStatusDisconnectPending : MQTTStatusConnected;
         }
 
         if( status == MQTTSuccess )
@@ -3038,6 +3900,100 @@ MQTTStatus_t MQTT_Connect( MQTTContext_t * pContext,
 
 /*-----------------------------------------------------------*/
 
+MQTTStatus_t MQTT_SendConnect( MQTTContext_t * pContext,
+                               const MQTTConnectInfo_t * pConnectInfo,
+                               const MQTTPublishInfo_t * pWillInfo )
+{
+    MQTTStatus_t status;
+    MQTTConnectionStatus_t connectStatus;
+
+    status = validatePipelinedConnectParams( pContext, pConnectInfo, pWillInfo );
+
+    if( status == MQTTSuccess )
+    {
+        MQTT_PRE_STATE_UPDATE_HOOK( pContext );
+
+        connectStatus = pContext->connectStatus;
+
+        if( connectStatus != MQTTNotConnected )
+        {
+            status = ( connectStatus == MQTTDisconnectPending ) ? MQTTStatusDisconnectPending : MQTTStatusConnected;
+        }
+
+        if( status == MQTTSuccess )
+        {
+            status = sendPipelinedConnect( pContext, pConnectInfo, pWillInfo );
+        }
+
+        MQTT_POST_STATE_UPDATE_HOOK( pContext );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        LogDebug( ( "CONNECT sent, CONNACK will be handled by the receive loop." ) );
+    }
+    else
+    {
+        LogError( ( "Pipelined CONNECT failed with status = %s.",
+                    MQTT_Status_strerror( status ) ) );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_ConnectAsync( MQTTContext_t * pContext,
+                                const MQTTConnectInfo_t * pConnectInfo,
+                                const MQTTPublishInfo_t * pWillInfo )
+{
+    MQTTStatus_t status;
+    MQTTConnectionStatus_t connectStatus;
+
+    status = validatePipelinedConnectParams( pContext, pConnectInfo, pWillInfo );
+
+    if( status == MQTTSuccess )
+    {
+        MQTT_PRE_STATE_UPDATE_HOOK( pContext );
+
+        connectStatus = pContext->connectStatus;
+
+        if( connectStatus != MQTTNotConnected )
+        {
+            status = ( connectStatus == MQTTDisconnectPending ) ? MQTTStatusDisconnectPending : MQTTStatusConnected;
+        }
+
+        if( status != MQTTSuccess )
+        {
+            /* Empty else MISRA 15.7 */
+        }
+        else if( pContext->transportInterface.connect == NULL )
+        {
+            /* Nothing to wait for, the transport is connected already. */
+            status = sendPipelinedConnect( pContext, pConnectInfo, pWillInfo );
+        }
+        else
+        {
+            pContext->pConnectInfo = pConnectInfo;
+            pContext->pWillInfo = pWillInfo;
+            pContext->connectStartTimeMs = pContext->getTime();
+            pContext->connectStatus = MQTTConnecting;
+        }
+
+        MQTT_POST_STATE_UPDATE_HOOK( pContext );
+    }
+
+    if( status != MQTTSuccess )
+    {
+        LogError( ( "Non-blocking connect failed with status = %s.",
+                    MQTT_Status_strerror( status ) ) );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
 MQTTStatus_t MQTT_Subscribe( MQTTContext_t * pContext,
                              const MQTTSubscribeInfo_t * pSubscriptionList,
                              size_t subscriptionCount,
@@ -3070,9 +4026,9 @@ MQTTStatus_t MQTT_Subscribe( MQTTContext_t * pContext,
 
         connectStatus = pContext->connectStatus;
 
-        if( connectStatus != MQTTConnected )
+        if( ( connectStatus != MQTTConnected ) && ( connectStatus != MQTTConnackPending ) )
         {
-            status = ( connectStatus == MQTTNotConnected ) ? MQTTStatusNotConnected : MQTTStatusDisconnectPending;
+            status = ( connectStatus == MQTTDisconnectPending ) ? MQTTStatusDisconnectPending : MQTTStatusNotConnected;
         }
 
         if( status == MQTTSuccess )
@@ -3137,21 +4093,20 @@ MQTTStatus_t MQTT_Publish( MQTTContext_t * pContext,
 
     if( status == MQTTSuccess )
     {
-        /* Take the mutex as multiple send calls are required for sending this
-         * packet. */
+        /* The state lock only covers the state engine. The PUBLISH itself
+         * goes out under the send lock taken by sendMessageVector, so a
+         * thread receiving acks is not held up by a long send. */
         MQTT_PRE_STATE_UPDATE_HOOK( pContext );
 
         connectStatus = pContext->connectStatus;
 
-        if( connectStatus != MQTTConnected )
+        if( ( connectStatus != MQTTConnected ) && ( connectStatus != MQTTConnackPending ) )
         {
-            status = ( connectStatus == MQTTNotConnected ) ? MQTTStatusNotConnected : MQTTStatusDisconnectPending;
+            status = ( connectStatus == MQTTDisconnectPending ) ? MQTTStatusDisconnectPending : MQTTStatusNotConnected;
         }
 
         if( ( status == MQTTSuccess ) && ( pPublishInfo->qos > MQTTQoS0 ) )
         {
-            /* Set the flag so that the corresponding hook can be called later. */
-
             status = MQTT_ReserveState( pContext,
                                         packetId,
                                         pPublishInfo->qos );
@@ -3161,46 +4116,45 @@ MQTTStatus_t MQTT_Publish( MQTTContext_t * pContext,
              * state engine. */
             if( ( status == MQTTStateCollision ) && ( pPublishInfo->dup == true ) )
             {
+                MQTT_METRICS_ADD( pContext, stateCollisions, 1U );
                 status = MQTTSuccess;
             }
         }
 
-        if( status == MQTTSuccess )
-        {
-            status = sendPublishWithoutCopy( pContext,
-                                             pPublishInfo,
-                                             mqttHeader,
-                                             headerSize,
-                                             packetId );
-        }
-
         if( ( status == MQTTSuccess ) &&
             ( pPublishInfo->qos > MQTTQoS0 ) )
         {
-            /* Update state machine after PUBLISH is sent.
-             * Only to be done for QoS1 or QoS2. */
+            /* Move the record to awaiting its ack before the PUBLISH goes out,
+             * as the ack may be received by another thread as soon as the
+             * broker has the packet. Should the send fail, the record is
+             * resent like one in #MQTTPublishSend when the session resumes. */
             status = MQTT_UpdateStatePublish( pContext,
                                               packetId,
                                               MQTT_SEND,
                                               pPublishInfo->qos,
                                               &publishStatus );
 
-            if( status != MQTTSuccess )
+            if( status == MQTTSuccess )
+            {
+                MQTT_TRACE( pContext, MQTTTraceState, packetId, publishStatus, 0U );
+            }
+            else
             {
-                LogError( ( "Update state for publish failed with status %s."
-                            " However PUBLISH packet was sent to the broker."
-                            " Any further handling of ACKs for the packet Id"
-                            " will fail.",
+                LogError( ( "Update state for publish failed with status %s.",
                             MQTT_Status_strerror( status ) ) );
             }
         }
 
-        /* mutex should be released and not before updating the state
-         * because we need to make sure that the state is updated
-         * after sending the publish packet, before the receive
-         * loop receives ack for this and would want to update its state
-         */
         MQTT_POST_STATE_UPDATE_HOOK( pContext );
+
+        if( status == MQTTSuccess )
+        {
+            status = sendPublishWithoutCopy( pContext,
+                                             pPublishInfo,
+                                             mqttHeader,
+                                             headerSize,
+                                             packetId );
+        }
     }
 
     if( status != MQTTSuccess )
@@ -3267,7 +4221,7 @@ MQTTStatus_t MQTT_Ping( MQTTContext_t * pContext )
 
         if( connectStatus != MQTTConnected )
         {
-            status = ( connectStatus == MQTTNotConnected ) ? MQTTStatusNotConnected : MQTTStatusDisconnectPending;
+            status = ( connectStatus == MQTTDisconnectPending ) ? MQTTStatusDisconnectPending : MQTTStatusNotConnected;
         }
 
         if( status == MQTTSuccess )
@@ -3336,9 +4290,9 @@ MQTTStatus_t MQTT_Unsubscribe( MQTTContext_t * pContext,
 
         connectStatus = pContext->connectStatus;
 
-        if( connectStatus != MQTTConnected )
+        if( ( connectStatus != MQTTConnected ) && ( connectStatus != MQTTConnackPending ) )
         {
-            status = ( connectStatus == MQTTNotConnected ) ? MQTTStatusNotConnected : MQTTStatusDisconnectPending;
+            status = ( connectStatus == MQTTDisconnectPending ) ? MQTTStatusDisconnectPending : MQTTStatusNotConnected;
         }
 
         if( status == MQTTSuccess )
@@ -3402,8 +4356,20 @@ MQTTStatus_t MQTT_Disconnect( MQTTContext_t * pContext )
         {
             status = MQTTStatusNotConnected;
         }
+        else if( connectStatus == MQTTConnecting )
+        {
+            /* No CONNECT was sent yet, so there is nothing to tell the broker. */
+            LogInfo( ( "Non-blocking connect abandoned." ) );
+            pContext->connectStatus = MQTTNotConnected;
+            pContext->pConnectInfo = NULL;
+            pContext->pWillInfo = NULL;
+        }
+        else
+        {
+            /* Empty else MISRA 15.7 */
+        }
 
-        if( status == MQTTSuccess )
+        if( ( status == MQTTSuccess ) && ( connectStatus != MQTTConnecting ) )
         {
             LogInfo( ( "Disconnected from the broker." ) );
             pContext->connectStatus = MQTTNotConnected;
@@ -3457,6 +4423,10 @@ MQTTStatus_t MQTT_ProcessLoop( MQTTContext_t * pContext )
     {
         LogError( ( "Invalid input parameter: The MQTT context's networkBuffer must not be NULL." ) );
     }
+    else if( pContext->connectStatus == MQTTConnecting )
+    {
+        status = advanceConnect( pContext );
+    }
     else
     {
         pContext->controlPacketSent = false;
@@ -3484,6 +4454,10 @@ MQTTStatus_t MQTT_ReceiveLoop( MQTTContext_t * pContext )
     {
         LogError( ( "Invalid input parameter: MQTT context's networkBuffer must not be NULL." ) );
     }
+    else if( pContext->connectStatus == MQTTConnecting )
+    {
+        status = advanceConnect( pContext );
+    }
     else
     {
         status = receiveSingleIteration( pContext, false );
@@ -3523,6 +4497,249 @@ uint16_t MQTT_GetPacketId( MQTTContext_t * pContext )
 
 /*-----------------------------------------------------------*/
 
+MQTTStatus_t MQTT_AckIncomingPublish( MQTTContext_t * pContext,
+                                      uint16_t packetId,
+                                      MQTTQoS_t qos )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    MQTTPublishState_t publishState = MQTTStateNull;
+    MQTTQoS_t recordQoS = MQTTQoS0;
+
+    if( ( pContext == NULL ) || ( packetId == 0U ) ||
+        ( ( qos != MQTTQoS1 ) && ( qos != MQTTQoS2 ) ) )
+    {
+        LogError( ( "Argument cannot be NULL and packet ID must be non-zero for a QoS 1 or 2 "
+                    "publish: pContext=%p, packetId=%hu, qos=%d.",
+                    ( void * ) pContext, ( unsigned short ) packetId, ( int ) qos ) );
+        status = MQTTBadParameter;
+    }
+    else if( pContext->incomingPublishRecords == NULL )
+    {
+        LogError( ( "Incoming publish records have not been initialized." ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        MQTT_PRE_STATE_UPDATE_HOOK( pContext );
+
+        publishState = MQTT_GetIncomingPublishState( pContext, packetId, &recordQoS );
+
+        MQTT_POST_STATE_UPDATE_HOOK( pContext );
+
+        if( ( recordQoS != qos ) ||
+            ( ( publishState != MQTTPubAckDeferred ) && ( publishState != MQTTPubRecDeferred ) ) )
+        {
+            LogError( ( "Incoming publish %hu with QoS %d is not waiting for a deferred ack: State=%s.",
+                        ( unsigned short ) packetId, ( int ) qos,
+                        MQTT_State_strerror( publishState ) ) );
+            status = MQTTBadParameter;
+        }
+    }
+
+    if( status == MQTTSuccess )
+    {
+        status = sendPublishAcks( pContext, packetId, publishState );
+
+        if( status == MQTTSuccess )
+        {
+            MQTT_PRE_STATE_UPDATE_HOOK( pContext );
+
+            if( pContext->deferredAckCount > 0U )
+            {
+                pContext->deferredAckCount--;
+            }
+
+            MQTT_POST_STATE_UPDATE_HOOK( pContext );
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_SetDeferredAckLimit( MQTTContext_t * pContext,
+                                       size_t maxCount )
+{
+    MQTTStatus_t status = MQTTSuccess;
+
+    if( pContext == NULL )
+    {
+        LogError( ( "Argument cannot be NULL: pContext=%p.", ( void * ) pContext ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        MQTT_PRE_STATE_UPDATE_HOOK( pContext );
+
+        pContext->deferredAckMax = maxCount;
+
+        MQTT_POST_STATE_UPDATE_HOOK( pContext );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_SetFlowControl( MQTTContext_t * pContext,
+                                  MQTTFlowControlDepth_t getDepth,
+                                  void * pUserData,
+                                  size_t highWatermark,
+                                  size_t lowWatermark )
+{
+    MQTTStatus_t status = MQTTSuccess;
+
+    if( pContext == NULL )
+    {
+        LogError( ( "Argument cannot be NULL: pContext=%p.", ( void * ) pContext ) );
+        status = MQTTBadParameter;
+    }
+    else if( ( getDepth != NULL ) && ( lowWatermark >= highWatermark ) )
+    {
+        LogError( ( "Low watermark must be below the high watermark: low=%lu, high=%lu.",
+                    ( unsigned long ) lowWatermark,
+                    ( unsigned long ) highWatermark ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        pContext->getConsumerDepth = getDepth;
+        pContext->pFlowControlUserData = pUserData;
+        pContext->flowHighWatermark = highWatermark;
+        pContext->flowLowWatermark = lowWatermark;
+        pContext->flowPaused = false;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+bool MQTT_IsReceivePaused( const MQTTContext_t * pContext )
+{
+    bool isPaused = false;
+
+    if( pContext != NULL )
+    {
+        isPaused = ( pContext->deferredAckMax > 0U ) &&
+                   ( pContext->deferredAckCount >= pContext->deferredAckMax );
+        isPaused = isPaused || pContext->flowPaused;
+    }
+
+    return isPaused;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_GetMetrics( const MQTTContext_t * pContext,
+                              MQTTMetrics_t * pMetrics )
+{
+    MQTTStatus_t status = MQTTSuccess;
+
+    #if ( MQTT_METRICS_ENABLE != 0 )
+        const uint32_t * pSource = NULL;
+        uint32_t * pDestination = NULL;
+        size_t i;
+    #endif
+
+    if( ( pContext == NULL ) || ( pMetrics == NULL ) )
+    {
+        LogError( ( "Argument cannot be NULL: pContext=%p, pMetrics=%p.",
+                    ( void * ) pContext,
+                    ( void * ) pMetrics ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        #if ( MQTT_METRICS_ENABLE != 0 )
+            /* Counters are taken one by one while the client may be running, so
+             * the snapshot is consistent per counter only. */
+            pSource = ( const uint32_t * ) &( pContext->metrics );
+            pDestination = ( uint32_t * ) pMetrics;
+
+            for( i = 0U; i < ( sizeof( MQTTMetrics_t ) / sizeof( uint32_t ) ); i++ )
+            {
+                pDestination[ i ] = MQTT_METRICS_ATOMIC_LOAD( &pSource[ i ] );
+            }
+        #else
+            ( void ) memset( pMetrics, 0, sizeof( MQTTMetrics_t ) );
+        #endif
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_ResetMetrics( MQTTContext_t * pContext )
+{
+    MQTTStatus_t status = MQTTSuccess;
+
+    #if ( MQTT_METRICS_ENABLE != 0 )
+        uint32_t * pCounter = NULL;
+        size_t i;
+    #endif
+
+    if( pContext == NULL )
+    {
+        LogError( ( "Argument cannot be NULL: pContext=%p.",
+                    ( void * ) pContext ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        #if ( MQTT_METRICS_ENABLE != 0 )
+            pCounter = ( uint32_t * ) &( pContext->metrics );
+
+            for( i = 0U; i < ( sizeof( MQTTMetrics_t ) / sizeof( uint32_t ) ); i++ )
+            {
+                MQTT_METRICS_ATOMIC_STORE( &pCounter[ i ], 0U );
+            }
+        #endif
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+uint32_t MQTT_LatencyPercentile( const MQTTLatencyHistogram_t * pHistogram,
+                                 uint32_t percent )
+{
+    uint32_t percentileMs = 0U;
+    uint32_t rank;
+    uint32_t seen = 0U;
+    uint32_t bucket = 0U;
+
+    if( ( pHistogram != NULL ) && ( pHistogram->count > 0U ) )
+    {
+        /* Rank of the sample wanted, counted from one. */
+        percent = ( percent > 100U ) ? 100U : percent;
+        rank = ( uint32_t ) ( ( ( ( uint64_t ) pHistogram->count * percent ) + 99U ) / 100U );
+        rank = ( rank == 0U ) ? 1U : rank;
+
+        while( ( bucket < ( MQTT_LATENCY_BUCKET_COUNT - 1U ) ) &&
+               ( ( seen + pHistogram->buckets[ bucket ] ) < rank ) )
+        {
+            seen += pHistogram->buckets[ bucket ];
+            bucket++;
+        }
+
+        /* Top of the bucket, capped at the largest sample. */
+        percentileMs = ( ( uint32_t ) 1U << bucket ) - 1U;
+
+        if( ( bucket == ( MQTT_LATENCY_BUCKET_COUNT - 1U ) ) || ( percentileMs > pHistogram->maxMs ) )
+        {
+            percentileMs = pHistogram->maxMs;
+        }
+    }
+
+    return percentileMs;
+}
+
+/*-----------------------------------------------------------*/
+
 MQTTStatus_t MQTT_MatchTopic( const char * pTopicName,
                               const uint16_t topicNameLength,
                               const char * pTopicFilter,
@@ -3592,6 +4809,221 @@ MQTTStatus_t MQTT_MatchTopic( const char * pTopicName,
 
 /*-----------------------------------------------------------*/
 
+MQTTStatus_t MQTT_CompileTopicFilter( const char * pTopicFilter,
+                                      uint16_t topicFilterLength,
+                                      MQTTTopicToken_t * pTokens,
+                                      uint16_t tokenMaxCount,
+                                      MQTTCompiledTopicFilter_t * pCompiled )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    const char * pLevelEnd;
+    uint16_t offset = 0U, levelLength, tokenCount = 0U, wildcardLength = 0U;
+    bool hasWildcard = false, lastLevel = false;
+    MQTTTopicToken_t * pToken;
+
+    if( ( pTopicFilter == NULL ) || ( topicFilterLength == 0U ) ||
+        ( pTokens == NULL ) || ( tokenMaxCount == 0U ) || ( pCompiled == NULL ) )
+    {
+        LogError( ( "Argument cannot be NULL or zero: pTopicFilter=%p, "
+                    "topicFilterLength=%hu, pTokens=%p, tokenMaxCount=%hu, pCompiled=%p.",
+                    ( void * ) pTopicFilter,
+                    ( unsigned short ) topicFilterLength,
+                    ( void * ) pTokens,
+                    ( unsigned short ) tokenMaxCount,
+                    ( void * ) pCompiled ) );
+        status = MQTTBadParameter;
+    }
+
+    while( ( status == MQTTSuccess ) && ( lastLevel == false ) )
+    {
+        pLevelEnd = memchr( &pTopicFilter[ offset ], '/', ( size_t ) topicFilterLength - offset );
+
+        if( pLevelEnd == NULL )
+        {
+            levelLength = ( uint16_t ) ( topicFilterLength - offset );
+            lastLevel = true;
+        }
+        else
+        {
+            levelLength = ( uint16_t ) ( pLevelEnd - &pTopicFilter[ offset ] );
+        }
+
+        if( ( levelLength == 1U ) &&
+            ( ( pTopicFilter[ offset ] == '+' ) || ( pTopicFilter[ offset ] == '#' ) ) )
+        {
+            /* '#' is only valid as the last level of a filter. */
+            if( ( pTopicFilter[ offset ] == '#' ) && ( lastLevel == false ) )
+            {
+                status = MQTTBadParameter;
+            }
+            else if( tokenCount == tokenMaxCount )
+            {
+                status = MQTTBadParameter;
+            }
+            else
+            {
+                pToken = &pTokens[ tokenCount ];
+                pToken->offset = offset;
+                pToken->length = 1U;
+                pToken->type = ( pTopicFilter[ offset ] == '+' ) ? MQTTTopicTokenSingleLevel :
+                               MQTTTopicTokenMultiLevel;
+                tokenCount++;
+                hasWildcard = true;
+
+                /* '+' may match an empty level and "/#" may match nothing at all. */
+                wildcardLength += ( pToken->type == MQTTTopicTokenSingleLevel ) ? 1U : 2U;
+            }
+        }
+        else if( ( memchr( &pTopicFilter[ offset ], '+', levelLength ) != NULL ) ||
+                 ( memchr( &pTopicFilter[ offset ], '#', levelLength ) != NULL ) )
+        {
+            /* Wildcards must occupy an entire level. */
+            status = MQTTBadParameter;
+        }
+        else if( ( tokenCount > 0U ) &&
+                 ( pTokens[ tokenCount - 1U ].type == MQTTTopicTokenLiteral ) )
+        {
+            /* Extend the previous literal span over this level and its separator. */
+            pToken = &pTokens[ tokenCount - 1U ];
+            pToken->length = ( uint16_t ) ( offset + levelLength - pToken->offset );
+        }
+        else if( tokenCount == tokenMaxCount )
+        {
+            status = MQTTBadParameter;
+        }
+        else
+        {
+            pToken = &pTokens[ tokenCount ];
+            pToken->offset = offset;
+            pToken->length = levelLength;
+            pToken->type = MQTTTopicTokenLiteral;
+            tokenCount++;
+        }
+
+        offset = ( uint16_t ) ( offset + levelLength + 1U );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        pCompiled->pTopicFilter = pTopicFilter;
+        pCompiled->topicFilterLength = topicFilterLength;
+        pCompiled->pTokens = pTokens;
+        pCompiled->tokenCount = tokenCount;
+        pCompiled->hasWildcard = hasWildcard;
+        pCompiled->minTopicLength = ( wildcardLength >= topicFilterLength ) ? 0U :
+                                    ( uint16_t ) ( topicFilterLength - wildcardLength );
+    }
+    else if( pTopicFilter != NULL )
+    {
+        LogError( ( "Topic filter %.*s is invalid or needs more than %hu tokens.",
+                    ( int ) topicFilterLength,
+                    pTopicFilter,
+                    ( unsigned short ) tokenMaxCount ) );
+    }
+    else
+    {
+        /* Empty else MISRA 15.7 */
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_MatchCompiledTopic( const char * pTopicName,
+                                      uint16_t topicNameLength,
+                                      const MQTTCompiledTopicFilter_t * pCompiled,
+                                      bool * pIsMatch )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    const MQTTTopicToken_t * pToken;
+    const char * pLevelEnd;
+    uint32_t nameIndex = 0U, spanEnd;
+    uint16_t tokenIndex;
+    bool matchStatus = false, decided = false;
+
+    if( ( pTopicName == NULL ) || ( topicNameLength == 0U ) ||
+        ( pCompiled == NULL ) || ( pCompiled->pTokens == NULL ) || ( pIsMatch == NULL ) )
+    {
+        LogError( ( "Argument cannot be NULL or zero: pTopicName=%p, "
+                    "topicNameLength=%hu, pCompiled=%p, pIsMatch=%p.",
+                    ( void * ) pTopicName,
+                    ( unsigned short ) topicNameLength,
+                    ( const void * ) pCompiled,
+                    ( void * ) pIsMatch ) );
+        status = MQTTBadParameter;
+    }
+    else if( pCompiled->hasWildcard == false )
+    {
+        matchStatus = ( topicNameLength == pCompiled->topicFilterLength ) &&
+                      ( memcmp( pTopicName, pCompiled->pTopicFilter, topicNameLength ) == 0 );
+    }
+    else if( ( topicNameLength < pCompiled->minTopicLength ) ||
+             ( ( pTopicName[ 0 ] == '$' ) && ( pCompiled->pTokens[ 0 ].type != MQTTTopicTokenLiteral ) ) )
+    {
+        /* Too short to match, or a '$' topic against a leading wildcard. */
+        matchStatus = false;
+    }
+    else
+    {
+        /* nameIndex is the start of the next topic level, or one past the end of
+         * the topic name once its last level has been consumed. */
+        for( tokenIndex = 0U; ( tokenIndex < pCompiled->tokenCount ) && ( decided == false ); tokenIndex++ )
+        {
+            pToken = &pCompiled->pTokens[ tokenIndex ];
+
+            if( pToken->type == MQTTTopicTokenMultiLevel )
+            {
+                /* '#' matches the parent level and everything below it. */
+                matchStatus = true;
+                decided = true;
+            }
+            else if( nameIndex > topicNameLength )
+            {
+                /* The filter has more levels than the topic name. */
+                decided = true;
+            }
+            else if( pToken->type == MQTTTopicTokenSingleLevel )
+            {
+                pLevelEnd = memchr( &pTopicName[ nameIndex ], '/', topicNameLength - nameIndex );
+                spanEnd = ( pLevelEnd == NULL ) ? topicNameLength :
+                          ( uint32_t ) ( pLevelEnd - pTopicName );
+                nameIndex = spanEnd + 1U;
+            }
+            else
+            {
+                spanEnd = nameIndex + pToken->length;
+
+                /* The span must match byte for byte and end on a level boundary. */
+                if( ( spanEnd > topicNameLength ) ||
+                    ( memcmp( &pTopicName[ nameIndex ],
+                              &pCompiled->pTopicFilter[ pToken->offset ],
+                              pToken->length ) != 0 ) ||
+                    ( ( spanEnd < topicNameLength ) && ( pTopicName[ spanEnd ] != '/' ) ) )
+                {
+                    decided = true;
+                }
+
+                nameIndex = spanEnd + 1U;
+            }
+        }
+
+        if( decided == false )
+        {
+            matchStatus = ( nameIndex > topicNameLength );
+        }
+    }
+
+    if( status == MQTTSuccess )
+    {
+        *pIsMatch = matchStatus;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
 MQTTStatus_t MQTT_GetSubAckStatusCodes( const MQTTPacketInfo_t * pSubackPacket,
                                         uint8_t ** pPayloadStart,
                                         size_t * pPayloadSize )
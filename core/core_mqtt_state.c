@@ -308,13 +308,17 @@ static bool validateTransitionAck( MQTTPublishState_t currentState,
     {
         case MQTTPubAckSend:
         /* Incoming publish, QoS 1. */
+        case MQTTPubAckDeferred:
+        /* Incoming publish, QoS 1, acked by the application. */
         case MQTTPubAckPending:
             /* Outgoing publish, QoS 1. */
             isValid = newState == MQTTPublishDone;
             break;
 
         case MQTTPubRecSend:
-            /* Incoming publish, QoS 2. */
+        /* Incoming publish, QoS 2. */
+        case MQTTPubRecDeferred:
+            /* Incoming publish, QoS 2, acked by the application. */
             isValid = newState == MQTTPubRelPending;
             break;
 
@@ -496,6 +500,9 @@ static void compactRecords( MQTTPubAckInfo_t * records,
                 records[ emptyIndex ].packetId = records[ index ].packetId;
                 records[ emptyIndex ].qos = records[ index ].qos;
                 records[ emptyIndex ].publishState = records[ index ].publishState;
+                #if ( MQTT_METRICS_ENABLE != 0 )
+                    records[ emptyIndex ].sendTimeMs = records[ index ].sendTimeMs;
+                #endif
 
                 /* Mark the record at current non empty index as invalid. */
                 records[ index ].packetId = MQTT_PACKET_ID_INVALID;
@@ -941,6 +948,15 @@ MQTTStatus_t MQTT_UpdateStatePublish( const MQTTContext_t * pMqttContext,
         {
             *pNewState = newState;
         }
+
+        #if ( MQTT_METRICS_ENABLE != 0 )
+            /* The PUBLISH goes out right after this, time its ack from here. */
+            if( ( mqttStatus == MQTTSuccess ) && ( opType == MQTT_SEND ) &&
+                ( pMqttContext->getTime != NULL ) )
+            {
+                pMqttContext->outgoingPublishRecords[ recordIndex ].sendTimeMs = pMqttContext->getTime();
+            }
+        #endif
     }
 
     return mqttStatus;
@@ -996,6 +1012,141 @@ MQTTStatus_t MQTT_RemoveStateRecord( const MQTTContext_t * pMqttContext,
 
 /*-----------------------------------------------------------*/
 
+MQTTStatus_t MQTT_UpdateStateDeferAck( const MQTTContext_t * pMqttContext,
+                                       uint16_t packetId,
+                                       MQTTPublishState_t * pNewState )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    MQTTPublishState_t currentState = MQTTStateNull;
+    MQTTPublishState_t newState = MQTTStateNull;
+    MQTTQoS_t qos = MQTTQoS0;
+    size_t recordIndex = MQTT_INVALID_STATE_COUNT;
+
+    if( ( pMqttContext == NULL ) || ( pNewState == NULL ) ||
+        ( pMqttContext->incomingPublishRecords == NULL ) ||
+        ( packetId == MQTT_PACKET_ID_INVALID ) )
+    {
+        LogError( ( "Invalid parameter: pMqttContext=%p, pNewState=%p, packetId=%hu.",
+                    ( void * ) pMqttContext,
+                    ( void * ) pNewState,
+                    ( unsigned short ) packetId ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        recordIndex = findInRecord( pMqttContext->incomingPublishRecords,
+                                    pMqttContext->incomingPublishRecordMaxCount,
+                                    packetId,
+                                    &qos,
+                                    &currentState );
+
+        if( recordIndex == MQTT_INVALID_STATE_COUNT )
+        {
+            LogError( ( "No matching record found for publish: PacketId=%u.",
+                        ( unsigned int ) packetId ) );
+            status = MQTTBadParameter;
+        }
+    }
+
+    if( status == MQTTSuccess )
+    {
+        /* Only an ack that has not been sent yet can be deferred. */
+        if( currentState == MQTTPubAckSend )
+        {
+            newState = MQTTPubAckDeferred;
+        }
+        else if( currentState == MQTTPubRecSend )
+        {
+            newState = MQTTPubRecDeferred;
+        }
+        else
+        {
+            LogError( ( "Cannot defer the ack of publish %hu in state %s.",
+                        ( unsigned short ) packetId,
+                        MQTT_State_strerror( currentState ) ) );
+            status = MQTTIllegalState;
+        }
+    }
+
+    if( status == MQTTSuccess )
+    {
+        updateRecord( pMqttContext->incomingPublishRecords,
+                      recordIndex,
+                      newState,
+                      false );
+        *pNewState = newState;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTPublishState_t MQTT_GetIncomingPublishState( const MQTTContext_t * pMqttContext,
+                                                 uint16_t packetId,
+                                                 MQTTQoS_t * pQos )
+{
+    MQTTPublishState_t state = MQTTStateNull;
+    MQTTQoS_t qos = MQTTQoS0;
+
+    if( ( pMqttContext != NULL ) && ( pMqttContext->incomingPublishRecords != NULL ) &&
+        ( packetId != MQTT_PACKET_ID_INVALID ) )
+    {
+        ( void ) findInRecord( pMqttContext->incomingPublishRecords,
+                               pMqttContext->incomingPublishRecordMaxCount,
+                               packetId,
+                               &qos,
+                               &state );
+    }
+
+    if( pQos != NULL )
+    {
+        *pQos = qos;
+    }
+
+    return state;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_GetPublishSendTime( const MQTTContext_t * pMqttContext,
+                                      uint16_t packetId,
+                                      uint32_t * pSendTimeMs )
+{
+    MQTTStatus_t status = MQTTBadParameter;
+    MQTTPublishState_t state = MQTTStateNull;
+    MQTTQoS_t qos = MQTTQoS0;
+    size_t recordIndex;
+
+    if( ( pMqttContext != NULL ) && ( pMqttContext->outgoingPublishRecords != NULL ) &&
+        ( packetId != MQTT_PACKET_ID_INVALID ) && ( pSendTimeMs != NULL ) )
+    {
+        recordIndex = findInRecord( pMqttContext->outgoingPublishRecords,
+                                    pMqttContext->outgoingPublishRecordMaxCount,
+                                    packetId,
+                                    &qos,
+                                    &state );
+
+        if( recordIndex == MQTT_INVALID_STATE_COUNT )
+        {
+            status = MQTTBadResponse;
+        }
+        else
+        {
+            #if ( MQTT_METRICS_ENABLE != 0 )
+                *pSendTimeMs = pMqttContext->outgoingPublishRecords[ recordIndex ].sendTimeMs;
+            #else
+                *pSendTimeMs = 0U;
+            #endif
+            status = MQTTSuccess;
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
 MQTTStatus_t MQTT_UpdateStateAck( const MQTTContext_t * pMqttContext,
                                   uint16_t packetId,
                                   MQTTPubAckType_t packetType,
@@ -1194,6 +1345,14 @@ const char * MQTT_State_strerror( MQTTPublishState_t state )
             str = "MQTTPublishDone";
             break;
 
+        case MQTTPubAckDeferred:
+            str = "MQTTPubAckDeferred";
+            break;
+
+        case MQTTPubRecDeferred:
+            str = "MQTTPubRecDeferred";
+            break;
+
         default:
             /* Invalid state received. */
             str = "Invalid MQTT State";
@@ -0,0 +1,169 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_trace.c
+ * @brief Implements the functions in core_mqtt_trace.h.
+ */
+#include "core_mqtt_trace.h"
+
+/* Include config defaults header to get default values of configs. */
+#include "core_mqtt_config_defaults.h"
+
+/*-----------------------------------------------------------*/
+
+#if ( MQTT_TRACE_ENABLE != 0 )
+
+    #if ( ( MQTT_TRACE_BUFFER_COUNT & ( MQTT_TRACE_BUFFER_COUNT - 1 ) ) != 0 ) || ( MQTT_TRACE_BUFFER_COUNT < 2 )
+        #error MQTT_TRACE_BUFFER_COUNT must be a power of two.
+    #endif
+
+/**
+ * @brief Atomic access to the ring.
+ *
+ * A slot is written like a sequence lock: its sequence is cleared, the event
+ * stored and the sequence set again, so a reader that sees the same sequence
+ * before and after copying has a whole event. Without GCC or Clang builtins
+ * only one thread may record at a time.
+ */
+    #if defined( __GNUC__ ) || defined( __clang__ )
+        #define TRACE_CLAIM( pValue )             __atomic_fetch_add( ( pValue ), 1U, __ATOMIC_RELAXED )
+        #define TRACE_LOAD( pValue )              __atomic_load_n( ( pValue ), __ATOMIC_ACQUIRE )
+        #define TRACE_STORE( pValue, value )      __atomic_store_n( ( pValue ), ( value ), __ATOMIC_RELEASE )
+        #define TRACE_FENCE_RELEASE()             __atomic_thread_fence( __ATOMIC_RELEASE )
+        #define TRACE_FENCE_ACQUIRE()             __atomic_thread_fence( __ATOMIC_ACQUIRE )
+    #else
+        #define TRACE_CLAIM( pValue )             ( ( *( pValue ) )++ )
+        #define TRACE_LOAD( pValue )              ( *( pValue ) )
+        #define TRACE_STORE( pValue, value )      ( *( pValue ) = ( value ) )
+        #define TRACE_FENCE_RELEASE()
+        #define TRACE_FENCE_ACQUIRE()
+    #endif
+
+/**
+ * @brief The events, indexed by sequence modulo the ring size.
+ */
+    static MQTTTraceEvent_t traceRing[ MQTT_TRACE_BUFFER_COUNT ];
+
+/**
+ * @brief Number of events recorded, the sequence of the newest one.
+ */
+    static uint32_t traceRecorded = 0U;
+
+#endif /* if ( MQTT_TRACE_ENABLE != 0 ) */
+
+/*-----------------------------------------------------------*/
+
+void MQTT_TraceRecord( uint32_t timestampUs,
+                       MQTTTraceEventType_t event,
+                       uint16_t packetId,
+                       uint8_t detail,
+                       uint32_t length )
+{
+    #if ( MQTT_TRACE_ENABLE != 0 )
+        uint32_t sequence = TRACE_CLAIM( &traceRecorded ) + 1U;
+        MQTTTraceEvent_t * pSlot = &traceRing[ ( sequence - 1U ) & ( ( uint32_t ) MQTT_TRACE_BUFFER_COUNT - 1U ) ];
+
+        /* Sequence 0 marks a slot being written, so it is never handed out;
+         * the event taking it after 2^32 events is dropped. */
+        if( sequence != 0U )
+        {
+            TRACE_STORE( &pSlot->sequence, 0U );
+            TRACE_FENCE_RELEASE();
+
+            pSlot->timestampUs = timestampUs;
+            pSlot->length = length;
+            pSlot->packetId = packetId;
+            pSlot->event = ( uint8_t ) event;
+            pSlot->detail = detail;
+
+            TRACE_STORE( &pSlot->sequence, sequence );
+        }
+    #else /* if ( MQTT_TRACE_ENABLE != 0 ) */
+        ( void ) timestampUs;
+        ( void ) event;
+        ( void ) packetId;
+        ( void ) detail;
+        ( void ) length;
+    #endif /* if ( MQTT_TRACE_ENABLE != 0 ) */
+}
+
+/*-----------------------------------------------------------*/
+
+size_t MQTT_TraceRead( uint32_t * pCursor,
+                       MQTTTraceEvent_t * pEvents,
+                       size_t maxEvents )
+{
+    size_t count = 0U;
+
+    #if ( MQTT_TRACE_ENABLE != 0 )
+        uint32_t recorded;
+        uint32_t next;
+        const MQTTTraceEvent_t * pSlot;
+        MQTTTraceEvent_t event;
+
+        if( ( pCursor != NULL ) && ( pEvents != NULL ) )
+        {
+            recorded = TRACE_LOAD( &traceRecorded );
+            next = *pCursor + 1U;
+
+            /* Skip what has been overwritten since the last read. */
+            if( ( recorded - *pCursor ) > ( uint32_t ) MQTT_TRACE_BUFFER_COUNT )
+            {
+                next = recorded - ( uint32_t ) MQTT_TRACE_BUFFER_COUNT + 1U;
+            }
+
+            while( ( count < maxEvents ) && ( ( int32_t ) ( recorded - next ) >= 0 ) )
+            {
+                pSlot = &traceRing[ ( next - 1U ) & ( ( uint32_t ) MQTT_TRACE_BUFFER_COUNT - 1U ) ];
+
+                if( TRACE_LOAD( &pSlot->sequence ) == next )
+                {
+                    event = *pSlot;
+                    TRACE_FENCE_ACQUIRE();
+
+                    /* Keep it only if no writer took the slot meanwhile. */
+                    if( TRACE_LOAD( &pSlot->sequence ) == next )
+                    {
+                        event.sequence = next;
+                        pEvents[ count ] = event;
+                        count++;
+                    }
+                }
+
+                next++;
+            }
+
+            *pCursor = next - 1U;
+        }
+    #else /* if ( MQTT_TRACE_ENABLE != 0 ) */
+        ( void ) pCursor;
+        ( void ) pEvents;
+        ( void ) maxEvents;
+    #endif /* if ( MQTT_TRACE_ENABLE != 0 ) */
+
+    return count;
+}
+
+/*-----------------------------------------------------------*/
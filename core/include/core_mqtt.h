@@ -41,6 +41,9 @@
 /* Include transport interface. */
 #include "transport_interface.h"
 
+/* The context layout depends on MQTT_METRICS_ENABLE. */
+#include "core_mqtt_config_defaults.h"
+
 /**
  * @cond DOXYGEN_IGNORE
  * The current version of this library.
@@ -59,6 +62,12 @@
  */
 #define MQTT_PACKET_ID_INVALID    ( ( uint16_t ) 0U )
 
+/**
+ * @ingroup mqtt_constants
+ * @brief Number of buckets in a #MQTTLatencyHistogram_t.
+ */
+#define MQTT_LATENCY_BUCKET_COUNT    ( 16U )
+
 /* Structures defined in this file. */
 struct MQTTPubAckInfo;
 struct MQTTContext;
@@ -107,6 +116,18 @@ typedef void (* MQTTEventCallback_t )( struct MQTTContext * pContext,
                                        struct MQTTPacketInfo * pPacketInfo,
                                        struct MQTTDeserializedInfo * pDeserializedInfo );
 
+/**
+ * @brief User defined callback reporting how many received messages are still
+ * waiting for their consumers. Used by #MQTT_SetFlowControl.
+ *
+ * @param[in] pUserData The user data passed to #MQTT_SetFlowControl.
+ *
+ * @return Current depth of the consumer queue.
+ */
+/* @[define_mqtt_flowcontroldepth] */
+typedef size_t ( * MQTTFlowControlDepth_t )( void * pUserData );
+/* @[define_mqtt_flowcontroldepth] */
+
 /**
  * @brief User defined callback used to store outgoing publishes. Used to track any publish
  * retransmit on an unclean session connection.
@@ -166,7 +187,9 @@ typedef enum MQTTConnectionStatus
 {
     MQTTNotConnected,     /**< @brief MQTT Connection is inactive. */
     MQTTConnected,        /**< @brief MQTT Connection is active. */
-    MQTTDisconnectPending /**< @brief MQTT Connection needs to be disconnected as a transport error has occurred. */
+    MQTTDisconnectPending, /**< @brief MQTT Connection needs to be disconnected as a transport error has occurred. */
+    MQTTConnackPending,    /**< @brief CONNECT was sent by #MQTT_SendConnect and the CONNACK has not arrived yet. */
+    MQTTConnecting         /**< @brief #MQTT_ConnectAsync is waiting for the transport to connect. */
 } MQTTConnectionStatus_t;
 
 /**
@@ -185,7 +208,9 @@ typedef enum MQTTPublishState
     MQTTPubRecPending,  /**< @brief The library is awaiting a PUBREC for an outgoing PUBLISH. */
     MQTTPubRelPending,  /**< @brief The library is awaiting a PUBREL for an incoming PUBLISH. */
     MQTTPubCompPending, /**< @brief The library is awaiting a PUBCOMP for an outgoing PUBLISH. */
-    MQTTPublishDone     /**< @brief The PUBLISH has been completed. */
+    MQTTPublishDone,    /**< @brief The PUBLISH has been completed. */
+    MQTTPubAckDeferred, /**< @brief The application will ack a received QoS 1 PUBLISH with #MQTT_AckIncomingPublish. */
+    MQTTPubRecDeferred  /**< @brief The application will ack a received QoS 2 PUBLISH with #MQTT_AckIncomingPublish. */
 } MQTTPublishState_t;
 
 /**
@@ -212,6 +237,46 @@ typedef enum MQTTSubAckStatus
     MQTTSubAckFailure = 0x80      /**< @brief Failure. */
 } MQTTSubAckStatus_t;
 
+/**
+ * @ingroup mqtt_enum_types
+ * @brief Kinds of tokens in a topic filter compiled by #MQTT_CompileTopicFilter.
+ */
+typedef enum MQTTTopicTokenType
+{
+    MQTTTopicTokenLiteral = 0, /**< @brief One or more literal levels, separators included. */
+    MQTTTopicTokenSingleLevel, /**< @brief A '+' level. */
+    MQTTTopicTokenMultiLevel   /**< @brief A trailing '#' level. */
+} MQTTTopicTokenType_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief A token of a compiled topic filter.
+ */
+typedef struct MQTTTopicToken
+{
+    uint16_t offset;           /**< @brief Offset of the token in the topic filter. */
+    uint16_t length;           /**< @brief Length of a literal span, 1 for wildcards. */
+    MQTTTopicTokenType_t type; /**< @brief Kind of the token. */
+} MQTTTopicToken_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief A topic filter pre-parsed for repeated matching with
+ * #MQTT_MatchCompiledTopic.
+ *
+ * @note The compiled filter references the filter string, which must stay
+ * valid for as long as the compiled filter is used.
+ */
+typedef struct MQTTCompiledTopicFilter
+{
+    const char * pTopicFilter;   /**< @brief The topic filter string. */
+    uint16_t topicFilterLength;  /**< @brief Length of the topic filter. */
+    MQTTTopicToken_t * pTokens;  /**< @brief Token array provided by the application. */
+    uint16_t tokenCount;         /**< @brief Number of valid tokens in pTokens. */
+    uint16_t minTopicLength;     /**< @brief Shortest topic name that can match. */
+    bool hasWildcard;            /**< @brief Whether the filter contains '+' or '#'. */
+} MQTTCompiledTopicFilter_t;
+
 /**
  * @ingroup mqtt_struct_types
  * @brief An element of the state engine records for QoS 1 or Qos 2 publishes.
@@ -221,8 +286,58 @@ typedef struct MQTTPubAckInfo
     uint16_t packetId;               /**< @brief The packet ID of the original PUBLISH. */
     MQTTQoS_t qos;                   /**< @brief The QoS of the original PUBLISH. */
     MQTTPublishState_t publishState; /**< @brief The current state of the publish process. */
+    #if ( MQTT_METRICS_ENABLE != 0 )
+        uint32_t sendTimeMs;         /**< @brief When an outgoing PUBLISH was last sent. */
+    #endif
 } MQTTPubAckInfo_t;
 
+/**
+ * @ingroup mqtt_struct_types
+ * @brief A histogram of round-trip times in milliseconds.
+ *
+ * Bucket 0 counts times under 1 ms, bucket i those from 2^(i-1) up to
+ * 2^i - 1 ms and the last bucket everything from 2^14 ms on. Use
+ * #MQTT_LatencyPercentile to read percentiles from it.
+ */
+typedef struct MQTTLatencyHistogram
+{
+    uint32_t buckets[ MQTT_LATENCY_BUCKET_COUNT ]; /**< @brief Samples by bucket. */
+    uint32_t count;                                /**< @brief Number of samples. */
+    uint32_t totalMs;                              /**< @brief Sum of the samples, for the mean. */
+    uint32_t maxMs;                                /**< @brief Largest sample. */
+} MQTTLatencyHistogram_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief Runtime counters of a context, counted when #MQTT_METRICS_ENABLE is 1
+ * and left at zero otherwise.
+ *
+ * All counters are 32 bits wide and wrap; compare two snapshots taken with
+ * #MQTT_GetMetrics to get rates. Packet counters are indexed by the packet
+ * type, the high nibble of the first byte, e.g. PINGREQ at 12 and PINGRESP at
+ * 13. Round trips are timed with the context's millisecond clock.
+ */
+typedef struct MQTTMetrics
+{
+    uint32_t packetsSent[ 16 ];     /**< @brief Packets fully sent, by type. */
+    uint32_t packetsReceived[ 16 ]; /**< @brief Packets received and handled, by type. */
+    uint32_t bytesSent;             /**< @brief Bytes taken by the transport send. */
+    uint32_t bytesReceived;         /**< @brief Bytes returned by the transport receive. */
+    uint32_t sendRetries;           /**< @brief Transport sends that took no bytes and were tried again. */
+    uint32_t partialSends;          /**< @brief Transport sends that took only part of the bytes. */
+    uint32_t sendTimeouts;          /**< @brief Packets not sent within #MQTT_SEND_TIMEOUT_MS. */
+    uint32_t recvTimeouts;          /**< @brief Packets not completed within #MQTT_RECV_POLLING_TIMEOUT_MS. */
+    uint32_t discardedPackets;      /**< @brief Packets larger than the network buffer, read and dropped. */
+    uint32_t discardedBytes;        /**< @brief Bytes of those packets. */
+    uint32_t memmoveBytes;          /**< @brief Bytes moved to the front of the network buffer after a packet. */
+    uint32_t stateCollisions;       /**< @brief PUBLISHes already in the state engine. */
+    uint32_t keepAliveTimeouts;     /**< @brief PINGRESPs or CONNACKs that did not come in time. */
+
+    MQTTLatencyHistogram_t publishAck;      /**< @brief QoS 1 PUBLISH to PUBACK. */
+    MQTTLatencyHistogram_t publishComplete; /**< @brief QoS 2 PUBLISH to PUBCOMP. */
+    MQTTLatencyHistogram_t pingResponse;    /**< @brief PINGREQ to PINGRESP. */
+} MQTTMetrics_t;
+
 /**
  * @ingroup mqtt_struct_types
  * @brief A struct representing an MQTT connection.
@@ -304,6 +419,22 @@ typedef struct MQTTContext
     uint16_t keepAliveIntervalSec; /**< @brief Keep Alive interval. */
     uint32_t pingReqSendTimeMs;    /**< @brief Timestamp of the last sent PINGREQ. */
     bool waitingForPingResp;       /**< @brief If the library is currently awaiting a PINGRESP. */
+    uint32_t connectStartTimeMs;   /**< @brief Timestamp the current step of a non-blocking connect started at. */
+
+    /* Deferred acknowledgement members. */
+    size_t deferredAckCount; /**< @brief Incoming publishes whose ack the application deferred. */
+    size_t deferredAckMax;   /**< @brief Receiving pauses while this many acks are deferred, 0 for no limit. */
+
+    /* Receive flow control members. */
+    MQTTFlowControlDepth_t getConsumerDepth; /**< @brief Reports the consumer queue depth, NULL to disable. */
+    void * pFlowControlUserData;             /**< @brief Passed to getConsumerDepth. */
+    size_t flowHighWatermark;                /**< @brief Receiving pauses once the depth reaches this. */
+    size_t flowLowWatermark;                 /**< @brief Receiving resumes once the depth is down to this. */
+    bool flowPaused;                         /**< @brief If receiving is paused by flow control. */
+
+    /* Non-blocking connect members. */
+    const MQTTConnectInfo_t * pConnectInfo; /**< @brief CONNECT to send once #MQTT_ConnectAsync has a transport. */
+    const MQTTPublishInfo_t * pWillInfo;    /**< @brief Will of that CONNECT, may be NULL. */
 
     /**
      * @brief User defined API used to store outgoing publishes.
@@ -319,6 +450,14 @@ typedef struct MQTTContext
      * @brief User defined API used to clear a particular copied publish packet.
      */
     MQTTClearPacketForRetransmit clearFunction;
+
+    #if ( MQTT_METRICS_ENABLE != 0 )
+
+        /**
+         * @brief Runtime counters, see #MQTT_GetMetrics.
+         */
+        MQTTMetrics_t metrics;
+    #endif
 } MQTTContext_t;
 
 /**
@@ -331,6 +470,13 @@ typedef struct MQTTDeserializedInfo
     uint16_t packetIdentifier;          /**< @brief Packet ID of deserialized packet. */
     MQTTPublishInfo_t * pPublishInfo;   /**< @brief Pointer to deserialized publish info. */
     MQTTStatus_t deserializationResult; /**< @brief Return code of deserialization. */
+
+    /**
+     * @brief Set by the callback of an incoming QoS 1 or 2 PUBLISH to send its
+     * PUBACK or PUBREC later with #MQTT_AckIncomingPublish instead of right
+     * after the callback returns.
+     */
+    bool deferAck;
 } MQTTDeserializedInfo_t;
 
 /**
@@ -714,6 +860,78 @@ MQTTStatus_t MQTT_Connect( MQTTContext_t * pContext,
                            bool * pSessionPresent );
 /* @[declare_mqtt_connect] */
 
+/**
+ * @brief Send a CONNECT packet without waiting for the CONNACK.
+ *
+ * This is the pipelined counterpart of #MQTT_Connect. The connection enters
+ * the #MQTTConnackPending state, in which #MQTT_Subscribe, #MQTT_Publish and
+ * #MQTT_Unsubscribe may already be called, so their packets leave in the same
+ * flight as the CONNECT (MQTT 3.1.1 section 3.1.4 allows a client to send
+ * packets before the CONNACK arrives). The CONNACK is then handled by
+ * #MQTT_ProcessLoop or #MQTT_ReceiveLoop like any other incoming packet: it is
+ * passed to the event callback and moves the connection to #MQTTConnected.
+ *
+ * Only clean sessions can be pipelined, since nothing can be resent before the
+ * broker has told us whether it kept the session.
+ *
+ * @param[in] pContext Initialized MQTT context.
+ * @param[in] pConnectInfo MQTT CONNECT packet information. cleanSession must be true.
+ * @param[in] pWillInfo Last Will and Testament. Pass NULL if not used.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed or a persistent
+ * session is requested;
+ * #MQTTStatusConnected or #MQTTStatusDisconnectPending if a connection exists;
+ * #MQTTSendFailed if transport send failed;
+ * #MQTTSuccess otherwise.
+ *
+ * @note The loop functions return #MQTTServerRefused if the broker refuses the
+ * connection and #MQTTBadResponse if the CONNACK reports a session.
+ * #MQTT_ProcessLoop also returns #MQTTKeepAliveTimeout if no CONNACK arrives
+ * within #MQTT_CONNACK_TIMEOUT_MS.
+ */
+/* @[declare_mqtt_sendconnect] */
+MQTTStatus_t MQTT_SendConnect( MQTTContext_t * pContext,
+                               const MQTTConnectInfo_t * pConnectInfo,
+                               const MQTTPublishInfo_t * pWillInfo );
+/* @[declare_mqtt_sendconnect] */
+
+/**
+ * @brief Start a connection without blocking.
+ *
+ * The whole connection setup is driven by #MQTT_ProcessLoop or
+ * #MQTT_ReceiveLoop. While the context is #MQTTConnecting, each loop call runs
+ * one step of TransportInterface_t.connect. Once that reports a connected
+ * transport, the CONNECT is sent as by #MQTT_SendConnect and the CONNACK is
+ * received by the loop. A single thread can bring up many connections this
+ * way by calling the loop of each context in turn.
+ *
+ * If TransportInterface_t.connect is NULL, the transport is taken to be
+ * connected already and the CONNECT is sent immediately.
+ *
+ * @param[in] pContext Initialized MQTT context.
+ * @param[in] pConnectInfo MQTT CONNECT packet information. cleanSession must
+ * be true. It is referenced, not copied, and must stay valid until the
+ * CONNECT was sent.
+ * @param[in] pWillInfo Last Will and Testament. Pass NULL if not used. Same
+ * lifetime as pConnectInfo.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed or a persistent
+ * session is requested;
+ * #MQTTStatusConnected or #MQTTStatusDisconnectPending if a connection exists;
+ * #MQTTSendFailed if transport send failed;
+ * #MQTTSuccess otherwise.
+ *
+ * @note The loop functions return #MQTTSendFailed if the transport could not
+ * connect, and #MQTTKeepAliveTimeout if it did not connect within
+ * #MQTT_TRANSPORT_CONNECT_TIMEOUT_MS. In both cases the context is back in
+ * #MQTTNotConnected. CONNACK errors are reported as for #MQTT_SendConnect.
+ */
+/* @[declare_mqtt_connectasync] */
+MQTTStatus_t MQTT_ConnectAsync( MQTTContext_t * pContext,
+                                const MQTTConnectInfo_t * pConnectInfo,
+                                const MQTTPublishInfo_t * pWillInfo );
+/* @[declare_mqtt_connectasync] */
+
 /**
  * @brief Sends MQTT SUBSCRIBE for the given list of topic filters to
  * the broker.
@@ -926,6 +1144,9 @@ MQTTStatus_t MQTT_Unsubscribe( MQTTContext_t * pContext,
 /**
  * @brief Disconnect an MQTT session.
  *
+ * A non-blocking connect still in #MQTTConnecting is abandoned without
+ * sending anything.
+ *
  * @param[in] pContext Initialized and connected MQTT context.
  *
  * @return #MQTTNoMemory if the #MQTTContext_t.networkBuffer is too small to
@@ -1076,6 +1297,142 @@ MQTTStatus_t MQTT_ReceiveLoop( MQTTContext_t * pContext );
 uint16_t MQTT_GetPacketId( MQTTContext_t * pContext );
 /* @[declare_mqtt_getpacketid] */
 
+/**
+ * @brief Send the PUBACK or PUBREC of an incoming PUBLISH whose callback set
+ * #MQTTDeserializedInfo_t.deferAck.
+ *
+ * Lets the application acknowledge a message only once it has been processed,
+ * for example by a worker thread. Must be called from the context that runs
+ * #MQTT_ProcessLoop, like every other send. The state record of the publish
+ * stays in #MQTTPubAckDeferred or #MQTTPubRecDeferred until then, so a
+ * duplicate sent by the broker after a reconnect is neither delivered nor
+ * acked a second time.
+ *
+ * @param[in] pContext Initialized and connected MQTT context.
+ * @param[in] packetId Packet ID of the incoming PUBLISH.
+ * @param[in] qos QoS of the incoming PUBLISH.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed or there is no
+ * incoming PUBLISH with this ID and QoS waiting for its ack;
+ * #MQTTStatusNotConnected or #MQTTStatusDisconnectPending if the connection
+ * is gone; #MQTTSendFailed if the ack could not be sent; #MQTTSuccess otherwise.
+ */
+/* @[declare_mqtt_ackincomingpublish] */
+MQTTStatus_t MQTT_AckIncomingPublish( MQTTContext_t * pContext,
+                                      uint16_t packetId,
+                                      MQTTQoS_t qos );
+/* @[declare_mqtt_ackincomingpublish] */
+
+/**
+ * @brief Bound the number of incoming publishes whose ack may be deferred.
+ *
+ * Once @p maxCount acks are outstanding, #MQTT_ProcessLoop and
+ * #MQTT_ReceiveLoop stop reading from the network until the application acks
+ * one of them with #MQTT_AckIncomingPublish. Keep-alive is still serviced
+ * while receiving is paused. #MQTT_InitStatefulQoS sets the limit to the
+ * number of incoming publish records.
+ *
+ * @param[in] pContext Initialized MQTT context.
+ * @param[in] maxCount Largest number of deferred acks, 0 for no limit.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed;
+ * #MQTTSuccess otherwise.
+ */
+/* @[declare_mqtt_setdeferredacklimit] */
+MQTTStatus_t MQTT_SetDeferredAckLimit( MQTTContext_t * pContext,
+                                       size_t maxCount );
+/* @[declare_mqtt_setdeferredacklimit] */
+
+/**
+ * @brief Stop reading from the network while consumers fall behind.
+ *
+ * Before each read, #MQTT_ProcessLoop and #MQTT_ReceiveLoop ask @p getDepth
+ * how many received messages are still queued for the application. Once it
+ * reaches @p highWatermark they stop calling the transport receive function,
+ * so the TCP window fills and the broker has to slow down. Reading resumes
+ * once the depth is down to @p lowWatermark. Keep-alive and acks sent by the
+ * application are still serviced while paused.
+ *
+ * @param[in] pContext Initialized MQTT context.
+ * @param[in] getDepth Reports the consumer queue depth, NULL to disable.
+ * @param[in] pUserData Passed to @p getDepth.
+ * @param[in] highWatermark Depth at which receiving pauses.
+ * @param[in] lowWatermark Depth at which receiving resumes, below @p highWatermark.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed;
+ * #MQTTSuccess otherwise.
+ */
+/* @[declare_mqtt_setflowcontrol] */
+MQTTStatus_t MQTT_SetFlowControl( MQTTContext_t * pContext,
+                                  MQTTFlowControlDepth_t getDepth,
+                                  void * pUserData,
+                                  size_t highWatermark,
+                                  size_t lowWatermark );
+/* @[declare_mqtt_setflowcontrol] */
+
+/**
+ * @brief Check whether receiving is paused, either because too many acks are
+ * deferred or because flow control stopped it.
+ *
+ * Lets an event loop stop polling the socket for reads while paused.
+ *
+ * @param[in] pContext Initialized MQTT context.
+ *
+ * @return true if #MQTT_ProcessLoop will not read from the network.
+ */
+/* @[declare_mqtt_isreceivepaused] */
+bool MQTT_IsReceivePaused( const MQTTContext_t * pContext );
+/* @[declare_mqtt_isreceivepaused] */
+
+/**
+ * @brief Take a snapshot of the runtime counters of a context.
+ *
+ * Each counter is read atomically, but the snapshot as a whole is not: a
+ * packet sent meanwhile by another thread may be in its byte count and not
+ * yet in its packet count. All counters are zero unless the library is built
+ * with #MQTT_METRICS_ENABLE.
+ *
+ * @param[in] pContext Initialized MQTT context.
+ * @param[out] pMetrics Receives the counters.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed;
+ * #MQTTSuccess otherwise.
+ */
+/* @[declare_mqtt_getmetrics] */
+MQTTStatus_t MQTT_GetMetrics( const MQTTContext_t * pContext,
+                              MQTTMetrics_t * pMetrics );
+/* @[declare_mqtt_getmetrics] */
+
+/**
+ * @brief Set the runtime counters of a context back to zero.
+ *
+ * @param[in] pContext Initialized MQTT context.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed;
+ * #MQTTSuccess otherwise.
+ */
+/* @[declare_mqtt_resetmetrics] */
+MQTTStatus_t MQTT_ResetMetrics( MQTTContext_t * pContext );
+/* @[declare_mqtt_resetmetrics] */
+
+/**
+ * @brief Estimate a percentile of a latency histogram.
+ *
+ * The result is the top of the bucket holding the percentile, capped at the
+ * largest sample, so it may overstate the true value by up to a factor of
+ * two.
+ *
+ * @param[in] pHistogram Histogram taken with #MQTT_GetMetrics.
+ * @param[in] percent Percentile, from 0 to 100.
+ *
+ * @return The percentile in milliseconds, 0 if the histogram is empty or
+ * NULL.
+ */
+/* @[declare_mqtt_latencypercentile] */
+uint32_t MQTT_LatencyPercentile( const MQTTLatencyHistogram_t * pHistogram,
+                                 uint32_t percent );
+/* @[declare_mqtt_latencypercentile] */
+
 /**
  * @brief A utility function that determines whether the passed topic filter and
  * topic name match according to the MQTT 3.1.1 protocol specification.
@@ -1126,6 +1483,70 @@ MQTTStatus_t MQTT_MatchTopic( const char * pTopicName,
                               const uint16_t topicFilterLength,
                               bool * pIsMatch );
 
+/**
+ * @brief Parse a topic filter once so it can be matched repeatedly with
+ * #MQTT_MatchCompiledTopic.
+ *
+ * Consecutive literal levels are merged into a single span, so that matching
+ * compares them with one length check and one memcmp instead of walking the
+ * filter character by character.
+ *
+ * @param[in] pTopicFilter The topic filter to compile. It must outlive @p pCompiled.
+ * @param[in] topicFilterLength Length of the topic filter.
+ * @param[in] pTokens Array to hold the tokens of the filter. A filter with N
+ * levels needs at most N tokens.
+ * @param[in] tokenMaxCount Number of elements in @p pTokens.
+ * @param[out] pCompiled The compiled topic filter.
+ *
+ * @return #MQTTBadParameter if a parameter is NULL, the filter is not a valid
+ * MQTT topic filter or @p pTokens is too small; #MQTTSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * const char * pFilter = "site/+/building/#";
+ * MQTTTopicToken_t tokens[ 4 ];
+ * MQTTCompiledTopicFilter_t compiled;
+ * bool match = false;
+ *
+ * if( MQTT_CompileTopicFilter( pFilter, strlen( pFilter ), tokens, 4, &compiled ) == MQTTSuccess )
+ * {
+ *      // Compile once, then match every incoming topic name.
+ *      ( void ) MQTT_MatchCompiledTopic( "site/eu/building/3", 18, &compiled, &match );
+ * }
+ * @endcode
+ */
+/* @[declare_mqtt_compiletopicfilter] */
+MQTTStatus_t MQTT_CompileTopicFilter( const char * pTopicFilter,
+                                      uint16_t topicFilterLength,
+                                      MQTTTopicToken_t * pTokens,
+                                      uint16_t tokenMaxCount,
+                                      MQTTCompiledTopicFilter_t * pCompiled );
+/* @[declare_mqtt_compiletopicfilter] */
+
+/**
+ * @brief Match a topic name against a topic filter compiled with
+ * #MQTT_CompileTopicFilter.
+ *
+ * Wildcard semantics follow the MQTT 3.1.1 specification, including '#'
+ * matching the parent level ("sport/+/#" matches "sport/tennis") and
+ * wildcards at the first level not matching topics starting with '$'.
+ *
+ * @param[in] pTopicName The topic name to check.
+ * @param[in] topicNameLength Length of the topic name.
+ * @param[in] pCompiled The compiled topic filter.
+ * @param[out] pIsMatch Set to whether the topic name matches the filter.
+ *
+ * @return #MQTTBadParameter if any of the input parameters is invalid;
+ * #MQTTSuccess otherwise.
+ */
+/* @[declare_mqtt_matchcompiledtopic] */
+MQTTStatus_t MQTT_MatchCompiledTopic( const char * pTopicName,
+                                      uint16_t topicNameLength,
+                                      const MQTTCompiledTopicFilter_t * pCompiled,
+                                      bool * pIsMatch );
+/* @[declare_mqtt_matchcompiledtopic] */
+
 /**
  * @brief Parses the payload of an MQTT SUBACK packet that contains status codes
  * corresponding to topic filter subscription requests from the original
@@ -118,6 +118,37 @@
     #define MQTT_PINGRESP_TIMEOUT_MS    ( 5000U )
 #endif
 
+/**
+ * @brief Maximum number of milliseconds to wait for the CONNACK of a CONNECT
+ * sent with #MQTT_SendConnect.
+ *
+ * If no CONNACK is received before this timeout, #MQTT_ProcessLoop returns
+ * #MQTTKeepAliveTimeout.
+ *
+ * <b>Possible values:</b> Any positive 32 bit integer. <br>
+ * <b>Default value:</b> `10000`
+ */
+#ifndef MQTT_CONNACK_TIMEOUT_MS
+/* Wait 10 seconds by default for a pipelined CONNACK. */
+    #define MQTT_CONNACK_TIMEOUT_MS    ( 10000U )
+#endif
+
+/**
+ * @brief Maximum number of milliseconds the transport may take to connect
+ * after #MQTT_ConnectAsync.
+ *
+ * If TransportInterface_t.connect has not reported a connected transport
+ * before this timeout, #MQTT_ProcessLoop and #MQTT_ReceiveLoop return
+ * #MQTTKeepAliveTimeout.
+ *
+ * <b>Possible values:</b> Any positive 32 bit integer. <br>
+ * <b>Default value:</b> `10000`
+ */
+#ifndef MQTT_TRANSPORT_CONNECT_TIMEOUT_MS
+/* Allow 10 seconds by default for name resolution and TCP connect. */
+    #define MQTT_TRANSPORT_CONNECT_TIMEOUT_MS    ( 10000U )
+#endif
+
 /**
  * @brief Maximum number of milliseconds of TX inactivity to wait
  * before initiating a PINGREQ
@@ -192,6 +223,82 @@
     #define MQTT_SEND_TIMEOUT_MS    ( 20000U )
 #endif
 
+/**
+ * @brief Select the implementation used by #MQTT_MatchTopic to compare literal
+ * characters and to find '/' level separators.
+ *
+ * When enabled, runs of equal characters are compared and separators are
+ * searched 16 bytes at a time with SSE2 or NEON if the compiler targets them,
+ * and a machine word at a time otherwise. When disabled, the portable byte
+ * by byte loops are used. Both produce the same results.
+ *
+ * <b>Possible values:</b> `0` or `1`. <br>
+ * <b>Default value:</b> `1`
+ */
+#ifndef MQTT_TOPIC_MATCH_ACCELERATION
+    #define MQTT_TOPIC_MATCH_ACCELERATION    ( 1 )
+#endif
+
+/**
+ * @brief Keep runtime counters in each #MQTTContext_t.
+ *
+ * When enabled, the context counts packets sent and received by type, bytes
+ * in and out, retried and partial sends, receive timeouts, discarded packets,
+ * bytes moved in the network buffer, state collisions and keep-alive
+ * timeouts, and keeps histograms of the PUBACK, PUBCOMP and PINGRESP round
+ * trips. Each outgoing QoS 1 or 2 PUBLISH is timed from its state record.
+ * #MQTT_GetMetrics takes a snapshot and #MQTT_ResetMetrics clears them. The
+ * counters are 32 bits wide and wrap; they are updated with relaxed atomic
+ * adds on GCC and Clang, so a reader and a writer thread may share a context.
+ * When disabled, no counting code is generated.
+ *
+ * <b>Possible values:</b> `0` or `1`. <br>
+ * <b>Default value:</b> `0`
+ */
+#ifndef MQTT_METRICS_ENABLE
+    #define MQTT_METRICS_ENABLE    ( 0 )
+#endif
+
+/**
+ * @brief Record trace events at the tracepoints of core_mqtt.c.
+ *
+ * When enabled, receiving, parsing and deserializing a packet, entering and
+ * leaving the application callback, sending a packet or an ack and changing
+ * the state of a publish each record a 16-byte event in the ring of
+ * core_mqtt_trace.h, read back with #MQTT_TraceRead. When disabled, the
+ * tracepoints generate no code and the ring takes no memory.
+ *
+ * <b>Possible values:</b> `0` or `1`. <br>
+ * <b>Default value:</b> `0`
+ */
+#ifndef MQTT_TRACE_ENABLE
+    #define MQTT_TRACE_ENABLE    ( 0 )
+#endif
+
+/**
+ * @brief Number of events the trace ring holds before the oldest are
+ * overwritten.
+ *
+ * <b>Possible values:</b> Any power of two from 2. <br>
+ * <b>Default value:</b> `256`
+ */
+#ifndef MQTT_TRACE_BUFFER_COUNT
+    #define MQTT_TRACE_BUFFER_COUNT    ( 256 )
+#endif
+
+/**
+ * @brief Timestamp of a trace event in microseconds, for the context given.
+ *
+ * The core only has the millisecond clock of the context, so the default
+ * scales that; map this to a microsecond counter of the platform for a finer
+ * timeline. It only needs to be monotonic and may wrap at 32 bits.
+ *
+ * <b>Default value:</b> The context's `getTime()` times 1000.
+ */
+#ifndef MQTT_TRACE_TIMESTAMP_US
+    #define MQTT_TRACE_TIMESTAMP_US( pContext )    ( ( pContext )->getTime() * 1000U )
+#endif
+
 #ifdef MQTT_SEND_RETRY_TIMEOUT_MS
     #error MQTT_SEND_RETRY_TIMEOUT_MS is deprecated. Instead use MQTT_SEND_TIMEOUT_MS.
 #endif
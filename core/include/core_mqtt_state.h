@@ -144,6 +144,76 @@ MQTTStatus_t MQTT_RemoveStateRecord( const MQTTContext_t * pMqttContext,
                                      uint16_t packetId );
 /** @endcond */
 
+/**
+ * @fn MQTTStatus_t MQTT_UpdateStateDeferAck( const MQTTContext_t * pMqttContext, uint16_t packetId, MQTTPublishState_t * pNewState );
+ * @brief Mark an incoming PUBLISH as waiting for the application to ack it.
+ *
+ * Moves the record from #MQTTPubAckSend or #MQTTPubRecSend to
+ * #MQTTPubAckDeferred or #MQTTPubRecDeferred.
+ *
+ * @param[in] pMqttContext Initialized MQTT context.
+ * @param[in] packetId ID of the incoming PUBLISH packet.
+ * @param[out] pNewState Updated state of the publish.
+ *
+ * @return #MQTTBadParameter if an invalid parameter is passed or there is no
+ * record for the packet; #MQTTIllegalState if the ack was already sent;
+ * #MQTTSuccess otherwise.
+ */
+
+/**
+ * @cond DOXYGEN_IGNORE
+ * Doxygen should ignore this definition, this function is private.
+ */
+MQTTStatus_t MQTT_UpdateStateDeferAck( const MQTTContext_t * pMqttContext,
+                                       uint16_t packetId,
+                                       MQTTPublishState_t * pNewState );
+/** @endcond */
+
+/**
+ * @fn MQTTPublishState_t MQTT_GetIncomingPublishState( const MQTTContext_t * pMqttContext, uint16_t packetId, MQTTQoS_t * pQos );
+ * @brief Look up the state of an incoming PUBLISH.
+ *
+ * @param[in] pMqttContext Initialized MQTT context.
+ * @param[in] packetId ID of the incoming PUBLISH packet.
+ * @param[out] pQos QoS of the record, may be NULL.
+ *
+ * @return The state of the record, #MQTTStateNull if there is none.
+ */
+
+/**
+ * @cond DOXYGEN_IGNORE
+ * Doxygen should ignore this definition, this function is private.
+ */
+MQTTPublishState_t MQTT_GetIncomingPublishState( const MQTTContext_t * pMqttContext,
+                                                 uint16_t packetId,
+                                                 MQTTQoS_t * pQos );
+/** @endcond */
+
+/**
+ * @fn MQTTStatus_t MQTT_GetPublishSendTime( const MQTTContext_t * pMqttContext, uint16_t packetId, uint32_t * pSendTimeMs );
+ * @brief Look up when an outgoing PUBLISH was last sent.
+ *
+ * The time is only kept when #MQTT_METRICS_ENABLE is 1, otherwise it reads
+ * as 0.
+ *
+ * @param[in] pMqttContext Initialized MQTT context.
+ * @param[in] packetId ID of the outgoing PUBLISH packet.
+ * @param[out] pSendTimeMs Time of the send, from the context's clock.
+ *
+ * @return #MQTTBadParameter if an invalid parameter is passed;
+ * #MQTTBadResponse if there is no record for the packet;
+ * #MQTTSuccess otherwise.
+ */
+
+/**
+ * @cond DOXYGEN_IGNORE
+ * Doxygen should ignore this definition, this function is private.
+ */
+MQTTStatus_t MQTT_GetPublishSendTime( const MQTTContext_t * pMqttContext,
+                                      uint16_t packetId,
+                                      uint32_t * pSendTimeMs );
+/** @endcond */
+
 /**
  * @fn MQTTPublishState_t MQTT_CalculateStateAck( MQTTPubAckType_t packetType, MQTTStateOperation_t opType, MQTTQoS_t qos );
  * @brief Calculate the state from a PUBACK, PUBREC, PUBREL, or PUBCOMP.
@@ -0,0 +1,141 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_trace.h
+ * @brief Ring buffer of trace events recorded at the tracepoints of core_mqtt.c.
+ *
+ * Events are only recorded when the library is built with #MQTT_TRACE_ENABLE.
+ * All contexts share one ring; when it is full the oldest events are
+ * overwritten. tools/mqtt_trace_json.py turns a dump into a Chrome trace
+ * that Perfetto can open.
+ */
+#ifndef CORE_MQTT_TRACE_H
+#define CORE_MQTT_TRACE_H
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @ingroup mqtt_constants
+ * @brief First four bytes of a binary trace dump.
+ *
+ * A dump is this magic, a 16-bit format version of #MQTT_TRACE_FORMAT_VERSION
+ * and the 16-bit size of an #MQTTTraceEvent_t, followed by the events as they
+ * are in memory. Everything after the magic is in the byte order of the
+ * device, which the version tells.
+ */
+#define MQTT_TRACE_FILE_MAGIC         "MQTR"
+
+/**
+ * @ingroup mqtt_constants
+ * @brief Version of the trace dump format.
+ */
+#define MQTT_TRACE_FORMAT_VERSION     ( 1U )
+
+/**
+ * @ingroup mqtt_enum_types
+ * @brief Tracepoints in core_mqtt.c.
+ */
+typedef enum MQTTTraceEventType
+{
+    MQTTTraceRecv = 1,      /**< @brief Transport receive returned; length is its result. */
+    MQTTTraceHeader,        /**< @brief Fixed header parsed; detail is the type, length the remaining length. */
+    MQTTTraceDeserialized,  /**< @brief Packet deserialized; detail is the type, length the remaining length. */
+    MQTTTraceCallbackEnter, /**< @brief Application callback entered; detail is the packet type. */
+    MQTTTraceCallbackExit,  /**< @brief Application callback returned; detail is the packet type. */
+    MQTTTraceAckSent,       /**< @brief PUBACK, PUBREC, PUBREL or PUBCOMP sent; detail is the type. */
+    MQTTTraceSendStart,     /**< @brief Packet send started; detail is the type, length the packet size. */
+    MQTTTraceSendDone,      /**< @brief Packet send finished; length is the bytes sent or the error. */
+    MQTTTraceState          /**< @brief Publish state changed; detail is the new #MQTTPublishState_t. */
+} MQTTTraceEventType_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief A trace event, 16 bytes.
+ */
+typedef struct MQTTTraceEvent
+{
+    uint32_t sequence;    /**< @brief Position in the recording order, counted from 1. */
+    uint32_t timestampUs; /**< @brief Time from #MQTT_TRACE_TIMESTAMP_US, wraps. */
+    uint32_t length;      /**< @brief Byte count or result, see #MQTTTraceEventType_t. */
+    uint16_t packetId;    /**< @brief Packet identifier, 0 if none or unknown. */
+    uint8_t event;        /**< @brief An #MQTTTraceEventType_t. */
+    uint8_t detail;       /**< @brief Packet type byte or publish state. */
+} MQTTTraceEvent_t;
+
+/**
+ * @brief Record a trace event.
+ *
+ * Called by the tracepoints of core_mqtt.c. Safe to call from any thread, as
+ * writers claim slots with an atomic add on GCC and Clang; no lock is taken.
+ * Does nothing unless the library is built with #MQTT_TRACE_ENABLE.
+ *
+ * @param[in] timestampUs Time of the event.
+ * @param[in] event Tracepoint.
+ * @param[in] packetId Packet identifier, 0 if none.
+ * @param[in] detail Packet type byte or publish state.
+ * @param[in] length Byte count or result.
+ */
+/* @[declare_mqtt_tracerecord] */
+void MQTT_TraceRecord( uint32_t timestampUs,
+                       MQTTTraceEventType_t event,
+                       uint16_t packetId,
+                       uint8_t detail,
+                       uint32_t length );
+/* @[declare_mqtt_tracerecord] */
+
+/**
+ * @brief Copy the events recorded after a cursor, oldest first.
+ *
+ * Events overwritten before they were read are skipped and show as a gap in
+ * the sequence numbers, as are events still being written.
+ *
+ * @param[in,out] pCursor Sequence of the last event read, 0 to start with the
+ * oldest one held. Advanced past the events copied.
+ * @param[out] pEvents Receives the events.
+ * @param[in] maxEvents Capacity of @p pEvents.
+ *
+ * @return The number of events copied, 0 once there are no more or when
+ * tracing is compiled out.
+ */
+/* @[declare_mqtt_traceread] */
+size_t MQTT_TraceRead( uint32_t * pCursor,
+                       MQTTTraceEvent_t * pEvents,
+                       size_t maxEvents );
+/* @[declare_mqtt_traceread] */
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* ifndef CORE_MQTT_TRACE_H */
@@ -294,6 +294,27 @@ typedef int32_t ( * TransportWritev_t )( NetworkContext_t * pNetworkContext,
                                          size_t ioVecCount );
 /* @[define_transportwritev] */
 
+/**
+ * @transportcallback
+ * @brief Transport interface function for a non-blocking connection setup.
+ *
+ * #MQTT_ConnectAsync hands the connection setup to the MQTT receive loop,
+ * which calls this function on every iteration until the transport is up.
+ * Each call should advance the setup (name resolution, TCP connect, TLS
+ * handshake) as far as possible without blocking.
+ *
+ * @note This function is optional. Leave it NULL when the transport is always
+ * connected before the MQTT API is used.
+ *
+ * @param[in] pNetworkContext Implementation-defined network context.
+ *
+ * @return A positive value once the transport is connected, zero while the
+ * setup is still in progress, or a negative value if it failed.
+ */
+/* @[define_transportconnect] */
+typedef int32_t ( * TransportConnect_t )( NetworkContext_t * pNetworkContext );
+/* @[define_transportconnect] */
+
 /**
  * @transportstruct
  * @brief The transport layer interface.
@@ -304,6 +325,7 @@ typedef struct TransportInterface
     TransportRecv_t recv;               /**< Transport receive function pointer. */
     TransportSend_t send;               /**< Transport send function pointer. */
     TransportWritev_t writev;           /**< Transport writev function pointer. */
+    TransportConnect_t connect;         /**< Transport connect step function pointer, optional. */
     NetworkContext_t * pNetworkContext; /**< Implementation-defined network context. */
 } TransportInterface_t;
 /* @[define_transportinterface] */
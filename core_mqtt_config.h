@@ -11,8 +11,6 @@
 #ifndef APPLICATIONS_FIREMQTT_PORT_CONFIG_H_
 #define APPLICATIONS_FIREMQTT_PORT_CONFIG_H_
 
-#include "mqtt_api.h"
-
 /* MQTT Broker Address */
 #ifndef MQTT_BROKER_ADDRESS
 #define MQTT_BROKER_ADDRESS  "broker.emqx.io"
@@ -63,6 +61,11 @@
 #define MQTT_OUTGOING_PUBLISH_COUNT     30
 #endif
 
+/* MQTT Incoming Publish Count, QoS 1/2 messages received and not yet acked (0: QoS 0 subscriptions only) */
+#ifndef MQTT_INCOMING_PUBLISH_COUNT
+#define MQTT_INCOMING_PUBLISH_COUNT     0
+#endif
+
 /* MQTT Buffer Size */
 #ifndef MQTT_BUF_SIZE
 #define MQTT_BUF_SIZE                   4096
@@ -83,6 +86,221 @@
 #define MAX_BACKOFF_MS                  60000
 #endif
 
+/* MQTT Subscriptions Restored After Reconnect */
+#ifndef MQTT_SUBSCRIPTION_MAX
+#define MQTT_SUBSCRIPTION_MAX           16
+#endif
+
+/* MQTT Largest SUBSCRIBE Packet Sent When Restoring Subscriptions (bytes) */
+#ifndef MQTT_SUBSCRIBE_PACKET_MAX
+#define MQTT_SUBSCRIBE_PACKET_MAX       MQTT_BUF_SIZE
+#endif
+
+/* MQTT Offline Queue, requires DFS (0: disable, 1: enable) */
+#ifndef MQTT_OFFLINE_QUEUE_ENABLE
+#define MQTT_OFFLINE_QUEUE_ENABLE       0
+#endif
+
+/* MQTT Offline Queue Directory */
+#ifndef MQTT_OFFLINE_QUEUE_PATH
+#define MQTT_OFFLINE_QUEUE_PATH         "/mqtt_queue"
+#endif
+
+/* MQTT Offline Queue Segment Size (bytes), bounds the largest queued publish */
+#ifndef MQTT_OFFLINE_QUEUE_SEGMENT_SIZE
+#define MQTT_OFFLINE_QUEUE_SEGMENT_SIZE 4096
+#endif
+
+/* MQTT Offline Queue Segment Count, capacity is SEGMENT_SIZE * SEGMENT_COUNT */
+#ifndef MQTT_OFFLINE_QUEUE_SEGMENT_COUNT
+#define MQTT_OFFLINE_QUEUE_SEGMENT_COUNT 8
+#endif
+
+/* MQTT Offline Queue Drop Policy when full (MQTTOfflineDropOldest or MQTTOfflineDropNewest) */
+#ifndef MQTT_OFFLINE_QUEUE_DROP_POLICY
+#define MQTT_OFFLINE_QUEUE_DROP_POLICY  MQTTOfflineDropOldest
+#endif
+
+/* MQTT Offline Queue Records Published But Not Yet Acknowledged */
+#ifndef MQTT_OFFLINE_QUEUE_INFLIGHT
+#define MQTT_OFFLINE_QUEUE_INFLIGHT     32
+#endif
+
+/* MQTT Dispatcher Trie Nodes, one per distinct filter level */
+#ifndef MQTT_DISPATCH_MAX_NODES
+#define MQTT_DISPATCH_MAX_NODES         64
+#endif
+
+/* MQTT Dispatcher Handlers */
+#ifndef MQTT_DISPATCH_MAX_HANDLERS
+#define MQTT_DISPATCH_MAX_HANDLERS      16
+#endif
+
+/* MQTT Dispatcher Maximum Filter Levels */
+#ifndef MQTT_DISPATCH_MAX_LEVELS
+#define MQTT_DISPATCH_MAX_LEVELS        16
+#endif
+
+/* MQTT Dispatcher Cache Lines (0: disable) */
+#ifndef MQTT_DISPATCH_CACHE_SIZE
+#define MQTT_DISPATCH_CACHE_SIZE        8
+#endif
+
+/* MQTT Dispatcher Cache Longest Cached Topic (bytes) */
+#ifndef MQTT_DISPATCH_CACHE_TOPIC_MAX
+#define MQTT_DISPATCH_CACHE_TOPIC_MAX   64
+#endif
+
+/* MQTT Pipelined Connect: send SUBSCRIBEs and queued publishes before CONNACK (1: enable) */
+#ifndef MQTT_PIPELINED_CONNECT
+#define MQTT_PIPELINED_CONNECT          0
+#endif
+
+/* MQTT CONNACK Timeout For Pipelined Connect (milliseconds) */
+#ifndef MQTT_CONNACK_TIMEOUT_MS
+#define MQTT_CONNACK_TIMEOUT_MS         (10000U)
+#endif
+
+/* MQTT Non-blocking Connect: DNS, TCP, CONNECT and CONNACK driven by MQTT_ProcessLoop (1: enable) */
+#ifndef MQTT_ASYNC_CONNECT
+#define MQTT_ASYNC_CONNECT              0
+#endif
+
+/* MQTT Client Task Stack Size (bytes) */
+#ifndef MQTT_CLIENT_STACK_SIZE
+#define MQTT_CLIENT_STACK_SIZE          4096
+#endif
+
+/* MQTT Client Task Priority */
+#ifndef MQTT_CLIENT_PRIORITY
+#define MQTT_CLIENT_PRIORITY            10
+#endif
+
+/* MQTT Client Task Time Slice (ticks) */
+#ifndef MQTT_CLIENT_TIMESLICE
+#define MQTT_CLIENT_TIMESLICE           20
+#endif
+
+/* MQTT Event Loop Longest Wait (milliseconds), bounds how late keep-alive work may run */
+#ifndef MQTT_EVENT_LOOP_MAX_WAIT_MS
+#define MQTT_EVENT_LOOP_MAX_WAIT_MS     1000
+#endif
+
+/* MQTT Event Loop Packets Handled Per Client And Wakeup */
+#ifndef MQTT_EVENT_LOOP_BURST
+#define MQTT_EVENT_LOOP_BURST           8
+#endif
+
+/* MQTT Event Loop Offline Queue Records Published Per Client And Wakeup */
+#ifndef MQTT_EVENT_LOOP_DRAIN_BURST
+#define MQTT_EVENT_LOOP_DRAIN_BURST     8
+#endif
+
+/* MQTT Event Loop Wait Backend (1: epoll, 0: poll) */
+#ifndef MQTT_EVENT_LOOP_EPOLL
+#if defined(__linux__)
+#define MQTT_EVENT_LOOP_EPOLL           1
+#else
+#define MQTT_EVENT_LOOP_EPOLL           0
+#endif
+#endif
+
+/* MQTT Worker Threads running message handlers (0: handlers run on the receive thread) */
+#ifndef MQTT_WORKER_COUNT
+#define MQTT_WORKER_COUNT               0
+#endif
+
+/* MQTT Worker Queue Depth, messages queued per worker before the receive thread waits */
+#ifndef MQTT_WORKER_QUEUE_DEPTH
+#define MQTT_WORKER_QUEUE_DEPTH         8
+#endif
+
+/* MQTT Worker Slot Size (bytes of topic and payload), larger messages are allocated */
+#ifndef MQTT_WORKER_SLOT_SIZE
+#define MQTT_WORKER_SLOT_SIZE           256
+#endif
+
+/* MQTT Worker Ack Mode (MQTTWorkerAckOnReceive or MQTTWorkerAckOnComplete) */
+#ifndef MQTT_WORKER_ACK_MODE
+#define MQTT_WORKER_ACK_MODE            MQTTWorkerAckOnReceive
+#endif
+
+/* MQTT Worker Thread Stack Size and Priority */
+#ifndef MQTT_WORKER_STACK_SIZE
+#define MQTT_WORKER_STACK_SIZE          2048
+#endif
+
+#ifndef MQTT_WORKER_PRIORITY
+#define MQTT_WORKER_PRIORITY            12
+#endif
+
+/* MQTT Receive Flow Control, receiving pauses once a worker queue holds the high watermark and resumes
+ * at the low one (0: derived from the worker queue depth) */
+#ifndef MQTT_FLOW_HIGH_WATERMARK
+#define MQTT_FLOW_HIGH_WATERMARK        0
+#endif
+
+#ifndef MQTT_FLOW_LOW_WATERMARK
+#define MQTT_FLOW_LOW_WATERMARK         0
+#endif
+
+/* MQTT Deferred Acks, handler acks held back before receiving pauses (0: one per incoming publish record) */
+#ifndef MQTT_DEFERRED_ACK_MAX
+#define MQTT_DEFERRED_ACK_MAX           0
+#endif
+
+/* MQTT Full Duplex, a reader and a writer thread share the client through the state engine (0: one task) */
+#ifndef MQTT_DUPLEX_ENABLE
+#define MQTT_DUPLEX_ENABLE              0
+#endif
+
+/* MQTT Writer Queue Depth, publishes waiting for the writer thread in full duplex mode */
+#ifndef MQTT_WRITER_QUEUE_DEPTH
+#define MQTT_WRITER_QUEUE_DEPTH         16
+#endif
+
+/* MQTT Writer Slot Size, bytes of topic and payload copied into each queue slot */
+#ifndef MQTT_WRITER_SLOT_SIZE
+#define MQTT_WRITER_SLOT_SIZE           256
+#endif
+
+#ifndef MQTT_WRITER_STACK_SIZE
+#define MQTT_WRITER_STACK_SIZE          2048
+#endif
+
+#ifndef MQTT_WRITER_PRIORITY
+#define MQTT_WRITER_PRIORITY            10
+#endif
+
+/* MQTT Metrics, per client packet counters and ack latencies shown by mqtt_stats and mqtt_latency (0: not counted) */
+#ifndef MQTT_METRICS_ENABLE
+#define MQTT_METRICS_ENABLE             0
+#endif
+
+/* MQTT Trace, core tracepoints recorded into a ring read by mqtt_trace (0: compiled out) */
+#ifndef MQTT_TRACE_ENABLE
+#define MQTT_TRACE_ENABLE               0
+#endif
+
+#ifndef MQTT_TRACE_BUFFER_COUNT
+#define MQTT_TRACE_BUFFER_COUNT         256
+#endif
+
+/* In full duplex mode the core serializes the state engine and the socket's
+ * send side with two client locks, see mqtt_api.c. */
+#if MQTT_DUPLEX_ENABLE
+struct MQTTContext;
+void mqttStateLock(const struct MQTTContext *context);
+void mqttStateUnlock(const struct MQTTContext *context);
+void mqttSendLock(const struct MQTTContext *context);
+void mqttSendUnlock(const struct MQTTContext *context);
+
+#define MQTT_PRE_STATE_UPDATE_HOOK(pContext)    mqttStateLock(pContext)
+#define MQTT_POST_STATE_UPDATE_HOOK(pContext)   mqttStateUnlock(pContext)
+#define MQTT_PRE_SEND_HOOK(pContext)            mqttSendLock(pContext)
+#define MQTT_POST_SEND_HOOK(pContext)           mqttSendUnlock(pContext)
+#endif
+
 /* MQTT User Callback */
 #ifndef MQTT_USER_CALLBACK
 #define MQTT_USER_CALLBACK               mqttEventCallback
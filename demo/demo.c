@@ -3,7 +3,10 @@
 #define DBG_TAG "MQTT"
 #define DBG_LVL DBG_LOG
 
+#include <fcntl.h>
 #include "mqtt_api.h"
+#include "mqtt_event_loop.h"
+#include "core_mqtt_trace.h"
 
 #define CORE_MQTTT_STACK_SIZE       4096
 #define CORE_MQTTT_PRIORITY         10
@@ -58,6 +61,16 @@ static int mqtt_pub(int argc, char **argv)
 MSH_CMD_EXPORT_ALIAS(mqtt_pub, mqtt_pub, Send MQTT message);
 #endif
 
+static void mqtt_sub_handler(MQTTContext_t *pContext, MQTTDeserializedInfo_t *pDeserializedInfo, void *pUserData)
+{
+    MQTTPublishInfo_t *pPublishInfo = pDeserializedInfo->pPublishInfo;
+
+    (void) pContext;
+
+    rt_kprintf("[%s] '%.*s': %.*s\n", (const char *) pUserData, pPublishInfo->topicNameLength,
+            pPublishInfo->pTopicName, pPublishInfo->payloadLength, (const char *) pPublishInfo->pPayload);
+}
+
 static int mqtt_sub(int argc, char **argv)
 {
     MQTTStatus_t status;
@@ -73,9 +86,17 @@ static int mqtt_sub(int argc, char **argv)
     subscribeInfo.pTopicFilter = argv[1];
     subscribeInfo.topicFilterLength = strlen(argv[1]);
 
+    status = mqttRegisterHandler(argv[1], mqtt_sub_handler, "mqtt_sub");
+    if (status != MQTTSuccess)
+    {
+        rt_kprintf("MQTT handler register failed: %d\n", status);
+        return -RT_ERROR;
+    }
+
     status = mqttSubscribe(&subscribeInfo);
     if (status != MQTTSuccess)
     {
+        mqttUnregisterHandler(argv[1], mqtt_sub_handler);
         rt_kprintf("MQTT subscribe failed: %d\n", status);
         return -RT_ERROR;
     }
@@ -86,3 +107,350 @@ static int mqtt_sub(int argc, char **argv)
 #ifdef RT_USING_FINSH
 MSH_CMD_EXPORT_ALIAS(mqtt_sub, mqtt_sub, Subscribe MQTT message);
 #endif
+
+static int mqtt_unsub(int argc, char **argv)
+{
+    MQTTStatus_t status;
+    MQTTSubscribeInfo_t subscribeInfo;
+
+    if (argc != 2)
+    {
+        rt_kprintf("Usage: mqtt_unsub <topic>\n");
+        return -RT_ERROR;
+    }
+
+    subscribeInfo.qos = MQTTQoS0;
+    subscribeInfo.pTopicFilter = argv[1];
+    subscribeInfo.topicFilterLength = strlen(argv[1]);
+
+    status = mqttUnsubscribe(&subscribeInfo);
+    mqttUnregisterHandler(argv[1], mqtt_sub_handler);
+    if (status != MQTTSuccess)
+    {
+        rt_kprintf("MQTT unsubscribe failed: %d\n", status);
+        return -RT_ERROR;
+    }
+
+    rt_kprintf("Unsubscribed from topic: %s\n", argv[1]);
+    return RT_EOK;
+}
+#ifdef RT_USING_FINSH
+MSH_CMD_EXPORT_ALIAS(mqtt_unsub, mqtt_unsub, Unsubscribe MQTT topic);
+#endif
+
+static int mqtt_queue(int argc, char **argv)
+{
+    MQTTOfflineQueueStats_t stats;
+
+    (void) argc;
+    (void) argv;
+
+    mqttGetOfflineQueueStats(&stats);
+    rt_kprintf("depth      : %u\n", stats.depth);
+    rt_kprintf("bytes      : %u / %u\n", stats.bytes, stats.capacity);
+    rt_kprintf("dropped    : %u\n", stats.dropped);
+    rt_kprintf("drained    : %u\n", stats.drained);
+    rt_kprintf("last drain : %u msgs in %u ms (%u msg/s)\n", stats.lastDrainCount, stats.lastDrainMs, stats.drainRate);
+    return RT_EOK;
+}
+#ifdef RT_USING_FINSH
+MSH_CMD_EXPORT_ALIAS(mqtt_queue, mqtt_queue, Show MQTT offline queue status);
+#endif
+
+static int mqtt_dispatch(int argc, char **argv)
+{
+    MQTTDispatchCacheStats_t stats;
+    uint32_t lookups;
+
+    (void) argc;
+    (void) argv;
+
+    mqttGetDispatchCacheStats(&stats);
+    lookups = stats.hits + stats.misses;
+    rt_kprintf("cache lines : %u / %u used\n", stats.used, stats.lines);
+    rt_kprintf("hits        : %u\n", stats.hits);
+    rt_kprintf("misses      : %u\n", stats.misses);
+    rt_kprintf("hit rate    : %u%%\n", (lookups > 0) ? (stats.hits * 100U / lookups) : 0U);
+    return RT_EOK;
+}
+#ifdef RT_USING_FINSH
+MSH_CMD_EXPORT_ALIAS(mqtt_dispatch, mqtt_dispatch, Show MQTT topic dispatch cache status);
+#endif
+
+static int mqtt_workers(int argc, char **argv)
+{
+    MQTTWorkerPoolStats_t stats;
+
+    (void) argc;
+    (void) argv;
+
+    mqttClientGetWorkerStats(mqttDefaultClient(), &stats);
+    rt_kprintf("submitted  : %u\n", (unsigned int) stats.submitted);
+    rt_kprintf("completed  : %u\n", (unsigned int) stats.completed);
+    rt_kprintf("queued     : %u\n", (unsigned int) stats.queued);
+    rt_kprintf("acks due   : %u\n", (unsigned int) stats.deferred);
+    rt_kprintf("allocated  : %u\n", (unsigned int) stats.allocated);
+    rt_kprintf("inlined    : %u\n", (unsigned int) stats.inlined);
+    rt_kprintf("stalls     : %u\n", (unsigned int) stats.stalls);
+    return RT_EOK;
+}
+#ifdef RT_USING_FINSH
+MSH_CMD_EXPORT_ALIAS(mqtt_workers, mqtt_workers, Show MQTT worker pool status);
+#endif
+
+static int mqtt_clients(int argc, char **argv)
+{
+    static const char *const states[] = { "idle", "connected", "closing", "connack", "connecting" };
+    MQTTClient_t *client;
+    size_t total = 0;
+
+    (void) argc;
+    (void) argv;
+
+    for (client = mqttClientNext(RT_NULL); client != RT_NULL; client = mqttClientNext(client))
+    {
+        rt_kprintf("%-24s %-10s %s:%u  %u bytes\n", client->config.clientId, states[client->context.connectStatus],
+                client->config.brokerAddress, client->config.brokerPort,
+                (unsigned int) mqttClientMemoryUsage(client));
+        total += mqttClientMemoryUsage(client);
+    }
+    rt_kprintf("total %u bytes\n", (unsigned int) total);
+    return RT_EOK;
+}
+#ifdef RT_USING_FINSH
+MSH_CMD_EXPORT_ALIAS(mqtt_clients, mqtt_clients, Show MQTT clients and their memory);
+#endif
+
+static int mqtt_stats(int argc, char **argv)
+{
+    static const char *const types[16] = { "-", "CONNECT", "CONNACK", "PUBLISH", "PUBACK", "PUBREC", "PUBREL",
+            "PUBCOMP", "SUBSCRIBE", "SUBACK", "UNSUBSCRIBE", "UNSUBACK", "PINGREQ", "PINGRESP", "DISCONNECT", "-" };
+    MQTTClient_t *client;
+    MQTTMetrics_t m;
+    int i;
+
+#if !MQTT_METRICS_ENABLE
+    rt_kprintf("Counting is off, build with MQTT_METRICS_ENABLE set to 1\n");
+#endif
+    for (client = mqttClientNext(RT_NULL); client != RT_NULL; client = mqttClientNext(client))
+    {
+        if ((argc > 1) && (strcmp(argv[1], "reset") == 0))
+        {
+            MQTT_ResetMetrics(&client->context);
+            continue;
+        }
+
+        MQTT_GetMetrics(&client->context, &m);
+        rt_kprintf("%s\n", client->config.clientId);
+        rt_kprintf("  %-12s %10s %10s\n", "packet", "sent", "received");
+        for (i = 0; i < 16; i++)
+        {
+            if ((m.packetsSent[i] != 0U) || (m.packetsReceived[i] != 0U))
+            {
+                rt_kprintf("  %-12s %10u %10u\n", types[i], (unsigned int) m.packetsSent[i],
+                        (unsigned int) m.packetsReceived[i]);
+            }
+        }
+        rt_kprintf("  bytes out     : %u\n", (unsigned int) m.bytesSent);
+        rt_kprintf("  bytes in      : %u\n", (unsigned int) m.bytesReceived);
+        rt_kprintf("  send retries  : %u, partial %u, timed out %u\n", (unsigned int) m.sendRetries,
+                (unsigned int) m.partialSends, (unsigned int) m.sendTimeouts);
+        rt_kprintf("  recv timeouts : %u\n", (unsigned int) m.recvTimeouts);
+        rt_kprintf("  discarded     : %u packets, %u bytes\n", (unsigned int) m.discardedPackets,
+                (unsigned int) m.discardedBytes);
+        rt_kprintf("  memmove bytes : %u\n", (unsigned int) m.memmoveBytes);
+        rt_kprintf("  collisions    : %u\n", (unsigned int) m.stateCollisions);
+        rt_kprintf("  pings         : %u sent, %u answered, %u timed out\n", (unsigned int) m.packetsSent[12],
+                (unsigned int) m.packetsReceived[13], (unsigned int) m.keepAliveTimeouts);
+    }
+    return RT_EOK;
+}
+#ifdef RT_USING_FINSH
+MSH_CMD_EXPORT_ALIAS(mqtt_stats, mqtt_stats, Show MQTT client counters or reset them);
+#endif
+
+static void mqtt_latency_print(const char *name, const MQTTLatencyHistogram_t *histogram)
+{
+    uint32_t i;
+
+    rt_kprintf("  %-17s %8u %8u %8u %8u %8u\n", name, (unsigned int) histogram->count,
+            (unsigned int) ((histogram->count > 0U) ? (histogram->totalMs / histogram->count) : 0U),
+            (unsigned int) MQTT_LatencyPercentile(histogram, 50U), (unsigned int) MQTT_LatencyPercentile(histogram, 99U),
+            (unsigned int) histogram->maxMs);
+    for (i = 0; i < MQTT_LATENCY_BUCKET_COUNT; i++)
+    {
+        if (histogram->buckets[i] == 0U)
+        {
+            continue;
+        }
+        if (i == 0U)
+        {
+            rt_kprintf("    %14s ms %8u\n", "< 1", (unsigned int) histogram->buckets[i]);
+        }
+        else if (i == (MQTT_LATENCY_BUCKET_COUNT - 1U))
+        {
+            rt_kprintf("    %14s ms %8u\n", ">= 16384", (unsigned int) histogram->buckets[i]);
+        }
+        else
+        {
+            rt_kprintf("    %6u - %-5u ms %8u\n", (unsigned int) (1UL << (i - 1U)), (unsigned int) ((1UL << i) - 1U),
+                    (unsigned int) histogram->buckets[i]);
+        }
+    }
+}
+
+static int mqtt_latency(int argc, char **argv)
+{
+    MQTTClient_t *client;
+    MQTTMetrics_t m;
+
+    (void) argc;
+    (void) argv;
+
+#if !MQTT_METRICS_ENABLE
+    rt_kprintf("Timing is off, build with MQTT_METRICS_ENABLE set to 1\n");
+#endif
+    for (client = mqttClientNext(RT_NULL); client != RT_NULL; client = mqttClientNext(client))
+    {
+        MQTT_GetMetrics(&client->context, &m);
+        rt_kprintf("%s\n", client->config.clientId);
+        rt_kprintf("  %-17s %8s %8s %8s %8s %8s\n", "round trip, ms", "count", "mean", "p50", "p99", "max");
+        mqtt_latency_print("PUBLISH-PUBACK", &m.publishAck);
+        mqtt_latency_print("PUBLISH-PUBCOMP", &m.publishComplete);
+        mqtt_latency_print("PINGREQ-PINGRESP", &m.pingResponse);
+    }
+    return RT_EOK;
+}
+#ifdef RT_USING_FINSH
+MSH_CMD_EXPORT_ALIAS(mqtt_latency, mqtt_latency, Show MQTT ack round trip histograms);
+#endif
+
+static int mqtt_trace(int argc, char **argv)
+{
+    static uint32_t cursor;
+    MQTTTraceEvent_t events[16];
+    uint16_t header[2] = { MQTT_TRACE_FORMAT_VERSION, sizeof(MQTTTraceEvent_t) };
+    size_t i, count, total = 0;
+    int fd = -1;
+
+#if !MQTT_TRACE_ENABLE
+    rt_kprintf("Tracing is off, build with MQTT_TRACE_ENABLE set to 1\n");
+#endif
+    if ((argc > 2) && (strcmp(argv[1], "save") == 0))
+    {
+        fd = open(argv[2], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if ((fd < 0) || (write(fd, MQTT_TRACE_FILE_MAGIC, 4) != 4) || (write(fd, header, sizeof(header)) != (int) sizeof(header)))
+        {
+            rt_kprintf("Failed to write %s\n", argv[2]);
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            return -RT_ERROR;
+        }
+    }
+    else if (argc > 1)
+    {
+        rt_kprintf("Usage: mqtt_trace [save <file>]\n");
+        return -RT_ERROR;
+    }
+
+    /* Events since the last call, as text lines or into a file for
+     * tools/mqtt_trace_json.py. */
+    while ((count = MQTT_TraceRead(&cursor, events, sizeof(events) / sizeof(events[0]))) > 0)
+    {
+        if (fd >= 0)
+        {
+            if (write(fd, events, count * sizeof(events[0])) != (int) (count * sizeof(events[0])))
+            {
+                break;
+            }
+        }
+        else
+        {
+            for (i = 0; i < count; i++)
+            {
+                rt_kprintf("trace %u %u %u %u %u %u\n", (unsigned int) events[i].sequence,
+                        (unsigned int) events[i].timestampUs, (unsigned int) events[i].event,
+                        (unsigned int) events[i].packetId, (unsigned int) events[i].detail,
+                        (unsigned int) events[i].length);
+            }
+        }
+        total += count;
+    }
+
+    if (fd >= 0)
+    {
+        close(fd);
+        rt_kprintf("%u events saved to %s\n", (unsigned int) total, argv[2]);
+    }
+    return RT_EOK;
+}
+#ifdef RT_USING_FINSH
+MSH_CMD_EXPORT_ALIAS(mqtt_trace, mqtt_trace, Dump MQTT trace events or save them to a file);
+#endif
+
+static int mqtt_loop(int argc, char **argv)
+{
+    static MQTTEventLoop_t loop;
+    MQTTClientConfig_t config;
+    MQTTClient_t *client;
+    char *clientId;
+    int i, count;
+
+    if (argc < 2)
+    {
+        if (!loop.initialized)
+        {
+            rt_kprintf("Usage: mqtt_loop <clients>\n");
+            return -RT_ERROR;
+        }
+        rt_kprintf("clients    : %u / %u\n", loop.count, loop.maxClients);
+        rt_kprintf("iterations : %u\n", (unsigned int) loop.iterations);
+        rt_kprintf("serviced   : %u\n", (unsigned int) loop.serviced);
+        return RT_EOK;
+    }
+
+    count = atoi(argv[1]);
+    if ((count <= 0) || loop.initialized)
+    {
+        rt_kprintf("The event loop is already running or the client count is invalid\n");
+        return -RT_ERROR;
+    }
+
+    if (mqttEventLoopInit(&loop, (uint16_t) count) != MQTTSuccess)
+    {
+        rt_kprintf("Failed to create the event loop\n");
+        return -RT_ENOMEM;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        client = rt_calloc(1, sizeof(MQTTClient_t));
+        clientId = rt_malloc(sizeof(MQTT_CLIENT_ID) + 8);
+        if ((client == RT_NULL) || (clientId == RT_NULL))
+        {
+            rt_free(client);
+            rt_free(clientId);
+            break;
+        }
+        rt_snprintf(clientId, sizeof(MQTT_CLIENT_ID) + 8, "%s_%d", MQTT_CLIENT_ID, i);
+
+        mqttClientConfigInit(&config);
+        config.clientId = clientId;
+        config.offlineQueuePath = RT_NULL;
+        if ((mqttClientInit(client, &config) != MQTTSuccess) || (mqttEventLoopAdd(&loop, client) != MQTTSuccess))
+        {
+            mqttClientDeinit(client);
+            rt_free(client);
+            rt_free(clientId);
+            break;
+        }
+    }
+
+    rt_kprintf("%u clients on one thread\n", loop.count);
+    return (mqttEventLoopStart(&loop, MQTT_CLIENT_STACK_SIZE, MQTT_CLIENT_PRIORITY) == MQTTSuccess) ? RT_EOK : -RT_ERROR;
+}
+#ifdef RT_USING_FINSH
+MSH_CMD_EXPORT_ALIAS(mqtt_loop, mqtt_loop, Run many MQTT clients on one event loop thread);
+#endif
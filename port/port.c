@@ -1,13 +1,27 @@
 #include <rtthread.h>
 #include <core_mqtt.h>
 #include <sys/socket.h>
+#include <sys/select.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <string.h>
 #include "port.h"
 
+#define RESOLVE_THREAD_STACK    2048
+#define RESOLVE_THREAD_PRIO     (RT_THREAD_PRIORITY_MAX - 2)
+
+/* Name lookup handed to a resolver thread, freed by whichever side finishes last. */
+struct TransportResolve
+{
+    volatile int result;        /* 0 pending, 1 resolved, -1 failed */
+    bool abandoned;
+    struct in_addr address;
+    char host[];
+};
+
 uint32_t getCurrentTime(void)
 {
     return rt_tick_get() / (1000 / RT_TICK_PER_SECOND); //ms
@@ -15,10 +29,238 @@ uint32_t getCurrentTime(void)
 
 int32_t transportSend(NetworkContext_t *pNetworkContext, const void *pBuffer, size_t bytesToSend)
 {
-    return send(pNetworkContext->socket, pBuffer, bytesToSend, 0);
+    int32_t result = send(pNetworkContext->socket, pBuffer, bytesToSend, 0);
+
+    /* A full send buffer of a non-blocking socket is retried by the core. */
+    if ((result < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+    {
+        result = 0;
+    }
+    return result;
 }
 
 int32_t transportRecv(NetworkContext_t *pNetworkContext, void *pBuffer, size_t bytesToRead)
 {
-    return recv(pNetworkContext->socket, pBuffer, bytesToRead, 0);
+    int32_t result = recv(pNetworkContext->socket, pBuffer, bytesToRead, 0);
+
+    if ((result < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+    {
+        result = 0;
+    }
+    return result;
+}
+
+static void resolveEntry(void *parameter)
+{
+    struct TransportResolve *resolve = parameter;
+    struct addrinfo hints = { 0 }, *info = RT_NULL;
+    bool abandoned;
+    int result = -1;
+
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if ((getaddrinfo(resolve->host, RT_NULL, &hints, &info) == 0) && (info != RT_NULL))
+    {
+        resolve->address = ((struct sockaddr_in *) info->ai_addr)->sin_addr;
+        result = 1;
+    }
+    if (info != RT_NULL)
+    {
+        freeaddrinfo(info);
+    }
+
+    rt_enter_critical();
+    resolve->result = result;
+    abandoned = resolve->abandoned;
+    rt_exit_critical();
+
+    if (abandoned)
+    {
+        rt_free(resolve);
+    }
+}
+
+static void releaseResolve(NetworkContext_t *pNetworkContext)
+{
+    struct TransportResolve *resolve = pNetworkContext->resolve;
+    bool pending;
+
+    if (resolve == RT_NULL)
+    {
+        return;
+    }
+
+    /* A lookup still running keeps its request, the thread frees it. */
+    rt_enter_critical();
+    pending = (resolve->result == 0);
+    resolve->abandoned = pending;
+    rt_exit_critical();
+
+    if (!pending)
+    {
+        rt_free(resolve);
+    }
+    pNetworkContext->resolve = RT_NULL;
+}
+
+static int32_t startSocketConnect(NetworkContext_t *pNetworkContext, struct in_addr address)
+{
+    struct sockaddr_in serverAddr = { 0 };
+    int flags;
+
+    pNetworkContext->socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (pNetworkContext->socket < 0)
+    {
+        return -1;
+    }
+
+    flags = fcntl(pNetworkContext->socket, F_GETFL, 0);
+    if ((flags < 0) || (fcntl(pNetworkContext->socket, F_SETFL, flags | O_NONBLOCK) < 0))
+    {
+        return -1;
+    }
+
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(pNetworkContext->port);
+    serverAddr.sin_addr = address;
+    if (connect(pNetworkContext->socket, (struct sockaddr *) &serverAddr, sizeof(serverAddr)) == 0)
+    {
+        pNetworkContext->state = TransportConnected;
+        return 1;
+    }
+    if ((errno != EINPROGRESS) && (errno != EWOULDBLOCK))
+    {
+        return -1;
+    }
+
+    pNetworkContext->state = TransportConnecting;
+    return 0;
+}
+
+int32_t transportConnectStart(NetworkContext_t *pNetworkContext, const char *host, uint16_t port)
+{
+    struct TransportResolve *resolve;
+    struct in_addr address;
+    size_t length = strlen(host);
+    rt_thread_t thread;
+
+    transportClose(pNetworkContext);
+    pNetworkContext->port = port;
+
+    /* Numeric addresses need no lookup. */
+    if (inet_aton(host, &address))
+    {
+        return (startSocketConnect(pNetworkContext, address) < 0) ? -1 : 0;
+    }
+
+    resolve = rt_malloc(sizeof(*resolve) + length + 1U);
+    if (resolve == RT_NULL)
+    {
+        return -1;
+    }
+    memset(resolve, 0, sizeof(*resolve));
+    memcpy(resolve->host, host, length + 1U);
+
+    thread = rt_thread_create("mqttdns", resolveEntry, resolve, RESOLVE_THREAD_STACK, RESOLVE_THREAD_PRIO, 10);
+    if (thread == RT_NULL)
+    {
+        rt_free(resolve);
+        return -1;
+    }
+
+    pNetworkContext->resolve = resolve;
+    pNetworkContext->state = TransportResolving;
+    rt_thread_startup(thread);
+
+    return 0;
+}
+
+int32_t transportConnectStep(NetworkContext_t *pNetworkContext)
+{
+    struct timeval timeout = { 0, 0 };
+    socklen_t length = sizeof(int);
+    fd_set writeSet;
+    int error = 0;
+
+    switch (pNetworkContext->state)
+    {
+        case TransportResolving:
+            if (pNetworkContext->resolve->result == 0)
+            {
+                return 0;
+            }
+            if (pNetworkContext->resolve->result < 0)
+            {
+                releaseResolve(pNetworkContext);
+                return -1;
+            }
+            {
+                struct in_addr address = pNetworkContext->resolve->address;
+
+                releaseResolve(pNetworkContext);
+                return startSocketConnect(pNetworkContext, address);
+            }
+
+        case TransportConnecting:
+            /* Writable means the handshake finished, SO_ERROR tells how. */
+            FD_ZERO(&writeSet);
+            FD_SET(pNetworkContext->socket, &writeSet);
+            if (select(pNetworkContext->socket + 1, RT_NULL, &writeSet, RT_NULL, &timeout) < 0)
+            {
+                return -1;
+            }
+            if (!FD_ISSET(pNetworkContext->socket, &writeSet))
+            {
+                return 0;
+            }
+            if ((getsockopt(pNetworkContext->socket, SOL_SOCKET, SO_ERROR, &error, &length) < 0) || (error != 0))
+            {
+                return -1;
+            }
+            pNetworkContext->state = TransportConnected;
+            return 1;
+
+        case TransportConnected:
+            return 1;
+
+        default:
+            return -1;
+    }
+}
+
+/* Waits up to timeoutMs for data to read: 1 readable, 0 timed out, -1 error. */
+int32_t transportWaitReadable(NetworkContext_t *pNetworkContext, uint32_t timeoutMs)
+{
+    struct timeval timeout;
+    fd_set readSet;
+    int result;
+
+    if (pNetworkContext->socket < 0)
+    {
+        return -1;
+    }
+
+    timeout.tv_sec = timeoutMs / 1000U;
+    timeout.tv_usec = (timeoutMs % 1000U) * 1000U;
+    FD_ZERO(&readSet);
+    FD_SET(pNetworkContext->socket, &readSet);
+    result = select(pNetworkContext->socket + 1, &readSet, RT_NULL, RT_NULL, &timeout);
+    if (result < 0)
+    {
+        return (errno == EINTR) ? 0 : -1;
+    }
+
+    return (result > 0) ? 1 : 0;
+}
+
+void transportClose(NetworkContext_t *pNetworkContext)
+{
+    releaseResolve(pNetworkContext);
+
+    if (pNetworkContext->socket >= 0)
+    {
+        closesocket(pNetworkContext->socket);
+        pNetworkContext->socket = -1;
+    }
+    pNetworkContext->state = TransportIdle;
 }
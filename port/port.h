@@ -12,13 +12,31 @@
 
 #define min(a, b) ((a) < (b) ? (a) : (b))
 
+/* States of the non-blocking connect driven by transportConnectStep(). */
+typedef enum TransportConnectState
+{
+    TransportIdle,
+    TransportResolving,
+    TransportConnecting,
+    TransportConnected
+} TransportConnectState_t;
+
+struct TransportResolve;
+
 typedef struct NetworkContext
 {
     int socket;
+    TransportConnectState_t state;
+    uint16_t port;
+    struct TransportResolve *resolve;
 } NetworkContext_t;
 
 uint32_t getCurrentTime(void);
 int32_t transportSend(NetworkContext_t *pNetworkContext, const void *pBuffer, size_t bytesToSend);
 int32_t transportRecv(NetworkContext_t *pNetworkContext, void *pBuffer, size_t bytesToRead);
+int32_t transportConnectStart(NetworkContext_t *pNetworkContext, const char *host, uint16_t port);
+int32_t transportConnectStep(NetworkContext_t *pNetworkContext);
+int32_t transportWaitReadable(NetworkContext_t *pNetworkContext, uint32_t timeoutMs);
+void transportClose(NetworkContext_t *pNetworkContext);
 
 #endif /* APPLICATIONS_FIREMQTT_PORT_PORT_H_ */
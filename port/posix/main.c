@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+/*
+ * Host entry point of the demo: starts the MQTT client task as an RT-Thread
+ * application would and reads msh commands (mqtt_pub, mqtt_sub, ...) from
+ * stdin until EOF or "exit".
+ */
+
+#include <rtthread.h>
+#include <string.h>
+
+#define LINE_MAX_LENGTH     256
+
+void mqtt_client_start(void);
+
+int main(void)
+{
+    char line[LINE_MAX_LENGTH];
+    size_t length;
+
+    mqtt_client_start();
+
+    while (1)
+    {
+        rt_kprintf("msh />");
+        if (fgets(line, sizeof(line), stdin) == RT_NULL)
+        {
+            break;
+        }
+
+        length = strlen(line);
+        if (strncmp(line, "exit", 4) == 0)
+        {
+            break;
+        }
+        msh_exec(line, length);
+    }
+
+    return 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+#ifndef APPLICATIONS_FIREMQTT_PORT_POSIX_RTDBG_H_
+#define APPLICATIONS_FIREMQTT_PORT_POSIX_RTDBG_H_
+
+/* Log macros of RT-Thread's rtdbg.h for the POSIX port, filtered by DBG_LVL. */
+
+#include <rtthread.h>
+
+#define DBG_ERROR           0
+#define DBG_WARNING         1
+#define DBG_INFO            2
+#define DBG_LOG             3
+
+#ifndef DBG_TAG
+#define DBG_TAG             "DBG"
+#endif
+
+#ifndef DBG_LVL
+#define DBG_LVL             DBG_WARNING
+#endif
+
+void rt_dbg_log(char level, const char *tag, const char *fmt, ...);
+
+#if (DBG_LVL >= DBG_LOG)
+#define LOG_D(fmt, ...)     rt_dbg_log('D', DBG_TAG, fmt, ##__VA_ARGS__)
+#else
+#define LOG_D(fmt, ...)     ((void) 0)
+#endif
+
+#if (DBG_LVL >= DBG_INFO)
+#define LOG_I(fmt, ...)     rt_dbg_log('I', DBG_TAG, fmt, ##__VA_ARGS__)
+#else
+#define LOG_I(fmt, ...)     ((void) 0)
+#endif
+
+#if (DBG_LVL >= DBG_WARNING)
+#define LOG_W(fmt, ...)     rt_dbg_log('W', DBG_TAG, fmt, ##__VA_ARGS__)
+#else
+#define LOG_W(fmt, ...)     ((void) 0)
+#endif
+
+#define LOG_E(fmt, ...)     rt_dbg_log('E', DBG_TAG, fmt, ##__VA_ARGS__)
+
+#endif /* APPLICATIONS_FIREMQTT_PORT_POSIX_RTDBG_H_ */
@@ -0,0 +1,436 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+#include <rtthread.h>
+#include <rtdbg.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <time.h>
+
+#define MSH_CMD_MAX         64
+#define MSH_ARG_MAX         16
+
+struct MshCommand
+{
+    const char *name;
+    const char *desc;
+    syscall_func func;
+};
+
+static struct MshCommand commands[MSH_CMD_MAX];
+static int commandCount;
+static pthread_mutex_t criticalLock;
+static pthread_once_t criticalOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t printLock = PTHREAD_MUTEX_INITIALIZER;
+static __thread struct rt_thread *currentThread;
+
+/* Ticks */
+
+rt_tick_t rt_tick_get(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (rt_tick_t) ((uint64_t) ts.tv_sec * RT_TICK_PER_SECOND + (uint64_t) ts.tv_nsec / 1000000U);
+}
+
+rt_tick_t rt_tick_from_millisecond(rt_int32_t ms)
+{
+    return (ms < 0) ? (rt_tick_t) RT_WAITING_FOREVER : (rt_tick_t) ms;
+}
+
+/* Deadline for the pthread timed waits, which take an absolute time. */
+static void deadlineAfter(struct timespec *ts, clockid_t clock, rt_int32_t ms)
+{
+    clock_gettime(clock, ts);
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long) (ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/* Memory */
+
+void *rt_malloc(rt_size_t size)
+{
+    return malloc(size);
+}
+
+void *rt_calloc(rt_size_t count, rt_size_t size)
+{
+    return calloc(count, size);
+}
+
+void *rt_realloc(void *ptr, rt_size_t size)
+{
+    return realloc(ptr, size);
+}
+
+void rt_free(void *ptr)
+{
+    free(ptr);
+}
+
+/* Threads */
+
+static void *threadEntry(void *parameter)
+{
+    struct rt_thread *thread = parameter;
+
+    currentThread = thread;
+    thread->entry(thread->parameter);
+    currentThread = RT_NULL;
+
+    /* As on RT-Thread, a thread that returns is reclaimed by the system. */
+    rt_free(thread);
+    return NULL;
+}
+
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter), void *parameter,
+        rt_uint32_t stack_size, rt_uint8_t priority, rt_uint32_t tick)
+{
+    struct rt_thread *thread;
+
+    (void) stack_size;
+    (void) priority;
+    (void) tick;
+
+    thread = rt_calloc(1, sizeof(struct rt_thread));
+    if (thread == RT_NULL)
+    {
+        return RT_NULL;
+    }
+
+    rt_snprintf(thread->name, sizeof(thread->name), "%s", name);
+    thread->entry = entry;
+    thread->parameter = parameter;
+
+    return thread;
+}
+
+rt_err_t rt_thread_startup(rt_thread_t thread)
+{
+    pthread_attr_t attr;
+    int result;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    result = pthread_create(&thread->tid, &attr, threadEntry, thread);
+    pthread_attr_destroy(&attr);
+
+    return (result == 0) ? RT_EOK : -RT_ERROR;
+}
+
+rt_thread_t rt_thread_self(void)
+{
+    /* Threads not created through rt_thread_create(), such as main(), get a
+     * handle of their own on first use. */
+    if (currentThread == RT_NULL)
+    {
+        currentThread = rt_calloc(1, sizeof(struct rt_thread));
+        if (currentThread != RT_NULL)
+        {
+            currentThread->tid = pthread_self();
+            rt_snprintf(currentThread->name, sizeof(currentThread->name), "main");
+        }
+    }
+
+    return currentThread;
+}
+
+rt_err_t rt_thread_mdelay(rt_int32_t ms)
+{
+    struct timespec ts;
+
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long) (ms % 1000) * 1000000L;
+    while ((nanosleep(&ts, &ts) != 0) && (errno == EINTR))
+    {
+    }
+
+    return RT_EOK;
+}
+
+rt_err_t rt_thread_delay(rt_tick_t tick)
+{
+    return rt_thread_mdelay((rt_int32_t) tick);
+}
+
+static void criticalInit(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&criticalLock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+/* There is no scheduler to lock, so a global lock stands in for it. */
+void rt_enter_critical(void)
+{
+    pthread_once(&criticalOnce, criticalInit);
+    pthread_mutex_lock(&criticalLock);
+}
+
+void rt_exit_critical(void)
+{
+    pthread_mutex_unlock(&criticalLock);
+}
+
+/* Mutexes */
+
+rt_err_t rt_mutex_init(rt_mutex_t mutex, const char *name, rt_uint8_t flag)
+{
+    pthread_mutexattr_t attr;
+
+    (void) name;
+    (void) flag;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mutex->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    return RT_EOK;
+}
+
+rt_err_t rt_mutex_detach(rt_mutex_t mutex)
+{
+    pthread_mutex_destroy(&mutex->mutex);
+    return RT_EOK;
+}
+
+rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t timeout)
+{
+    struct timespec ts;
+    int result;
+
+    if (timeout == RT_WAITING_FOREVER)
+    {
+        result = pthread_mutex_lock(&mutex->mutex);
+    }
+    else if (timeout == RT_WAITING_NO)
+    {
+        result = pthread_mutex_trylock(&mutex->mutex);
+    }
+    else
+    {
+        deadlineAfter(&ts, CLOCK_REALTIME, timeout);
+        result = pthread_mutex_timedlock(&mutex->mutex, &ts);
+    }
+
+    return (result == 0) ? RT_EOK : -RT_ETIMEOUT;
+}
+
+rt_err_t rt_mutex_release(rt_mutex_t mutex)
+{
+    return (pthread_mutex_unlock(&mutex->mutex) == 0) ? RT_EOK : -RT_ERROR;
+}
+
+/* Semaphores */
+
+rt_err_t rt_sem_init(rt_sem_t sem, const char *name, rt_uint32_t value, rt_uint8_t flag)
+{
+    pthread_condattr_t attr;
+
+    (void) name;
+    (void) flag;
+
+    pthread_mutex_init(&sem->lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&sem->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    sem->value = value;
+
+    return RT_EOK;
+}
+
+rt_err_t rt_sem_detach(rt_sem_t sem)
+{
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->lock);
+    return RT_EOK;
+}
+
+rt_err_t rt_sem_take(rt_sem_t sem, rt_int32_t timeout)
+{
+    struct timespec ts;
+    rt_err_t result = RT_EOK;
+
+    if (timeout > 0)
+    {
+        deadlineAfter(&ts, CLOCK_MONOTONIC, timeout);
+    }
+
+    pthread_mutex_lock(&sem->lock);
+    while ((sem->value == 0) && (result == RT_EOK))
+    {
+        if (timeout == RT_WAITING_FOREVER)
+        {
+            pthread_cond_wait(&sem->cond, &sem->lock);
+        }
+        else if ((timeout == RT_WAITING_NO) || (pthread_cond_timedwait(&sem->cond, &sem->lock, &ts) == ETIMEDOUT))
+        {
+            result = -RT_ETIMEOUT;
+        }
+    }
+    if (result == RT_EOK)
+    {
+        sem->value--;
+    }
+    pthread_mutex_unlock(&sem->lock);
+
+    return result;
+}
+
+rt_err_t rt_sem_trytake(rt_sem_t sem)
+{
+    return rt_sem_take(sem, RT_WAITING_NO);
+}
+
+rt_err_t rt_sem_release(rt_sem_t sem)
+{
+    pthread_mutex_lock(&sem->lock);
+    sem->value++;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->lock);
+
+    return RT_EOK;
+}
+
+/* Console */
+
+void rt_kprintf(const char *fmt, ...)
+{
+    va_list args;
+
+    pthread_mutex_lock(&printLock);
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    fflush(stdout);
+    pthread_mutex_unlock(&printLock);
+}
+
+int rt_snprintf(char *buf, rt_size_t size, const char *fmt, ...)
+{
+    va_list args;
+    int length;
+
+    va_start(args, fmt);
+    length = vsnprintf(buf, size, fmt, args);
+    va_end(args);
+
+    return length;
+}
+
+void rt_dbg_log(char level, const char *tag, const char *fmt, ...)
+{
+    va_list args;
+    size_t length = strlen(fmt);
+
+    pthread_mutex_lock(&printLock);
+    printf("[%c/%s] ", level, tag);
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    if ((length == 0) || (fmt[length - 1] != '\n'))
+    {
+        putchar('\n');
+    }
+    fflush(stdout);
+    pthread_mutex_unlock(&printLock);
+}
+
+void rt_assert_handler(const char *expression, const char *func, rt_size_t line)
+{
+    rt_kprintf("(%s) assertion failed at function:%s, line number:%u\n", expression, func, (unsigned int) line);
+    abort();
+}
+
+/* Shell */
+
+void rt_msh_register(const char *name, const char *desc, syscall_func func)
+{
+    if (commandCount < MSH_CMD_MAX)
+    {
+        commands[commandCount].name = name;
+        commands[commandCount].desc = desc;
+        commands[commandCount].func = func;
+        commandCount++;
+    }
+}
+
+static int mshHelp(void)
+{
+    int i;
+
+    rt_kprintf("Commands:\n");
+    for (i = 0; i < commandCount; i++)
+    {
+        rt_kprintf("%-16s - %s\n", commands[i].name, commands[i].desc);
+    }
+
+    return RT_EOK;
+}
+
+int msh_exec(char *cmd, rt_size_t length)
+{
+    char *argv[MSH_ARG_MAX];
+    char *end = cmd + length;
+    int argc = 0, i;
+
+    /* Split on blanks in place; there is no quoting. */
+    while ((cmd < end) && (argc < MSH_ARG_MAX))
+    {
+        while ((cmd < end) && ((*cmd == ' ') || (*cmd == '\t') || (*cmd == '\r') || (*cmd == '\n')))
+        {
+            *cmd++ = '\0';
+        }
+        if (cmd == end)
+        {
+            break;
+        }
+        argv[argc++] = cmd;
+        while ((cmd < end) && (*cmd != ' ') && (*cmd != '\t') && (*cmd != '\r') && (*cmd != '\n'))
+        {
+            cmd++;
+        }
+    }
+    if (cmd < end)
+    {
+        *cmd = '\0';
+    }
+
+    if (argc == 0)
+    {
+        return RT_EOK;
+    }
+    if (strcmp(argv[0], "help") == 0)
+    {
+        return mshHelp();
+    }
+
+    for (i = 0; i < commandCount; i++)
+    {
+        if (strcmp(argv[0], commands[i].name) == 0)
+        {
+            return commands[i].func(argc, argv);
+        }
+    }
+
+    rt_kprintf("%s: command not found.\n", argv[0]);
+    return -RT_ERROR;
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+#ifndef APPLICATIONS_FIREMQTT_PORT_POSIX_RTTHREAD_H_
+#define APPLICATIONS_FIREMQTT_PORT_POSIX_RTTHREAD_H_
+
+/*
+ * RT-Thread compatibility layer for POSIX hosts.
+ *
+ * Provides the part of the RT-Thread kernel API the client uses, on top of
+ * pthreads and the monotonic clock, so the library, the demo and the
+ * benchmarks build and run unchanged on a workstation. One tick is one
+ * millisecond. Thread stack sizes and priorities are accepted and ignored.
+ *
+ * Like rt_mutex, the mutexes are recursive, which the full duplex state hooks
+ * rely on. Commands exported with MSH_CMD_EXPORT_ALIAS() are collected at
+ * start-up and run by msh_exec().
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+typedef long                rt_err_t;
+typedef long                rt_base_t;
+typedef unsigned long       rt_ubase_t;
+typedef uint32_t            rt_tick_t;
+typedef int8_t              rt_int8_t;
+typedef int16_t             rt_int16_t;
+typedef int32_t             rt_int32_t;
+typedef uint8_t             rt_uint8_t;
+typedef uint16_t            rt_uint16_t;
+typedef uint32_t            rt_uint32_t;
+typedef size_t              rt_size_t;
+typedef int                 rt_bool_t;
+
+#define RT_NULL             NULL
+#define RT_TRUE             1
+#define RT_FALSE            0
+
+#define RT_EOK              0
+#define RT_ERROR            1
+#define RT_ETIMEOUT         2
+#define RT_EFULL            3
+#define RT_EEMPTY           4
+#define RT_ENOMEM           5
+#define RT_ENOSYS           6
+#define RT_EBUSY            7
+#define RT_EIO              8
+#define RT_EINTR            9
+#define RT_EINVAL           10
+
+#define RT_WAITING_FOREVER  -1
+#define RT_WAITING_NO       0
+
+#define RT_TICK_PER_SECOND      1000
+#define RT_NAME_MAX             8
+#define RT_THREAD_PRIORITY_MAX  32
+#define RT_IPC_FLAG_FIFO        0x00
+#define RT_IPC_FLAG_PRIO        0x01
+
+#define RT_USING_FINSH
+#define RT_USING_ULOG
+
+#define RT_ASSERT(expression)   do { if (!(expression)) { rt_assert_handler(#expression, __func__, __LINE__); } } while (0)
+
+/* Kernel objects */
+
+struct rt_thread
+{
+    char name[RT_NAME_MAX];
+    void (*entry)(void *parameter);
+    void *parameter;
+    pthread_t tid;
+};
+typedef struct rt_thread *rt_thread_t;
+
+struct rt_mutex
+{
+    pthread_mutex_t mutex;
+};
+typedef struct rt_mutex *rt_mutex_t;
+
+struct rt_semaphore
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    rt_uint32_t value;
+};
+typedef struct rt_semaphore *rt_sem_t;
+
+/* Lists */
+
+struct rt_list_node
+{
+    struct rt_list_node *next;
+    struct rt_list_node *prev;
+};
+typedef struct rt_list_node rt_list_t;
+
+#define RT_LIST_OBJECT_INIT(object) { &(object), &(object) }
+
+#define rt_container_of(ptr, type, member) \
+    ((type *) ((char *) (ptr) - (unsigned long) (&((type *) 0)->member)))
+
+#define rt_list_entry(node, type, member) \
+    rt_container_of(node, type, member)
+
+static inline void rt_list_init(rt_list_t *l)
+{
+    l->next = l->prev = l;
+}
+
+static inline void rt_list_insert_after(rt_list_t *l, rt_list_t *n)
+{
+    l->next->prev = n;
+    n->next = l->next;
+    l->next = n;
+    n->prev = l;
+}
+
+static inline void rt_list_insert_before(rt_list_t *l, rt_list_t *n)
+{
+    l->prev->next = n;
+    n->prev = l->prev;
+    l->prev = n;
+    n->next = l;
+}
+
+static inline void rt_list_remove(rt_list_t *n)
+{
+    n->next->prev = n->prev;
+    n->prev->next = n->next;
+    n->next = n->prev = n;
+}
+
+static inline int rt_list_isempty(const rt_list_t *l)
+{
+    return l->next == l;
+}
+
+/* Shell */
+
+typedef int (*syscall_func)(int argc, char **argv);
+
+void rt_msh_register(const char *name, const char *desc, syscall_func func);
+int msh_exec(char *cmd, rt_size_t length);
+
+#define MSH_CMD_EXPORT_ALIAS(command, alias, desc)                                  \
+    static void __attribute__((constructor)) __msh_register_##command(void)         \
+    {                                                                               \
+        rt_msh_register(#alias, #desc, (syscall_func) command);                     \
+    }
+
+#define MSH_CMD_EXPORT(command, desc)   MSH_CMD_EXPORT_ALIAS(command, command, desc)
+
+/* Sockets: SAL names the BSD close() closesocket(). */
+
+#define closesocket(s)      close(s)
+
+/* Kernel API */
+
+rt_tick_t rt_tick_get(void);
+rt_tick_t rt_tick_from_millisecond(rt_int32_t ms);
+
+void *rt_malloc(rt_size_t size);
+void *rt_calloc(rt_size_t count, rt_size_t size);
+void *rt_realloc(void *ptr, rt_size_t size);
+void rt_free(void *ptr);
+
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter), void *parameter,
+        rt_uint32_t stack_size, rt_uint8_t priority, rt_uint32_t tick);
+rt_err_t rt_thread_startup(rt_thread_t thread);
+rt_thread_t rt_thread_self(void);
+rt_err_t rt_thread_mdelay(rt_int32_t ms);
+rt_err_t rt_thread_delay(rt_tick_t tick);
+
+void rt_enter_critical(void);
+void rt_exit_critical(void);
+
+rt_err_t rt_mutex_init(rt_mutex_t mutex, const char *name, rt_uint8_t flag);
+rt_err_t rt_mutex_detach(rt_mutex_t mutex);
+rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t timeout);
+rt_err_t rt_mutex_release(rt_mutex_t mutex);
+
+rt_err_t rt_sem_init(rt_sem_t sem, const char *name, rt_uint32_t value, rt_uint8_t flag);
+rt_err_t rt_sem_detach(rt_sem_t sem);
+rt_err_t rt_sem_take(rt_sem_t sem, rt_int32_t timeout);
+rt_err_t rt_sem_trytake(rt_sem_t sem);
+rt_err_t rt_sem_release(rt_sem_t sem);
+
+void rt_kprintf(const char *fmt, ...);
+int rt_snprintf(char *buf, rt_size_t size, const char *fmt, ...);
+void rt_assert_handler(const char *expression, const char *func, rt_size_t line);
+
+#endif /* APPLICATIONS_FIREMQTT_PORT_POSIX_RTTHREAD_H_ */
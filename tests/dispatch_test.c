@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+/*
+ * Topic dispatcher: wildcard resolution, static topics, the resolution cache,
+ * handlers running on two threads at once and unregistering while a handler
+ * runs, on another thread or from the handler itself.
+ */
+
+#include "mqtt_api.h"
+#include "mqtt_dispatch.h"
+#include "test_common.h"
+
+#define SLOW_HANDLER_MS     50U
+
+static MQTTDispatcher_t dispatcher;
+static MQTTPublishInfo_t publishInfo;
+static MQTTDeserializedInfo_t deserializedInfo;
+static char order[16];
+static size_t orderLength;
+static volatile int inside;
+static volatile int maxInside;
+static volatile int slowCalls;
+
+static void onMessage(MQTTContext_t *pContext, MQTTDeserializedInfo_t *pDeserializedInfo, void *pUserData)
+{
+    (void) pContext;
+    (void) pDeserializedInfo;
+
+    if (orderLength < sizeof(order) - 1U)
+    {
+        order[orderLength++] = *(const char *) pUserData;
+    }
+}
+
+static void onSlowMessage(MQTTContext_t *pContext, MQTTDeserializedInfo_t *pDeserializedInfo, void *pUserData)
+{
+    int now;
+
+    (void) pContext;
+    (void) pDeserializedInfo;
+    (void) pUserData;
+
+    now = __sync_add_and_fetch(&inside, 1);
+    if (now > maxInside)
+    {
+        maxInside = now;
+    }
+    rt_thread_mdelay(SLOW_HANDLER_MS);
+    (void) __sync_sub_and_fetch(&inside, 1);
+    (void) __sync_add_and_fetch(&slowCalls, 1);
+}
+
+static void onceHandler(MQTTContext_t *pContext, MQTTDeserializedInfo_t *pDeserializedInfo, void *pUserData)
+{
+    (void) pContext;
+    (void) pDeserializedInfo;
+    (void) pUserData;
+
+    TEST_CHECK(mqttDispatcherUnregister(&dispatcher, "once/#", 6, onceHandler) == MQTTSuccess);
+}
+
+static size_t dispatch(const char *topic)
+{
+    orderLength = 0;
+    memset(order, 0, sizeof(order));
+    publishInfo.pTopicName = topic;
+    publishInfo.topicNameLength = (uint16_t) strlen(topic);
+    deserializedInfo.pPublishInfo = &publishInfo;
+
+    return mqttDispatcherDispatch(&dispatcher, RT_NULL, &deserializedInfo);
+}
+
+static void dispatchThread(void *parameter)
+{
+    (void) parameter;
+
+    (void) mqttDispatcherDispatch(&dispatcher, RT_NULL, &deserializedInfo);
+}
+
+static void testWildcards(void)
+{
+    static const MQTTStaticTopic_t topics[] = { MQTT_STATIC_TOPIC("dev/1/cmd", onMessage, "s") };
+
+    TEST_CHECK(mqttDispatcherRegister(&dispatcher, "dev/+/cmd", 9, onMessage, "p") == MQTTSuccess);
+    TEST_CHECK(mqttDispatcherRegister(&dispatcher, "dev/#", 5, onMessage, "h") == MQTTSuccess);
+    TEST_CHECK(mqttDispatcherRegister(&dispatcher, "dev/2/cmd", 9, onMessage, "e") == MQTTSuccess);
+    TEST_CHECK(mqttDispatcherRegister(&dispatcher, "dev/+/#/x", 9, onMessage, "x") == MQTTBadParameter);
+    TEST_CHECK(mqttDispatcherSetStaticTopics(&dispatcher, topics, 1) == MQTTSuccess);
+
+    TEST_CHECK(dispatch("dev/2/cmd") == 3U);
+    TEST_CHECK(strchr(order, 'p') && strchr(order, 'h') && strchr(order, 'e'));
+    TEST_CHECK(dispatch("dev") == 1U);
+    TEST_CHECK(dispatch("other/2/cmd") == 0U);
+
+    /* The static topic runs ahead of the trie matches. */
+    TEST_CHECK(dispatch("dev/1/cmd") == 3U);
+    TEST_CHECK(order[0] == 's');
+
+    TEST_CHECK(mqttDispatcherUnregister(&dispatcher, "dev/#", 5, RT_NULL) == MQTTSuccess);
+    TEST_CHECK(mqttDispatcherUnregister(&dispatcher, "dev/#", 5, RT_NULL) == MQTTBadParameter);
+    TEST_CHECK(dispatch("dev/2/cmd") == 2U);
+    TEST_CHECK(strchr(order, 'h') == RT_NULL);
+
+    TEST_CHECK(mqttDispatcherSetStaticTopics(&dispatcher, RT_NULL, 0) == MQTTSuccess);
+    TEST_CHECK(mqttDispatcherUnregister(&dispatcher, "dev/+/cmd", 9, onMessage) == MQTTSuccess);
+    TEST_CHECK(mqttDispatcherUnregister(&dispatcher, "dev/2/cmd", 9, onMessage) == MQTTSuccess);
+    TEST_CHECK(dispatch("dev/2/cmd") == 0U);
+}
+
+static void testConcurrentHandlers(void)
+{
+    rt_thread_t first, second;
+    uint32_t startMs;
+
+    TEST_CHECK(mqttDispatcherRegister(&dispatcher, "slow/+", 6, onSlowMessage, RT_NULL) == MQTTSuccess);
+    publishInfo.pTopicName = "slow/1";
+    publishInfo.topicNameLength = 6;
+    deserializedInfo.pPublishInfo = &publishInfo;
+
+    first = rt_thread_create("disp1", dispatchThread, RT_NULL, 4096, 10, 10);
+    second = rt_thread_create("disp2", dispatchThread, RT_NULL, 4096, 10, 10);
+    TEST_CHECK((first != RT_NULL) && (second != RT_NULL));
+    if ((first == RT_NULL) || (second == RT_NULL))
+    {
+        return;
+    }
+
+    startMs = getCurrentTime();
+    rt_thread_startup(first);
+    rt_thread_startup(second);
+    while ((inside < 2) && (getCurrentTime() - startMs < SLOW_HANDLER_MS))
+    {
+        rt_thread_mdelay(1);
+    }
+
+    /* Returns only once both running handlers are done. */
+    TEST_CHECK(mqttDispatcherUnregister(&dispatcher, "slow/+", 6, onSlowMessage) == MQTTSuccess);
+    TEST_CHECK(slowCalls == 2);
+    TEST_CHECK(maxInside == 2);
+    TEST_CHECK(dispatch("slow/1") == 0U);
+}
+
+static void testSelfUnregister(void)
+{
+    TEST_CHECK(mqttDispatcherRegister(&dispatcher, "once/#", 6, onceHandler, RT_NULL) == MQTTSuccess);
+    TEST_CHECK(dispatch("once/a") == 1U);
+    TEST_CHECK(dispatch("once/a") == 0U);
+}
+
+int main(void)
+{
+    if ((mqttDispatcherInit(&dispatcher, 32, 8, 8, 3) != MQTTSuccess)
+            || (mqttDispatcherEnableCache(&dispatcher, 4, 32) != MQTTSuccess))
+    {
+        printf("dispatch_test: init failed\n");
+        return 1;
+    }
+
+    testWildcards();
+    testConcurrentHandlers();
+    testSelfUnregister();
+
+    mqttDispatcherDeinit(&dispatcher);
+    return testResult("dispatch_test");
+}
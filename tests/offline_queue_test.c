@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+/*
+ * Offline publish queue: QoS 1 records stay queued until they are acked and
+ * are published again after a new session or a reboot, QoS 0 records leave
+ * once sent, and the oldest segment goes when the queue is full. The queue is
+ * drained through a core context whose transport accepts every byte.
+ */
+
+#include <stdlib.h>
+#include "mqtt_api.h"
+#include "mqtt_offline_queue.h"
+#include "core_mqtt_state.h"
+#include "test_common.h"
+
+#define SEGMENT_SIZE        128U
+#define SEGMENT_COUNT       4U
+#define OUTGOING_RECORDS    4U
+
+static MQTTOfflineQueue_t queue;
+/* In full duplex mode the core hooks take the locks of the api client around
+ * its context, so the context lives in one. */
+static MQTTClient_t client;
+static MQTTContext_t *const context = &client.context;
+static NetworkContext_t network;
+static TransportInterface_t transport;
+static uint8_t networkBuffer[256];
+static MQTTFixedBuffer_t buffer = { networkBuffer, sizeof(networkBuffer) };
+static MQTTPubAckInfo_t outgoingRecords[OUTGOING_RECORDS];
+static MQTTPubAckInfo_t incomingRecords[1];
+static char directory[] = "/tmp/freemqtt_oq_XXXXXX";
+
+static int32_t acceptSend(NetworkContext_t *pNetworkContext, const void *pBuffer, size_t bytesToSend)
+{
+    (void) pNetworkContext;
+    (void) pBuffer;
+    return (int32_t) bytesToSend;
+}
+
+static int32_t emptyRecv(NetworkContext_t *pNetworkContext, void *pBuffer, size_t bytesToRecv)
+{
+    (void) pNetworkContext;
+    (void) pBuffer;
+    (void) bytesToRecv;
+    return 0;
+}
+
+static void eventCallback(MQTTContext_t *pContext, MQTTPacketInfo_t *pPacketInfo,
+        MQTTDeserializedInfo_t *pDeserializedInfo)
+{
+    (void) pContext;
+    (void) pPacketInfo;
+    (void) pDeserializedInfo;
+}
+
+/* A clean session, as after a reconnect: no records, packet IDs from 1. */
+static void startSession(void)
+{
+    memset(context, 0, sizeof(*context));
+    memset(outgoingRecords, 0, sizeof(outgoingRecords));
+    (void) MQTT_Init(context, &transport, getCurrentTime, eventCallback, &buffer);
+    (void) MQTT_InitStatefulQoS(context, outgoingRecords, OUTGOING_RECORDS, incomingRecords, 1);
+    context->connectStatus = MQTTConnected;
+    mqttOfflineQueueRewind(&queue);
+}
+
+static void appendRecords(MQTTQoS_t qos, uint32_t count)
+{
+    MQTTPublishInfo_t publishInfo = { 0 };
+    char payload[8];
+    uint32_t i;
+
+    publishInfo.qos = qos;
+    publishInfo.pTopicName = "t/q";
+    publishInfo.topicNameLength = 3;
+    publishInfo.pPayload = payload;
+    for (i = 0; i < count; i++)
+    {
+        publishInfo.payloadLength = (size_t) rt_snprintf(payload, sizeof(payload), "m%u", (unsigned int) i);
+        TEST_CHECK(mqttOfflineQueueAppend(&queue, &publishInfo) == MQTTSuccess);
+    }
+}
+
+/* Acks a publish the way the client's event callback does. */
+static void ack(uint16_t packetId)
+{
+    MQTTPublishState_t state;
+
+    TEST_CHECK(MQTT_UpdateStateAck(context, packetId, MQTTPuback, MQTT_RECEIVE, &state) == MQTTSuccess);
+    mqttOfflineQueueAck(&queue, packetId);
+}
+
+static void ackAll(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < OUTGOING_RECORDS; i++)
+    {
+        if (outgoingRecords[i].packetId != MQTT_PACKET_ID_INVALID)
+        {
+            ack(outgoingRecords[i].packetId);
+        }
+    }
+}
+
+static void openQueue(void)
+{
+    TEST_CHECK(mqttOfflineQueueInit(&queue, directory, SEGMENT_SIZE, SEGMENT_COUNT, MQTTOfflineDropOldest)
+            == MQTTSuccess);
+}
+
+static void testCommitOnAck(void)
+{
+    openQueue();
+    startSession();
+    appendRecords(MQTTQoS1, 6);
+
+    /* The window of four records fills, nothing is committed yet. */
+    TEST_CHECK(mqttOfflineQueueDrain(&queue, context) == MQTTSuccess);
+    TEST_CHECK(mqttOfflineQueueDepth(&queue) == 6U);
+
+    /* Commits follow the queue order, a later ack waits for the earlier one. */
+    ack(2);
+    TEST_CHECK(mqttOfflineQueueDepth(&queue) == 6U);
+    ack(1);
+    TEST_CHECK(mqttOfflineQueueDepth(&queue) == 4U);
+
+    /* The link drops before the other acks: a new session sends them again. */
+    startSession();
+    TEST_CHECK(mqttOfflineQueueDrain(&queue, context) == MQTTSuccess);
+    ackAll();
+    TEST_CHECK(mqttOfflineQueueDepth(&queue) == 0U);
+
+    /* The last two need their own pass, the window was full. */
+    TEST_CHECK(mqttOfflineQueueDrain(&queue, context) == MQTTSuccess);
+    ackAll();
+    TEST_CHECK(mqttOfflineQueueDepth(&queue) == 0U);
+    mqttOfflineQueueDeinit(&queue);
+}
+
+static void testReplayAfterReboot(void)
+{
+    MQTTOfflineQueueStats_t stats;
+
+    openQueue();
+    startSession();
+    appendRecords(MQTTQoS1, 3);
+    TEST_CHECK(mqttOfflineQueueDrain(&queue, context) == MQTTSuccess);
+    ack(1);
+    mqttOfflineQueueDeinit(&queue);
+
+    /* The commit offset is not stored, so the acked record of the partly
+     * drained segment is sent again too. */
+    openQueue();
+    TEST_CHECK(mqttOfflineQueueDepth(&queue) == 3U);
+    startSession();
+    appendRecords(MQTTQoS0, 2);
+    TEST_CHECK(mqttOfflineQueueDrain(&queue, context) == MQTTSuccess);
+
+    /* The QoS 0 records wait behind the unacked QoS 1 ones. */
+    TEST_CHECK(mqttOfflineQueueDepth(&queue) == 5U);
+    ackAll();
+    TEST_CHECK(mqttOfflineQueueDepth(&queue) == 0U);
+    mqttOfflineQueueGetStats(&queue, &stats);
+    TEST_CHECK((stats.drained == 5U) && (stats.bytes == 0U));
+    mqttOfflineQueueDeinit(&queue);
+}
+
+static void testDropOldest(void)
+{
+    MQTTOfflineQueueStats_t stats;
+
+    openQueue();
+    startSession();
+    appendRecords(MQTTQoS1, 2);
+    TEST_CHECK(mqttOfflineQueueDrain(&queue, context) == MQTTSuccess);
+
+    /* Fill every segment, the one holding the records in flight goes first. */
+    appendRecords(MQTTQoS0, 40);
+    mqttOfflineQueueGetStats(&queue, &stats);
+    TEST_CHECK(stats.dropped > 0U);
+    TEST_CHECK(stats.depth + stats.dropped == 42U);
+
+    /* Their acks no longer commit anything. */
+    ackAll();
+    mqttOfflineQueueGetStats(&queue, &stats);
+    TEST_CHECK(stats.drained == 0U);
+
+    /* What is left is QoS 0, committed as it is sent. */
+    TEST_CHECK(mqttOfflineQueueDrainSome(&queue, context, 4) == MQTTSuccess);
+    TEST_CHECK(mqttOfflineQueueDepth(&queue) == stats.depth - 4U);
+    TEST_CHECK(mqttOfflineQueueDrain(&queue, context) == MQTTSuccess);
+    TEST_CHECK(mqttOfflineQueueDepth(&queue) == 0U);
+    mqttOfflineQueueDeinit(&queue);
+}
+
+int main(void)
+{
+    char command[64];
+
+    if (mkdtemp(directory) == RT_NULL)
+    {
+        printf("offline_queue_test: no temporary directory\n");
+        return 1;
+    }
+
+#if MQTT_DUPLEX_ENABLE
+    rt_mutex_init(&client.stateLock, "testst", RT_IPC_FLAG_PRIO);
+    rt_mutex_init(&client.sendLock, "testsd", RT_IPC_FLAG_PRIO);
+#endif
+    transport.send = acceptSend;
+    transport.recv = emptyRecv;
+    transport.pNetworkContext = &network;
+
+    testCommitOnAck();
+    testReplayAfterReboot();
+    testDropOldest();
+
+    rt_snprintf(command, sizeof(command), "rm -rf %s", directory);
+    (void) system(command);
+    return testResult("offline_queue_test");
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+
+/*
+ * Subscription registry: a list of filters is added as a whole or not at all,
+ * subscribing again only updates the QoS, and removed filters are forgotten.
+ */
+
+#include "mqtt_api.h"
+#include "mqtt_subscription.h"
+#include "test_common.h"
+
+#define MAX_FILTERS     4U
+
+static MQTTSubscriptionRegistry_t registry;
+
+static MQTTQoS_t qosOf(const char *filter)
+{
+    size_t i;
+
+    for (i = 0; i < registry.count; i++)
+    {
+        if ((registry.subscriptions[i].topicFilterLength == strlen(filter))
+                && (memcmp(registry.subscriptions[i].pTopicFilter, filter, strlen(filter)) == 0))
+        {
+            return registry.subscriptions[i].qos;
+        }
+    }
+
+    return (MQTTQoS_t) 0xFF;
+}
+
+int main(void)
+{
+    MQTTSubscribeInfo_t first[] = { { MQTTQoS0, "a/1", 3 }, { MQTTQoS1, "a/2", 3 } };
+    MQTTSubscribeInfo_t again[] = { { MQTTQoS2, "a/1", 3 } };
+    MQTTSubscribeInfo_t tooMany[] = { { MQTTQoS1, "b/1", 3 }, { MQTTQoS1, "b/2", 3 }, { MQTTQoS1, "b/3", 3 } };
+    MQTTSubscribeInfo_t duplicates[] = { { MQTTQoS1, "c/1", 3 }, { MQTTQoS2, "c/1", 3 }, { MQTTQoS1, "c/2", 3 } };
+    MQTTSubscribeInfo_t invalid[] = { { MQTTQoS1, "d/1", 3 }, { MQTTQoS1, RT_NULL, 0 } };
+
+    if (mqttSubscriptionInit(&registry, MAX_FILTERS, 256, 256) != MQTTSuccess)
+    {
+        printf("subscription_test: init failed\n");
+        return 1;
+    }
+
+    TEST_CHECK(mqttSubscriptionAdd(&registry, first, 2) == MQTTSuccess);
+    TEST_CHECK(mqttSubscriptionCount(&registry) == 2U);
+
+    TEST_CHECK(mqttSubscriptionAdd(&registry, again, 1) == MQTTSuccess);
+    TEST_CHECK(mqttSubscriptionCount(&registry) == 2U);
+    TEST_CHECK(qosOf("a/1") == MQTTQoS2);
+
+    /* Only two of the three fit, none of them is kept. */
+    TEST_CHECK(mqttSubscriptionAdd(&registry, tooMany, 3) == MQTTNoMemory);
+    TEST_CHECK(mqttSubscriptionCount(&registry) == 2U);
+    TEST_CHECK(qosOf("b/1") == (MQTTQoS_t) 0xFF);
+
+    TEST_CHECK(mqttSubscriptionAdd(&registry, invalid, 2) == MQTTBadParameter);
+    TEST_CHECK(mqttSubscriptionCount(&registry) == 2U);
+
+    /* A filter listed twice takes one slot and the last QoS. */
+    TEST_CHECK(mqttSubscriptionRemove(&registry, again, 1) == MQTTSuccess);
+    TEST_CHECK(mqttSubscriptionAdd(&registry, duplicates, 3) == MQTTSuccess);
+    TEST_CHECK(mqttSubscriptionCount(&registry) == 3U);
+    TEST_CHECK(qosOf("c/1") == MQTTQoS2);
+    TEST_CHECK(qosOf("a/1") == (MQTTQoS_t) 0xFF);
+    TEST_CHECK(qosOf("a/2") == MQTTQoS1);
+
+    mqttSubscriptionDeinit(&registry);
+    return testResult("subscription_test");
+}
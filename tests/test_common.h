@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-18     RV           the first version
+ */
+#ifndef APPLICATIONS_FIREMQTT_TESTS_TEST_COMMON_H_
+#define APPLICATIONS_FIREMQTT_TESTS_TEST_COMMON_H_
+
+/*
+ * Checks shared by the host unit tests. Each test links the freemqtt library
+ * against the port/posix layer, prints every failed check and exits with 1
+ * if any failed, so ctest reports it:
+ *
+ *   cmake -S . -B build && cmake --build build -j && ctest --test-dir build
+ */
+
+#include <stdio.h>
+
+static unsigned int testFailures;
+
+#define TEST_CHECK(condition)                                                   \
+    do                                                                          \
+    {                                                                           \
+        if (!(condition))                                                       \
+        {                                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,    \
+                    #condition);                                                \
+            testFailures++;                                                     \
+        }                                                                       \
+    } while (0)
+
+static inline int testResult(const char *name)
+{
+    printf("%s: %s\n", name, (testFailures == 0U) ? "passed" : "FAILED");
+    return (testFailures == 0U) ? 0 : 1;
+}
+
+#endif /* APPLICATIONS_FIREMQTT_TESTS_TEST_COMMON_H_ */
@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2006-2021, RT-Thread Development Team
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Change Logs:
+# Date           Author       Notes
+# 2026-10-18     RV           the first version
+#
+"""Turn a FreeMQTT trace into a Chrome trace for chrome://tracing or Perfetto.
+
+The trace is either a binary file written by `mqtt_trace save <file>`, or a
+console log holding the `trace ...` lines printed by `mqtt_trace`; other lines
+of the log are ignored. Build the client with MQTT_TRACE_ENABLE set to 1 to
+record events, see core/include/core_mqtt_trace.h.
+
+    tools/mqtt_trace_json.py trace.bin -o trace.json
+
+Receiving, parsing and the application callback go on a "receive" track,
+sends and acks on a "send" track and publish state changes on a "state"
+track. Sends and callbacks are slices, everything else instant events.
+"""
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+MAGIC = b"MQTR"
+FORMAT_VERSION = 1
+
+EVENT_FORMAT = "IIIHBB"
+EVENT_SIZE = struct.calcsize("<" + EVENT_FORMAT)
+
+# MQTTTraceEventType_t
+RECV, HEADER, DESERIALIZED, CALLBACK_ENTER, CALLBACK_EXIT, ACK_SENT, SEND_START, SEND_DONE, STATE = range(1, 10)
+
+PACKET_TYPES = {
+    1: "CONNECT", 2: "CONNACK", 3: "PUBLISH", 4: "PUBACK", 5: "PUBREC", 6: "PUBREL", 7: "PUBCOMP",
+    8: "SUBSCRIBE", 9: "SUBACK", 10: "UNSUBSCRIBE", 11: "UNSUBACK", 12: "PINGREQ", 13: "PINGRESP",
+    14: "DISCONNECT",
+}
+
+# MQTTPublishState_t
+PUBLISH_STATES = [
+    "MQTTStateNull", "MQTTPublishSend", "MQTTPubAckSend", "MQTTPubRecSend", "MQTTPubRelSend",
+    "MQTTPubCompSend", "MQTTPubAckPending", "MQTTPubRecPending", "MQTTPubRelPending",
+    "MQTTPubCompPending", "MQTTPublishDone", "MQTTPubAckDeferred", "MQTTPubRecDeferred",
+]
+
+PID = 1
+TRACKS = {"receive": 1, "send": 2, "state": 3}
+
+TEXT_LINE = re.compile(r"\btrace (\d+) (\d+) (\d+) (\d+) (\d+) (\d+)\s*$")
+
+
+def read_binary(data):
+    """Events of a binary dump, in the byte order its version tells."""
+    for order in "<>":
+        version, size = struct.unpack_from(order + "HH", data, len(MAGIC))
+        if version == FORMAT_VERSION:
+            break
+    else:
+        raise ValueError("unknown trace format version")
+    if size != EVENT_SIZE:
+        raise ValueError("trace events are %d bytes, expected %d" % (size, EVENT_SIZE))
+
+    offset = len(MAGIC) + 4
+    events = []
+    while offset + size <= len(data):
+        events.append(struct.unpack_from(order + EVENT_FORMAT, data, offset))
+        offset += size
+    return events
+
+
+def read_text(data):
+    """Events of the `trace` lines of a console log."""
+    events = []
+    for line in data.decode("utf-8", "replace").splitlines():
+        match = TEXT_LINE.search(line)
+        if match:
+            sequence, timestamp, event, packet_id, detail, length = (int(field) for field in match.groups())
+            events.append((sequence, timestamp, length, packet_id, event, detail))
+    return events
+
+
+def packet_name(type_byte):
+    return PACKET_TYPES.get(type_byte >> 4, "0x%02x" % type_byte)
+
+
+def signed(value):
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def convert(events):
+    """Chrome trace events, with 32-bit timestamps unwrapped in sequence order."""
+    trace = [{"ph": "M", "pid": PID, "name": "process_name", "args": {"name": "FreeMQTT"}}]
+    for name, tid in TRACKS.items():
+        trace.append({"ph": "M", "pid": PID, "tid": tid, "name": "thread_name", "args": {"name": name}})
+
+    events = sorted(events)
+    base = 0
+    previous = None
+    lost = 0
+    for sequence, timestamp, length, packet_id, event, detail in events:
+        if previous is not None:
+            lost += sequence - previous[0] - 1
+            if timestamp + base < previous[1] - (1 << 31):
+                base += 1 << 32
+        previous = (sequence, timestamp + base)
+
+        entry = {"pid": PID, "ts": timestamp + base, "ph": "i", "s": "t"}
+        args = {}
+        if packet_id:
+            args["packet id"] = packet_id
+
+        if event == RECV:
+            entry.update(tid=TRACKS["receive"], name="recv")
+            args["bytes"] = signed(length)
+        elif event == HEADER:
+            entry.update(tid=TRACKS["receive"], name="header " + packet_name(detail))
+            args["remaining length"] = length
+        elif event == DESERIALIZED:
+            entry.update(tid=TRACKS["receive"], name="deserialized " + packet_name(detail))
+            args["remaining length"] = length
+        elif event in (CALLBACK_ENTER, CALLBACK_EXIT):
+            entry.update(tid=TRACKS["receive"], name="callback " + packet_name(detail),
+                         ph="B" if event == CALLBACK_ENTER else "E")
+            del entry["s"]
+        elif event == ACK_SENT:
+            entry.update(tid=TRACKS["send"], name="ack " + packet_name(detail))
+        elif event in (SEND_START, SEND_DONE):
+            entry.update(tid=TRACKS["send"], name="send " + packet_name(detail),
+                         ph="B" if event == SEND_START else "E")
+            del entry["s"]
+            args["bytes" if event == SEND_START else "result"] = signed(length)
+        elif event == STATE:
+            state = PUBLISH_STATES[detail] if detail < len(PUBLISH_STATES) else str(detail)
+            entry.update(tid=TRACKS["state"], name=state)
+        else:
+            entry.update(tid=TRACKS["receive"], name="event %d" % event)
+            args["length"] = length
+
+        if args:
+            entry["args"] = args
+        trace.append(entry)
+
+    return {"traceEvents": trace, "displayTimeUnit": "ms",
+            "otherData": {"events": len(events), "lost": lost}}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("trace", help="binary dump or console log, - for stdin")
+    parser.add_argument("-o", "--output", help="JSON file to write, stdout by default")
+    options = parser.parse_args()
+
+    if options.trace == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(options.trace, "rb") as source:
+            data = source.read()
+
+    events = read_binary(data) if data.startswith(MAGIC) else read_text(data)
+    result = convert(events)
+
+    if options.output:
+        with open(options.output, "w") as output:
+            json.dump(result, output)
+    else:
+        json.dump(result, sys.stdout)
+        sys.stdout.write("\n")
+
+    sys.stderr.write("%d events, %d lost\n" % (result["otherData"]["events"], result["otherData"]["lost"]))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())